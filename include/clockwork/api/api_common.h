@@ -1,6 +1,7 @@
 #ifndef _CLOCKWORK_API_API_COMMON_H_
 #define _CLOCKWORK_API_API_COMMON_H_
 
+#include <cstdint>
 #include <functional>
 #include <string>
 
@@ -11,12 +12,14 @@ const int clockworkInitializing = 5;
 const int clockworkInvalidRequest = 6;
 const int clockworkControllerSkipped = 7;
 const int clockworkControllerCouldNotStartInTime = 8;
+const int clockworkControllerRejected = 9;
 
 namespace clockwork {
 
 struct RequestHeader {
 	int user_id;
 	int user_request_id;
+	uint64_t trace_id = 0; // 0 if the request isn't traced
 };
 
 struct ResponseHeader {
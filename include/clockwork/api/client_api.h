@@ -81,12 +81,14 @@ struct InferenceResponse {
 	int batch_size;
 	size_t output_size;
 	void* output;
+	uint64_t retry_after = 0; // If rejected, nanoseconds to back off before retrying
 
 	// Not sent over the network; used by controller
 	uint64_t deadline = 0;
 	uint64_t departure = 0;
 	unsigned arrival_count = 0;
 	unsigned departure_count = 0;
+	int cache_status = 0; // 0 if executed; 1 if served from the result cache; 2 if it joined an identical request
 
 	std::string str();
 };
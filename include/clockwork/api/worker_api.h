@@ -6,6 +6,7 @@
 #include <string>
 #include <memory>
 #include "clockwork/api/api_common.h"
+#include "clockwork/telemetry.h"
 
 /**
 This is the API for Clockwork Workers that are controlled by a centralized Clockwork scheduler.
@@ -85,6 +86,11 @@ const int evictWeightsAction = 3;
 const int clearCacheAction = 4;
 const int getWorkerStateAction = 5;
 
+/* Worker state event types */
+const int modelAddedEvent = 0;
+const int modelLoadedEvent = 1; // Weights became resident on a GPU
+const int modelEvictedEvent = 2; // Weights are no longer resident on a GPU
+
 class Action {
 public:
 	int id;
@@ -153,6 +159,7 @@ public:
 	int input_size;
 	char* input;
 	std::vector<size_t> input_sizes;
+	std::vector<uint64_t> trace_ids; // of the batched requests that are traced
 
 	// Not actually sent to workers; here for convenience
 	int worker_id = -1;
@@ -169,6 +176,10 @@ public:
 
 class GetWorkerState : public Action {
 public:
+	// If nonzero, the worker may respond with only the events after this seqno.
+	// If zero, or if the worker no longer has those events, it sends a full snapshot.
+	uint64_t since_seqno = 0;
+
 	virtual std::string str();
 };
 
@@ -259,6 +270,9 @@ public:
 	unsigned gpu_id;
 	unsigned gpu_clock_before;
 	unsigned gpu_clock;
+
+	// Running totals of the worker's executors; only attached periodically, otherwise empty
+	std::vector<ExecutorTelemetry> executors;
 	
 	virtual std::string str();
 };
@@ -276,6 +290,9 @@ public:
 	std::vector<unsigned> models; // Models currently on GPU
 	size_t io_pool_size; // Not actually useful but included for completeness
 	size_t workspace_pool_size; // Not actually useful but included for completeness
+	std::string name = ""; // GPU model name, e.g. Tesla V100-PCIE-32GB
+	unsigned clock = 0; // Current SM clock in MHz; 0 if unknown
+	unsigned max_clock = 0; // Max SM clock in MHz; 0 if unknown
 
 	virtual std::string str();	
 };
@@ -291,9 +308,28 @@ public:
 	virtual std::string str();	
 };
 
+class WorkerStateEvent {
+public:
+	uint64_t seqno;
+	int type;
+	int model_id;
+	unsigned gpu_id;
+	ModelInfo model; // Only set for modelAddedEvent
+
+	virtual std::string str();
+};
+
 class GetWorkerStateResult : public Result {
 public:
+	// The worker's seqno at the time the result was created
+	uint64_t seqno = 0;
+
+	// A snapshot contains every model in worker.models and every loaded model in worker.gpus.
+	// Otherwise, worker.models and the GPU model lists are empty and the changes since
+	// the requested seqno are in events, in order.
+	bool is_snapshot = true;
 	WorkerMemoryInfo worker;
+	std::vector<WorkerStateEvent> events;
 
 	virtual std::string str();
 };
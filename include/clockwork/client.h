@@ -22,6 +22,19 @@ public:
 	clockwork_initializing(std::string what) : std::runtime_error(what) {}
 };
 
+/*
+Receives the result of an infer.  Not copied by infer, so a single callback can be
+reused across many requests.  Called on the client's network thread.
+*/
+class InferCallback {
+public:
+	virtual ~InferCallback() {}
+
+	// output is only valid for the duration of the call
+	virtual void success(uint8_t* output, size_t output_size) = 0;
+	virtual void error(int status, std::string &message) = 0;
+};
+
 /* Represents a model that can be inferred */
 class Model {
 public:
@@ -50,10 +63,26 @@ public:
 	*/
 	virtual std::future<std::vector<uint8_t>> infer_async(std::vector<uint8_t> &input, bool compressed=false) = 0;
 
+	/*
+	Callback version of infer.
+	intended_send is when the caller meant to send the request, if it has fallen behind.
+	Latency is then measured from intended_send, so that delays in the caller are not
+	omitted.  If 0, latency is measured from when the request is sent.
+	*/
 	virtual void infer(std::vector<uint8_t> &input, 
 		std::function<void(std::vector<uint8_t>&)> onSuccess, 
 		std::function<void(int, std::string&)> onError,
-		bool compressed=false) = 0;
+		bool compressed=false,
+		uint64_t intended_send=0) = 0;
+
+	/*
+	Allocation-free version of infer, for generating load.
+	input must be lz4 compressed.  It is borrowed rather than copied, so it must remain
+	valid until callback is called.  intended_send is as above.
+	*/
+	virtual void infer(const void* input, size_t input_size,
+		InferCallback* callback,
+		uint64_t intended_send=0) = 0;
 
 	/*
 	This is a backdoor API call that's useful for testing.
@@ -4,6 +4,7 @@
 #include <pods/pods.h>
 #include <pods/binary.h>
 #include <pods/buffers.h>
+#include <algorithm>
 #include <chrono>
 #include "clockwork/util.h"
 
@@ -26,10 +27,27 @@ struct ActionTelemetry {
 };
 
 
+// An executor's cumulative totals since it started; utilization over an interval is the
+// difference between two readings
 struct ExecutorTelemetry {
-	int task_type, executor_id;
-	clockwork::time_point next_task_begin, slot_available, task_dequeued, task_complete;
-	float async_wait, async_duration;
+	int task_type;
+	int gpu_id; // -1 for executors that aren't on a GPU
+	uint64_t timestamp; // when the totals were read
+	uint64_t busy; // nanoseconds running tasks, on the executor thread or asynchronously on its stream
+	uint64_t tasks; // tasks dequeued
+	uint64_t dropped; // tasks dequeued after the latest time they could start
+	uint64_t lateness; // total nanoseconds from each task becoming eligible until its dequeue
+	int64_t queued; // tasks waiting at the time of reading
+
+	uint64_t idle(const ExecutorTelemetry &previous) const {
+		uint64_t elapsed = timestamp - previous.timestamp;
+		uint64_t busy_since = busy - previous.busy;
+		return busy_since < elapsed ? elapsed - busy_since : 0;
+	}
+	double utilization(const ExecutorTelemetry &previous) const {
+		uint64_t elapsed = timestamp - previous.timestamp;
+		return elapsed == 0 ? 0 : std::min(1.0, (busy - previous.busy) / ((double) elapsed));
+	}
 };
 
 struct RequestTelemetry {
@@ -76,22 +94,6 @@ struct SerializedActionTelemetry {
     )
 };
 
-struct SerializedExecutorTelemetry {
-	int task_type, executor_id;
-	uint64_t next_task_begin, slot_available, task_dequeued, task_complete;
-	uint64_t async_wait, async_duration;
-
-	PODS_SERIALIZABLE(1,
-		PODS_MDR(task_type),
-		PODS_MDR(executor_id),
-		PODS_MDR(next_task_begin),
-		PODS_MDR(slot_available),
-		PODS_MDR(task_dequeued),
-		PODS_MDR(task_complete),
-		PODS_MDR(async_wait)
-    )
-};
-
 struct SerializedRequestTelemetry {
 	int model_id, request_id;
 	uint64_t arrived, submitted, complete;
@@ -0,0 +1,131 @@
+#include <catch2/catch.hpp>
+#include <unistd.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <asio.hpp>
+#include "clockwork/util.h"
+#include "clockwork/network/controller.h"
+#include "clockwork/controller/infer5/infer5_scheduler.h"
+
+using namespace clockwork;
+
+/* Drives the infer5 admission pipeline with a synthetic client and no real workers.
+The single fake GPU is too small to hold any model, so every request is admitted,
+enqueued to its model, and then expired by its admission shard.  Each case shuts its
+scheduler down, so the cases can run in one invocation, e.g.
+    ./profile "[admission]" */
+void profile_admission(unsigned num_admission_threads) {
+    unsigned num_models = 1000;
+    unsigned num_client_threads = 4;
+    unsigned requests_per_client = 500000;
+
+    ClockworkState state;
+    state.page_size = 16 * 1024 * 1024;
+
+    WorkerState worker;
+    worker.id = 0;
+    GPUState gpu;
+    gpu.id = 0;
+    gpu.weights_cache_size = state.page_size;
+    gpu.weights_cache_total_pages = 1;
+    gpu.name = "synthetic";
+    gpu.clock = 0;
+    worker.gpus.push_back(gpu);
+
+    for (unsigned i = 0; i < num_models; i++) {
+        BatchedModelState model;
+        model.id = i;
+        model.model_path = "synthetic";
+        model.input_size = 0;
+        model.output_size = 0;
+        model.weights_size = 2 * state.page_size;
+        model.num_weights_pages = 2;
+        model.weights_transfer_duration = 1000000UL;
+        model.supported_batch_sizes = {1};
+        model.exec_duration[1] = 1000000UL;
+        worker.models[i] = model;
+    }
+    state.workers.push_back(worker);
+
+    asio::io_service io_service;
+    std::vector<network::controller::WorkerConnection*> workers = {
+        new network::controller::WorkerConnection(io_service, nullptr)
+    };
+
+    auto scheduler = new scheduler::infer5::Scheduler(
+        10000000UL, // default_slo
+        1000000UL, // latest_delta
+        1000000UL, // schedule_ahead
+        false, // generate_inputs
+        1, // max_gpus
+        25000000UL, // max_allowable_exec_time
+        1, // max_batch_size
+        "/tmp/clockwork_profile_admission_actions.tsv",
+        num_admission_threads
+    );
+    scheduler->start(workers, state);
+
+    uint64_t total = num_client_threads * requests_per_client;
+    std::atomic_uint64_t responses(0);
+    auto callback = [&responses](clientapi::InferenceResponse &response) {
+        responses++;
+    };
+
+    uint64_t begin = util::now();
+
+    std::vector<std::thread> clients;
+    for (unsigned c = 0; c < num_client_threads; c++) {
+        clients.push_back(std::thread([&, c]() {
+            for (unsigned i = 0; i < requests_per_client; i++) {
+                clientapi::InferenceRequest request;
+                request.header.user_id = c;
+                request.header.user_request_id = i;
+                request.model_id = (c * requests_per_client + i) % num_models;
+                request.batch_size = 1;
+                request.input_size = 0;
+                request.input = nullptr;
+                request.slo_factor = 0;
+                request.arrival = util::now();
+                scheduler->clientInfer(request, callback);
+            }
+        }));
+    }
+    for (auto &client : clients) {
+        client.join();
+    }
+    uint64_t submitted = util::now();
+
+    while (responses.load() < total) {
+        usleep(1000);
+    }
+    uint64_t end = util::now();
+
+    std::cout << num_admission_threads << " admission threads: "
+              << total << " requests submitted in " << ((submitted - begin) / 1000000.0) << "ms, "
+              << "all completed in " << ((end - begin) / 1000000.0) << "ms "
+              << "(" << (total * 1000000000.0 / (end - begin)) << " r/s)" << std::endl;
+
+    REQUIRE(responses.load() == total);
+
+    scheduler->shutdown();
+    delete scheduler;
+    delete workers[0];
+}
+
+TEST_CASE("Profile infer5 admission 1 shard", "[profile] [admission]") {
+    profile_admission(1);
+}
+
+TEST_CASE("Profile infer5 admission 2 shards", "[profile] [admission]") {
+    profile_admission(2);
+}
+
+TEST_CASE("Profile infer5 admission 4 shards", "[profile] [admission]") {
+    profile_admission(4);
+}
+
+TEST_CASE("Profile infer5 admission 8 shards", "[profile] [admission]") {
+    profile_admission(8);
+}
@@ -0,0 +1,77 @@
+#include <catch2/catch.hpp>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+#include "clockwork/util.h"
+#include "clockwork/controller/infer5/request_log.h"
+
+using namespace clockwork;
+using namespace clockwork::scheduler::infer5;
+
+/* Replays the per-model queue operations of infer5's Model::new_strategies and
+Model::try_dequeue against a model with many supported batch sizes.  Requests are
+shared_ptrs as in the scheduler, so refcount traffic is included. */
+struct FakeRequest {
+    uint64_t deadline;
+};
+
+template <typename Queues>
+uint64_t profile_queues(std::vector<unsigned> &batch_sizes, unsigned iterations, uint64_t &checksum) {
+    Queues queues(batch_sizes.size());
+    std::mt19937_64 rng(0);
+    uint64_t now = 0;
+
+    uint64_t begin = util::now();
+    for (unsigned iter = 0; iter < iterations; iter++) {
+        // Arrivals at roughly the rate they are served
+        for (unsigned i = 0; i < 4; i++) {
+            auto request = std::make_shared<FakeRequest>();
+            request->deadline = now + 10000000UL + (rng() % 100000);
+            queues.push(request, request->deadline);
+        }
+        now += 1000000UL;
+
+        // new_strategies
+        for (int i = batch_sizes.size() - 1; i >= 0; i--) {
+            if (queues.size(i) == 0) continue;
+            checksum += queues.front_deadline(i);
+        }
+
+        // try_dequeue
+        for (unsigned i = 0; i < batch_sizes.size(); i++) {
+            queues.drop_expired(i, now + 500000UL * batch_sizes[i]);
+        }
+        unsigned i = 0;
+        while (i < batch_sizes.size() - 1 && queues.size(i+1) >= batch_sizes[i+1]) i++;
+        if (queues.size(i) >= batch_sizes[i]) {
+            std::vector<std::shared_ptr<FakeRequest>> taken;
+            queues.catch_up(queues.take(i, batch_sizes[i], taken));
+            checksum += taken.size();
+        }
+        queues.trim();
+    }
+    return util::now() - begin;
+}
+
+TEST_CASE("Profile infer5 model request queues", "[profile] [requestlog]") {
+    unsigned iterations = 1000000;
+
+    std::vector<std::vector<unsigned>> configurations = {
+        {1, 2, 4, 8},
+        {1, 2, 4, 8, 16, 32, 64, 128},
+        {1, 2, 3, 4, 5, 6, 7, 8, 10, 12, 14, 16, 20, 24, 28, 32}
+    };
+
+    for (auto &batch_sizes : configurations) {
+        uint64_t checksum = 0;
+        typedef std::shared_ptr<FakeRequest> Request;
+        uint64_t replicated = profile_queues<ReplicatedRequestQueues<Request>>(batch_sizes, iterations, checksum);
+        uint64_t log = profile_queues<RequestLog<Request>>(batch_sizes, iterations, checksum);
+
+        std::cout << batch_sizes.size() << " batch sizes:"
+                  << " replicated=" << (replicated / (float) iterations) << "ns"
+                  << " log=" << (log / (float) iterations) << "ns"
+                  << " per new_strategies+try_dequeue (" << checksum << ")" << std::endl;
+    }
+}
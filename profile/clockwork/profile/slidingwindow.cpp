@@ -0,0 +1,121 @@
+#include <catch2/catch.hpp>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <list>
+#include <vector>
+#include "clockwork/util.h"
+#include "clockwork/sliding_window.h"
+
+/* These two files are included for the Order Statistics Tree. */
+#include <ext/pb_ds/assoc_container.hpp>
+#include <ext/pb_ds/tree_policy.hpp>
+
+using namespace clockwork;
+
+/* The original tree-based implementation that SlidingWindowT replaced, kept here
+   only as the baseline for this profile. */
+template <typename T> 
+class OrderStatisticsSlidingWindowT {
+private:
+    unsigned window_size;
+
+    /* An order statistics tree is used to implement a wrapper around a C++
+       set with the ability to know the ordinal number of an item in the set
+       and also to get an item by its ordinal number from the set.
+       The data structure I use is implemented in STL but only for GNU C++.
+       Some sources are documented below:
+         -- https://gcc.gnu.org/onlinedocs/libstdc++/ext/pb_ds/
+         -- https://codeforces.com/blog/entry/11080
+         -- https://gcc.gnu.org/onlinedocs/libstdc++/ext/pb_ds/tree_based_containers.html
+         -- https://opensource.apple.com/source/llvmgcc42/llvmgcc42-2336.9/libstdc++-v3/testsuite/ext/pb_ds/example/tree_order_statistics.cc.auto.html
+         -- https://stackoverflow.com/questions/44238144/order-statistics-tree-using-gnu-pbds-for-multiset
+         -- https://www.geeksforgeeks.org/order-statistic-tree-using-fenwick-tree-bit/ */
+
+    typedef __gnu_pbds::tree<
+        T,
+        __gnu_pbds::null_type,
+        std::less_equal<T>,
+        __gnu_pbds::rb_tree_tag,
+        __gnu_pbds::tree_order_statistics_node_update> OrderedMultiset;
+
+    /* We maintain a list of data items (FIFO ordered) so that the latest
+       and the oldest items can be easily tracked for insertion and removal.
+       And we also maintain a parallel OrderedMultiset data structure where the
+       items are stored in an order statistics tree so that querying, say, the
+       99th percentile value is easy. We also maintain an upper bound on sliding
+       window size. After the first few iterations, the number of data items
+       is always equal to the upper bound. Thus, we have:
+            -- Invariant 1: q.size() == oms.size()
+            -- Invariant 2: q.size() <= window_size */
+    std::list<T> q;
+    OrderedMultiset oms;
+
+public:
+    OrderStatisticsSlidingWindowT() : window_size(100) {}
+    OrderStatisticsSlidingWindowT(unsigned window_size) : window_size(window_size) {}
+
+    /* Assumption: q.size() == oms.size() */
+    unsigned get_size() { return q.size(); }
+
+    /* Requirement: rank < oms.size() */
+    T get_value(unsigned rank) { return (*(oms.find_by_order(rank))); }
+    T get_percentile(float percentile) {
+        float position = percentile * (q.size() - 1);
+        unsigned up = ceil(position);
+        unsigned down = floor(position);
+        if (up == down) return get_value(up);
+        return get_value(up) * (position - down) + get_value(down) * (up - position);
+    }
+    T get_min() { return get_value(0); }
+    T get_max() { return get_value(q.size()-1); }
+    void insert(T latest) {
+        q.push_back(latest);
+        oms.insert(latest);
+        if (q.size() > window_size) {
+            uint64_t oldest = q.front();
+            q.pop_front();
+            auto it=oms.upper_bound (oldest);
+            oms.erase(it); // Assumption: *it == oldest
+        }
+    }
+    
+    OrderStatisticsSlidingWindowT(unsigned window_size, T initial_value) : window_size(window_size) {
+        insert(initial_value);
+    }
+};
+
+template <typename Window>
+uint64_t profile_window(unsigned window_size, std::vector<uint64_t> &values, uint64_t &checksum) {
+    Window window(window_size);
+
+    uint64_t begin = util::now();
+    for (uint64_t &value : values) {
+        window.insert(value);
+        checksum += window.get_percentile(0.99);
+    }
+    uint64_t end = util::now();
+    return end - begin;
+}
+
+TEST_CASE("Profile sliding window insert & percentile", "[profile] [slidingwindow]") {
+    std::srand(0);
+
+    unsigned iterations = 1000000;
+    std::vector<uint64_t> values;
+    for (unsigned i = 0; i < iterations; i++) {
+        // Roughly exec-duration shaped: ~5ms with jitter
+        values.push_back(5000000 + (std::rand() % 500000));
+    }
+
+    for (unsigned window_size : {10, 100, 1024}) {
+        uint64_t checksum = 0;
+        uint64_t tree = profile_window<OrderStatisticsSlidingWindowT<uint64_t>>(window_size, values, checksum);
+        uint64_t ring = profile_window<SlidingWindowT<uint64_t>>(window_size, values, checksum);
+
+        std::cout << "window_size=" << window_size
+                  << " tree=" << (tree / (float) iterations) << "ns"
+                  << " ring=" << (ring / (float) iterations) << "ns"
+                  << " per insert+p99 (" << checksum << ")" << std::endl;
+    }
+}
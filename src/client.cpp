@@ -53,6 +53,11 @@ void printUsage() {
 			  << "\t\t Rate should be provided in requests/second" << std::endl
 			  << "\t\t Rate is split across all models" << std::endl
 
+			  << "\t noisy-neighbour num_tenants models_per_tenant rate noisy_concurrency" << std::endl
+			  << "\t\t num_tenants open-loop tenants (user_id 0 to num_tenants-1), each at rate requests/second" << std::endl
+			  << "\t\t One closed-loop tenant (user_id num_tenants) with noisy_concurrency outstanding requests" << std::endl
+			  << "\t\t Each tenant has its own models_per_tenant copies of resnet50_v2" << std::endl
+
 			  << "\t scalability-exp-1 num-models rate-min rate-max rate-factor rate-op period" << std::endl
 			  << "\t\t Workload parameters:" << std::endl
 			  << "\t\t\t num-models: number of \"resnet50_v2\" models" << std::endl
@@ -199,6 +204,9 @@ int main(int argc, char *argv[])
 	else if (workload == "poisson-open-loop")
 		engine = workload::poisson_open_loop(client, std::stoul(argv[3]),
 			std::stod(argv[4]));
+	else if (workload == "noisy-neighbour")
+		engine = workload::noisy_neighbour(client, std::stoul(argv[3]),
+			std::stoul(argv[4]), std::stod(argv[5]), std::stoul(argv[6]));
 	else if (workload == "scalability-exp-1")
     // num-models rate-min rate-max rate-factor rate-op
     engine = workload::scalability_experiment_1(
@@ -8,31 +8,37 @@
 
 namespace clockwork {
 
-void extract_timing_sync(workerapi::Timing* timing, std::shared_ptr<TaskTelemetry> &telemetry) {
-	timing->begin = util::nanos(telemetry->dequeued);
+void extract_timing_sync(workerapi::Timing* timing, TaskTelemetry &telemetry) {
+	timing->begin = util::nanos(telemetry.dequeued);
 	timing->end = util::now();
 	timing->duration = timing->end - timing->begin;
 }
 
-void extract_timing_async(workerapi::Timing* timing, std::shared_ptr<TaskTelemetry> &telemetry) {
-	timing->begin = util::nanos(telemetry->dequeued);
-	timing->end = util::nanos(telemetry->async_complete);
-	timing->duration = (uint64_t) (telemetry->async_duration * 1000000.0);
+void extract_timing_async(workerapi::Timing* timing, TaskTelemetry &telemetry) {
+	timing->begin = util::nanos(telemetry.dequeued);
+	timing->end = util::nanos(telemetry.async_complete);
+	timing->duration = (uint64_t) (telemetry.async_duration * 1000000.0);
 }
 
 void set_taskTelemetry(
-		std::shared_ptr<TaskTelemetry> telemetry, 
+		TaskTelemetry &telemetry, 
 		int action_id, int model_id, int gpu_id, int status, int batch_size, uint64_t earliest,
 		int action_type, int task_type) {
 
-	telemetry->action_id = action_id;
-	telemetry->model_id = model_id;
-	telemetry->gpu_id = gpu_id;
-	telemetry->status = status;
-	telemetry->batch_size = batch_size;
-	telemetry->eligible_for_dequeue = earliest;
-	telemetry->action_type = action_type;
-	telemetry->task_type = task_type;
+	telemetry.action_id = action_id;
+	telemetry.model_id = model_id;
+	telemetry.gpu_id = gpu_id;
+	telemetry.status = status;
+	telemetry.batch_size = batch_size;
+	telemetry.eligible_for_dequeue = earliest;
+	telemetry.action_type = action_type;
+	telemetry.task_type = task_type;
+
+	// CudaAsyncTask sets exec_complete when it submits its async work.  Synchronous
+	// tasks, and tasks that fail before submitting, complete as they are logged
+	if (telemetry.exec_complete == clockwork::time_point()) {
+		telemetry.exec_complete = util::hrt();
+	}
 }
 
 LoadModelFromDiskAction::LoadModelFromDiskTaskImpl::LoadModelFromDiskTaskImpl(LoadModelFromDiskAction* load_model) : 
@@ -398,7 +404,7 @@ void InferAction::CopyOutputTaskImpl::run(cudaStream_t stream) {
 
 		// Making this synchronous
 		CUDA_CALL(cudaStreamSynchronize(stream));
-		telemetry->async_complete = util::hrt();
+		telemetry.async_complete = util::hrt();
 		CopyOutputTask::process_completion();
 	} catch (TaskError &error) {
 		infer->handle_error(error);
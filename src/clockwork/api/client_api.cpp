@@ -67,6 +67,7 @@ std::string InferenceResponse::str() {
 	ss << "Rsp" << header.user_request_id << ":Infer";
 	if (header.status != clockworkSuccess) {
 		ss << " error " << header.status << ": " << header.message;
+		if (retry_after > 0) ss << " retry_after=" << retry_after;
 	} else {
 		ss << " model_id=" << model_id << " b=" << batch_size << " output=" << output_size;
 	}
@@ -74,6 +74,7 @@ std::string ClearCache::str() {
 std::string GetWorkerState::str() {
 	std::stringstream ss;
 	ss << "A" << id << ":GetWorkerState";
+	if (since_seqno > 0) ss << " since=" << since_seqno;
 	return ss.str();
 }
 
@@ -167,6 +168,7 @@ std::string GPUInfo::str() {
 	ss.precision(1);
 	ss << std::fixed;
 	ss << "GPU-" << id
+	   << " " << name << " @" << clock << "MHz"
 	   << " weights_cache=" << as_gb(weights_cache_size) << "GB (" << weights_cache_total_pages << " pages)"
 	   << " io_pool=" << as_mb(io_pool_size) << "MB"
 	   << " workspace_pool=" << as_mb(workspace_pool_size) << "MB"
@@ -188,10 +190,30 @@ std::string WorkerMemoryInfo::str() {
 	return ss.str();
 }
 
+std::string WorkerStateEvent::str() {
+	std::stringstream ss;
+	ss << seqno << ":";
+	switch (type) {
+		case modelAddedEvent: ss << "ModelAdded"; break;
+		case modelLoadedEvent: ss << "ModelLoaded"; break;
+		case modelEvictedEvent: ss << "ModelEvicted"; break;
+		default: ss << "Unknown"; break;
+	}
+	ss << " model=" << model_id << " gpu=" << gpu_id;
+	return ss.str();
+}
+
 std::string GetWorkerStateResult::str() {
 	std::stringstream ss;
-	ss << "R" << id << ":GetWorkerState:\n";
-	ss << worker.str();
+	ss << "R" << id << ":GetWorkerState seqno=" << seqno;
+	if (is_snapshot) {
+		ss << ":\n" << worker.str();
+	} else {
+		ss << " " << events.size() << " events:\n";
+		for (auto &event : events) {
+			ss << " " << event.str() << "\n";
+		}
+	}
 	return ss.str();
 }
 
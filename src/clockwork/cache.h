@@ -24,6 +24,7 @@ template<typename T> class LinkedList {
 public:
 	LinkedListElement<T>* head = nullptr;
 	LinkedListElement<T>* tail = nullptr;
+	std::atomic_int length{0}; // may be read without holding the owner's lock
 
 	~LinkedList() {
 		while (popHead() != nullptr);
@@ -34,13 +35,7 @@ public:
 	}
 
 	int size() {
-		LinkedListElement<T>* next = head;
-		int count = 0;
-		while (next != nullptr) {
-			next = next->next;
-			count++;
-		}
-		return count;
+		return length.load(std::memory_order_relaxed);
 	}
 
 	T popHead() {
@@ -53,6 +48,7 @@ public:
 		if (head == nullptr && tail == elem) tail = nullptr;
 		T data = elem->data;
 		delete elem;
+		length--;
 		return data;
 	}
 
@@ -66,6 +62,7 @@ public:
 		if (tail == nullptr && head == elem) head = nullptr;
 		T data = elem->data;
 		delete elem;
+		length--;
 		return data;
 	}
 
@@ -76,6 +73,7 @@ public:
 		if (element->prev != nullptr) element->prev->next = element->next;
 		else if (head == element) head = element->next;
 		delete element;
+		length--;
 		return true;
 	}
 
@@ -93,6 +91,7 @@ public:
 			tail = element;
 			element->container = this;
 		}
+		length++;
 		return element;
 	}	
 };
@@ -1,11 +1,13 @@
 #include <cstring>
 #include <future>
 #include <atomic>
+#include <unistd.h>
 #include <dmlc/logging.h>
 #include "clockwork/client.h"
 #include "clockwork/api/client_api.h"
 #include "clockwork/network/client.h"
 #include "clockwork/telemetry/client_telemetry_logger.h"
+#include "clockwork/telemetry/trace.h"
 #include "lz4.h"
 
 namespace clockwork
@@ -49,7 +51,7 @@ public:
 	const std::string source_;
 	const size_t input_size_;
 	const size_t output_size_;
-	float slo_factor_ = 0;
+	std::atomic<float> slo_factor_ = 0; // can be adjusted by another workload's thread
 
 	ModelImpl(NetworkClient *client, int model_id, std::string source, size_t input_size_, size_t output_size, bool print);
 
@@ -67,7 +69,9 @@ public:
 	virtual void infer(std::vector<uint8_t> &input, 
 		std::function<void(std::vector<uint8_t>&)> onSuccess, 
 		std::function<void(int, std::string&)> onError,
-		bool compressed);
+		bool compressed, uint64_t intended_send);
+	virtual void infer(const void* input, size_t input_size,
+		InferCallback* callback, uint64_t intended_send);
 	virtual std::future<std::vector<uint8_t>> infer_async(std::vector<uint8_t> &input, bool compressed);
 	virtual void evict();
 	virtual std::future<void> evict_async();
@@ -255,21 +259,43 @@ std::future<std::vector<uint8_t>> ModelImpl::infer_async(std::vector<uint8_t> &i
 		}
 	};
 
-	this->infer(input, onSuccess, onError, compressed);
+	this->infer(input, onSuccess, onError, compressed, 0);
 
 	return promise->get_future();
 }
 
-void ModelImpl::infer(std::vector<uint8_t> &input, std::function<void(std::vector<uint8_t>&)> onSuccess, std::function<void(int, std::string&)> onError, bool compressed) {
-	CHECK(compressed || input_size_ == input.size()) << "Infer called with incorrect input size";
+// Adapts the std::function version of infer; owns the request's input and deletes itself when called
+class FunctionInferCallback : public InferCallback {
+public:
+	char* data;
+	std::function<void(std::vector<uint8_t>&)> onSuccess;
+	std::function<void(int, std::string&)> onError;
 
+	FunctionInferCallback(char* data,
+		std::function<void(std::vector<uint8_t>&)> onSuccess,
+		std::function<void(int, std::string&)> onError) :
+			data(data), onSuccess(onSuccess), onError(onError) {}
 
-	clientapi::InferenceRequest request;
-	request.header.user_id = user_id_;
-	request.header.user_request_id = client->request_id_seed++;
-	request.model_id = model_id_;
-	request.batch_size = 1; // TODO: support batched requests in client
-	request.slo_factor = slo_factor_;
+	~FunctionInferCallback() {
+		if (data != nullptr) {
+			delete[] data;
+		}
+	}
+
+	void success(uint8_t* output, size_t output_size) {
+		std::vector<uint8_t> result(output, output + output_size);
+		onSuccess(result);
+		delete this;
+	}
+
+	void error(int status, std::string &message) {
+		onError(status, message);
+		delete this;
+	}
+};
+
+void ModelImpl::infer(std::vector<uint8_t> &input, std::function<void(std::vector<uint8_t>&)> onSuccess, std::function<void(int, std::string&)> onError, bool compressed, uint64_t intended_send) {
+	CHECK(compressed || input_size_ == input.size()) << "Infer called with incorrect input size";
 
 	char* data = nullptr;
 	size_t data_size = 0;
@@ -287,36 +313,51 @@ void ModelImpl::infer(std::vector<uint8_t> &input, std::function<void(std::vecto
 		}
 	}
 
-	request.input = data;
-	request.input_size = data_size;
+	this->infer(data, data_size, new FunctionInferCallback(data, onSuccess, onError), intended_send);
+}
+
+void ModelImpl::infer(const void* input, size_t input_size, InferCallback* callback, uint64_t intended_send) {
+	clientapi::InferenceRequest request;
+	request.header.user_id = user_id_;
+	request.header.user_request_id = client->request_id_seed++;
+	request.header.trace_id = trace::new_id();
+	request.model_id = model_id_;
+	request.batch_size = 1; // TODO: support batched requests in client
+	request.slo_factor = slo_factor_;
+
+	// Sent directly from the caller's buffer
+	request.input = inputs_enabled_ ? const_cast<void*>(input) : nullptr;
+	request.input_size = inputs_enabled_ ? input_size : 0;
 
 	if (print) std::cout << "<--  " << request.str() << std::endl;
 
 	client->telemetry->incrOutstanding();
 
 	uint64_t t_send = util::now();
-	client->connection->infer(request, [this, data, t_send, onSuccess, onError](clientapi::InferenceResponse &response) {
+	uint64_t t_intended = (intended_send == 0 || intended_send > t_send) ? t_send : intended_send;
+	uint64_t trace_id = request.header.trace_id;
+	client->connection->infer(request, [this, callback, t_intended, t_send, trace_id](clientapi::InferenceResponse &response) {
 		uint64_t t_receive = util::now();
+		if (trace::enabled()) {
+			// Convert to controller time
+			int64_t clock_delta = client->connection->estimate_clock_delta();
+			trace::span(trace_id, "client", t_send - clock_delta, t_receive - clock_delta);
+		}
 		float duration_ms = (t_receive - t_send) / 1000000.0;
 		if (print) std::cout << " --> " << response.str() << " (" << duration_ms << " ms)" << std::endl;
 		if (response.header.status == clockworkSuccess)
 		{
-			uint8_t *output = static_cast<uint8_t *>(response.output);
-			std::vector<uint8_t> result(output, output + response.output_size);
-			onSuccess(result);
-			client->telemetry->log(user_id_, model_id_, 1, input_size_, output_size_, t_send, t_receive, true);
+			callback->success(static_cast<uint8_t *>(response.output), response.output_size);
+			client->telemetry->log(user_id_, model_id_, 1, input_size_, output_size_, t_intended, t_send, t_receive, true);
 		}
 		else
 		{
-			onError(response.header.status, response.header.message);
+			callback->error(response.header.status, response.header.message);
 			if (response.header.status == clockworkError) {
-				client->telemetry->log(user_id_, model_id_, 1, input_size_, output_size_, t_send, t_receive, false);
+				client->telemetry->log(user_id_, model_id_, 1, input_size_, output_size_, t_intended, t_send, t_receive, false);
 			}
 		}
 		client->telemetry->decrOutstanding();
-		if (data != nullptr) {
-			delete data;
-		}
 		free(response.output);
 	});
 }
@@ -341,6 +382,11 @@ Client *Connect(const std::string &hostname, const std::string &port, bool print
 	// Ideally clients would share threads, but for now that's nitpicking
 	network::client::ConnectionManager *manager = new network::client::ConnectionManager();
 
+	std::string trace_file = util::get_trace_file("clockwork_client_" + std::to_string(getpid()));
+	if (trace_file != "" && !trace::enabled()) {
+		trace::start(trace_file, "client");
+	}
+
 	// Connect to clockwork
 	network::client::Connection *clockwork_connection = manager->connect(hostname, port);
 
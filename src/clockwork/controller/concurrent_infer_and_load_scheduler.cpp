@@ -1144,7 +1144,7 @@ void Scheduler::initialize_network(std::vector<network::controller::WorkerConnec
         network_timeout_queue.push({timeout_at, result});
     };
 
-    this->network = new NetworkExecutor(network_concurrency, transmitError);
+    this->network = new SpinNetworkExecutor(network_concurrency, transmitError);
 
     for (auto worker : workers) {
         worker->setTransmitCallback(transmitComplete);
@@ -1392,70 +1392,6 @@ void Scheduler::clientInfer(clientapi::InferenceRequest &request,
     request_queue.push(std::make_shared<RequestImpl>(this, request, callback));
 }
 
-Scheduler::NetworkExecutor::NetworkExecutor(unsigned concurrency, 
-    std::function<void(uint64_t, std::shared_ptr<workerapi::Result>)> error_callback) : 
-idle(concurrency), error_callback(error_callback) {}
-
-void Scheduler::NetworkExecutor::send(network::controller::WorkerConnection* worker, 
-          std::shared_ptr<workerapi::Action> action,
-          uint64_t start_send_by,
-          uint64_t send_error_at) {
-
-    NetworkAction toSend;
-    {
-        tbb::spin_mutex::scoped_lock lock(mutex);
-
-        pending.push_back({worker, action, start_send_by, send_error_at});
-
-        if (idle == 0) return;
-
-        if (!next(toSend)) return;
-
-        idle--;
-    }
-
-    toSend.worker->sendAction(toSend.action);            
-}
-
-void Scheduler::NetworkExecutor::sendComplete() {
-    NetworkAction toSend;
-    {
-        tbb::spin_mutex::scoped_lock lock(mutex);
-        if (!next(toSend)) {
-            idle++;
-            return;
-        }
-    }
-
-    toSend.worker->sendAction(toSend.action);
-}
-
-bool Scheduler::NetworkExecutor::next(NetworkAction &toSend) {
-    uint64_t now = util::now();
-    while (pending.size() > 0) {
-        toSend = pending.front();
-        pending.pop_front();
-
-        if (toSend.start_send_by >= now) {
-            return true;
-        }
-
-        auto action = toSend.action;
-        auto result = std::make_shared<workerapi::ErrorResult>();
-        result->id = action->id;
-        result->action_type = action->action_type;
-        result->status = networkSendTooLate;
-        result->action_received = now;
-        result->result_sent = now;
-        result->result_received = now;
-        result->message = "Could not send action to worker in time";
-
-        error_callback(toSend.send_error_at, result);
-
-    }
-    return false;
-}
-
 }
 }
 }
\ No newline at end of file
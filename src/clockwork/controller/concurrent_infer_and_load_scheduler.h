@@ -10,6 +10,7 @@
 #include <set>
 #include "clockwork/controller/scheduler.h"
 #include "clockwork/controller/worker_tracker.h"
+#include "clockwork/controller/network_executor.h"
 #include "clockwork/controller/load_tracker.h"
 #include "clockwork/telemetry/controller_action_logger.h"
 #include "clockwork/thread.h"
@@ -367,36 +368,6 @@ class Scheduler : public clockwork::Scheduler {
         void evict_result(EvictWeightsAction* action, std::shared_ptr<workerapi::Result> &result);
     };
 
-    class NetworkExecutor {
-     private:
-
-        struct NetworkAction {
-            network::controller::WorkerConnection* worker;
-            std::shared_ptr<workerapi::Action> action;
-            uint64_t start_send_by;
-            uint64_t send_error_at;
-        };
-
-        tbb::spin_mutex mutex;
-        unsigned idle;
-        std::deque<NetworkAction> pending;
-        std::function<void(uint64_t, std::shared_ptr<workerapi::Result>)> error_callback;
-
-     public:
-        NetworkExecutor(unsigned concurrency, 
-            std::function<void(uint64_t, std::shared_ptr<workerapi::Result>)> error_callback);
-
-        void send(network::controller::WorkerConnection* worker, 
-                  std::shared_ptr<workerapi::Action> action,
-                  uint64_t start_send_by,
-                  uint64_t send_error_at);
-        void sendComplete();
-
-    private:
-
-        bool next(NetworkAction &toSend);
-
-    };
  public:
 
     // Thread-safe clockwork state
@@ -421,7 +392,7 @@ class Scheduler : public clockwork::Scheduler {
     std::vector<std::thread> load_threads;
 
     // Network executor
-    NetworkExecutor* network = nullptr;
+    SpinNetworkExecutor* network = nullptr;
 
     // Messages
     struct TimeoutResult {
@@ -1,6 +1,7 @@
 #include "clockwork/controller/controller.h"
 #include <sstream>
 #include "clockwork/thread.h"
+#include "clockwork/telemetry/trace.h"
 
 using namespace clockwork;
 using namespace clockwork::controller;
@@ -45,6 +46,7 @@ std::string BatchedModelState::str() {
 std::string GPUState::str() {
 	std::stringstream ss;
 	ss << "GPU " << id 
+	   << " " << name << " @" << clock << "MHz"
 	   << " " << as_gb(weights_cache_size) << " GB (" << weights_cache_total_pages << " pages)"
 	   << " " << loaded_models.size() << " loaded models" << std::endl;
 	return ss.str();
@@ -94,9 +96,14 @@ void QueryWorkerStage::populate_gpu_state(GPUState &gpu, workerapi::GPUInfo &inf
 	gpu.weights_cache_size = info.weights_cache_size;
 	gpu.weights_cache_total_pages = info.weights_cache_total_pages;
 	gpu.loaded_models = info.models;
+	gpu.name = info.name;
+	gpu.clock = info.clock;
+	gpu.max_clock = info.max_clock;
 }
 
 void QueryWorkerStage::populate_worker_state(WorkerState &worker, workerapi::WorkerMemoryInfo &info) {
+	worker.gpus.clear();
+	worker.models.clear();
 	for (auto &gpuinfo : info.gpus) {
 		GPUState gpu;
 		populate_gpu_state(gpu, gpuinfo);
@@ -109,28 +116,81 @@ void QueryWorkerStage::populate_worker_state(WorkerState &worker, workerapi::Wor
 	}
 }
 
+bool QueryWorkerStage::apply(WorkerState &worker, uint64_t &seqno, workerapi::GetWorkerStateResult &result) {
+	if (result.is_snapshot) {
+		populate_worker_state(worker, result.worker);
+		seqno = result.seqno;
+		return true;
+	}
+
+	// A delta must pick up exactly where we left off
+	uint64_t expected = seqno + 1;
+	for (auto &event : result.events) {
+		if (event.seqno != expected++) return false;
+		if (event.type != workerapi::modelAddedEvent && event.gpu_id >= worker.gpus.size()) return false;
+	}
+	if (seqno == 0 || expected != result.seqno + 1) return false;
+
+	// GPU clocks may have changed
+	for (auto &gpuinfo : result.worker.gpus) {
+		if ((unsigned) gpuinfo.id < worker.gpus.size()) {
+			worker.gpus[gpuinfo.id].clock = gpuinfo.clock;
+		}
+	}
+
+	// Events are idempotent, so applying one that we already reflect is harmless
+	for (auto &event : result.events) {
+		if (event.type == workerapi::modelAddedEvent) {
+			if (worker.models.find(event.model_id) == worker.models.end()) {
+				BatchedModelState model;
+				populate_model_state(model, event.model);
+				worker.models[model.id] = model;
+			}
+			continue;
+		}
+
+		auto &loaded = worker.gpus[event.gpu_id].loaded_models;
+		auto it = std::lower_bound(loaded.begin(), loaded.end(), (unsigned) event.model_id);
+		bool present = it != loaded.end() && *it == (unsigned) event.model_id;
+		if (event.type == workerapi::modelLoadedEvent && !present) {
+			loaded.insert(it, event.model_id);
+		} else if (event.type == workerapi::modelEvictedEvent && present) {
+			loaded.erase(it);
+		}
+	}
+
+	seqno = result.seqno;
+	return true;
+}
+
 ClockworkState QueryWorkerStage::run(std::vector<network::controller::WorkerConnection*> workers,
 		 		   tbb::concurrent_queue<std::shared_ptr<workerapi::Result>> &worker_results_queue) {
-	std::unordered_set<unsigned> outstanding;
+	// Outstanding action id to worker id; action ids are unique per run
+	std::unordered_map<unsigned, unsigned> outstanding;
+	unsigned action_id_seed = 0;
 
-	// The state we will construct
-	ClockworkState state;
-
-	// Send actions to all workers
-	for (auto &worker : workers) {
+	auto send = [&](unsigned worker_id) {
 		// Create and send an action
 		auto action = std::make_shared<workerapi::GetWorkerState>();
-		action->id = outstanding.size();
+		action->id = action_id_seed++;
+		action->since_seqno = seqnos[worker_id];
 		std::vector<std::shared_ptr<workerapi::Action>> actions{action};
-		worker->sendActions(actions);
+		workers[worker_id]->sendActions(actions);
 
 		// Save the action as outstanding
-		outstanding.insert(action->id);
+		outstanding[action->id] = worker_id;
+	};
 
-		// Create a WorkerState for this worker
-		WorkerState workerstate;
-		workerstate.id = action->id;
-		state.workers.push_back(workerstate);
+	// Send actions to all workers
+	for (unsigned worker_id = 0; worker_id < workers.size(); worker_id++) {
+		if (worker_id == state.workers.size()) {
+			// Create a WorkerState for this worker
+			WorkerState workerstate;
+			workerstate.id = worker_id;
+			state.workers.push_back(workerstate);
+			seqnos.push_back(0);
+		}
+		send(worker_id);
 	}
 
 	// Await results
@@ -139,23 +199,28 @@ ClockworkState QueryWorkerStage::run(std::vector<network::controller::WorkerConn
 		while (!worker_results_queue.try_pop(result)) usleep(10000);
 
 		// Check and remove action
-		unsigned worker_id = result->id;
-		auto it = outstanding.find(worker_id);
+		auto it = outstanding.find(result->id);
 		CHECK(it != outstanding.end()) << "Received result for non-existent action " << result->str();
+		unsigned worker_id = it->second;
+		outstanding.erase(it);
 
 		// Validate result
 		auto state_result = std::dynamic_pointer_cast<workerapi::GetWorkerStateResult>(result);
 		CHECK(state_result) << "Fetching worker state failed " << result->str();
 
 		// Process result
-		if (outstanding.size() == workers.size()) {
+		if (state.page_size == 0) {
 			state.page_size = state_result->worker.page_size;
 		}
 		CHECK(state.page_size == state_result->worker.page_size) << "Found workers with inconsistent page sizes " << state_result->str();
-		populate_worker_state(state.workers[worker_id], state_result->worker);
 
-		// Remove outstanding action
-		outstanding.erase(it);
+		if (!apply(state.workers[worker_id], seqnos[worker_id], *state_result)) {
+			// Missed some events; start over from a snapshot
+			std::cout << "Worker " << worker_id << " state out of sync at seqno "
+			          << seqnos[worker_id] << ", requesting snapshot" << std::endl;
+			seqnos[worker_id] = 0;
+			send(worker_id);
+		}
 	}
 
 	return state;
@@ -262,14 +327,46 @@ void LoadingStage::Worker::add_action(std::shared_ptr<workerapi::LoadModelFromDi
 
 void LoadingStage::Worker::result_received() {
 	outstanding--;
+	epoch_completed++;
+	adapt();
 	check();
 }
 
+void LoadingStage::Worker::adapt() {
+	if (epoch_completed < epoch_multiplier * max_outstanding) return;
+
+	uint64_t now = util::now();
+	double throughput = epoch_completed / ((now - epoch_begin) / 1000000000.0);
+
+	// Throughput is only meaningful while the worker is saturated with loads
+	if (!action_queue.empty()) {
+		if (throughput < 0.95 * last_throughput) {
+			step = -step;
+		}
+		int next = ((int) max_outstanding) + step;
+		next = std::max(next, (int) min_outstanding_limit);
+		next = std::min(next, (int) max_outstanding_limit);
+		if (next != max_outstanding) {
+			std::cout << "LoadingStage: " << throughput << " loads/s, max_outstanding "
+			          << max_outstanding << " -> " << next << std::endl;
+		}
+		max_outstanding = next;
+	}
+
+	last_throughput = throughput;
+	epoch_begin = now;
+	epoch_completed = 0;
+}
+
 void LoadingStage::Worker::check() {
-	if (outstanding == max_outstanding || action_queue.empty()) {
+	if (outstanding >= max_outstanding || action_queue.empty()) {
 		return;
 	}
 
+	if (epoch_begin == 0) {
+		epoch_begin = util::now();
+	}
+
 	std::vector<std::shared_ptr<workerapi::Action>> actions;
 	while (outstanding < max_outstanding && !action_queue.empty()) {
 		actions.push_back(action_queue.front());
@@ -434,7 +531,7 @@ ClockworkState ControllerStartup::run(uint64_t timeout, std::vector<network::con
 
 	// Let loadModel requests buffer while querying worker state
 	std::cout << "(Startup-2) Querying current worker state" << std::endl;
-	ClockworkState state = QueryWorkerStage().run(workers, worker_results_queue);
+	ClockworkState state = query_stage.run(workers, worker_results_queue);
 
 	std::cout << state.str() << std::endl;
 
@@ -447,9 +544,27 @@ ClockworkState ControllerStartup::run(uint64_t timeout, std::vector<network::con
 
 	std::cout << "(Startup-3) Awaiting LoadModel requests from clients" << std::endl;
 	state = LoadingStage(state, workers, timeout, max_batch_size, max_exec_duration).run(load_model_request_queue, worker_results_queue);
-	std::cout << "(Startup-6) LoadModelStage complete.  Printing loaded models: " << std::endl;
+	std::cout << "(Startup-6) LoadModelStage complete.  Re-syncing worker state" << std::endl;
+
+	// Only the events since Startup-2 are fetched.  Loading may have loaded or evicted
+	// weights, so take the GPU state from the workers rather than assuming it.
+	ClockworkState synced = query_stage.run(workers, worker_results_queue);
+	for (unsigned i = 0; i < state.workers.size(); i++) {
+		CHECK(synced.workers[i].models.size() == state.workers[i].models.size())
+			<< "Worker " << i << " reports " << synced.workers[i].models.size() 
+			<< " models but " << state.workers[i].models.size() << " were loaded";
+		state.workers[i].gpus = synced.workers[i].gpus;
+	}
+
+	std::cout << "Printing loaded models: " << std::endl;
 	std::cout << state.str() << std::endl;
 
+	if (profile_cache != nullptr) {
+		unsigned found = profile_cache->apply(state);
+		std::cout << "(Startup-7) Warm-started " << found << " models from profile cache " 
+		          << profile_cache->filename << std::endl;
+	}
+
 
 	std::cout << "(Startup-end) Transitioning to scheduler" << std::endl;
 
@@ -561,14 +676,18 @@ void ControllerWithStartupPhase::infer(clientapi::InferenceRequest &request, std
 			return;
 		}
 	}
+	// Requests from clients that don't assign trace ids are traced from here
+	if (request.header.trace_id == 0 && trace::enabled()) {
+		request.header.trace_id = trace::new_id();
+	}
 	if (request_telemetry != nullptr) {
-		ControllerRequestTelemetry* telemetry = new ControllerRequestTelemetry();
-		telemetry->set(request);
-		scheduler->clientInfer(request, [this, telemetry, callback](clientapi::InferenceResponse &response) {
-			telemetry->set(response);
+		ControllerRequestTelemetry telemetry;
+		telemetry.set(request);
+		scheduler->clientInfer(request, [this, telemetry, callback](clientapi::InferenceResponse &response) mutable {
+			telemetry.set(response);
 			callback(response);
-			request_telemetry->log(*telemetry);
-			delete telemetry;
+			request_telemetry->log(telemetry);
+			trace::span(telemetry.trace_id, "controller", telemetry.arrival, telemetry.departure);
 		});
 	} else {
 		scheduler->clientInfer(request, callback);
@@ -2,6 +2,7 @@
 #define _CLOCKWORK_CONTROLLER_CONTROLLER_H_
 
 #include "clockwork/controller/scheduler.h"
+#include "clockwork/controller/profile_cache.h"
 #include "clockwork/network/controller.h"
 #include "clockwork/api/worker_api.h"
 #include "clockwork/telemetry/controller_request_logger.h"
@@ -64,9 +65,17 @@ typedef Request<clientapi::InferenceRequest, clientapi::InferenceResponse> Infer
 typedef Request<clientapi::LoadModelFromRemoteDiskRequest, clientapi::LoadModelFromRemoteDiskResponse> LoadModelRequest;
 typedef Request<clientapi::LSRequest, clientapi::LSResponse> LSRequest;
 
-/* Handles fetching information from workers about currently-loaded models */
+/* Handles fetching information from workers about currently-loaded models.
+
+The first run fetches a full snapshot from each worker.  Subsequent runs on the same
+instance only fetch the events (model added, loaded, evicted) since the last seqno seen
+from that worker; ControllerStartup re-syncs this way once loading completes.  If the
+worker no longer has those events, it sends a snapshot instead; if a delta does not
+directly follow the last seqno seen, the worker is re-queried for a snapshot. */
 class QueryWorkerStage {
 public:
+	ClockworkState state;
+	std::vector<uint64_t> seqnos; // Last seqno applied, per worker; 0 if none
 
 	QueryWorkerStage() {}
 
@@ -74,6 +83,10 @@ public:
 	void populate_gpu_state(GPUState &gpu, workerapi::GPUInfo &info);
 	void populate_worker_state(WorkerState &worker, workerapi::WorkerMemoryInfo &info);
 
+	// Applies a snapshot or delta to the worker's state.  Returns false if a
+	// delta could not be applied because events are missing.
+	bool apply(WorkerState &worker, uint64_t &seqno, workerapi::GetWorkerStateResult &result);
+
 	ClockworkState run(std::vector<network::controller::WorkerConnection*> workers,
 			 		   tbb::concurrent_queue<std::shared_ptr<workerapi::Result>> &worker_results_queue);
 };
@@ -98,19 +111,35 @@ public:
 		void check_completion(ClockworkState &state);
 	};
 
+	/* Sends LoadModelFromDisk actions to a worker, limiting the number outstanding.
+	The limit adapts by hill-climbing on load throughput: every epoch of completions,
+	keep stepping the limit in the same direction while throughput improves, and reverse
+	direction when it drops. */
 	class Worker {
 	public:
+		static const unsigned min_outstanding_limit = 1;
+		static const unsigned max_outstanding_limit = 64;
+		static const unsigned epoch_multiplier = 2; // An epoch is this many times max_outstanding completions
+
 		network::controller::WorkerConnection* worker;
 		std::queue<std::shared_ptr<workerapi::LoadModelFromDisk>> action_queue;
 		unsigned outstanding = 0;
 		unsigned max_outstanding = 4;
 
+		uint64_t epoch_begin = 0;
+		unsigned epoch_completed = 0;
+		double last_throughput = 0;
+		int step = 1;
+
 		Worker(network::controller::WorkerConnection* worker);
 
 		void add_action(std::shared_ptr<workerapi::LoadModelFromDisk> action);
 		void result_received();
 
 		void check();
+
+	private:
+		void adapt();
 	};
 
 	unsigned action_id_seed = 0;
@@ -201,9 +230,12 @@ public:
 
 	unsigned max_batch_size;
 	uint64_t max_exec_duration;
+	ModelProfileCache* profile_cache; // Optional; if set, used to warm-start model profiles
+	startup::QueryWorkerStage query_stage; // Long-lived so that re-syncs only fetch deltas
 
-	ControllerStartup(unsigned max_batch_size = 32, uint64_t max_exec_duration = 1000000000UL)
-		: max_batch_size(max_batch_size), max_exec_duration(max_exec_duration) {}
+	ControllerStartup(unsigned max_batch_size = 32, uint64_t max_exec_duration = 1000000000UL,
+		ModelProfileCache* profile_cache = nullptr)
+		: max_batch_size(max_batch_size), max_exec_duration(max_exec_duration), profile_cache(profile_cache) {}
 
 	void bounceLSRequest(std::shared_ptr<startup::LSRequest> &request);
 	void bounceInferRequest(std::shared_ptr<startup::InferRequest> &request);
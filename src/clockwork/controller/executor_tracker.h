@@ -0,0 +1,140 @@
+#ifndef _CLOCKWORK_CONTROLLER_EXECUTOR_TRACKER_H_
+#define _CLOCKWORK_CONTROLLER_EXECUTOR_TRACKER_H_
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "clockwork/common.h"
+#include "clockwork/telemetry.h"
+
+namespace clockwork {
+
+// Utilization of a GPU's executors, measured by its worker and reported periodically in infer results.
+// Reports are published with a seqlock per task type, so that readers (the stats printer and
+// metrics collection) never block the result path; only concurrent updates serialize.
+class ExecutorTracker {
+public:
+	// Between the two most recent reports
+	struct Interval {
+		double utilization = 0; // fraction of the interval with a task in progress
+		uint64_t idle = 0;
+		uint64_t tasks = 0;
+		uint64_t dropped = 0; // tasks dequeued too late to start
+		uint64_t mean_lateness = 0; // from a task becoming eligible until it was dequeued
+		int64_t queued = 0; // tasks waiting at the most recent report
+	};
+
+private:
+	// One report's totals, read and written field by field under the seqlock
+	struct Totals {
+		std::atomic_uint64_t timestamp{0}, busy{0}, tasks{0}, dropped{0}, lateness{0};
+		std::atomic_int64_t queued{0};
+
+		void store(const ExecutorTelemetry &t) {
+			timestamp.store(t.timestamp, std::memory_order_relaxed);
+			busy.store(t.busy, std::memory_order_relaxed);
+			tasks.store(t.tasks, std::memory_order_relaxed);
+			dropped.store(t.dropped, std::memory_order_relaxed);
+			lateness.store(t.lateness, std::memory_order_relaxed);
+			queued.store(t.queued, std::memory_order_relaxed);
+		}
+		void load(ExecutorTelemetry &t) const {
+			t.timestamp = timestamp.load(std::memory_order_relaxed);
+			t.busy = busy.load(std::memory_order_relaxed);
+			t.tasks = tasks.load(std::memory_order_relaxed);
+			t.dropped = dropped.load(std::memory_order_relaxed);
+			t.lateness = lateness.load(std::memory_order_relaxed);
+			t.queued = queued.load(std::memory_order_relaxed);
+		}
+	};
+
+	// Previous and latest report for one task type; sequence is odd while being written
+	struct Report {
+		std::atomic_uint64_t sequence{0};
+		bool received = false; // only accessed by writers
+		Totals previous, latest;
+	};
+
+	const int gpu_id;
+	std::mutex update_mutex; // serializes writers only
+	std::array<Report, std::tuple_size<decltype(TaskTypes)>::value> reports;
+
+	// Returns false if nothing has been received for task_type
+	bool read(int task_type, ExecutorTelemetry &previous, ExecutorTelemetry &latest) const {
+		if (task_type < 0 || task_type >= (int) reports.size()) return false;
+		const Report &report = reports[task_type];
+		while (true) {
+			uint64_t sequence = report.sequence.load(std::memory_order_acquire);
+			if (sequence & 1) {
+				std::this_thread::yield();
+				continue;
+			}
+			report.previous.load(previous);
+			report.latest.load(latest);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (report.sequence.load(std::memory_order_relaxed) != sequence) continue;
+			if (sequence == 0) return false;
+
+			previous.task_type = latest.task_type = task_type;
+			previous.gpu_id = latest.gpu_id = gpu_id;
+			return true;
+		}
+	}
+
+public:
+	ExecutorTracker(int gpu_id) : gpu_id(gpu_id) {}
+
+	// Telemetry for executors on other GPUs is ignored
+	void update(const std::vector<ExecutorTelemetry> &telemetry) {
+		std::lock_guard<std::mutex> lock(update_mutex);
+		for (auto &t : telemetry) {
+			if (t.gpu_id != gpu_id) continue;
+			if (t.task_type < 0 || t.task_type >= (int) reports.size()) continue;
+
+			Report &report = reports[t.task_type];
+			ExecutorTelemetry latest;
+			report.latest.load(latest);
+			if (report.received && t.timestamp <= latest.timestamp) continue;
+
+			uint64_t sequence = report.sequence.load(std::memory_order_relaxed);
+			report.sequence.store(sequence + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			if (report.received) {
+				report.previous.store(latest);
+			} else {
+				report.previous.store(t);
+				report.received = true;
+			}
+			report.latest.store(t);
+			report.sequence.store(sequence + 2, std::memory_order_release);
+		}
+	}
+
+	// Returns false if fewer than two reports have been received
+	bool interval(int task_type, Interval &interval) const {
+		ExecutorTelemetry previous, latest;
+		if (!read(task_type, previous, latest)) return false;
+		if (latest.timestamp == previous.timestamp) return false;
+
+		interval.utilization = latest.utilization(previous);
+		interval.idle = latest.idle(previous);
+		interval.tasks = latest.tasks - previous.tasks;
+		interval.dropped = latest.dropped - previous.dropped;
+		interval.mean_lateness = interval.tasks == 0 ? 0 : (latest.lateness - previous.lateness) / interval.tasks;
+		interval.queued = latest.queued;
+		return true;
+	}
+
+	// The most recent running totals; returns false if none have been received
+	bool latest(int task_type, ExecutorTelemetry &telemetry) const {
+		ExecutorTelemetry previous;
+		return read(task_type, previous, telemetry);
+	}
+
+};
+
+}
+
+#endif
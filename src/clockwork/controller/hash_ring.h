@@ -0,0 +1,79 @@
+#ifndef _CLOCKWORK_CONTROLLER_HASH_RING_H_
+#define _CLOCKWORK_CONTROLLER_HASH_RING_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace clockwork {
+namespace controller {
+
+/*
+Consistent hashing of keys (e.g. model paths) onto shards.
+
+Each shard is placed on the ring at vnodes pseudo-random points; a key is owned by the shard
+at the first point clockwise of the key's hash.  Adding or removing a shard only moves the
+keys adjacent to its points, and with enough vnodes each shard owns a near-equal share.
+
+The hash is FNV-1a followed by a 64-bit finalizer, so placement is stable across processes
+and builds, unlike std::hash.
+*/
+class HashRing {
+ private:
+	std::vector<std::pair<uint64_t, unsigned>> points; // (hash, shard), sorted by hash
+	unsigned num_shards;
+
+ public:
+	static uint64_t hash(const std::string &key) {
+		uint64_t h = 14695981039346656037UL;
+		for (unsigned char c : key) {
+			h ^= c;
+			h *= 1099511628211UL;
+		}
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdUL;
+		h ^= h >> 33;
+		h *= 0xc4ceb9fe1a85ec53UL;
+		h ^= h >> 33;
+		return h;
+	}
+
+	HashRing(unsigned num_shards, unsigned vnodes = 128) : num_shards(num_shards) {
+		for (unsigned shard = 0; shard < num_shards; shard++) {
+			for (unsigned i = 0; i < vnodes; i++) {
+				points.push_back({hash("shard-" + std::to_string(shard) + "-" + std::to_string(i)), shard});
+			}
+		}
+		std::sort(points.begin(), points.end());
+	}
+
+	unsigned size() { return num_shards; }
+
+	// The shard owning key
+	unsigned owner(const std::string &key) {
+		return owners(key, 1)[0];
+	}
+
+	// Up to n distinct shards for key, in ring order starting with its owner
+	std::vector<unsigned> owners(const std::string &key, unsigned n) {
+		n = std::min(n, num_shards);
+		std::vector<unsigned> result;
+		if (n == 0) return result;
+
+		auto it = std::lower_bound(points.begin(), points.end(), std::make_pair(hash(key), 0U));
+		for (unsigned i = 0; i < points.size() && result.size() < n; i++, it++) {
+			if (it == points.end()) it = points.begin();
+			if (std::find(result.begin(), result.end(), it->second) == result.end()) {
+				result.push_back(it->second);
+			}
+		}
+		return result;
+	}
+};
+
+}
+}
+
+#endif
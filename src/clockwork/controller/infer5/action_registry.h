@@ -0,0 +1,144 @@
+// Copyright 2020 Max Planck Institute for Software Systems
+
+#ifndef SRC_CLOCKWORK_CONTROLLER_INFER5_ACTION_REGISTRY_H_
+#define SRC_CLOCKWORK_CONTROLLER_INFER5_ACTION_REGISTRY_H_
+
+#include <atomic>
+#include <iostream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <dmlc/logging.h>
+#include "tbb/spin_mutex.h"
+
+namespace clockwork {
+namespace scheduler {
+namespace infer5 {
+
+/*
+A fixed-capacity registry of in-flight actions, indexed by action id.
+
+Action ids are handed out sequentially by the scheduler, so id % capacity spreads
+consecutive actions over consecutive slots.  Each slot carries a tag that is either
+empty, busy (transiently, while a thread is writing or reading the value), or the
+full action id of the occupant.  The full id acts as a generation counter: a result
+for an action only matches the slot if the tag equals its own id, never a later
+action that happens to share the slot.
+
+insert, owner and take are lock-free; the only contention is between the single
+inserter and single taker of the same action.  Capacity should exceed the number of
+concurrently outstanding actions.  An action whose slot is still occupied, e.g. by an
+action whose result was never delivered, goes into a locked overflow map instead; lookups
+only take the lock while the overflow map is non-empty.
+*/
+template <typename T> class ActionRegistry {
+ private:
+    static const uint64_t empty = 0;
+    static const uint64_t busy = 1;
+    static uint64_t tag_for(uint64_t action_id) { return action_id + 2; }
+
+    struct Slot {
+        std::atomic_uint64_t tag;
+        unsigned owner;
+        T value;
+        Slot() : tag(empty), owner(0) {}
+    };
+
+    const uint64_t mask;
+    std::vector<Slot> slots;
+
+    tbb::spin_mutex overflow_mutex;
+    std::unordered_map<uint64_t, std::pair<unsigned, T>> overflow;
+    std::atomic_uint64_t overflow_size;
+    std::atomic_uint64_t overflowed; // total actions ever put in the overflow map
+
+ public:
+
+    // Capacity is rounded up to a power of two
+    ActionRegistry(uint64_t capacity = 65536) : 
+        mask(round_up(capacity) - 1), slots(mask + 1), overflow_size(0), overflowed(0) {}
+
+    uint64_t capacity() const { return mask + 1; }
+
+    // Number of actions currently in the overflow map
+    uint64_t overflow_count() const { return overflow_size.load(); }
+
+    // Register an action; owner is an arbitrary tag (e.g. GPU index) recoverable via owner()
+    void insert(uint64_t action_id, unsigned owner, T value) {
+        Slot &slot = slots[action_id & mask];
+
+        uint64_t expected = empty;
+        if (!slot.tag.compare_exchange_strong(expected, busy, std::memory_order_acquire)) {
+            {
+                tbb::spin_mutex::scoped_lock lock(overflow_mutex);
+                overflow[action_id] = std::make_pair(owner, std::move(value));
+                overflow_size++;
+            }
+
+            // Log the 1st, 2nd, 4th, 8th, ... overflow
+            uint64_t count = ++overflowed;
+            if ((count & (count - 1)) == 0) {
+                std::cout << "ActionRegistry slot for action " << action_id << " still occupied"
+                          << " (" << count << " overflowed so far); is a result missing?" << std::endl;
+            }
+            return;
+        }
+
+        slot.owner = owner;
+        slot.value = std::move(value);
+        slot.tag.store(tag_for(action_id), std::memory_order_release);
+    }
+
+    // Look up the owner of a registered action without removing it
+    bool owner(uint64_t action_id, unsigned &owner) {
+        Slot &slot = slots[action_id & mask];
+        if (slot.tag.load(std::memory_order_acquire) == tag_for(action_id)) {
+            owner = slot.owner;
+            return true;
+        }
+
+        if (overflow_size.load() == 0) return false;
+        tbb::spin_mutex::scoped_lock lock(overflow_mutex);
+        auto it = overflow.find(action_id);
+        if (it == overflow.end()) return false;
+        owner = it->second.first;
+        return true;
+    }
+
+    // Remove a registered action, returning its value.  Returns false if not present.
+    bool take(uint64_t action_id, T &value) {
+        Slot &slot = slots[action_id & mask];
+
+        uint64_t expected = tag_for(action_id);
+        if (!slot.tag.compare_exchange_strong(expected, busy, std::memory_order_acquire)) {
+            if (overflow_size.load() == 0) return false;
+            tbb::spin_mutex::scoped_lock lock(overflow_mutex);
+            auto it = overflow.find(action_id);
+            if (it == overflow.end()) return false;
+            value = std::move(it->second.second);
+            overflow.erase(it);
+            overflow_size--;
+            return true;
+        }
+
+        value = std::move(slot.value);
+        slot.value = T();
+        slot.tag.store(empty, std::memory_order_release);
+        return true;
+    }
+
+ private:
+
+    static uint64_t round_up(uint64_t capacity) {
+        uint64_t size = 1;
+        while (size < capacity) size <<= 1;
+        return size;
+    }
+
+};
+
+}
+}
+}
+
+#endif // SRC_CLOCKWORK_CONTROLLER_INFER5_ACTION_REGISTRY_H_
@@ -0,0 +1,107 @@
+#include "clockwork/controller/infer5/arrival_forecaster.h"
+#include <algorithm>
+#include <cmath>
+#include "dmlc/logging.h"
+
+namespace clockwork {
+namespace scheduler {
+namespace infer5 {
+
+ArrivalForecaster::ArrivalForecaster(unsigned num_models, uint64_t bucket_duration, uint64_t now) :
+        bucket_duration(bucket_duration),
+        models(num_models),
+        bucket_end(now + bucket_duration) {
+    CHECK(bucket_duration > 0) << "ArrivalForecaster requires a positive bucket duration";
+}
+
+bool ArrivalForecaster::refresh(uint64_t now) {
+    if (now < bucket_end) return false;
+
+    // Buckets that elapsed while we weren't looking had no arrivals
+    while (bucket_end <= now) {
+        for (unsigned i = 0; i < models.size(); i++) {
+            close(i, models[i]);
+        }
+        bucket_end += bucket_duration;
+        buckets++;
+    }
+    return true;
+}
+
+void ArrivalForecaster::close(unsigned model_id, Model &model) {
+    double arrivals = model.current.exchange(0, std::memory_order_relaxed);
+
+    if (model.history.size() < max_history) {
+        model.history.push_back(arrivals);
+    } else {
+        model.history[model.count % max_history] = arrivals;
+    }
+    model.count++;
+
+    model.ewma = model.count == 1 ? arrivals : alpha * arrivals + (1 - alpha) * model.ewma;
+
+    if ((model.count + model_id) % detect_every == 0) {
+        // Oldest to newest
+        std::vector<double> series(model.history.size());
+        for (unsigned i = 0; i < series.size(); i++) {
+            series[i] = model.history[(model.count - series.size() + i) % max_history];
+        }
+        model.period = detect_period(series);
+    }
+
+    model.forecast = model.ewma;
+    if (model.period > 0 && model.period <= model.history.size()) {
+        // The bucket one period before the next one
+        double seasonal = model.history[(model.count - model.period) % max_history];
+        model.forecast = seasonal_weight * seasonal + (1 - seasonal_weight) * model.ewma;
+    }
+}
+
+std::vector<int64_t> ArrivalForecaster::forecasts() {
+    std::vector<int64_t> result(models.size());
+    for (unsigned i = 0; i < models.size(); i++) {
+        result[i] = std::llround(models[i].forecast);
+    }
+    return result;
+}
+
+unsigned ArrivalForecaster::detect_period(const std::vector<double> &series) {
+    unsigned n = series.size();
+    if (n < 2 * min_period) return 0;
+
+    double mean = 0;
+    for (double x : series) mean += x;
+    mean /= n;
+
+    double variance = 0;
+    for (double x : series) variance += (x - mean) * (x - mean);
+    if (variance == 0) return 0;
+
+    unsigned longest = std::min(n / 2, max_period);
+    std::vector<double> correlations(longest + 1, 0);
+    double best_correlation = min_correlation;
+    for (unsigned lag = min_period; lag <= longest; lag++) {
+        double covariance = 0;
+        for (unsigned i = lag; i < n; i++) {
+            covariance += (series[i] - mean) * (series[i - lag] - mean);
+        }
+
+        // Normalize by the number of terms so that long lags aren't penalized
+        correlations[lag] = (covariance / (n - lag)) / (variance / n);
+        best_correlation = std::max(best_correlation, correlations[lag]);
+    }
+
+    // Multiples of the period correlate almost as well as the period itself
+    unsigned best_lag = 0;
+    for (unsigned lag = min_period; lag <= longest; lag++) {
+        if (correlations[lag] >= min_correlation && correlations[lag] >= 0.9 * best_correlation) {
+            best_lag = lag;
+            break;
+        }
+    }
+    return best_lag;
+}
+
+}
+}
+}
@@ -0,0 +1,83 @@
+#ifndef _CLOCKWORK_CONTROLLER_INFER5_ARRIVAL_FORECASTER_H_
+#define _CLOCKWORK_CONTROLLER_INFER5_ARRIVAL_FORECASTER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace clockwork {
+namespace scheduler {
+namespace infer5 {
+
+/*
+Forecasts the number of requests each model will receive in the next interval.
+
+Arrivals are counted into fixed-length buckets (by default one minute, the granularity of
+the Azure functions traces).  When a bucket closes, each model's forecast is an EWMA of its
+bucket counts, blended with the count one period ago if the model's demand is periodic.
+The period is the shortest lag up to max_period whose autocorrelation over the retained
+history is within 10% of the highest, provided it is at least min_correlation.  Detection
+costs O(max_period * max_history), so each model redetects only every detect_every buckets,
+staggered across models.
+
+arrived() may be called concurrently; refresh() and forecast() are called by one thread.
+*/
+class ArrivalForecaster {
+ public:
+    static const unsigned max_history = 1440; // buckets retained for period detection
+    static const unsigned min_period = 2;
+    static const unsigned max_period = 120; // longest candidate period, in buckets
+    static const unsigned detect_every = 60; // buckets between period detection
+    static constexpr double alpha = 0.3; // EWMA smoothing factor
+    static constexpr double seasonal_weight = 0.75; // weight of the periodic forecast vs. the EWMA
+    static constexpr double min_correlation = 0.5;
+
+    const uint64_t bucket_duration;
+
+ private:
+    struct Model {
+        std::atomic_uint64_t current; // arrivals in the open bucket
+        std::vector<double> history; // ring buffer of closed bucket counts
+        uint64_t count = 0; // number of closed buckets
+        double ewma = 0;
+        unsigned period = 0; // 0 if not periodic
+        double forecast = 0;
+
+        Model() : current(0) {}
+    };
+
+    std::vector<Model> models;
+    uint64_t bucket_end;
+    uint64_t buckets = 0;
+
+    void close(unsigned model_id, Model &model);
+
+ public:
+    ArrivalForecaster(unsigned num_models, uint64_t bucket_duration, uint64_t now);
+
+    void arrived(unsigned model_id) {
+        models[model_id].current.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Closes the open bucket if it has elapsed.  Returns true if forecasts were updated
+    bool refresh(uint64_t now);
+
+    // Expected arrivals in the next bucket
+    double forecast(unsigned model_id) { return models[model_id].forecast; }
+
+    // Forecasts of all models, rounded to whole requests
+    std::vector<int64_t> forecasts();
+
+    // Detected period in buckets, or 0
+    unsigned period(unsigned model_id) { return models[model_id].period; }
+
+    // Shortest lag in [min_period, min(max_period, series.size()/2)] with near-highest
+    // autocorrelation of at least min_correlation, or 0 if there is none
+    static unsigned detect_period(const std::vector<double> &series);
+};
+
+}
+}
+}
+
+#endif // _CLOCKWORK_CONTROLLER_INFER5_ARRIVAL_FORECASTER_H_
@@ -0,0 +1,84 @@
+// Copyright 2020 Max Planck Institute for Software Systems
+
+#ifndef SRC_CLOCKWORK_CONTROLLER_INFER5_BATCH_PLANNER_H_
+#define SRC_CLOCKWORK_CONTROLLER_INFER5_BATCH_PLANNER_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace clockwork {
+namespace scheduler {
+namespace infer5 {
+
+struct BatchPlan {
+    enum Choice { none, split, pad, wait };
+
+    Choice choice = none;
+    unsigned index = 0; // Index of the batch size to execute (or wait for)
+    unsigned count = 0; // Number of requests to take from that batch size's cursor
+};
+
+/*
+Chooses how to batch a model's queued requests, given for each supported batch size its exec
+estimate, the number of requests that would meet their deadline at that batch size, and how
+long that batch size could be delayed before its first request would miss its deadline.
+
+Let k be the largest batch size that can be filled.  The options are:
+  split: run a full batch of size k now; the remaining requests are batched later, on
+         whichever GPU gets to them first
+  pad:   run all the requests as one batch of the next size up, which the worker pads
+  wait:  wait for more requests to fill the next size up
+
+Padding is only chosen if it serves more requests per unit of exec time than the split,
+and only if every request the split could serve would also meet its deadline in the padded
+batch.  Waiting is only chosen if, at the model's recent interarrival time, the larger batch
+is expected to fill within max_wait and before its first request's slack runs out, and if the
+full batch would be more efficient still.
+*/
+inline BatchPlan plan_batch(const std::vector<unsigned> &batch_sizes,
+                            const std::vector<uint64_t> &estimates,
+                            const std::vector<unsigned> &available,
+                            const std::vector<uint64_t> &slack,
+                            uint64_t interarrival,
+                            uint64_t max_wait) {
+    BatchPlan plan;
+
+    unsigned k = 0;
+    while (k < batch_sizes.size() - 1 && available[k+1] >= batch_sizes[k+1]) {
+        k++;
+    }
+    if (available[k] < batch_sizes[k]) return plan;
+
+    plan.choice = BatchPlan::split;
+    plan.index = k;
+    plan.count = batch_sizes[k];
+
+    unsigned j = k + 1;
+    if (j == batch_sizes.size()) return plan;
+
+    // Requests that would miss their deadline in the larger batch are dropped by running it
+    if (available[j] != available[k]) return plan;
+
+    unsigned count = available[j];
+    if (estimates[j] * batch_sizes[k] < estimates[k] * count) {
+        plan.choice = BatchPlan::pad;
+        plan.index = j;
+        plan.count = count;
+    }
+
+    uint64_t fill_time = (batch_sizes[j] - count) * interarrival;
+    if (interarrival > 0 && fill_time <= max_wait && fill_time <= slack[j] &&
+            estimates[j] * plan.count < estimates[plan.index] * batch_sizes[j]) {
+        plan.choice = BatchPlan::wait;
+        plan.index = j;
+        plan.count = batch_sizes[j];
+    }
+
+    return plan;
+}
+
+}
+}
+}
+
+#endif // SRC_CLOCKWORK_CONTROLLER_INFER5_BATCH_PLANNER_H_
@@ -1,4 +1,6 @@
 #include "clockwork/controller/infer5/infer5_scheduler.h"
+#include <fstream>
+#include <unordered_map>
 #include <vector>
 
 namespace clockwork {
@@ -12,16 +14,33 @@ Scheduler::Scheduler(uint64_t default_slo, uint64_t latest_delta,
                      uint64_t schedule_ahead, 
                      bool generate_inputs, int max_gpus,
                      uint64_t max_allowable_exec_time, unsigned max_batch_size,
-                     std::string actions_filename)
+                     std::string actions_filename,
+                     unsigned num_admission_threads,
+                     ModelProfileCache* profile_cache,
+                     std::string tenants_spec,
+                     uint64_t forecast_interval,
+                     double hedge_budget,
+                     bool early_rejection,
+                     std::string tuning_filename,
+                     size_t result_cache_bytes,
+                     uint64_t result_cache_ttl,
+                     SchedulingPolicy* policy)
     : default_slo(default_slo),
+      generate_inputs(generate_inputs),
+      max_gpus(max_gpus),
+      num_admission_threads(num_admission_threads),
+      forecast_interval(forecast_interval),
+      hedge_budget(hedge_budget),
+      early_rejection(early_rejection),
+      tuning_filename(tuning_filename),
       latest_delta(latest_delta),
       schedule_ahead(schedule_ahead),
       max_allowable_exec_time(max_allowable_exec_time),
       max_batch_size(max_batch_size),
-      generate_inputs(generate_inputs),
-      max_gpus(max_gpus),
       actions_filename(actions_filename),
-      has_logged_inputs_status(ATOMIC_FLAG_INIT) {
+      callbacks(max_outstanding_actions),
+      has_logged_inputs_status(ATOMIC_FLAG_INIT),
+      profile_cache(profile_cache) {
     std::cout << "ConcurrentInferAndLoadScheduler using:" << std::endl;
     std::cout << "\t default_slo=" << default_slo << std::endl;
     std::cout << "\t latest_delta=" << latest_delta << std::endl;
@@ -30,10 +49,36 @@ Scheduler::Scheduler(uint64_t default_slo, uint64_t latest_delta,
     std::cout << "\t max_batch_size=" << max_batch_size << std::endl;
     std::cout << "\t generate_inputs=" << generate_inputs << std::endl;
     std::cout << "\t max_gpus=" << max_gpus << std::endl;
+    std::cout << "\t num_admission_threads=" << num_admission_threads << std::endl;
+    std::cout << "\t tenants=" << tenants_spec << std::endl;
+    std::cout << "\t forecast_interval=" << forecast_interval << std::endl;
+    std::cout << "\t hedge_budget=" << hedge_budget << std::endl;
+    std::cout << "\t early_rejection=" << early_rejection << std::endl;
+    std::cout << "\t tuning_filename=" << tuning_filename << std::endl;
+    std::cout << "\t result_cache_bytes=" << result_cache_bytes << std::endl;
+    std::cout << "\t result_cache_ttl=" << result_cache_ttl << std::endl;
+
+    CHECK(num_admission_threads > 0) << "Need at least one admission thread";
+    for (unsigned i = 0; i < num_admission_threads; i++) {
+        admission_queues.push_back(new tbb::concurrent_queue<Request>());
+    }
+
+    // Tenants are penalized by at most the default SLO
+    tenants = new TenantTracker(default_slo);
+    tenants->configure(tenants_spec);
 
     if (generate_inputs) {
         input_generator = new util::InputGenerator();
     }
+
+    if (result_cache_bytes > 0) {
+        result_cache = new ResultCache(result_cache_bytes, result_cache_ttl);
+    }
+
+    if (policy == nullptr) {
+        policy = new DeadlinePolicy(forecast_interval > 0, max_batch_wait);
+    }
+    this->policy = policy;
 }
 
 Scheduler::RequestImpl::RequestImpl(
@@ -44,7 +89,9 @@ Scheduler::RequestImpl::RequestImpl(
         request(request), 
         callback(callback),
         locked(false),
-        response_sent(ATOMIC_FLAG_INIT) {
+        response_sent(ATOMIC_FLAG_INIT),
+        attempts(0),
+        claimed(false) {
     // Set the response header fields now
     response.header.user_request_id = request.header.user_request_id;
     response.header.message = "";
@@ -63,6 +110,12 @@ void Scheduler::RequestImpl::lock() {
     locked = true;
 }
 
+bool Scheduler::RequestImpl::claim(bool success) {
+    // Errors defer to other outstanding actions, which may yet succeed
+    if (--attempts > 0 && !success) return false;
+    return !claimed.exchange(true);
+}
+
 void Scheduler::RequestImpl::set_model(Model* model) {
     this->model = model;
     response.arrival_count = model->copies_loaded;
@@ -107,7 +160,9 @@ bool Scheduler::RequestImpl::complete(uint64_t now, int gpu_id) {
 
     callback(response);
 
-    return response.header.status == clockworkSuccess && response.departure <= response.deadline;
+    bool success = response.header.status == clockworkSuccess && response.departure <= response.deadline;
+    record_outcome(success);
+    return success;
 }
 
 void Scheduler::RequestImpl::timeout() {
@@ -124,6 +179,7 @@ void Scheduler::RequestImpl::timeout() {
     response.departure_count = model->copies_loaded;
 
     callback(response);
+    record_outcome(false);
 
     model->tracker->cancelled(demand);
     model->invalidate_tracker();
@@ -133,6 +189,21 @@ void Scheduler::RequestImpl::finalize() {
     timeout();
 }
 
+void Scheduler::RequestImpl::record_outcome(bool met_deadline) {
+    if (met_deadline) scheduler->slo_met++;
+    else scheduler->slo_missed++;
+
+    if (predicted_completion == 0) return;
+
+    if (predicted_completion > deadline) {
+        if (met_deadline) scheduler->predicted_miss_met++;
+        else scheduler->predicted_miss_missed++;
+    } else {
+        if (met_deadline) scheduler->predicted_met_met++;
+        else scheduler->predicted_met_missed++;
+    }
+}
+
 unsigned Scheduler::Model::batch_lookup(unsigned num_requests) {
     return num_requests > max_batch_size ? max_batch_size : batch_lookup_[num_requests];
 }
@@ -144,7 +215,9 @@ unsigned Scheduler::Model::index_lookup(unsigned batch_size) {
 Scheduler::Model::Model(Scheduler* scheduler, BatchedModelState &state)
     : scheduler(scheduler),
       id(state.id), 
+      model_path(state.model_path),
       num_weights_pages(state.num_weights_pages),
+      weights_size(state.weights_size),
       input_size(state.input_size),
       output_size(state.output_size),
       stale(ATOMIC_FLAG_INIT) {
@@ -169,7 +242,6 @@ Scheduler::Model::Model(Scheduler* scheduler, BatchedModelState &state)
             estimates[batch_size] = estimate * Scheduler::default_clock;
             estimators[batch_size] = new SlidingWindow(Scheduler::estimate_window_size);
             supported_batch_sizes.push_back(batch_size);
-            queues.push_back(new ModelQueue(batch_size));
         } else {
             std::cout << "Excluding b" << batch_size << " with estimate " << estimate << "model=" << state.model_path << std::endl;
         }
@@ -179,6 +251,8 @@ Scheduler::Model::Model(Scheduler* scheduler, BatchedModelState &state)
     weights_estimator = new SlidingWindow(Scheduler::estimate_window_size);
     weights_estimate = state.weights_transfer_duration;
 
+    requests = new RequestLog<Request>(supported_batch_sizes.size());
+
     batch_lookup_ = util::make_batch_lookup(supported_batch_sizes);
     index_lookup_ = util::make_reverse_batch_lookup(supported_batch_sizes);
     max_batch_size = batch_lookup_.size() - 1;
@@ -188,6 +262,7 @@ Scheduler::Model::Model(Scheduler* scheduler, BatchedModelState &state)
 
 void Scheduler::Model::enqueue(Request request) {
     request->id = request_id_seed_++;
+    last_user_id = request->request.header.user_id;
     incoming_requests.push(request);
     requests_queued++;
 
@@ -199,10 +274,14 @@ void Scheduler::Model::enqueue(Request request) {
 void Scheduler::Model::pull_incoming_requests() {
     Request request;
     while (incoming_requests.try_pop(request)) {
-        request->seqno = seqno_seed++;
-        for (auto &queue : queues) {
-            queue->push(request);
+        request->seqno = requests->push(request, request->deadline);
+
+        uint64_t arrival = request->request.arrival;
+        if (last_arrival > 0 && arrival > last_arrival) {
+            uint64_t delta = arrival - last_arrival;
+            interarrival = interarrival == 0 ? delta : (7 * interarrival + delta) / 8;
         }
+        last_arrival = std::max(last_arrival, arrival);
     }
 }
 
@@ -212,21 +291,28 @@ std::vector<Scheduler::StrategyImpl> Scheduler::Model::new_strategies(int gpu_id
     pull_incoming_requests();
 
     std::vector<StrategyImpl> strategies;
-    for (int i = queues.size()-1; i >= 0; i--) {
-        auto &queue = queues[i];
-
-        if (queue->size() == 0) continue;
-        if (queue->batchsize > max_batchsize) continue;
+    for (int i = supported_batch_sizes.size()-1; i >= 0; i--) {
+        int batchsize = supported_batch_sizes[i];
+
+        if (requests->size(i) == 0) continue;
+        if (batchsize > max_batchsize) continue;
+        if (batchsize > 1 && (batchsize > scheduler->max_batch_size ||
+                              estimate(batchsize, gpu_clock) > scheduler->max_allowable_exec_time)) continue;
+
+        // Tenants that have had more than their fair share are deprioritized
+        SchedulingPolicy::InferOption option;
+        option.model_id = id;
+        option.batch_size = batchsize;
+        option.deadline = requests->front_deadline(i);
+        option.exec_time = estimate(batchsize);
+        option.user_id = requests->front(i)->request.header.user_id;
+        option.tenant_penalty = scheduler->tenants->penalty(option.user_id);
 
         StrategyImpl strategy;
-        strategy.priority = queue->front()->deadline - estimate(queue->batchsize);
-        strategy.batch_size = queue->batchsize;
+        strategy.priority = scheduler->policy->infer_priority(option);
+        strategy.batch_size = batchsize;
         strategy.instance = instances[gpu_id];
         strategies.push_back(strategy);
-
-        // if (queues[i]->has_demand()) {
-        //     break;
-        // }
     }
 
     return strategies;
@@ -235,62 +321,92 @@ std::vector<Scheduler::StrategyImpl> Scheduler::Model::new_strategies(int gpu_id
 Scheduler::InferAction* Scheduler::Model::try_dequeue(
         uint64_t free_at,
         unsigned gpu_clock,
-        int min_batchsize)
+        int min_batchsize,
+        bool &wait)
 {   
-    // Drain all requests from all queues that wouldn't be satisfiable
+    // Drop requests that wouldn't be satisfiable from each batchsize's view of the log
+    // Choose between a full batch, a padded batch, or waiting for more requests
     // If specified batchsize is not achievable, return
-    // Use maximum possible batch size
-    // Drain requests from all queues to catch up to id of drained req
+    // Catch up all batchsizes to the id of the last dequeued request
     // TODO: properly maintain requests_queued counter
     tbb::queuing_mutex::scoped_lock lock(mutex);
 
-    // Drain incoming requests to batchsize queues
+    // Drain incoming requests to the log
     pull_incoming_requests();
 
-    uint64_t size_before = queues[0]->size();
-
-    // Drop requests from batchsize queues that won't complete in time
-    for (auto &queue : queues) {
-        uint64_t exec_time = estimate(queue->batchsize, gpu_clock);
-        uint64_t completion_time = free_at + exec_time;
-
-        while (queue->size() > 0 && queue->front()->deadline < completion_time) {
-            queue->pop();
+    uint64_t size_before = requests->size(0);
+
+    // Drop requests that won't complete in time; larger batches take longer so drop more
+    uint64_t start = std::max(free_at, util::now());
+    unsigned n = supported_batch_sizes.size();
+    std::vector<uint64_t> exec_times(n);
+    std::vector<unsigned> available(n);
+    std::vector<uint64_t> slack(n, 0);
+    for (unsigned i = 0; i < n; i++) {
+        exec_times[i] = estimate(supported_batch_sizes[i], gpu_clock);
+        requests->drop_expired(i, free_at + exec_times[i]);
+        available[i] = requests->size(i);
+        if (available[i] > 0 && requests->front_deadline(i) > start + exec_times[i]) {
+            slack[i] = requests->front_deadline(i) - (start + exec_times[i]);
         }
     }
 
-    // Find the appropriate queue
-    int i = 0;
-    while (i < queues.size()-1 && queues[i+1]->has_demand()) {
-        i++;
+    // Only use the batch sizes within the scheduler's current limits
+    unsigned usable = n;
+    while (usable > 1 && (supported_batch_sizes[usable-1] > scheduler->max_batch_size ||
+                          exec_times[usable-1] > scheduler->max_allowable_exec_time)) {
+        usable--;
+    }
+
+    SchedulingPolicy::BatchOptions options;
+    options.batch_sizes.assign(supported_batch_sizes.begin(), supported_batch_sizes.begin() + usable);
+    options.exec_times.assign(exec_times.begin(), exec_times.begin() + usable);
+    options.available.assign(available.begin(), available.begin() + usable);
+    options.slack.assign(slack.begin(), slack.begin() + usable);
+    options.interarrival = interarrival;
+    BatchPlan plan = scheduler->policy->plan(options);
+    CHECK(plan.choice == BatchPlan::none || plan.index < usable) << "Policy chose an unusable batch size";
+
+    if (plan.choice == BatchPlan::wait) {
+        if (!waiting) scheduler->batch_waits++;
+        waiting = true;
+        wait = true;
+        requests->trim();
+        return nullptr;
     }
 
     // Not enough requests available at the requested batchsize
-    auto &queue = queues[i];
-    if (queue->batchsize < min_batchsize) return nullptr;
-    if (!queue->has_demand()) return nullptr;
+    int batchsize = supported_batch_sizes[plan.index];
+    if (plan.choice == BatchPlan::none || batchsize < min_batchsize) {
+        requests->trim();
+        return nullptr;
+    }
+    waiting = false;
+
+    if (plan.choice == BatchPlan::pad) {
+        scheduler->batches_padded++;
+        scheduler->padding_waste += (exec_times[plan.index] * (batchsize - plan.count)) / batchsize;
+    } else if (available[plan.index] > plan.count) {
+        scheduler->batches_split++;
+    }
+    scheduler->batched_exec += exec_times[plan.index];
 
     // Create the action
-    uint64_t seqno;
     auto action = new InferAction(scheduler, this);
-    for (unsigned i = 0; i < queue->batchsize; i++) {
-        auto &request = queue->front();
+    uint64_t seqno = requests->take(plan.index, plan.count, action->requests);
+    for (auto &request : action->requests) {
         request->lock();
-        action->requests.push_back(request);
-        seqno = request->seqno;
-        queue->pop();
+        request->attempt();
     }
-    action->set_expectations(free_at, estimate(queue->batchsize, gpu_clock), gpu_clock);
+    action->padded_batch_size = batchsize;
+    action->set_expectations(free_at, exec_times[plan.index], gpu_clock);
     action->batch();
 
-    // Catch up the queues
-    for (auto &queue : queues) {
-        while (queue->size() > 0 && queue->front()->seqno <= seqno) {
-            queue->pop();
-        }
-    }
+    // Catch up the other batchsizes and release requests no batchsize can use
+    requests->catch_up(seqno);
+    requests->trim();
 
-    uint64_t size_after = queues[0]->size();
+    uint64_t size_after = requests->size(0);
     requests_queued -= (size_before - size_after);
 
     return action;
@@ -325,10 +441,53 @@ uint64_t Scheduler::Model::estimate(unsigned batch_size, int clock) {
     return estimates[effective_batch_size] / clock;
 }
 
+unsigned Scheduler::Model::padded_batch_size(unsigned num_requests) {
+    for (auto &batch_size : supported_batch_sizes) {
+        if (batch_size >= num_requests) return batch_size;
+    }
+    return supported_batch_sizes.back();
+}
+
+uint64_t Scheduler::Model::predict_completion(uint64_t now) {
+    // The earliest a GPU with the model loaded can start new work
+    uint64_t horizon = UINT64_MAX;
+    for (auto &instance : instances) {
+        if (instance->loaded) {
+            horizon = std::min(horizon, instance->gpu->exec_horizon.load());
+        }
+    }
+    if (horizon == UINT64_MAX) return 0;
+    horizon = std::max(horizon, now);
+
+    // Queued requests, and this one, are shared across the loaded copies in the largest batches
+    unsigned copies = std::max(1, copies_loaded.load());
+    unsigned queued = std::max(0, requests_queued.load()) + 1;
+    unsigned per_copy = (queued + copies - 1) / copies;
+    unsigned full_batches = (per_copy - 1) / max_batch_size;
+    unsigned last_batch = per_copy - full_batches * max_batch_size;
+
+    return horizon + full_batches * estimate(max_batch_size) + estimate(padded_batch_size(last_batch));
+}
+
 uint64_t Scheduler::Model::estimate_weights() {
     return weights_estimate;
 }
 
+void Scheduler::Model::measured_estimates(std::map<unsigned, uint64_t> &exec_duration, 
+                                          uint64_t &weights_transfer_duration) {
+    {
+        tbb::queuing_mutex::scoped_lock lock(estimates_mutex);
+        for (auto &p : estimators) {
+            if (p.second->get_size() > 0) {
+                exec_duration[p.first] = estimates[p.first] / Scheduler::default_clock;
+            }
+        }
+    }
+
+    tbb::queuing_mutex::scoped_lock lock(weights_estimate_mutex);
+    weights_transfer_duration = weights_estimator->get_size() > 0 ? weights_estimate : 0;
+}
+
 Scheduler::InferAction::InferAction(Scheduler* scheduler, Model* model) : scheduler(scheduler), model(model) {
     action->id = action_id_seed++;
     action->model_id = model->id;
@@ -374,11 +533,19 @@ void Scheduler::InferAction::batch() {
 
     action->input = new char[action->input_size];
     size_t offset = 0;
+    telemetry.sample_hash = UINT64_MAX;
     for (auto &req : requests) {
         auto &r = req->request;
         std::memcpy(action->input + offset, r.input, r.input_size);
         offset += r.input_size;
         action->input_sizes.push_back(r.input_size);
+        if (r.header.trace_id != 0) {
+            action->trace_ids.push_back(r.header.trace_id);
+        }
+
+        // The action is logged if any of its requests is
+        uint64_t hash = sampling::hash(sampling::request_key(r.header.user_id, r.header.user_request_id));
+        telemetry.sample_hash = std::min(telemetry.sample_hash, hash);
     }
 }
 
@@ -386,19 +553,27 @@ void Scheduler::InferAction::unbatch() {
     size_t single_output_size = result->output_size / requests.size();
     if (generated_inputs) single_output_size = 0;
     size_t offset = 0;
+    claimed.resize(requests.size());
     for (unsigned i = 0; i < requests.size(); i++) {
-        char* output = new char[single_output_size];
-        std::memcpy(output, result->output + offset, single_output_size);
+        // A hedge may already have responded
+        claimed[i] = requests[i]->claim(true);
+        if (claimed[i]) {
+            char* output = new char[single_output_size];
+            std::memcpy(output, result->output + offset, single_output_size);
+            requests[i]->set_result(output, single_output_size);
+        }
         offset += single_output_size;
-
-        requests[i]->set_result(output, single_output_size);
     }
 }
 
 void Scheduler::InferAction::set_error(std::shared_ptr<workerapi::ErrorResult> &error) {
     this->error = error;
-    for (auto &request : requests) {
-        request->set_error(error->status, error->message);
+    claimed.resize(requests.size());
+    for (unsigned i = 0; i < requests.size(); i++) {
+        claimed[i] = requests[i]->claim(false);
+        if (claimed[i]) {
+            requests[i]->set_error(error->status, error->message);
+        }
     }
 }
 
@@ -410,20 +585,32 @@ void Scheduler::InferAction::set_result(std::shared_ptr<workerapi::InferResult>
 float Scheduler::InferAction::complete(uint64_t now, int gpu_id) {
     float successful_requests = 0;
     float total_requests = 0;
-    for (auto &request : requests) {
+    for (unsigned i = 0; i < requests.size(); i++) {
+        total_requests += 1;
+        if (!claimed[i]) continue; // Another action provided the response
+
+        auto &request = requests[i];
         if (request->complete(now, gpu_id)) {
             successful_requests += 1;
+            if (hedge) scheduler->hedge_wins++;
         }
 
         model->tracker->completed(request->demand, gpu_id);
         model->invalidate_tracker();
-
-        total_requests += 1;
     }
 
     return successful_requests / total_requests;
 }
 
+void Scheduler::InferAction::trace() {
+    if (!trace::enabled()) return;
+    for (auto &request : requests) {
+        uint64_t trace_id = request->request.header.trace_id;
+        trace::span(trace_id, "scheduled", request->request.arrival, telemetry.action_sent, action->id);
+        trace::span(trace_id, hedge ? "hedged infer" : "infer", telemetry.action_sent, telemetry.result_received, action->id);
+    }
+}
+
 void Scheduler::InferAction::set_expectations(uint64_t exec_start, uint64_t duration, int clock) {
     uint64_t now = util::now();
     action->expected_duration = duration;
@@ -523,6 +710,7 @@ Scheduler::GPU::GPU(
       gpu_id(gpu_id),
       pages(pages),
       free_pages(pages),
+      executors(gpu_id),
       exec(Scheduler::default_clock, Scheduler::lag, Scheduler::future), 
       loadweights(Scheduler::default_clock, Scheduler::lag, Scheduler::future) {
 }
@@ -536,24 +724,47 @@ void Scheduler::GPU::send_action(InferAction* action) {
     {
         tbb::queuing_mutex::scoped_lock lock(exec_mutex);
         exec.add(infer->id, infer->expected_duration);
+        exec_horizon = exec.available();
     }
 
     // Save the callback
     auto callback = [this, action](std::shared_ptr<workerapi::Result> result) {
         this->infer_result(action, result);
     };
-    scheduler->add_callback(infer->id, callback);
+    scheduler->add_callback(infer->id, id, callback);
 
     // Record the telemetry
     action->telemetry.set(infer);
     action->telemetry.requests_queued = action->model->requests_queued;
     action->telemetry.copies_loaded = action->model->copies_loaded;
 
-    // Immediately mark the requests as executing for load balancer
-    for (auto &request : action->requests) {
-        action->model->tracker->executing(request->demand, id);
+    if (instances[action->model->id]->prefetched.exchange(false)) {
+        scheduler->prefetch_hits++;
+    }
+
+    scheduler->total_exec_time += infer->expected_duration;
+    scheduler->infer_actions++;
+    if (action->hedge) {
+        // Hedges are the scheduler's choice, so tenants aren't charged
+        scheduler->hedges_sent++;
+        scheduler->hedged_requests += action->requests.size();
+        // hedge_exec_time was already reserved by hedge()
+    } else {
+        // Immediately mark the requests as executing for load balancer, and charge their tenants
+        uint64_t per_request = infer->expected_duration / action->requests.size();
+        for (auto &request : action->requests) {
+            action->model->tracker->executing(request->demand, id);
+            scheduler->tenants->charge(request->request.header.user_id, per_request);
+        }
+        action->model->invalidate_tracker();
+
+        // If the result is late, another GPU with the model loaded might still make the deadline
+        if (scheduler->hedge_budget > 0 && action->model->copies_loaded > 1) {
+            scheduler->hedge_candidates.push(HedgeCandidate{
+                infer->expected_exec_complete + Scheduler::hedge_lateness, id, action->requests
+            });
+        }
     }
-    action->model->invalidate_tracker();
 
     // Send the action
     scheduler->network->send(worker, infer, action->send_by, action->report_error_at);
@@ -570,13 +781,17 @@ void Scheduler::GPU::send_action(LoadWeightsAction* action) {
     {
         tbb::queuing_mutex::scoped_lock lock(loadweights_mutex);
         loadweights.add(load->id, load->expected_duration);
+        load_horizon = loadweights.available();
     }
 
     // Save the callback
     auto callback = [this, action](std::shared_ptr<workerapi::Result> result) {
         this->load_result(action, result);
     };
-    scheduler->add_callback(load->id, callback);
+    scheduler->add_callback(load->id, id, callback);
+
+    // Charge the load to a tenant of the model; the most recent tenant is picked in proportion to request rate
+    scheduler->tenants->charge(action->instance->model->last_user_id, load->expected_duration);
 
     // Record the telemetry
     action->telemetry.set(load);
@@ -598,7 +813,7 @@ void Scheduler::GPU::send_action(EvictWeightsAction* action) {
     auto callback = [this, action](std::shared_ptr<workerapi::Result> result) {
         this->evict_result(action, result);
     };
-    scheduler->add_callback(evict->id, callback);
+    scheduler->add_callback(evict->id, id, callback);
 
     // Record the telemetry
     action->telemetry.set(evict);
@@ -614,7 +829,7 @@ void Scheduler::GPU::send_action(EvictWeightsAction* action) {
 std::vector<Scheduler::EvictWeightsAction*> Scheduler::GPU::evict_pages(unsigned required_pages) {
     std::vector<EvictWeightsAction*> ret;
     while (free_pages < required_pages) {
-        int model_id = scheduler->tracker->evictModel(id);
+        int model_id = scheduler->policy->choose_eviction(scheduler->tracker, id);
 
         if (model_id == -1) break;
 
@@ -624,6 +839,11 @@ std::vector<Scheduler::EvictWeightsAction*> Scheduler::GPU::evict_pages(unsigned
         instance->loaded = false;
         instance->model->copies_loaded--;
 
+        if (instance->prefetched.exchange(false)) {
+            scheduler->prefetch_wasted++;
+            scheduler->prefetch_wasted_bytes += instance->model->weights_size;
+        }
+
         EvictWeightsAction* evict = new EvictWeightsAction(instance);
         evict->set_expectations();
         ret.push_back(evict);
@@ -648,12 +868,18 @@ bool Scheduler::GPU::schedule_load() {
 
     ModelInstance* instance;
     unsigned size;
+    bool prefetch = false;
     std::vector<EvictWeightsAction*> evict_actions;
     {
         tbb::queuing_mutex::scoped_lock load_lock(scheduler->tracker->load_mutex);
         tbb::queuing_mutex::scoped_lock lock(scheduler->tracker->mutex);
 
-        int model_id = scheduler->tracker->loadModel(id, eviction_required);
+        SchedulingPolicy::LoadOption option;
+        option.gpu_id = id;
+        option.eviction_required = eviction_required;
+        option.pcie_idle = available <= now;
+        option.free_pages = free_pages;
+        int model_id = scheduler->policy->choose_load(scheduler->tracker, option, prefetch);
         if (model_id == -1) {
             return false;
         }
@@ -689,6 +915,11 @@ bool Scheduler::GPU::schedule_load() {
     instance->loaded = false;
     action->set_expectations(available, expected_duration);
 
+    if (prefetch) {
+        instance->prefetched = true;
+        scheduler->prefetch_loads++;
+    }
+
     send_action(action);
     return true;
 }
@@ -731,6 +962,7 @@ bool Scheduler::GPU::schedule_infer() {
 
     // If model is empty, set active to false, then drain queue just in case
     bool active = false;
+    std::vector<ModelInstance*> waiting;
     while (strategies.size() > 0) {
         uint64_t exec_at;
         int clock;
@@ -766,7 +998,8 @@ bool Scheduler::GPU::schedule_infer() {
             continue;
         }
 
-        InferAction* action = strategy.instance->model->try_dequeue(exec_at, clock, strategy.batch_size);
+        bool wait = false;
+        InferAction* action = strategy.instance->model->try_dequeue(exec_at, clock, strategy.batch_size, wait);
 
         schedule_infer_action_attempted++;
         if (action != nullptr) {
@@ -775,11 +1008,19 @@ bool Scheduler::GPU::schedule_infer() {
             active = true;
             add_model_strategies(strategy.instance);
             break;
+        } else if (wait) {
+            // Revisit once other strategies have had a chance
+            strategy.instance->deactivate();
+            waiting.push_back(strategy.instance);
         } else {
             add_model_strategies(strategy.instance, strategy.batch_size-1);
         }
     }
 
+    for (auto &instance : waiting) {
+        instance->activate();
+    }
+
     if (active) {
         schedule_infer_active_count++;
     } else {
@@ -789,6 +1030,64 @@ bool Scheduler::GPU::schedule_infer() {
     return active;
 }
 
+bool Scheduler::GPU::hedge(std::vector<Request> &candidates) {
+    Model* model = candidates[0]->model;
+    if (!instances[model->id]->loaded) return false;
+
+    // Hold infer_mutex from reading the exec horizon until the hedge is sent, as schedule_infer does
+    tbb::queuing_mutex::scoped_lock infer_lock(infer_mutex);
+
+    uint64_t exec_at;
+    int clock;
+    {
+        tbb::queuing_mutex::scoped_lock lock(exec_mutex);
+        exec_at = exec.available();
+        clock = exec.clock();
+    }
+
+    // Only use spare capacity
+    uint64_t now = util::now();
+    if (exec_at >= now + scheduler->schedule_ahead) return false;
+
+    // Only duplicate requests that could still make their deadline here
+    unsigned batch_size = model->padded_batch_size(candidates.size());
+    uint64_t duration = model->estimate(batch_size, clock);
+    uint64_t complete_at = std::max(exec_at, now + Scheduler::future) + duration;
+
+    auto action = new InferAction(scheduler, model);
+    for (auto &request : candidates) {
+        if (action->requests.size() == batch_size) break;
+        if (request->deadline < complete_at) continue;
+        action->requests.push_back(request);
+    }
+
+    if (action->requests.size() == 0) {
+        delete action;
+        return false;
+    }
+
+    // Reserve the hedge's exec time; the budget is shared by all GPUs
+    uint64_t budget = scheduler->hedge_budget * scheduler->total_exec_time;
+    uint64_t hedged = scheduler->hedge_exec_time.load();
+    do {
+        if (hedged + duration > budget) {
+            delete action;
+            return false;
+        }
+    } while (!scheduler->hedge_exec_time.compare_exchange_weak(hedged, hedged + duration));
+
+    for (auto &request : action->requests) {
+        request->attempt();
+    }
+    action->hedge = true;
+    action->padded_batch_size = batch_size;
+    action->set_expectations(exec_at, duration, clock);
+    action->batch();
+
+    send_action(action);
+    return true;
+}
+
 void Scheduler::GPU::infer_error(InferAction* action, std::shared_ptr<workerapi::ErrorResult> &error) {
     action->telemetry.set(error);
     
@@ -796,13 +1095,16 @@ void Scheduler::GPU::infer_error(InferAction* action, std::shared_ptr<workerapi:
     {
         tbb::queuing_mutex::scoped_lock lock(exec_mutex);
         exec.error(error->id, util::now());
+        exec_horizon = exec.available();
     }
+    scheduler->infer_errors++;
 
     action->set_error(error);
     CHECK(action->complete(util::now(), id) == 0) << "ErrorResult should not result in successful requests";
 
     action->telemetry.goodput = 0;
     scheduler->printer->log(action->telemetry);
+    action->trace();
 
     delete action;
 }
@@ -815,11 +1117,22 @@ void Scheduler::GPU::infer_success(InferAction* action, std::shared_ptr<workerap
         tbb::queuing_mutex::scoped_lock lock(exec_mutex);
         exec.success(result->id, result->exec.end);
         exec.update_clock(result->gpu_clock);
+        exec_horizon = exec.available();
+    }
+    if (result->exec.end > action->action->expected_exec_complete) {
+        scheduler->result_lag += result->exec.end - action->action->expected_exec_complete;
+    }
+
+    // The worker periodically attaches the utilization of all its executors
+    if (!result->executors.empty()) {
+        for (auto &gpu : scheduler->gpus) {
+            if (gpu->worker_id == worker_id) gpu->executors.update(result->executors);
+        }
     }
 
     // Update model execution tracking
     action->model->add_measurement(
-        action->action->batch_size, 
+        action->padded_batch_size, 
         result->exec.duration, 
         (result->gpu_clock + result->gpu_clock_before) / 2
     );
@@ -828,6 +1141,7 @@ void Scheduler::GPU::infer_success(InferAction* action, std::shared_ptr<workerap
     action->telemetry.goodput = action->complete(util::now(), id);
 
     scheduler->printer->log(action->telemetry);
+    action->trace();
 
     delete action;
 }
@@ -853,12 +1167,14 @@ void Scheduler::GPU::load_error(LoadWeightsAction* action, std::shared_ptr<worke
     // Track model status
     action->instance->model->tracker->loadComplete(id, false);
     action->instance->model->invalidate_tracker();
+    action->instance->prefetched = false;
     free_pages += action->instance->model->num_weights_pages;
 
     // Update PCI state tracking
     {
         tbb::queuing_mutex::scoped_lock lock(loadweights_mutex);
         loadweights.error(error->id, util::now());
+        load_horizon = loadweights.available();
     }
 
     scheduler->printer->log(action->telemetry);
@@ -878,6 +1194,7 @@ void Scheduler::GPU::load_success(LoadWeightsAction* action, std::shared_ptr<wor
     {
         tbb::queuing_mutex::scoped_lock lock(loadweights_mutex);
         loadweights.success(result->id, result->end);
+        load_horizon = loadweights.available();
     }
 
     // Update PCI tracking
@@ -954,6 +1271,12 @@ void Scheduler::validate_clockwork_state(ClockworkState &state) {
         }
     }
 
+    // Measurements are pooled across GPUs, so they are cached under one GPU model and max clock
+    if (profile_cache != nullptr && 
+        !ModelProfileCache::gpu_key(state, profile_cache_gpu, profile_cache_clock)) {
+        profile_cache = nullptr;
+    }
+
     for (auto &p : state.workers[0].models) {
         unsigned model_id = p.first;
         for (auto &worker : state.workers) {
@@ -1043,17 +1366,21 @@ void Scheduler::initialize_model_instances() {
 
     tracker = new LoadTracker(gpus.size(), models.size(), default_slo);
     for (auto model : models) {
-        model->tracker = tracker->newModelTracker(model->id);
+        model->tracker = tracker->newModelTracker(model->id, model->num_weights_pages);
+    }
+
+    if (forecast_interval > 0) {
+        forecaster = new ArrivalForecaster(models.size(), forecast_interval, util::now());
     }
 }
 
 
-void networkPrintThread(std::vector<network::controller::WorkerConnection*> workers) {
+void networkPrintThread(std::vector<network::controller::WorkerConnection*> workers, std::atomic_bool &alive) {
     uint64_t last_print = util::now();
     uint64_t print_interval_nanos = 1000000000UL * 10;
 
     network::connection_stats previous_stats;
-    while (true) {
+    while (alive) {
         uint64_t now = util::now();
         if (last_print + print_interval_nanos > now) {
             usleep(100000);
@@ -1088,7 +1415,17 @@ void networkPrintThread(std::vector<network::controller::WorkerConnection*> work
 void Scheduler::run_gpu_stats_printer_thread() {
     uint64_t print_every = 2500000000UL;
     uint64_t last_print = util::now();
-    while (true) {
+
+    // Counters that are also exported as metrics stay monotonic; print their change
+    std::unordered_map<std::atomic_uint64_t*, uint64_t> printed;
+    auto delta = [&printed] (std::atomic_uint64_t &counter) {
+        uint64_t value = counter.load();
+        uint64_t change = value - printed[&counter];
+        printed[&counter] = value;
+        return change;
+    };
+
+    while (alive) {
         uint64_t now = util::now();
         if (print_every + last_print <= now) {
             last_print = now;
@@ -1098,6 +1435,43 @@ void Scheduler::run_gpu_stats_printer_thread() {
                 s << gpu->stats() << std::endl;
             }
             s << "Requests: " << request_count.exchange(0) << std::endl;
+            s << tenants->str(now) << std::endl;
+            uint64_t waste = delta(padding_waste);
+            uint64_t exec = delta(batched_exec);
+            s << "Batching: " << delta(batches_split) << " split, "
+              << delta(batches_padded) << " padded, "
+              << delta(batch_waits) << " waited, padding waste "
+              << (waste / 1000000.0) << "ms (" << (exec == 0 ? 0 : (100.0 * waste) / exec) << "% of exec)" << std::endl;
+            if (hedge_budget > 0) {
+                uint64_t hedged = delta(hedged_requests);
+                uint64_t wins = delta(hedge_wins);
+                s << "Hedging: " << delta(hedges_sent) << " batches, "
+                  << hedged << " requests, " << wins << " won ("
+                  << (hedged == 0 ? 0 : (100.0 * wins) / hedged) << "%), "
+                  << (hedge_exec_time / 1000000) << "ms exec total" << std::endl;
+            }
+            {
+                // When rejecting, only 1 in rejection_audit_interval predicted misses is observed
+                double tp = delta(predicted_miss_missed);
+                double fp = delta(predicted_miss_met);
+                double fn = delta(predicted_met_missed);
+                double tp_all = early_rejection ? tp * rejection_audit_interval : tp;
+                s << "Admission: " << delta(rejected) << " rejected, prediction precision "
+                  << (tp + fp == 0 ? 0 : (100.0 * tp) / (tp + fp)) << "% recall "
+                  << (tp_all + fn == 0 ? 0 : (100.0 * tp_all) / (tp_all + fn)) << "%" << std::endl;
+            }
+            s << "Prefetch: " << delta(prefetch_loads) << " loads, "
+              << delta(prefetch_hits) << " used, "
+              << delta(prefetch_wasted) << " wasted ("
+              << (delta(prefetch_wasted_bytes) / (1024 * 1024)) << " MB), "
+              << delta(cold_starts) << " cold-start requests" << std::endl;
+            if (result_cache != nullptr) {
+                s << "Result cache: " << result_cache->hits.exchange(0) << " hits, "
+                  << result_cache->joins.exchange(0) << " joined in-flight, "
+                  << result_cache->misses.exchange(0) << " misses, "
+                  << result_cache->evictions.exchange(0) << " evictions, "
+                  << (result_cache->size_bytes() / (1024 * 1024)) << " MB cached" << std::endl;
+            }
             std::cout << s.str();
         }
 
@@ -1105,15 +1479,50 @@ void Scheduler::run_gpu_stats_printer_thread() {
     }
 }
 
+void Scheduler::run_profile_cache_thread() {
+    uint64_t last_save = util::now();
+    while (alive) {
+        uint64_t now = util::now();
+        if (last_save + profile_cache_interval > now) {
+            usleep(100000);
+            continue;
+        }
+
+        unsigned updated = 0;
+        for (auto &model : models) {
+            if (model == nullptr) continue;
+
+            std::map<unsigned, uint64_t> exec_duration;
+            uint64_t weights_transfer_duration;
+            model->measured_estimates(exec_duration, weights_transfer_duration);
+            if (exec_duration.size() == 0 && weights_transfer_duration == 0) continue;
+
+            profile_cache->update(model->model_path, profile_cache_gpu, profile_cache_clock,
+                                  weights_transfer_duration, exec_duration);
+            updated++;
+        }
+
+        if (updated > 0) {
+            profile_cache->save();
+        }
+        last_save = now;
+    }
+}
+
 void Scheduler::initialize_network(std::vector<network::controller::WorkerConnection*> workers) {
     auto transmitComplete = [this]() {
         this->network->sendComplete();
     };
     auto transmitError = [this](uint64_t timeout_at, std::shared_ptr<workerapi::Result> result) {
-        network_timeout_queue.push({timeout_at, result});
+        TimeoutResult timeout{timeout_at, result};
+        this->dispatch_timeout(timeout);
     };
 
-    this->network = new NetworkExecutor(network_concurrency, transmitError);
+    this->network = new QueuingNetworkExecutor(network_concurrency, transmitError);
+
+    for (unsigned i = 0; i < gpus.size(); i++) {
+        result_queues.push_back(new ResultQueues());
+    }
 
     for (auto worker : workers) {
         worker->setTransmitCallback(transmitComplete);
@@ -1121,6 +1530,114 @@ void Scheduler::initialize_network(std::vector<network::controller::WorkerConnec
 }
 
 
+void Scheduler::collect_metrics(metrics::Writer &writer) {
+    uint64_t now = util::now();
+    for (auto &gpu : gpus) {
+        metrics::Labels labels = {
+            {"worker", std::to_string(gpu->worker_id)},
+            {"gpu", std::to_string(gpu->gpu_id)}
+        };
+        uint64_t exec_horizon = gpu->exec_horizon.load();
+        uint64_t load_horizon = gpu->load_horizon.load();
+        writer.gauge("clockwork_gpu_exec_horizon_seconds",
+            "Time until the GPU's outstanding infer actions complete",
+            exec_horizon > now ? (exec_horizon - now) / 1000000000.0 : 0, labels);
+        writer.gauge("clockwork_gpu_load_horizon_seconds",
+            "Time until the GPU's outstanding weights loads complete",
+            load_horizon > now ? (load_horizon - now) / 1000000000.0 : 0, labels);
+        writer.gauge("clockwork_gpu_pages_used",
+            "Weights cache pages in use or reserved on the GPU", gpu->pages_used(), labels);
+        writer.gauge("clockwork_gpu_pages_total",
+            "Weights cache pages on the GPU", gpu->pages, labels);
+
+        for (TaskType type : {TaskType::GPU, PCIe_H2D_Weights, PCIe_H2D_Inputs, PCIe_D2H_Output}) {
+            metrics::Labels executor_labels = labels;
+            executor_labels.push_back({"type", TaskTypeName(type)});
+
+            ExecutorTracker::Interval interval;
+            if (gpu->executors.interval(type, interval)) {
+                writer.gauge("clockwork_gpu_executor_utilization",
+                    "Fraction of the worker's last report interval an executor was busy",
+                    interval.utilization, executor_labels);
+                writer.gauge("clockwork_gpu_executor_queued_tasks",
+                    "Tasks waiting in an executor's queue on the worker", interval.queued, executor_labels);
+            }
+
+            ExecutorTelemetry totals;
+            if (gpu->executors.latest(type, totals)) {
+                writer.counter("clockwork_gpu_executor_dropped_tasks_total",
+                    "Tasks the worker dequeued after the latest time they could start", totals.dropped, executor_labels);
+                writer.counter("clockwork_gpu_executor_lateness_seconds_total",
+                    "Total time from tasks becoming eligible until the worker dequeued them",
+                    totals.lateness / 1000000000.0, executor_labels);
+            }
+        }
+    }
+
+    writer.counter("clockwork_batches_split_total",
+        "Full batches that left requests queued for a later batch", batches_split.load());
+    writer.counter("clockwork_batches_padded_total",
+        "Batches padded up to a supported batch size", batches_padded.load());
+    writer.counter("clockwork_batch_waits_total",
+        "Times a model started waiting for more requests instead of running a smaller batch", batch_waits.load());
+    writer.counter("clockwork_batch_padding_waste_seconds_total",
+        "Expected exec time spent on padding", padding_waste.load() / 1000000000.0);
+    writer.counter("clockwork_batch_exec_seconds_total",
+        "Expected exec time of all batches", batched_exec.load() / 1000000000.0);
+
+    writer.counter("clockwork_prefetch_loads_total",
+        "Weights loads made ahead of demand from arrival forecasts", prefetch_loads.load());
+    writer.counter("clockwork_prefetch_hits_total",
+        "Prefetched copies used before eviction", prefetch_hits.load());
+    writer.counter("clockwork_prefetch_wasted_total",
+        "Prefetched copies evicted without being used", prefetch_wasted.load());
+    writer.counter("clockwork_prefetch_wasted_bytes_total",
+        "Weights bytes of prefetched copies evicted without being used", prefetch_wasted_bytes.load());
+    writer.counter("clockwork_cold_start_requests_total",
+        "Requests that arrived with no copy of their model loaded", cold_starts.load());
+
+    {
+        writer.counter("clockwork_admission_rejected_total",
+            "Requests rejected at admission because they were predicted to miss their deadline", rejected.load());
+
+        // Outcomes of admitted requests, by whether admission predicted them to meet their deadline
+        std::string help = "Admitted requests by predicted and actual deadline outcome";
+        uint64_t tp = predicted_miss_missed.load();
+        uint64_t fp = predicted_miss_met.load();
+        uint64_t fn = predicted_met_missed.load();
+        writer.counter("clockwork_admission_predictions_total", help, tp, {{"predicted", "miss"}, {"outcome", "miss"}});
+        writer.counter("clockwork_admission_predictions_total", help, fp, {{"predicted", "miss"}, {"outcome", "met"}});
+        writer.counter("clockwork_admission_predictions_total", help, fn, {{"predicted", "met"}, {"outcome", "miss"}});
+        writer.counter("clockwork_admission_predictions_total", help, predicted_met_met.load(), {{"predicted", "met"}, {"outcome", "met"}});
+
+        // When rejecting, only 1 in rejection_audit_interval predicted misses is observed
+        double tp_all = early_rejection ? (double) tp * rejection_audit_interval : tp;
+        writer.gauge("clockwork_admission_precision",
+            "Fraction of predicted misses that missed their deadline",
+            tp + fp == 0 ? 0 : tp / (double) (tp + fp));
+        writer.gauge("clockwork_admission_recall",
+            "Fraction of deadline misses that admission predicted",
+            tp_all + fn == 0 ? 0 : tp_all / (tp_all + fn));
+    }
+
+    tenants->collect_metrics(writer);
+
+    if (hedge_budget > 0) {
+        uint64_t hedged = hedged_requests.load();
+        writer.counter("clockwork_hedge_batches_total",
+            "Duplicate batches sent to another GPU for late batches", hedges_sent.load());
+        writer.counter("clockwork_hedged_requests_total",
+            "Requests duplicated by hedge batches", hedged);
+        writer.counter("clockwork_hedge_wins_total",
+            "Hedged requests whose response came from the hedge", hedge_wins.load());
+        writer.counter("clockwork_hedge_exec_seconds_total",
+            "Expected exec time spent on hedge batches", hedge_exec_time.load() / 1000000000.0);
+        writer.gauge("clockwork_hedge_win_ratio",
+            "Fraction of hedged requests whose response came from the hedge",
+            hedged == 0 ? 0 : hedge_wins.load() / (double) hedged);
+    }
+}
+
 // Called when model loading has completed
 void Scheduler::start(std::vector<network::controller::WorkerConnection*> workers,
                     ClockworkState &state) 
@@ -1133,9 +1650,11 @@ void Scheduler::start(std::vector<network::controller::WorkerConnection*> worker
 
     print_status();
 
+    metrics_id = metrics::registry().add([this] (metrics::Writer &writer) { collect_metrics(writer); });
+
     // Create and start the printer threads
     this->printer = ControllerActionTelemetry::log_and_summarize(actions_filename, print_interval);
-    network_printer = std::thread(&networkPrintThread, workers);
+    network_printer = std::thread(&networkPrintThread, workers, std::ref(alive));
     threading::initLoggerThread(network_printer);
 
     if (print_scheduler_stats) {
@@ -1143,21 +1662,36 @@ void Scheduler::start(std::vector<network::controller::WorkerConnection*> worker
         threading::initLoggerThread(stats_printer);
     }
 
-    uint64_t num_admission_threads = 2; // 2
-    for (int i = 0; i < num_admission_threads; i++) {
-        admission_threads.push_back(std::thread(&Scheduler::run_admission_thread, this));
+    if (profile_cache != nullptr) {
+        this->profile_cache_thread = std::thread(&Scheduler::run_profile_cache_thread, this);
+        threading::initLoggerThread(profile_cache_thread);
+    }
+
+    for (unsigned i = 0; i < num_admission_threads; i++) {
+        admission_threads.push_back(std::thread(&Scheduler::run_admission_thread, this, i));
         threading::initHighPriorityThread(admission_threads[i]);
     }
 
+    if (hedge_budget > 0) {
+        hedge_thread = std::thread(&Scheduler::run_hedge_thread, this);
+        threading::initHighPriorityThread(hedge_thread);
+    }
+
+    if (tuning_filename != "") {
+        tuner_thread = std::thread(&Scheduler::run_tuner_thread, this);
+        threading::initLoggerThread(tuner_thread);
+    }
+
     uint64_t num_tracker_threads = 1;
     for (int i = 0; i < num_tracker_threads; i++) {
         tracker_threads.push_back(std::thread(&Scheduler::run_tracker_thread, this));
         threading::initHighPriorityThread(tracker_threads[i]);
     }
 
-    uint64_t num_results_threads = 2; // 2
-    for (int i = 0; i < num_results_threads; i++) {
-        results_threads.push_back(std::thread(&Scheduler::run_results_thread, this));
+    // Each GPU's results are handled by exactly one results thread
+    unsigned num_results_threads = std::min((unsigned) gpus.size(), max_results_threads);
+    for (unsigned i = 0; i < num_results_threads; i++) {
+        results_threads.push_back(std::thread(&Scheduler::run_results_thread, this, i, num_results_threads));
         threading::initHighPriorityThread(results_threads[i]);
     }
 
@@ -1180,6 +1714,23 @@ void Scheduler::start(std::vector<network::controller::WorkerConnection*> worker
     }
 }
 
+void Scheduler::shutdown() {
+    alive = false;
+    metrics::registry().remove(metrics_id);
+
+    for (std::thread* thread : {&network_printer, &stats_printer, &profile_cache_thread, &hedge_thread, &tuner_thread}) {
+        if (thread->joinable()) thread->join();
+    }
+    for (auto threads : {&admission_threads, &results_threads, &infer_threads, &load_threads, &tracker_threads}) {
+        for (auto &thread : *threads) {
+            thread.join();
+        }
+        threads->clear();
+    }
+
+    printer->shutdown(true);
+}
+
 struct tracker_request {
     int model_id;
     uint64_t size;
@@ -1187,65 +1738,95 @@ struct tracker_request {
     uint64_t start_loadweights_by;
 };
 
-void Scheduler::handle_request(Request &request) {
+bool Scheduler::handle_request(Request &request) {
     int model_id = request->request.model_id;
     Model* model = models[model_id];
 
     request->set_model(model);
     request->set_slo(default_slo);
 
+    if (model->copies_loaded == 0) cold_starts++;
+    if (forecaster != nullptr) forecaster->arrived(model_id);
+
+    // Tenants that have had more than their fair share create less load demand
+    int user_id = request->request.header.user_id;
+    tenants->arrived(user_id, request->request.arrival);
+
+    // Requests to models with no copy loaded are never rejected, otherwise the model would never
+    // see enough demand to be loaded
+    uint64_t now = util::now();
+    uint64_t predicted = model->predict_completion(now);
+    if (predicted > request->deadline) {
+        // Admit some predicted misses anyway, to keep measuring precision
+        if (early_rejection && (predicted_misses++ % rejection_audit_interval) != 0) {
+            rejected++;
+            request->response.retry_after = predicted - request->deadline;
+            request->set_error(clockworkControllerRejected, "Predicted to miss deadline by " +
+                std::to_string(request->response.retry_after / 1000000.0) + "ms");
+            CHECK(!request->complete(now, -1)) << "Rejected request should not be successful";
+            return false;
+        }
+    }
+    request->predicted_completion = predicted;
+
     request->demand = model->tracker->addRequest(
-        model->estimate(1), request->exec_slo, request->weights_slo);
+        model->estimate(1) * tenants->demand_scale(user_id), request->exec_slo, request->weights_slo);
     model->invalidate_tracker();
     request->model->enqueue(request);
+    return true;
+}
+
+void Scheduler::add_callback(uint64_t action_id, unsigned gpu, Callback callback) {
+    callbacks.insert(action_id, gpu, callback);
 }
 
-void Scheduler::add_callback(uint64_t action_id, Callback callback) {
-    auto pair = std::make_pair(action_id, callback);
+void Scheduler::dispatch_result(std::shared_ptr<workerapi::Result> &result) {
+    unsigned gpu;
+    CHECK(callbacks.owner(result->id, gpu))
+        << "Received result for non-existent action " << result->str();
 
-    tbb::queuing_mutex::scoped_lock lock(callbacks_mutex);
-    callbacks.insert(pair);
+    result_queues[gpu]->results.push(result);
 }
 
-void Scheduler::handle_result(std::shared_ptr<workerapi::Result> &result) {
-    Callback callback;
-    {
-        tbb::queuing_mutex::scoped_lock lock(callbacks_mutex);
+void Scheduler::dispatch_timeout(TimeoutResult &timeout) {
+    unsigned gpu;
+    CHECK(callbacks.owner(timeout.result->id, gpu))
+        << "Network timeout for non-existent action " << timeout.result->str();
 
-        auto it = callbacks.find(result->id);
-        CHECK(it != callbacks.end()) 
-            << "Received result for non-existent action " << result->str();
+    result_queues[gpu]->network_timeouts.push(timeout);
+}
 
-        callback = it->second;
-        callbacks.erase(it);
-    }
+void Scheduler::handle_result(std::shared_ptr<workerapi::Result> &result) {
+    Callback callback;
+    CHECK(callbacks.take(result->id, callback))
+        << "Received result for non-existent action " << result->str();
 
     callback(result);
 }
 
-void Scheduler::run_admission_thread() {
-    // Process this many requests per iteration
-    int max_requests = 50;
-    std::vector<Request> requests;
-    requests.reserve(max_requests);
+void Scheduler::run_admission_thread(unsigned shard) {
+    // This thread exclusively admits requests for models with id % num_admission_threads == shard,
+    // so requests for a model are enqueued in arrival order.  Deadlines are tracked per-shard.
+    tbb::concurrent_queue<Request>* request_queue = admission_queues[shard];
 
     std::priority_queue<Request, std::deque<Request>, RequestImpl::DeadlineComparator> timeout_queue;
 
     int i = 0;
-    while (true) {
+    while (alive) {
         bool active = false;
 
         // Pop a request
         Request request;
-        if (request_queue.try_pop(request)) {
+        if (request_queue->try_pop(request)) {
             // Immediately drop requests to invalid models
             unsigned model_id = request->request.model_id;
-            if (model_id > models.size() || models[model_id] == nullptr) {
+            if (model_id >= models.size() || models[model_id] == nullptr) {
                 request->set_error(clockworkError, "Invalid model ID");
                 CHECK(!request->complete(util::now(), -1)) << "Erroneous request should not be successful";
             } else {
-                handle_request(request);
-                timeout_queue.push(request);
+                if (handle_request(request)) {
+                    timeout_queue.push(request);
+                }
             }
             active = true;
             i++;
@@ -1271,32 +1852,40 @@ void Scheduler::run_admission_thread() {
     }
 }
 
-void Scheduler::run_results_thread() {
-    bool should_timeout = false;
-    TimeoutResult next_timeout;
+void Scheduler::run_results_thread(unsigned id, unsigned num_threads) {
+    // This thread exclusively handles GPUs id, id+num_threads, ...
+    std::vector<ResultQueues*> queues;
+    for (unsigned gpu = id; gpu < result_queues.size(); gpu += num_threads) {
+        queues.push_back(result_queues[gpu]);
+    }
+
+    std::vector<bool> should_timeout(queues.size(), false);
+    std::vector<TimeoutResult> next_timeout(queues.size());
 
     int i = 0;
-    while (true) {
+    while (alive) {
         bool active = false;
 
-        std::shared_ptr<workerapi::Result> result;
-        if (result_queue.try_pop(result)) {
-            handle_result(result);
-            active = true;
-            i++;
-        }
-
-        if (!should_timeout) {
-            should_timeout = network_timeout_queue.try_pop(next_timeout);
-        }
-
-        if (should_timeout) {
-            if (next_timeout.timeout_at <= util::now()) {
-                handle_result(next_timeout.result);
-                should_timeout = false;
+        for (unsigned j = 0; j < queues.size(); j++) {
+            std::shared_ptr<workerapi::Result> result;
+            if (queues[j]->results.try_pop(result)) {
+                handle_result(result);
                 active = true;
                 i++;
             }
+
+            if (!should_timeout[j]) {
+                should_timeout[j] = queues[j]->network_timeouts.try_pop(next_timeout[j]);
+            }
+
+            if (should_timeout[j]) {
+                if (next_timeout[j].timeout_at <= util::now()) {
+                    handle_result(next_timeout[j].result);
+                    should_timeout[j] = false;
+                    active = true;
+                    i++;
+                }
+            }
         }
 
         if (!active || i >= 100) {
@@ -1313,7 +1902,7 @@ void Scheduler::run_infer_thread(int id) {
 
     int i = 0;
     int n_gpus = gpus.size();
-    while (true) {
+    while (alive) {
         uint64_t i = (next_infer++) % n_gpus;
         bool active = gpus[i]->schedule_infer();
         usleep(10);
@@ -1327,7 +1916,7 @@ void Scheduler::run_load_thread(int id) {
 
     int inactive = 0;
     int n_gpus = gpus.size();
-    while (true) {
+    while (alive) {
         uint64_t i = (next_load++) % n_gpus;
         bool active = gpus[i]->schedule_load();
         usleep(10);
@@ -1335,10 +1924,101 @@ void Scheduler::run_load_thread(int id) {
 
 }
 
+void Scheduler::hedge(HedgeCandidate &candidate) {
+    // Requests that already have a response don't need hedging
+    std::vector<Request> requests;
+    for (auto &request : candidate.requests) {
+        if (!request->is_claimed()) {
+            requests.push_back(request);
+        }
+    }
+    if (requests.size() == 0) return;
+
+    for (auto &gpu : gpus) {
+        if (gpu->id == candidate.gpu_id) continue;
+        if (gpu->hedge(requests)) return;
+    }
+}
+
+void Scheduler::run_hedge_thread() {
+    std::cout << "Hedge thread running\n";
+    std::priority_queue<HedgeCandidate, std::vector<HedgeCandidate>, std::greater<HedgeCandidate>> pending;
+    while (alive) {
+        HedgeCandidate candidate;
+        while (hedge_candidates.try_pop(candidate)) {
+            pending.push(candidate);
+        }
+
+        uint64_t now = util::now();
+        while (!pending.empty() && pending.top().hedge_at <= now) {
+            candidate = pending.top();
+            pending.pop();
+            hedge(candidate);
+        }
+
+        usleep(100);
+    }
+}
+
+void Scheduler::run_tuner_thread() {
+    std::cout << "Tuner thread running, logging adjustments to " << tuning_filename << std::endl;
+    ParameterTuner tuner(schedule_ahead, latest_delta, max_allowable_exec_time, max_batch_size);
+
+    std::ofstream f(tuning_filename);
+    f << "t" << "\t" << "parameter" << "\t" << "before" << "\t" << "after" << "\t" << "reason" << std::endl;
+
+    uint64_t last_exec_time = total_exec_time;
+    uint64_t last_tuning = util::now();
+    while (alive) {
+        usleep(10000);
+        uint64_t now = util::now();
+        if (last_tuning + tuning_interval > now) continue;
+
+        ParameterTuner::Observation observation;
+        observation.met = slo_met.exchange(0);
+        observation.missed = slo_missed.exchange(0);
+        observation.infer_errors = infer_errors.exchange(0);
+        observation.infer_actions = infer_actions.exchange(0);
+        uint64_t lag = result_lag.exchange(0);
+        if (observation.infer_actions > 0) {
+            observation.mean_lag = lag / observation.infer_actions;
+        }
+        uint64_t exec_time = total_exec_time;
+        observation.utilization = (exec_time - last_exec_time) / ((double) (now - last_tuning) * gpus.size());
+        last_exec_time = exec_time;
+        last_tuning = now;
+
+        for (auto &adjustment : tuner.update(observation)) {
+            if (adjustment.parameter == "schedule_ahead") schedule_ahead = adjustment.after;
+            else if (adjustment.parameter == "latest_delta") latest_delta = adjustment.after;
+            else if (adjustment.parameter == "max_exec") max_allowable_exec_time = adjustment.after;
+            else if (adjustment.parameter == "max_batch") max_batch_size = adjustment.after;
+
+            std::cout << "Tuner: " << adjustment.parameter << " " << adjustment.before
+                      << " -> " << adjustment.after << " (" << adjustment.reason << ")" << std::endl;
+            f << now << "\t" << adjustment.parameter << "\t" << adjustment.before << "\t"
+              << adjustment.after << "\t" << adjustment.reason << std::endl;
+        }
+    }
+}
+
 void Scheduler::run_tracker_thread() {
     std::cout << "Tracker thread running\n";
     std::vector<Model*> models;
-    while (true) {
+    uint64_t last_tenant_refresh = 0;
+    while (alive) {
+        uint64_t now = util::now();
+        if (last_tenant_refresh + tenant_refresh_interval <= now) {
+            tenants->refresh(now);
+            last_tenant_refresh = now;
+        }
+
+        if (forecaster != nullptr && forecaster->refresh(now)) {
+            std::vector<int64_t> forecasts = forecaster->forecasts();
+            tbb::queuing_mutex::scoped_lock lock(tracker->mutex);
+            tracker->updateForecasts(forecasts);
+        }
+
         Model* model;
         while (stale.try_pop(model)) {
             models.push_back(model);
@@ -1365,7 +2045,7 @@ void Scheduler::resultFromWorker(std::shared_ptr<workerapi::Result> result)
     if (print_debug) std::cout << ("Worker  --> " + result->str() + "\n");
 
     result->result_received = util::now();
-    result_queue.push(result);
+    dispatch_result(result);
 }
 
 // The actual scheduler interface implementation, invoked by client network thread
@@ -1374,72 +2054,42 @@ void Scheduler::clientInfer(clientapi::InferenceRequest &request,
 {
     if (print_debug) std::cout << ("Client  --> " + request.str() + "\n");
 
-    request_queue.push(std::make_shared<RequestImpl>(this, request, callback));
-    request_count++;
-}
-
-Scheduler::NetworkExecutor::NetworkExecutor(unsigned concurrency, 
-    std::function<void(uint64_t, std::shared_ptr<workerapi::Result>)> error_callback) : 
-idle(concurrency), error_callback(error_callback) {}
-
-void Scheduler::NetworkExecutor::send(network::controller::WorkerConnection* worker, 
-          std::shared_ptr<workerapi::Action> action,
-          uint64_t start_send_by,
-          uint64_t send_error_at) {
-
-    NetworkAction toSend;
-    {
-        tbb::queuing_mutex::scoped_lock lock(mutex);
-
-        pending.push_back({worker, action, start_send_by, send_error_at});
-
-        if (idle == 0) return;
-
-        if (!next(toSend)) return;
-
-        idle--;
-    }
-
-    toSend.worker->sendAction(toSend.action);            
-}
-
-void Scheduler::NetworkExecutor::sendComplete() {
-    NetworkAction toSend;
-    {
-        tbb::queuing_mutex::scoped_lock lock(mutex);
-        if (!next(toSend)) {
-            idle++;
-            return;
+    // Requests without inputs all look identical, so aren't cached
+    if (result_cache != nullptr && request.input_size > 0 &&
+        request.model_id >= 0 && request.model_id < (int) models.size() && models[request.model_id] != nullptr) {
+        uint64_t slo = default_slo;
+        if (request.slo_factor > 0) {
+            slo = models[request.model_id]->b1_exec * request.slo_factor;
         }
-    }
-
-    toSend.worker->sendAction(toSend.action);
-}
-
-bool Scheduler::NetworkExecutor::next(NetworkAction &toSend) {
-    uint64_t now = util::now();
-    while (pending.size() > 0) {
-        toSend = pending.front();
-        pending.pop_front();
 
-        if (toSend.start_send_by >= now) {
-            return true;
+        auto key = ResultCache::key(request.model_id, request.input, request.input_size);
+        clientapi::InferenceResponse response;
+        switch (result_cache->lookup(key, util::now(), request, request.arrival + slo, callback, response)) {
+            case ResultCache::hit: {
+                if (print_debug) std::cout << ("Client <--  " + response.str() + "\n");
+                callback(response);
+                delete static_cast<char*>(request.input);
+                return;
+            }
+            case ResultCache::joined: {
+                delete static_cast<char*>(request.input);
+                return;
+            }
+            case ResultCache::miss: {
+                ResultCache* result_cache = this->result_cache;
+                auto onResponse = callback;
+                callback = [result_cache, key, onResponse] (clientapi::InferenceResponse &response) {
+                    result_cache->complete(key, util::now(), response);
+                    onResponse(response);
+                };
+                break;
+            }
         }
-
-        auto action = toSend.action;
-        auto result = std::make_shared<workerapi::ErrorResult>();
-        result->id = action->id;
-        result->action_type = action->action_type;
-        result->status = networkSendTooLate;
-        result->action_received = now;
-        result->result_sent = now;
-        result->result_received = now;
-        result->message = "Could not send action to worker in time";
-
-        error_callback(toSend.send_error_at, result);
-
     }
-    return false;
+
+    unsigned shard = ((unsigned) request.model_id) % num_admission_threads;
+    admission_queues[shard]->push(std::make_shared<RequestImpl>(this, request, callback));
+    request_count++;
 }
 
 }
@@ -9,9 +9,22 @@
 #include <sstream>
 #include <set>
 #include "clockwork/controller/scheduler.h"
+#include "clockwork/controller/profile_cache.h"
 #include "clockwork/controller/worker_tracker.h"
+#include "clockwork/controller/executor_tracker.h"
+#include "clockwork/controller/network_executor.h"
 #include "clockwork/controller/infer5/load_tracker.h"
+#include "clockwork/controller/infer5/action_registry.h"
+#include "clockwork/controller/infer5/request_log.h"
+#include "clockwork/controller/infer5/tenant_tracker.h"
+#include "clockwork/controller/infer5/arrival_forecaster.h"
+#include "clockwork/controller/infer5/batch_planner.h"
+#include "clockwork/controller/infer5/parameter_tuner.h"
+#include "clockwork/controller/infer5/result_cache.h"
+#include "clockwork/controller/infer5/scheduling_policy.h"
 #include "clockwork/telemetry/controller_action_logger.h"
+#include "clockwork/telemetry/metrics.h"
+#include "clockwork/telemetry/trace.h"
 #include "clockwork/thread.h"
 #include "clockwork/api/worker_api.h"
 #include "clockwork/sliding_window.h"
@@ -39,16 +52,32 @@ class Scheduler : public clockwork::Scheduler {
     static const uint64_t future = 1000000UL; // used for setting earliest timestamp; expect 1ms lag getting to worker
     static const uint64_t max_loadweights_slo = 25000000UL;
     static const unsigned network_concurrency = 2; // max number of concurrent network xfers
+    static const unsigned max_results_threads = 8; // results threads are partitioned by GPU, up to this many
+    static const uint64_t max_outstanding_actions = 65536; // capacity of the action callback registry
+    static const uint64_t profile_cache_interval = 60000000000UL; // how often to save measurements to the profile cache
+    static const uint64_t tenant_refresh_interval = 10000000UL; // how often to recompute tenant fair-share penalties
+    static const uint64_t max_batch_wait = 2000000UL; // max time to hold back a batch waiting for more requests
+    static const uint64_t hedge_lateness = 2000000UL; // hedge batches whose result is this late
+    static const unsigned rejection_audit_interval = 32; // admit 1 in this many predicted misses, to measure precision
+    static const uint64_t tuning_interval = 1000000000UL; // how often the tuner adjusts parameters
 
     // Scheduler parameters configurable by ./controller binary
 
     const uint64_t default_slo;
-    const uint64_t latest_delta; // Actions can run up to 10ms behind schedule before the worker will drop them
-    const uint64_t schedule_ahead; // schedule 10ms into the future
-    const uint64_t max_allowable_exec_time; // disallow batches with execution times greater than this
-    const unsigned max_batch_size;
     const bool generate_inputs; // if clients send 0-size inputs, do we want to generate real ones, or send 0-size?
     const int max_gpus; // max number of gpus to use
+    const unsigned num_admission_threads; // admission is sharded by model id across this many threads
+    const uint64_t forecast_interval; // bucket size for arrival forecasts used to prefetch weights; 0 disables
+    const double hedge_budget; // max fraction of exec time spent on hedged duplicates of late batches; 0 disables
+    const bool early_rejection; // reject requests at admission if they are predicted to miss their deadline
+    const std::string tuning_filename; // if set, the parameters below are tuned at runtime and adjustments logged here
+
+    // Configured by ./controller binary, and tuned at runtime if tuning_filename is set.
+    // max_allowable_exec_time and max_batch_size are only tuned below their configured values.
+    std::atomic_uint64_t latest_delta; // Actions can run up to 10ms behind schedule before the worker will drop them
+    std::atomic_uint64_t schedule_ahead; // schedule 10ms into the future
+    std::atomic_uint64_t max_allowable_exec_time; // disallow batches with execution times greater than this
+    std::atomic_uint max_batch_size;
 
     Scheduler(
         uint64_t default_slo, // 100ms
@@ -58,7 +87,18 @@ class Scheduler : public clockwork::Scheduler {
         int max_gpus, // max GPUs to use
         uint64_t max_allowable_exec_time, // don't use batch sizes with higher exec time than this
         unsigned max_batch_size, // max allowed batch size
-        std::string actions_filename);
+        std::string actions_filename,
+        unsigned num_admission_threads = 4, // number of admission shards
+        ModelProfileCache* profile_cache = nullptr, // if set, measurements are periodically saved here
+        std::string tenants_spec = "", // tenant weights and reserved shares, user_id:weight[:reserved],...
+        uint64_t forecast_interval = 0, // bucket size for arrival forecasts, e.g. 1 minute; 0 disables prefetching
+        double hedge_budget = 0, // fraction of exec time for hedging late batches on another GPU; 0 disables
+        bool early_rejection = false, // reject requests predicted to miss; predictions are tracked either way
+        std::string tuning_filename = "", // if set, tune parameters at runtime and log adjustments to this file
+        size_t result_cache_bytes = 0, // memory bound for cached results of identical requests; 0 disables
+        uint64_t result_cache_ttl = 10000000000UL, // how long a cached result may be reused
+        SchedulingPolicy* policy = nullptr // infer and load decisions; DeadlinePolicy if not set
+        );
 
     class RequestImpl;
     typedef std::shared_ptr<RequestImpl> Request;
@@ -73,6 +113,7 @@ class Scheduler : public clockwork::Scheduler {
         uint64_t exec_slo;
         uint64_t weights_slo;
         uint64_t deadline;
+        uint64_t predicted_completion = 0; // predicted at admission; 0 if no prediction was made
         Model* model = nullptr;
         clientapi::InferenceRequest request;
         clientapi::InferenceResponse response;
@@ -82,9 +123,14 @@ class Scheduler : public clockwork::Scheduler {
      private:
         std::atomic_bool locked;
         std::atomic_flag response_sent;
+        std::atomic_int attempts; // actions carrying this request whose result hasn't arrived
+        std::atomic_bool claimed; // an action has been chosen to provide the response
 
         std::function<void(clientapi::InferenceResponse&)> callback;
 
+        // Counts the outcome towards SLO attainment and compares it against the admission prediction
+        void record_outcome(bool met_deadline);
+
      public:
         RequestImpl(Scheduler* scheduler,
             clientapi::InferenceRequest request,
@@ -98,6 +144,13 @@ class Scheduler : public clockwork::Scheduler {
 
         void lock();
 
+        // Called when an action carrying this request is sent, and when its result arrives.
+        // claim returns true if that result should provide the response: the first success,
+        // or an error if no other action is still outstanding.
+        void attempt() { attempts++; }
+        bool claim(bool success);
+        bool is_claimed() { return claimed; }
+
         // Returns true if the result was successful and within the deadline
         void timeout();
         bool complete(uint64_t now, int gpu_id);
@@ -121,6 +174,9 @@ class Scheduler : public clockwork::Scheduler {
         std::shared_ptr<workerapi::ErrorResult> error = nullptr;
         std::shared_ptr<workerapi::InferResult> result = nullptr;
         std::vector<Request> requests;
+        std::vector<bool> claimed; // whether this action provides each request's response
+        unsigned padded_batch_size; // batch size executed by the worker; may exceed requests.size()
+        bool hedge = false; // a duplicate of a late batch on another GPU
         uint64_t send_by;
         uint64_t report_error_at;
 
@@ -135,6 +191,9 @@ class Scheduler : public clockwork::Scheduler {
 
         // Returns the fraction of successful requests
         float complete(uint64_t now, int gpu_id);
+
+        // Emits each traced request's time waiting to be scheduled, and this action's round trip
+        void trace();
     };
 
     class ModelInstance;
@@ -206,50 +265,20 @@ class Scheduler : public clockwork::Scheduler {
 
     };
 
-    class ModelQueue {
-     private:
-        std::deque<Request> queue;
-
-     public:
-
-        const int batchsize;
-
-        ModelQueue(int batchsize) : batchsize(batchsize) {}
-
-        Request& front() {
-            return queue.front();
-        }
-
-        void pop() {
-            queue.pop_front();
-        }
-
-        int size() {
-            return queue.size();
-        }
-
-        bool has_demand() {
-            return size() >= batchsize;
-        }
-
-        void push(Request &request) {
-            queue.push_back(request);
-        }
-
-    };
-
     class Model {
      public:
-        uint64_t seqno_seed = 0;
         unsigned id;
+        std::string model_path;
         Scheduler* scheduler;
         unsigned num_weights_pages;
+        size_t weights_size;
         size_t input_size;
         size_t output_size;
         std::vector<ModelInstance*> instances;
         uint64_t b1_exec;
         std::atomic_int copies_loaded = 0;
         std::atomic_int requests_queued = 0;
+        std::atomic_int last_user_id = 0; // Weights loads are charged to the most recent tenant
 
         ModelLoadTracker* tracker;
         std::atomic_flag stale;
@@ -283,7 +312,11 @@ class Scheduler : public clockwork::Scheduler {
         std::atomic_uint64_t request_id_seed_ = 0;
 
         tbb::concurrent_queue<Request> incoming_requests;
-        std::vector<ModelQueue*> queues;
+        RequestLog<Request>* requests; // One cursor per supported batch size
+
+        uint64_t last_arrival = 0;
+        uint64_t interarrival = 0; // EWMA of time between arrivals
+        bool waiting = false; // Holding back a batch for more requests
 
 
      public:
@@ -295,13 +328,20 @@ class Scheduler : public clockwork::Scheduler {
         // Enqueues the request to this model, then enqueues InferStrategies to all active ModelInstances
         void enqueue(Request request);
 
+        // Smallest supported batch size that fits num_requests, or the largest supported
+        unsigned padded_batch_size(unsigned num_requests);
+
+        // When a request arriving now would complete, given the requests already queued and the
+        // work outstanding on GPUs with the model loaded.  Returns 0 if no copy is loaded.
+        uint64_t predict_completion(uint64_t now);
+
         std::string queues_str() {
             std::stringstream msg;
             bool first = true;
-            for (auto &queue : queues) {
+            for (unsigned i = 0; i < supported_batch_sizes.size(); i++) {
                 if (!first) msg << " ";
                 first = false;
-                msg << "q" << queue->batchsize << "=" << queue->size();
+                msg << "q" << supported_batch_sizes[i] << "=" << requests->size(i);
             }
             return msg.str();
         }
@@ -312,13 +352,17 @@ class Scheduler : public clockwork::Scheduler {
     public:
         std::vector<StrategyImpl> new_strategies(int gpu_id, unsigned gpu_clock, int max_batchsize);
 
-        // Gets actions to execute for this model
-        InferAction* try_dequeue(uint64_t gpu_free_at, unsigned gpu_clock, int min_batchsize);
+        // Gets actions to execute for this model.  Sets wait if it's worth waiting for more requests
+        InferAction* try_dequeue(uint64_t gpu_free_at, unsigned gpu_clock, int min_batchsize, bool &wait);
 
         // GPUs can add new measurements
         void add_measurement(unsigned batch_size, uint64_t duration, unsigned gpu_clock);
         void add_weights_measurement(uint64_t duration);
         uint64_t estimate(unsigned batch_size);
+        uint64_t estimate(unsigned batch_size, int clock);
+
+        // Current estimates, in the units of BatchedModelState, for anything measured since startup
+        void measured_estimates(std::map<unsigned, uint64_t> &exec_duration, uint64_t &weights_transfer_duration);
 
      private:
 
@@ -327,7 +371,6 @@ class Scheduler : public clockwork::Scheduler {
         unsigned index_lookup(unsigned batchsize);
 
         void check_timeouts(uint64_t free_at);
-        uint64_t estimate(unsigned batch_size, int clock);
     };
 
     class ModelInstance {
@@ -336,10 +379,11 @@ class Scheduler : public clockwork::Scheduler {
         Model* model = nullptr;
         std::atomic_bool loaded;
         std::atomic_bool loading;
+        std::atomic_bool prefetched; // Loaded ahead of demand, and not yet used
         std::atomic_int version = 0;
         std::vector<StrategyImpl> strategies;
         std::atomic_flag active;
-        ModelInstance(GPU* gpu, Model* model): gpu(gpu), model(model), loaded(false), loading(false), active(ATOMIC_FLAG_INIT) {}
+        ModelInstance(GPU* gpu, Model* model): gpu(gpu), model(model), loaded(false), loading(false), prefetched(false), active(ATOMIC_FLAG_INIT) {}
 
         void activate();
         void deactivate();
@@ -363,6 +407,15 @@ class Scheduler : public clockwork::Scheduler {
         std::atomic_uint64_t schedule_infer_action_created = 0;
         std::atomic_uint64_t schedule_infer_action_attempted = 0;
 
+        std::atomic_uint64_t exec_horizon = 0; // when outstanding exec work completes; read without exec_mutex
+        std::atomic_uint64_t load_horizon = 0; // when outstanding loads complete; read without loadweights_mutex
+
+        // The number of pages in use or reserved for loads; read without load_mutex
+        int pages_used() { return pages - free_pages.load(); }
+
+        // Utilization measured by the worker, as opposed to the estimates of exec and loadweights
+        ExecutorTracker executors;
+
         std::string stats() {
             std::stringstream s;
             s << "GPU-" << id << "-INF ";
@@ -372,6 +425,11 @@ class Scheduler : public clockwork::Scheduler {
             s << schedule_infer_exec_full.exchange(0) << " execfull, ";
             s << schedule_infer_action_created.exchange(0) << "/";
             s << schedule_infer_action_attempted.exchange(0) << " created.";
+            ExecutorTracker::Interval interval;
+            if (executors.interval(TaskType::GPU, interval)) {
+                s << " " << (int) (100 * interval.utilization) << "% busy, ";
+                s << interval.dropped << " dropped.";
+            }
             return s.str();
         }
 
@@ -405,6 +463,9 @@ class Scheduler : public clockwork::Scheduler {
         bool schedule_infer();
         bool schedule_load();
 
+        // Sends a duplicate of the requests that can still meet their deadline, if there's spare capacity
+        bool hedge(std::vector<Request> &requests);
+
     private:
         void send_action(InferAction* action);
         void send_action(LoadWeightsAction* action);
@@ -425,43 +486,25 @@ class Scheduler : public clockwork::Scheduler {
         void evict_result(EvictWeightsAction* action, std::shared_ptr<workerapi::Result> &result);
     };
 
-    class NetworkExecutor {
-     private:
-
-        struct NetworkAction {
-            network::controller::WorkerConnection* worker;
-            std::shared_ptr<workerapi::Action> action;
-            uint64_t start_send_by;
-            uint64_t send_error_at;
-        };
-
-        tbb::queuing_mutex mutex;
-        unsigned idle;
-        std::deque<NetworkAction> pending;
-        std::function<void(uint64_t, std::shared_ptr<workerapi::Result>)> error_callback;
-
-     public:
-        NetworkExecutor(unsigned concurrency, 
-            std::function<void(uint64_t, std::shared_ptr<workerapi::Result>)> error_callback);
-
-        void send(network::controller::WorkerConnection* worker, 
-                  std::shared_ptr<workerapi::Action> action,
-                  uint64_t start_send_by,
-                  uint64_t send_error_at);
-        void sendComplete();
-
-    private:
-
-        bool next(NetworkAction &toSend);
-
-    };
 
  public:
 
     // Track the load on each model, used for LoadWeights/EvictWeights
     LoadTracker* tracker;
+
+    // Fair sharing between tenants
+    TenantTracker* tenants;
+
+    // Forecasts per-model demand for prefetching weights; nullptr if disabled
+    ArrivalForecaster* forecaster = nullptr;
     tbb::concurrent_queue<Model*> stale;
 
+    // Decides what to infer, load and evict; the rest of the scheduler carries out its decisions
+    SchedulingPolicy* policy;
+
+    // Results of identical requests; nullptr if disabled
+    ResultCache* result_cache = nullptr;
+
     // Non-mutable so thread-safe
     std::vector<GPU*> gpus;
     std::vector<Model*> models;
@@ -471,12 +514,53 @@ class Scheduler : public clockwork::Scheduler {
     std::atomic_uint64_t next_infer = 0;
     std::atomic_uint64_t request_count = 0;
 
+    // Prefetching telemetry
+    std::atomic_uint64_t cold_starts = 0; // requests that arrived with no copy of the model loaded
+    std::atomic_uint64_t prefetch_loads = 0;
+    std::atomic_uint64_t prefetch_hits = 0; // prefetched copies used before eviction
+    std::atomic_uint64_t prefetch_wasted = 0; // prefetched copies evicted without being used
+    std::atomic_uint64_t prefetch_wasted_bytes = 0;
+
+    // Batching telemetry
+    std::atomic_uint64_t batches_split = 0; // full batches that left requests for a later batch
+    std::atomic_uint64_t batches_padded = 0;
+    std::atomic_uint64_t batch_waits = 0;
+    std::atomic_uint64_t padding_waste = 0; // exec time spent on padding
+    std::atomic_uint64_t batched_exec = 0; // total expected exec time
+
+    // Hedging telemetry; the cumulative exec times enforce hedge_budget
+    std::atomic_uint64_t hedges_sent = 0;
+    std::atomic_uint64_t hedged_requests = 0;
+    std::atomic_uint64_t hedge_wins = 0; // hedged requests whose response came from the hedge
+    std::atomic_uint64_t total_exec_time = 0;
+    std::atomic_uint64_t hedge_exec_time = 0;
+
+    // Admission telemetry; predictions are compared against the outcomes of admitted requests
+    std::atomic_uint64_t rejected = 0;
+    std::atomic_uint64_t predicted_misses = 0; // every rejection_audit_interval'th is admitted anyway
+    std::atomic_uint64_t predicted_miss_missed = 0;
+    std::atomic_uint64_t predicted_miss_met = 0;
+    std::atomic_uint64_t predicted_met_missed = 0;
+    std::atomic_uint64_t predicted_met_met = 0;
+
+    // Tuning telemetry; the tuner thread takes the deltas each tuning_interval
+    std::atomic_uint64_t slo_met = 0;
+    std::atomic_uint64_t slo_missed = 0;
+    std::atomic_uint64_t infer_actions = 0;
+    std::atomic_uint64_t infer_errors = 0;
+    std::atomic_uint64_t result_lag = 0; // total time results completed after their expected completion
+
  private:
     // Threads
+    std::atomic_bool alive = true; // cleared by shutdown; every scheduler thread polls it
+    unsigned metrics_id; // the collector registered by start
     std::string actions_filename;
     ControllerActionTelemetryLogger* printer;
     std::thread network_printer;
     std::thread stats_printer;
+    std::thread profile_cache_thread;
+    std::thread hedge_thread;
+    std::thread tuner_thread;
     std::vector<std::thread> admission_threads;
     std::vector<std::thread> results_threads;
     std::vector<std::thread> infer_threads;
@@ -484,7 +568,7 @@ class Scheduler : public clockwork::Scheduler {
     std::vector<std::thread> tracker_threads;
 
     // Network executor
-    NetworkExecutor* network = nullptr;
+    QueuingNetworkExecutor* network = nullptr;
 
     // Messages
     struct TimeoutResult {
@@ -492,14 +576,32 @@ class Scheduler : public clockwork::Scheduler {
         std::shared_ptr<workerapi::Result> result;
     };
 
-    tbb::concurrent_queue<std::shared_ptr<workerapi::Result>> result_queue;
-    tbb::concurrent_queue<TimeoutResult> network_timeout_queue;
-    tbb::concurrent_queue<Request> request_queue;
+    // Results are routed to the queues of the GPU that sent the action
+    struct ResultQueues {
+        tbb::concurrent_queue<std::shared_ptr<workerapi::Result>> results;
+        tbb::concurrent_queue<TimeoutResult> network_timeouts;
+    };
+
+    std::vector<ResultQueues*> result_queues;
+
+    // Batches that may be hedged if their result hasn't arrived by hedge_at
+    struct HedgeCandidate {
+        uint64_t hedge_at;
+        unsigned gpu_id;
+        std::vector<Request> requests;
 
-    // Callbacks
-    tbb::queuing_mutex callbacks_mutex;
+        friend bool operator > (const HedgeCandidate &lhs, const HedgeCandidate &rhs) {
+            return lhs.hedge_at > rhs.hedge_at;
+        }
+    };
+    tbb::concurrent_queue<HedgeCandidate> hedge_candidates;
+
+    // Requests are sharded by model id; each admission thread owns one queue
+    std::vector<tbb::concurrent_queue<Request>*> admission_queues;
+
+    // Callbacks, keyed by action id; lock-free
     typedef std::function<void(std::shared_ptr<workerapi::Result>&)> Callback;
-    std::unordered_map<uint64_t, Callback> callbacks;
+    ActionRegistry<Callback> callbacks;
 
     // Diagnostic
     std::atomic_flag has_logged_inputs_status;
@@ -507,16 +609,24 @@ class Scheduler : public clockwork::Scheduler {
     // Used during experiments if we are generating inputs server-side
     util::InputGenerator* input_generator = nullptr;
 
+    // Used to warm-start future controllers
+    ModelProfileCache* profile_cache = nullptr;
+    std::string profile_cache_gpu;
+    unsigned profile_cache_clock = 0;
+
 
  public:
 
     // Called by GPU threads to register an action
-    void add_callback(uint64_t action_id, Callback callback);
+    void add_callback(uint64_t action_id, unsigned gpu, Callback callback);
 
     // Called when model loading has completed
     virtual void start(std::vector<network::controller::WorkerConnection*> workers,
                         ClockworkState &state);
 
+    // Stops and joins the threads created by start; requests still in flight are abandoned
+    void shutdown();
+
     // The actual scheduler interface implementation, invoked by client network thread
     virtual void clientInfer(clientapi::InferenceRequest &request, 
         std::function<void(clientapi::InferenceResponse&)> callback);
@@ -535,17 +645,27 @@ class Scheduler : public clockwork::Scheduler {
     void initialize_network(std::vector<network::controller::WorkerConnection*> workers);
     void print_status();
 
+    // Exports live metrics; reads only atomics and lock-free snapshots, so never contends with scheduling
+    void collect_metrics(metrics::Writer &writer);
+
     // The main thread run methods
-    void run_admission_thread();
+    void run_admission_thread(unsigned shard);
     void run_tracker_thread();
-    void run_results_thread();
+    void run_results_thread(unsigned id, unsigned num_threads);
     void run_infer_thread(int id);
     void run_load_thread(int id);
     void run_gpu_stats_printer_thread();
+    void run_profile_cache_thread();
+    void run_hedge_thread();
+    void run_tuner_thread();
 
     // Logic of the dispatcher thread
+    void dispatch_result(std::shared_ptr<workerapi::Result> &result);
+    void dispatch_timeout(TimeoutResult &timeout);
     void handle_result(std::shared_ptr<workerapi::Result> &result);
-    void handle_request(Request &request);
+    // Returns false if the request was rejected at admission
+    bool handle_request(Request &request);
+    void hedge(HedgeCandidate &candidate);
 };
 
 }
@@ -1,4 +1,5 @@
 #include "clockwork/controller/infer5/load_tracker.h"
+#include <algorithm>
 #include "clockwork/util.h"
 #include "dmlc/logging.h"
 
@@ -6,7 +7,8 @@ namespace clockwork {
 namespace scheduler {
 namespace infer5 {
 
-ModelLoadTracker* LoadTracker::newModelTracker(int model_id) {
+ModelLoadTracker* LoadTracker::newModelTracker(int model_id, unsigned weights_pages) {
+    models[model_id].weights_pages = weights_pages;
     return new ModelLoadTracker(capacity, model_id, gpus.size());
 }
    
@@ -152,6 +154,7 @@ void LoadTracker::updatePriority(Model &model) {
             model.priorities[i]->priority = load_priority;
         }
         model.priorities[i]->is_empty = is_empty;
+        model.priorities[i]->forecast = model.forecast;
         model.priorities[i]->last_used = model.last_used[i];
     }
 }
@@ -332,6 +335,54 @@ int LoadTracker::evictModel(int gpu_id) {
     return model.id;
 }
 
+int LoadTracker::prefetchModel(int gpu_id, unsigned free_pages) {
+    // Update and re-enqueue all models
+    refreshPriorities();
+    attach(gpus[gpu_id]);
+
+    while (prefetch_next < prefetch_candidates.size() &&
+           models[prefetch_candidates[prefetch_next]].gpu_count > 0) {
+        prefetch_next++;
+    }
+
+    for (unsigned i = prefetch_next; i < prefetch_candidates.size(); i++) {
+        Model &model = models[prefetch_candidates[i]];
+        if (model.gpu_count > 0) continue;
+        if (model.weights_pages > free_pages) continue;
+
+        detach(model);
+        invalidatePriorities(model);
+        addGPU(model, gpus[gpu_id]);
+        distributeLoad(model);
+
+        return model.id;
+    }
+
+    return -1;
+}
+
+void LoadTracker::updateForecasts(const std::vector<int64_t> &forecasts) {
+    CHECK(forecasts.size() == n_models) << "Expected " << n_models << " forecasts, got " << forecasts.size();
+
+    prefetch_candidates.clear();
+    prefetch_next = 0;
+    for (unsigned i = 0; i < n_models; i++) {
+        Model &model = models[i];
+        if (model.forecast != forecasts[i]) {
+            detach(model);
+            invalidatePriorities(model);
+            model.forecast = forecasts[i];
+        }
+        if (model.forecast > 0) {
+            prefetch_candidates.push_back(i);
+        }
+    }
+
+    std::stable_sort(prefetch_candidates.begin(), prefetch_candidates.end(), [this](int a, int b) {
+        return models[a].forecast > models[b].forecast;
+    });
+}
+
 void LoadTracker::process(ModelLoadTracker* tracker) {
     // Detach the model
     Model& model = models[tracker->model_id];
@@ -32,6 +32,8 @@ class LoadTracker {
     struct Model {
         int id;
         int gpu_count = 0;
+        unsigned weights_pages = 0;
+        int64_t forecast = 0; // Forecast requests in the next interval
         std::vector<bool> gpus;
         std::vector<bool> loading;
 
@@ -54,6 +56,7 @@ class LoadTracker {
         int64_t priority = 0;
         int preference = 0;
         bool is_empty = true;
+        int64_t forecast = 0;
         uint64_t last_used = 0;
         Model* model;
         ModelPriority(Model* model) : model(model) {}
@@ -62,7 +65,12 @@ class LoadTracker {
     struct CompareModelPriority {
         bool operator() (const ModelPriority* a, const ModelPriority* b) const {
             if (a->is_empty && b->is_empty) {
-                return a->last_used > b->last_used;
+                // Idle models expected to receive requests soon are evicted last
+                if (a->forecast == b->forecast) {
+                    return a->last_used > b->last_used;
+                } else {
+                    return a->forecast > b->forecast;
+                }
             } else if (!a->is_empty && !b->is_empty) {
                 if (a->priority == b->priority) {
                     return a->last_used > b->last_used;
@@ -107,6 +115,9 @@ class LoadTracker {
 
     std::priority_queue<Request, std::vector<Request>, std::greater<Request>> requests;
 
+    std::vector<int> prefetch_candidates; // Models with a positive forecast, most demand first
+    unsigned prefetch_next = 0; // Earlier candidates were already loaded
+
     void attach(GPU &gpu);
     void detach(Model &model);
 
@@ -127,11 +138,17 @@ class LoadTracker {
 
     LoadTracker(int num_gpus, int num_models, uint64_t capacity);
 
-    ModelLoadTracker* newModelTracker(int model_id);
+    ModelLoadTracker* newModelTracker(int model_id, unsigned weights_pages = 0);
 
     int loadModel(int gpu_id, bool requires_eviction = false);
     int evictModel(int gpu_id);
 
+    // Picks a model with forecast demand that isn't on any GPU and fits in free_pages
+    int prefetchModel(int gpu_id, unsigned free_pages);
+
+    // Forecast requests per model in the next interval; used for prefetching and eviction
+    void updateForecasts(const std::vector<int64_t> &forecasts);
+
     // Process all updates to a model's load
     void process(ModelLoadTracker* tracker);
 };
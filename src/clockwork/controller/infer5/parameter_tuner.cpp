@@ -0,0 +1,99 @@
+#include "clockwork/controller/infer5/parameter_tuner.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace clockwork {
+namespace scheduler {
+namespace infer5 {
+
+ParameterTuner::Parameter::Parameter(std::string name, uint64_t value, uint64_t min, uint64_t max, double step) :
+        name(name), value(value), min(min), max(max), step(step) {
+}
+
+ParameterTuner::ParameterTuner(uint64_t schedule_ahead, uint64_t latest_delta,
+                               uint64_t max_exec, unsigned max_batch) :
+        // The command-line values of max_exec and max_batch are upper bounds, since models
+        // exclude batch sizes above them at startup
+        schedule_ahead("schedule_ahead", schedule_ahead,
+                       std::min(schedule_ahead, 2000000UL), 4 * schedule_ahead, step),
+        latest_delta("latest_delta", latest_delta,
+                     std::min(latest_delta, 2000000UL), 4 * latest_delta, step),
+        max_exec("max_exec", max_exec, max_exec / 8, max_exec, step),
+        max_batch("max_batch", max_batch, 1, max_batch, 2) {
+}
+
+void ParameterTuner::vote(Parameter &parameter, int direction, std::string reason,
+                          std::vector<Adjustment> &adjustments) {
+    if (parameter.hold > 0) {
+        parameter.hold--;
+        parameter.direction = 0;
+        parameter.streak = 0;
+        return;
+    }
+
+    if (direction == 0 || direction != parameter.direction) {
+        parameter.direction = direction;
+        parameter.streak = direction == 0 ? 0 : 1;
+    } else {
+        parameter.streak++;
+    }
+    if (parameter.streak < patience) return;
+
+    uint64_t before = parameter.value;
+    uint64_t after = direction > 0 ? std::llround(before * parameter.step)
+                                   : std::llround(before / parameter.step);
+    if (after == before) after = direction > 0 ? before + 1 : before - 1;
+    after = std::max(parameter.min, std::min(parameter.max, after));
+
+    parameter.direction = 0;
+    parameter.streak = 0;
+    if (after == before) return;
+
+    parameter.value = after;
+    parameter.hold = cooldown;
+    adjustments.push_back({parameter.name, before, after, reason});
+}
+
+std::vector<ParameterTuner::Adjustment> ParameterTuner::update(const Observation &observation) {
+    std::vector<Adjustment> adjustments;
+
+    uint64_t completed = observation.met + observation.missed;
+    if (completed < min_requests) return adjustments;
+
+    double attainment = observation.met / ((double) completed);
+    double error_rate = observation.infer_actions == 0 ? 0 :
+                        observation.infer_errors / ((double) observation.infer_actions);
+    bool busy = observation.utilization > high_utilization;
+    bool idle = observation.utilization < low_utilization;
+    bool dropping = error_rate > max_error_rate;
+
+    std::stringstream s;
+    s << "attainment=" << attainment << " utilization=" << observation.utilization
+      << " error_rate=" << error_rate << " lag=" << observation.mean_lag;
+    std::string state = s.str();
+
+    int ahead = 0;
+    if (dropping || idle) ahead = -1;
+    else if (busy) ahead = 1;
+    vote(schedule_ahead, ahead, state, adjustments);
+
+    int delta = 0;
+    if (dropping) delta = 1;
+    else if (observation.infer_errors == 0 && observation.mean_lag < latest_delta.value / 4) delta = -1;
+    vote(latest_delta, delta, state, adjustments);
+
+    int batching = 0;
+    if (attainment < target_attainment) {
+        if (busy) batching = 1;
+        else if (idle) batching = -1;
+    }
+    vote(max_exec, batching, state, adjustments);
+    vote(max_batch, batching, state, adjustments);
+
+    return adjustments;
+}
+
+}
+}
+}
@@ -0,0 +1,91 @@
+#ifndef _CLOCKWORK_CONTROLLER_INFER5_PARAMETER_TUNER_H_
+#define _CLOCKWORK_CONTROLLER_INFER5_PARAMETER_TUNER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace clockwork {
+namespace scheduler {
+namespace infer5 {
+
+/*
+Feedback controller for the scheduler's schedule_ahead, latest_delta, max_allowable_exec_time
+and max_batch_size, driven by what was observed in each tuning interval.
+
+  schedule_ahead  grows when the GPUs are busy and workers keep up, so that worker queues
+                  don't run dry; shrinks when the GPUs are mostly idle, so that scheduling
+                  decisions are made later with more information, or when workers drop
+                  actions, which means their queues are too deep.
+  latest_delta    grows when workers drop actions for starting too late; shrinks when none
+                  are dropped and results are late by much less than the allowance.
+  max_exec and    grow when SLOs are missed while the GPUs are busy, since larger batches
+  max_batch       give more throughput; shrink when SLOs are missed while the GPUs are
+                  mostly idle, since then exec latency is what's missing the SLOs.
+
+Each parameter moves multiplicatively within [min, max].  For hysteresis, a parameter only
+moves after the same signal persists for `patience` intervals, then holds for `cooldown`
+intervals.  The utilization thresholds leave a dead band in which nothing changes, and
+intervals with fewer than min_requests completed requests are ignored.
+*/
+class ParameterTuner {
+ public:
+    static constexpr double target_attainment = 0.99; // fraction of requests meeting their SLO
+    static constexpr double high_utilization = 0.8;
+    static constexpr double low_utilization = 0.3;
+    static constexpr double max_error_rate = 0.01; // fraction of infer actions dropped by workers
+    static constexpr double step = 1.25; // multiplicative step; max_batch steps by 2
+    static const unsigned patience = 3;
+    static const unsigned cooldown = 5;
+    static const uint64_t min_requests = 100;
+
+    struct Observation {
+        uint64_t met = 0; // requests that met their SLO
+        uint64_t missed = 0; // requests that missed their SLO, timed out, or were rejected
+        uint64_t infer_actions = 0;
+        uint64_t infer_errors = 0; // infer actions that failed on the worker
+        double utilization = 0; // expected exec time sent, as a fraction of GPU time
+        uint64_t mean_lag = 0; // how late results completed relative to expectations
+    };
+
+    struct Adjustment {
+        std::string parameter;
+        uint64_t before;
+        uint64_t after;
+        std::string reason;
+    };
+
+    struct Parameter {
+        std::string name;
+        uint64_t value;
+        uint64_t min;
+        uint64_t max;
+        double step;
+        int direction = 0; // direction of the current streak
+        unsigned streak = 0;
+        unsigned hold = 0; // intervals remaining in cooldown
+
+        Parameter(std::string name, uint64_t value, uint64_t min, uint64_t max, double step);
+    };
+
+    Parameter schedule_ahead;
+    Parameter latest_delta;
+    Parameter max_exec;
+    Parameter max_batch;
+
+    ParameterTuner(uint64_t schedule_ahead, uint64_t latest_delta,
+                   uint64_t max_exec, unsigned max_batch);
+
+    // Returns the parameters that changed
+    std::vector<Adjustment> update(const Observation &observation);
+
+ private:
+    void vote(Parameter &parameter, int direction, std::string reason,
+              std::vector<Adjustment> &adjustments);
+};
+
+}
+}
+}
+
+#endif // _CLOCKWORK_CONTROLLER_INFER5_PARAMETER_TUNER_H_
@@ -0,0 +1,176 @@
+// Copyright 2020 Max Planck Institute for Software Systems
+
+#ifndef SRC_CLOCKWORK_CONTROLLER_INFER5_REQUEST_LOG_H_
+#define SRC_CLOCKWORK_CONTROLLER_INFER5_REQUEST_LOG_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace clockwork {
+namespace scheduler {
+namespace infer5 {
+
+/*
+The pending requests of one model, viewed as one queue per supported batch size.
+
+Every batch size sees the same requests in the same order, and differs only in how far
+it has dropped requests from the front, because a larger batch takes longer and so
+expires requests sooner.  Rather than copying each request into every queue, requests are
+appended once to a shared log and each batch size is a cursor into the log.  Dropping or
+taking requests only advances cursors; entries are released once by trim(), after every
+cursor has passed them.
+
+Each entry also records the maximum deadline of all entries up to and including itself.
+While deadlines arrive in order, these are sorted and drop_expired binary searches them.
+If an earlier request has a later deadline than the completion time, drop_expired falls
+back to a linear scan, which visits each expired entry at most once per cursor.
+
+Not thread-safe; the model's lock protects it.
+*/
+template <typename T> class RequestLog {
+ private:
+    struct Entry {
+        T value;
+        uint64_t deadline;
+        uint64_t max_deadline; // Max deadline of this and all earlier entries
+    };
+
+    std::deque<Entry> log;
+    uint64_t begin = 0; // seqno of log.front()
+    uint64_t end = 0; // seqno of the next entry pushed
+    uint64_t trimmed_max_deadline = 0; // max_deadline of the last trimmed entry
+    std::vector<uint64_t> heads; // seqno of the front of each cursor
+
+    Entry& at(uint64_t seqno) { return log[seqno - begin]; }
+
+    uint64_t max_deadline_before(uint64_t seqno) {
+        return seqno == begin ? trimmed_max_deadline : at(seqno - 1).max_deadline;
+    }
+
+ public:
+
+    explicit RequestLog(unsigned num_cursors) : heads(num_cursors, 0) {}
+
+    // Appends to all cursors; returns the seqno of the new entry
+    uint64_t push(const T &value, uint64_t deadline) {
+        uint64_t previous = log.empty() ? trimmed_max_deadline : log.back().max_deadline;
+        log.push_back(Entry{value, deadline, std::max(previous, deadline)});
+        return end++;
+    }
+
+    unsigned size(unsigned cursor) { return end - heads[cursor]; }
+    T& front(unsigned cursor) { return at(heads[cursor]).value; }
+    uint64_t front_deadline(unsigned cursor) { return at(heads[cursor]).deadline; }
+
+    // Drops entries from the front of the cursor while their deadline is before completion_time
+    void drop_expired(unsigned cursor, uint64_t completion_time) {
+        uint64_t &head = heads[cursor];
+        if (max_deadline_before(head) < completion_time) {
+            auto it = std::partition_point(log.begin() + (head - begin), log.end(),
+                [completion_time](const Entry &entry) {
+                    return entry.max_deadline < completion_time;
+                });
+            head = begin + (it - log.begin());
+        } else {
+            while (head < end && at(head).deadline < completion_time) {
+                head++;
+            }
+        }
+    }
+
+    // Takes count entries from the front of the cursor; returns the seqno of the last one
+    uint64_t take(unsigned cursor, unsigned count, std::vector<T> &taken) {
+        uint64_t &head = heads[cursor];
+        for (unsigned i = 0; i < count; i++) {
+            taken.push_back(at(head++).value);
+        }
+        return head - 1;
+    }
+
+    // Drops all entries up to and including seqno from every cursor
+    void catch_up(uint64_t seqno) {
+        for (auto &head : heads) {
+            head = std::max(head, seqno + 1);
+        }
+    }
+
+    // Releases entries that every cursor has passed
+    void trim() {
+        uint64_t min_head = *std::min_element(heads.begin(), heads.end());
+        while (begin < min_head) {
+            trimmed_max_deadline = log.front().max_deadline;
+            log.pop_front();
+            begin++;
+        }
+    }
+
+};
+
+/*
+The previous representation, with a copy of every request in one deque per batch size.
+Retained as a reference for testing and profiling RequestLog.
+*/
+template <typename T> class ReplicatedRequestQueues {
+ private:
+    struct Entry {
+        T value;
+        uint64_t seqno;
+        uint64_t deadline;
+    };
+
+    uint64_t seqno_seed = 0;
+    std::vector<std::deque<Entry>> queues;
+
+ public:
+
+    explicit ReplicatedRequestQueues(unsigned num_cursors) : queues(num_cursors) {}
+
+    uint64_t push(const T &value, uint64_t deadline) {
+        Entry entry{value, seqno_seed, deadline};
+        for (auto &queue : queues) {
+            queue.push_back(entry);
+        }
+        return seqno_seed++;
+    }
+
+    unsigned size(unsigned cursor) { return queues[cursor].size(); }
+    T& front(unsigned cursor) { return queues[cursor].front().value; }
+    uint64_t front_deadline(unsigned cursor) { return queues[cursor].front().deadline; }
+
+    void drop_expired(unsigned cursor, uint64_t completion_time) {
+        auto &queue = queues[cursor];
+        while (queue.size() > 0 && queue.front().deadline < completion_time) {
+            queue.pop_front();
+        }
+    }
+
+    uint64_t take(unsigned cursor, unsigned count, std::vector<T> &taken) {
+        auto &queue = queues[cursor];
+        uint64_t seqno = 0;
+        for (unsigned i = 0; i < count; i++) {
+            taken.push_back(queue.front().value);
+            seqno = queue.front().seqno;
+            queue.pop_front();
+        }
+        return seqno;
+    }
+
+    void catch_up(uint64_t seqno) {
+        for (auto &queue : queues) {
+            while (queue.size() > 0 && queue.front().seqno <= seqno) {
+                queue.pop_front();
+            }
+        }
+    }
+
+    void trim() {}
+
+};
+
+}
+}
+}
+
+#endif // SRC_CLOCKWORK_CONTROLLER_INFER5_REQUEST_LOG_H_
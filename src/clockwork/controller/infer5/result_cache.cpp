@@ -0,0 +1,216 @@
+#include "clockwork/controller/infer5/result_cache.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+
+namespace clockwork {
+namespace scheduler {
+namespace infer5 {
+
+namespace {
+
+inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t fmix64(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+void murmur3_128(const void* key, size_t len, uint64_t seed, uint64_t &out1, uint64_t &out2) {
+    const uint8_t* data = static_cast<const uint8_t*>(key);
+    const size_t nblocks = len / 16;
+    const uint64_t c1 = 0x87c37b91114253d5ULL;
+    const uint64_t c2 = 0x4cf5ad432745937fULL;
+
+    uint64_t h1 = seed;
+    uint64_t h2 = seed;
+
+    for (size_t i = 0; i < nblocks; i++) {
+        uint64_t k1, k2;
+        memcpy(&k1, data + i * 16, 8);
+        memcpy(&k2, data + i * 16 + 8, 8);
+
+        k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+        h1 = rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+
+        k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+        h2 = rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    const uint8_t* tail = data + nblocks * 16;
+    uint64_t k1 = 0;
+    uint64_t k2 = 0;
+    size_t remaining = len & 15;
+    for (size_t i = remaining; i > 8; i--) {
+        k2 ^= static_cast<uint64_t>(tail[i - 1]) << (8 * (i - 9));
+    }
+    if (remaining > 8) {
+        k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+    }
+    for (size_t i = std::min(remaining, (size_t) 8); i > 0; i--) {
+        k1 ^= static_cast<uint64_t>(tail[i - 1]) << (8 * (i - 1));
+    }
+    if (remaining > 0) {
+        k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+    }
+
+    h1 ^= len;
+    h2 ^= len;
+    h1 += h2;
+    h2 += h1;
+    h1 = fmix64(h1);
+    h2 = fmix64(h2);
+    h1 += h2;
+    h2 += h1;
+
+    out1 = h1;
+    out2 = h2;
+}
+
+char* copy(const void* data, size_t size) {
+    if (size == 0) return nullptr;
+    char* result = static_cast<char*>(malloc(size));
+    memcpy(result, data, size);
+    return result;
+}
+
+}
+
+ResultCache::ResultCache(size_t capacity, uint64_t ttl) :
+        capacity(capacity), ttl(ttl), hits(0), joins(0), misses(0), evictions(0) {
+    for (unsigned i = 0; i < num_shards; i++) {
+        shards.push_back(new Shard());
+    }
+}
+
+ResultCache::~ResultCache() {
+    for (Shard* shard : shards) {
+        for (Entry &entry : shard->lru) {
+            free(entry.output);
+        }
+        delete shard;
+    }
+}
+
+ResultCache::Key ResultCache::key(int model_id, const void* input, size_t input_size) {
+    Key key;
+    key.model_id = model_id;
+    murmur3_128(input, input_size, model_id, key.hi, key.lo);
+    return key;
+}
+
+void ResultCache::erase(Shard* shard, std::list<Entry>::iterator it) {
+    shard->bytes -= it->output_size;
+    free(it->output);
+    shard->entries.erase(it->key);
+    shard->lru.erase(it);
+}
+
+ResultCache::Status ResultCache::lookup(const Key &key, uint64_t now,
+                                        clientapi::InferenceRequest &request, uint64_t deadline,
+                                        std::function<void(clientapi::InferenceResponse&)> callback,
+                                        clientapi::InferenceResponse &response) {
+    Shard* shard = this->shard(key);
+    std::lock_guard<std::mutex> lock(shard->mutex);
+
+    auto cached = shard->entries.find(key);
+    if (cached != shard->entries.end()) {
+        auto it = cached->second;
+        if (it->expires > now) {
+            shard->lru.splice(shard->lru.begin(), shard->lru, it);
+
+            response.header.user_request_id = request.header.user_request_id;
+            response.header.status = clockworkSuccess;
+            response.header.message = "";
+            response.model_id = request.model_id;
+            response.batch_size = request.batch_size;
+            response.output_size = it->output_size;
+            response.output = copy(it->output, it->output_size);
+            response.deadline = deadline;
+            response.cache_status = hit;
+            hits++;
+            return hit;
+        }
+        erase(shard, it);
+    }
+
+    auto inflight = shard->inflight.find(key);
+    if (inflight != shard->inflight.end()) {
+        inflight->second.push_back({request.header.user_request_id, request.batch_size, deadline, callback});
+        joins++;
+        return joined;
+    }
+
+    shard->inflight[key];
+    misses++;
+    return miss;
+}
+
+void ResultCache::complete(const Key &key, uint64_t now, clientapi::InferenceResponse &response) {
+    Shard* shard = this->shard(key);
+    std::vector<Waiter> waiters;
+    {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+
+        auto inflight = shard->inflight.find(key);
+        if (inflight != shard->inflight.end()) {
+            waiters = std::move(inflight->second);
+            shard->inflight.erase(inflight);
+        }
+
+        size_t shard_capacity = capacity / num_shards;
+        if (response.header.status == clockworkSuccess && response.output_size <= shard_capacity) {
+            auto existing = shard->entries.find(key);
+            if (existing != shard->entries.end()) erase(shard, existing->second);
+
+            // Expired entries are at the back once they stop being used
+            while (!shard->lru.empty() && (shard->bytes + response.output_size > shard_capacity
+                                           || shard->lru.back().expires <= now)) {
+                erase(shard, std::prev(shard->lru.end()));
+                evictions++;
+            }
+
+            shard->lru.push_front({key, copy(response.output, response.output_size),
+                                   response.output_size, now + ttl});
+            shard->entries[key] = shard->lru.begin();
+            shard->bytes += response.output_size;
+        }
+    }
+
+    for (Waiter &waiter : waiters) {
+        clientapi::InferenceResponse joined_response;
+        joined_response.header.user_request_id = waiter.user_request_id;
+        joined_response.header.status = response.header.status;
+        joined_response.header.message = response.header.message;
+        joined_response.model_id = response.model_id;
+        joined_response.batch_size = waiter.batch_size;
+        joined_response.output_size = response.output_size;
+        joined_response.output = copy(response.output, response.output_size);
+        joined_response.retry_after = response.retry_after;
+        joined_response.deadline = waiter.deadline;
+        joined_response.arrival_count = response.arrival_count;
+        joined_response.departure_count = response.departure_count;
+        joined_response.cache_status = joined;
+        waiter.callback(joined_response);
+    }
+}
+
+size_t ResultCache::size_bytes() {
+    size_t total = 0;
+    for (Shard* shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        total += shard->bytes;
+    }
+    return total;
+}
+
+}
+}
+}
@@ -0,0 +1,111 @@
+#ifndef _CLOCKWORK_CONTROLLER_INFER5_RESULT_CACHE_H_
+#define _CLOCKWORK_CONTROLLER_INFER5_RESULT_CACHE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "clockwork/api/client_api.h"
+
+namespace clockwork {
+namespace scheduler {
+namespace infer5 {
+
+/*
+Caches inference results by (model id, 128-bit hash of the input), so that byte-identical
+requests don't each cost a batch slot on a GPU.
+
+Identical requests that arrive while the first is still executing join it rather than
+executing again; they get a copy of its response, successful or not.  Only successful
+results are cached.  Entries expire after ttl, and the least recently used entries are
+evicted to keep the cached outputs within capacity bytes.
+
+The cache is split into shards by key, each with its own lock.  Callbacks of joined
+requests are invoked outside of the lock.
+*/
+class ResultCache {
+ public:
+    static const unsigned num_shards = 16;
+
+    // Values of clientapi::InferenceResponse::cache_status
+    enum Status { miss = 0, hit = 1, joined = 2 };
+
+    struct Key {
+        int model_id;
+        uint64_t hi;
+        uint64_t lo;
+
+        bool operator==(const Key &other) const {
+            return model_id == other.model_id && hi == other.hi && lo == other.lo;
+        }
+    };
+
+    const size_t capacity; // bytes of cached outputs
+    const uint64_t ttl;
+
+    std::atomic_uint64_t hits;
+    std::atomic_uint64_t joins;
+    std::atomic_uint64_t misses;
+    std::atomic_uint64_t evictions;
+
+ private:
+    struct KeyHash {
+        size_t operator()(const Key &key) const { return key.lo ^ key.model_id; }
+    };
+
+    struct Entry {
+        Key key;
+        char* output;
+        size_t output_size;
+        uint64_t expires;
+    };
+
+    struct Waiter {
+        int user_request_id;
+        int batch_size;
+        uint64_t deadline;
+        std::function<void(clientapi::InferenceResponse&)> callback;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::list<Entry> lru; // most recently used first
+        std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> entries;
+        std::unordered_map<Key, std::vector<Waiter>, KeyHash> inflight;
+        size_t bytes = 0;
+    };
+
+    std::vector<Shard*> shards;
+
+    Shard* shard(const Key &key) { return shards[key.hi % num_shards]; }
+    void erase(Shard* shard, std::list<Entry>::iterator it);
+
+ public:
+    ResultCache(size_t capacity, uint64_t ttl);
+    ~ResultCache();
+
+    // MurmurHash3 x64_128 of the input
+    static Key key(int model_id, const void* input, size_t input_size);
+
+    /* On a hit, fills in response with a copy of the cached output.  If an identical request
+    is in flight, callback will receive a copy of its response.  On a miss, the request is now
+    in flight, and the caller must pass its response to complete().  deadline is the request's
+    SLO deadline, for telemetry. */
+    Status lookup(const Key &key, uint64_t now, clientapi::InferenceRequest &request, uint64_t deadline,
+                  std::function<void(clientapi::InferenceResponse&)> callback,
+                  clientapi::InferenceResponse &response);
+
+    // Caches a successful response and responds to the requests that joined it
+    void complete(const Key &key, uint64_t now, clientapi::InferenceResponse &response);
+
+    size_t size_bytes();
+};
+
+}
+}
+}
+
+#endif // _CLOCKWORK_CONTROLLER_INFER5_RESULT_CACHE_H_
@@ -0,0 +1,36 @@
+#include "clockwork/controller/infer5/scheduling_policy.h"
+
+namespace clockwork {
+namespace scheduler {
+namespace infer5 {
+
+DeadlinePolicy::DeadlinePolicy(bool prefetch, uint64_t max_batch_wait) :
+        prefetch(prefetch), max_batch_wait(max_batch_wait) {
+}
+
+uint64_t DeadlinePolicy::infer_priority(const InferOption &option) {
+    return option.deadline - option.exec_time + option.tenant_penalty;
+}
+
+BatchPlan DeadlinePolicy::plan(const BatchOptions &options) {
+    return plan_batch(options.batch_sizes, options.exec_times, options.available,
+                      options.slack, options.interarrival, max_batch_wait);
+}
+
+int DeadlinePolicy::choose_load(LoadTracker* tracker, const LoadOption &option, bool &prefetch) {
+    prefetch = false;
+    int model_id = tracker->loadModel(option.gpu_id, option.eviction_required);
+    if (model_id == -1 && this->prefetch && option.pcie_idle) {
+        model_id = tracker->prefetchModel(option.gpu_id, option.free_pages);
+        prefetch = model_id != -1;
+    }
+    return model_id;
+}
+
+int DeadlinePolicy::choose_eviction(LoadTracker* tracker, unsigned gpu_id) {
+    return tracker->evictModel(gpu_id);
+}
+
+}
+}
+}
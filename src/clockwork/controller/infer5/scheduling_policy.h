@@ -0,0 +1,88 @@
+#ifndef _CLOCKWORK_CONTROLLER_INFER5_SCHEDULING_POLICY_H_
+#define _CLOCKWORK_CONTROLLER_INFER5_SCHEDULING_POLICY_H_
+
+#include <cstdint>
+#include <vector>
+#include "clockwork/controller/infer5/batch_planner.h"
+#include "clockwork/controller/infer5/load_tracker.h"
+
+namespace clockwork {
+namespace scheduler {
+namespace infer5 {
+
+/*
+The decisions the infer5 runtime delegates to a policy.  The runtime owns admission, the
+per-model request logs, GPU exec and PCIe horizons, action dispatch and result routing; a
+policy only decides which batch a GPU runs next, how a model's requests are batched, and
+which models a GPU loads and evicts.
+
+Policy methods are called concurrently from the infer and load threads of different GPUs.
+choose_load and choose_eviction are called with the LoadTracker's locks held.
+*/
+class SchedulingPolicy {
+ public:
+
+    // A batch that a model could run next on a GPU
+    struct InferOption {
+        unsigned model_id;
+        unsigned batch_size;
+        uint64_t deadline; // exec deadline of the model's earliest queued request
+        uint64_t exec_time; // estimated exec time of the batch
+        int user_id; // tenant of the earliest queued request
+        uint64_t tenant_penalty; // deprioritization of that tenant for exceeding its fair share
+    };
+
+    // The batches a model could run next, indexed by supported batch size, ascending
+    struct BatchOptions {
+        std::vector<unsigned> batch_sizes;
+        std::vector<uint64_t> exec_times;
+        std::vector<unsigned> available; // requests that could meet their deadline at this batch size
+        std::vector<uint64_t> slack; // how long this batch size could be delayed
+        uint64_t interarrival; // recent mean time between the model's arrivals
+    };
+
+    struct LoadOption {
+        unsigned gpu_id;
+        bool eviction_required; // the GPU is at capacity, so loading means evicting
+        bool pcie_idle; // no weights transfers are outstanding on the GPU
+        unsigned free_pages;
+    };
+
+    virtual ~SchedulingPolicy() {}
+
+    // Across all models, GPUs run the option with the lowest priority first
+    virtual uint64_t infer_priority(const InferOption &option) = 0;
+
+    // Whether to run a batch now, and of which size
+    virtual BatchPlan plan(const BatchOptions &options) = 0;
+
+    // The model to load on a GPU, or -1.  Sets prefetch if not for outstanding demand.
+    virtual int choose_load(LoadTracker* tracker, const LoadOption &option, bool &prefetch) = 0;
+
+    // A model to evict from a GPU to make room, or -1
+    virtual int choose_eviction(LoadTracker* tracker, unsigned gpu_id) = 0;
+};
+
+/*
+infer5's default policy.  Batches run in order of deadline less exec time, plus the tenant's
+fair-share penalty.  Batching follows plan_batch.  Loads follow the LoadTracker's demand, and
+if prefetching is enabled, fill spare pages ahead of forecast demand while PCIe is idle.
+*/
+class DeadlinePolicy : public SchedulingPolicy {
+ public:
+    const bool prefetch; // whether arrival forecasts are available to prefetch from
+    const uint64_t max_batch_wait; // max time to hold back a batch waiting for more requests
+
+    DeadlinePolicy(bool prefetch, uint64_t max_batch_wait);
+
+    uint64_t infer_priority(const InferOption &option);
+    BatchPlan plan(const BatchOptions &options);
+    int choose_load(LoadTracker* tracker, const LoadOption &option, bool &prefetch);
+    int choose_eviction(LoadTracker* tracker, unsigned gpu_id);
+};
+
+}
+}
+}
+
+#endif // _CLOCKWORK_CONTROLLER_INFER5_SCHEDULING_POLICY_H_
@@ -0,0 +1,143 @@
+#include "clockwork/controller/infer5/tenant_tracker.h"
+#include <algorithm>
+#include <sstream>
+#include "dmlc/logging.h"
+
+namespace clockwork {
+namespace scheduler {
+namespace infer5 {
+
+TenantTracker::TenantTracker(uint64_t max_penalty, uint64_t active_window) :
+        max_penalty(max_penalty),
+        active_window(active_window),
+        tenants(max_tenants),
+        system_vtime(0) {
+}
+
+void TenantTracker::configure(int user_id, double weight, double reserved) {
+    CHECK(weight > 0) << "Tenant " << user_id << " weight must be positive, got " << weight;
+    CHECK(reserved >= 0 && reserved <= 1) << "Tenant " << user_id
+        << " reserved share must be in [0, 1], got " << reserved;
+
+    Tenant &tenant = get(user_id);
+    tenant.weight = weight;
+    tenant.reserved = reserved;
+}
+
+void TenantTracker::configure(std::string spec) {
+    std::stringstream ss(spec);
+    std::string entry;
+    while (std::getline(ss, entry, ',')) {
+        if (entry.empty()) continue;
+
+        std::vector<std::string> fields;
+        std::stringstream es(entry);
+        std::string field;
+        while (std::getline(es, field, ':')) {
+            fields.push_back(field);
+        }
+        CHECK(fields.size() == 2 || fields.size() == 3)
+            << "Invalid tenant spec " << entry << ", expected user_id:weight[:reserved]";
+
+        configure(std::stoi(fields[0]), std::stod(fields[1]),
+                  fields.size() == 3 ? std::stod(fields[2]) : 0.0);
+    }
+}
+
+void TenantTracker::arrived(int user_id, uint64_t now) {
+    Tenant &tenant = get(user_id);
+
+    // Avoid writing the shared cache line for every request
+    uint64_t last_arrival = tenant.last_arrival.load(std::memory_order_relaxed);
+    if (now < last_arrival + active_window / 100) return;
+    tenant.last_arrival.store(now, std::memory_order_relaxed);
+
+    // Idle tenants don't bank credit while away
+    if (last_arrival == 0 || now > last_arrival + active_window) {
+        uint64_t system = system_vtime.load(std::memory_order_relaxed);
+        uint64_t vtime = tenant.vtime.load(std::memory_order_relaxed);
+        while (vtime < system && !tenant.vtime.compare_exchange_weak(vtime, system));
+    }
+}
+
+void TenantTracker::charge(int user_id, uint64_t duration) {
+    Tenant &tenant = get(user_id);
+    tenant.vtime.fetch_add(duration / tenant.weight, std::memory_order_relaxed);
+    tenant.recent.fetch_add(duration, std::memory_order_relaxed);
+    tenant.charged.fetch_add(duration, std::memory_order_relaxed);
+}
+
+double TenantTracker::demand_scale(int user_id) {
+    if (max_penalty == 0) return 1.0;
+    return max_penalty / ((double) (max_penalty + penalty(user_id)));
+}
+
+void TenantTracker::refresh(uint64_t now) {
+    uint64_t min_vtime = UINT64_MAX;
+    uint64_t total = 0;
+    std::vector<uint64_t> recent(max_tenants);
+    for (unsigned i = 0; i < max_tenants; i++) {
+        Tenant &tenant = tenants[i];
+        recent[i] = tenant.recent.exchange(0, std::memory_order_relaxed);
+        total += recent[i];
+
+        if (!active(tenant, now)) continue;
+        min_vtime = std::min(min_vtime, tenant.vtime.load(std::memory_order_relaxed));
+    }
+
+    // System virtual time never goes backwards
+    uint64_t system = system_vtime.load(std::memory_order_relaxed);
+    if (min_vtime != UINT64_MAX && min_vtime > system) {
+        system = min_vtime;
+        system_vtime.store(system, std::memory_order_relaxed);
+    }
+
+    for (unsigned i = 0; i < max_tenants; i++) {
+        Tenant &tenant = tenants[i];
+        double share = tenant.share;
+        if (total > 0) {
+            share = recent[i] / ((double) total);
+            tenant.share = share;
+        }
+
+        uint64_t vtime = tenant.vtime.load(std::memory_order_relaxed);
+        uint64_t penalty = 0;
+        if (share >= tenant.reserved && vtime > system) {
+            penalty = std::min(max_penalty, vtime - system);
+        }
+        tenant.penalty.store(penalty, std::memory_order_relaxed);
+    }
+}
+
+std::string TenantTracker::str(uint64_t now) {
+    std::stringstream s;
+    s << "Tenants:";
+    for (unsigned i = 0; i < max_tenants; i++) {
+        Tenant &tenant = tenants[i];
+        if (!active(tenant, now)) continue;
+        s << " u" << i << "=" << ((int) (tenant.share * 100)) << "%"
+          << "/p" << (tenant.penalty / 1000000) << "ms";
+    }
+    return s.str();
+}
+
+void TenantTracker::collect_metrics(metrics::Writer &writer) {
+    for (unsigned i = 0; i < max_tenants; i++) {
+        Tenant &tenant = tenants[i];
+        if (tenant.last_arrival.load(std::memory_order_relaxed) == 0) continue;
+
+        metrics::Labels labels = {{"tenant", std::to_string(i)}};
+        writer.counter("clockwork_tenant_charged_seconds_total",
+            "GPU exec and weights load time charged to the tenant",
+            tenant.charged.load(std::memory_order_relaxed) / 1000000000.0, labels);
+        writer.gauge("clockwork_tenant_share",
+            "Tenant's fraction of all charged time in the last refresh interval", tenant.share, labels);
+        writer.gauge("clockwork_tenant_penalty_seconds",
+            "How much later the tenant's requests are prioritized for exceeding its fair share",
+            tenant.penalty.load(std::memory_order_relaxed) / 1000000000.0, labels);
+    }
+}
+
+}
+}
+}
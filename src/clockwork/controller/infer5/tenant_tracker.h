@@ -0,0 +1,97 @@
+#ifndef _CLOCKWORK_CONTROLLER_INFER5_TENANT_TRACKER_H_
+#define _CLOCKWORK_CONTROLLER_INFER5_TENANT_TRACKER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "clockwork/telemetry/metrics.h"
+
+namespace clockwork {
+namespace scheduler {
+namespace infer5 {
+
+/*
+Weighted fair sharing of GPU time between tenants, identified by the user_id of requests.
+
+Tenants are charged for the GPU exec time of their requests and the PCIe time of weights
+loads made on their behalf.  A tenant's virtual time is its charged time divided by its
+weight.  The system virtual time is the minimum virtual time of the active tenants, and a
+tenant whose virtual time runs ahead of it has received more than its fair share.
+
+That lead is the tenant's penalty: its requests are prioritized as if their deadlines were
+that much later (capped at max_penalty), and its load demand is discounted.  A tenant that
+received less than its reserved fraction of all charged time in the last refresh interval
+is never penalized.  Tenants that go idle re-enter at the system virtual time rather than
+with credit for the time they were away.
+
+Penalties are recomputed by refresh(); the hot path only reads atomics.
+*/
+class TenantTracker {
+ public:
+    static const unsigned max_tenants = 4096; // user_ids are folded into this many tenants
+
+    const uint64_t max_penalty;
+    const uint64_t active_window; // Tenants with no arrivals for this long are idle
+
+ private:
+    struct Tenant {
+        std::atomic_uint64_t vtime;
+        std::atomic_uint64_t recent; // Charged time since the last refresh
+        std::atomic_uint64_t charged; // Total charged time
+        std::atomic_uint64_t last_arrival;
+        std::atomic_uint64_t penalty;
+        double weight = 1.0;
+        double reserved = 0.0;
+        std::atomic<double> share; // Fraction of all charged time in the last refresh interval
+
+        Tenant() : vtime(0), recent(0), charged(0), last_arrival(0), penalty(0), share(0) {}
+    };
+
+    std::vector<Tenant> tenants;
+    std::atomic_uint64_t system_vtime;
+
+    Tenant& get(int user_id) { return tenants[((unsigned) user_id) % max_tenants]; }
+
+    bool active(Tenant &tenant, uint64_t now) {
+        uint64_t last_arrival = tenant.last_arrival.load(std::memory_order_relaxed);
+        return last_arrival != 0 && now <= last_arrival + active_window;
+    }
+
+ public:
+
+    TenantTracker(uint64_t max_penalty, uint64_t active_window = 1000000000UL);
+
+    // Weight must be positive; reserved is a fraction of total GPU time in [0, 1]
+    void configure(int user_id, double weight, double reserved = 0.0);
+
+    // Comma-separated user_id:weight[:reserved], e.g. "0:2:0.25,1:1"
+    void configure(std::string spec);
+
+    // Called for each request on admission
+    void arrived(int user_id, uint64_t now);
+
+    // Charges exec or loadweights time to the tenant
+    void charge(int user_id, uint64_t duration);
+
+    // How much later the tenant's requests should be prioritized, in nanoseconds
+    uint64_t penalty(int user_id) { return get(user_id).penalty.load(std::memory_order_relaxed); }
+
+    // Multiplier in (0, 1] applied to the tenant's LoadTracker demand
+    double demand_scale(int user_id);
+
+    // Recomputes the system virtual time and penalties; called periodically by one thread
+    void refresh(uint64_t now);
+
+    // Summary of active tenants
+    std::string str(uint64_t now);
+
+    // Exports the usage and penalty of every tenant that has made a request
+    void collect_metrics(metrics::Writer &writer);
+};
+
+}
+}
+}
+
+#endif // _CLOCKWORK_CONTROLLER_INFER5_TENANT_TRACKER_H_
@@ -0,0 +1,80 @@
+#include "clockwork/controller/network_executor.h"
+#include "clockwork/util.h"
+
+namespace clockwork {
+namespace scheduler {
+
+template <typename Mutex>
+NetworkExecutorT<Mutex>::NetworkExecutorT(unsigned concurrency, 
+    std::function<void(uint64_t, std::shared_ptr<workerapi::Result>)> error_callback) : 
+idle(concurrency), error_callback(error_callback) {}
+
+template <typename Mutex>
+void NetworkExecutorT<Mutex>::send(network::controller::WorkerConnection* worker, 
+          std::shared_ptr<workerapi::Action> action,
+          uint64_t start_send_by,
+          uint64_t send_error_at) {
+
+    NetworkAction toSend;
+    {
+        typename Mutex::scoped_lock lock(mutex);
+
+        pending.push_back({worker, action, start_send_by, send_error_at});
+
+        if (idle == 0) return;
+
+        if (!next(toSend)) return;
+
+        idle--;
+    }
+
+    toSend.worker->sendAction(toSend.action);            
+}
+
+template <typename Mutex>
+void NetworkExecutorT<Mutex>::sendComplete() {
+    NetworkAction toSend;
+    {
+        typename Mutex::scoped_lock lock(mutex);
+        if (!next(toSend)) {
+            idle++;
+            return;
+        }
+    }
+
+    toSend.worker->sendAction(toSend.action);
+}
+
+template <typename Mutex>
+bool NetworkExecutorT<Mutex>::next(NetworkAction &toSend) {
+    uint64_t now = util::now();
+    while (pending.size() > 0) {
+        toSend = pending.front();
+        pending.pop_front();
+
+        if (toSend.start_send_by >= now) {
+            return true;
+        }
+
+        auto action = toSend.action;
+        auto result = std::make_shared<workerapi::ErrorResult>();
+        result->id = action->id;
+        result->action_type = action->action_type;
+        result->status = networkSendTooLate;
+        result->action_received = now;
+        result->result_sent = now;
+        result->result_received = now;
+        result->message = "Could not send action to worker in time";
+
+        error_callback(toSend.send_error_at, result);
+
+    }
+    return false;
+}
+
+template class NetworkExecutorT<tbb::spin_mutex>;
+template class NetworkExecutorT<tbb::queuing_mutex>;
+
+}
+
+}
@@ -0,0 +1,61 @@
+#ifndef _CLOCKWORK_CONTROLLER_NETWORK_EXECUTOR_H_
+#define _CLOCKWORK_CONTROLLER_NETWORK_EXECUTOR_H_
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include "clockwork/api/worker_api.h"
+#include "clockwork/network/controller.h"
+#include "tbb/queuing_mutex.h"
+#include "tbb/spin_mutex.h"
+
+namespace clockwork {
+namespace scheduler {
+
+/*
+Limits the number of concurrent action transfers to workers, shared by the infer4 and infer5
+schedulers.  Actions queue in the order they were sent; an action that can no longer be sent
+by its start_send_by time is failed with networkSendTooLate, reported to error_callback along
+with its send_error_at time.
+
+The lock type is a parameter so that infer4 keeps its spin_mutex and infer5 its queuing_mutex.
+*/
+template <typename Mutex>
+class NetworkExecutorT {
+ private:
+
+    struct NetworkAction {
+        network::controller::WorkerConnection* worker;
+        std::shared_ptr<workerapi::Action> action;
+        uint64_t start_send_by;
+        uint64_t send_error_at;
+    };
+
+    Mutex mutex;
+    unsigned idle;
+    std::deque<NetworkAction> pending;
+    std::function<void(uint64_t, std::shared_ptr<workerapi::Result>)> error_callback;
+
+ public:
+    NetworkExecutorT(unsigned concurrency, 
+        std::function<void(uint64_t, std::shared_ptr<workerapi::Result>)> error_callback);
+
+    void send(network::controller::WorkerConnection* worker, 
+              std::shared_ptr<workerapi::Action> action,
+              uint64_t start_send_by,
+              uint64_t send_error_at);
+    void sendComplete();
+
+ private:
+
+    bool next(NetworkAction &toSend);
+
+};
+
+typedef NetworkExecutorT<tbb::spin_mutex> SpinNetworkExecutor; // infer4
+typedef NetworkExecutorT<tbb::queuing_mutex> QueuingNetworkExecutor; // infer5
+
+}
+}
+
+#endif // _CLOCKWORK_CONTROLLER_NETWORK_EXECUTOR_H_
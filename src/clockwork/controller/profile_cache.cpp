@@ -0,0 +1,179 @@
+#include "clockwork/controller/profile_cache.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <set>
+#include <vector>
+#include <dmlc/logging.h>
+
+namespace clockwork {
+
+ModelProfileCache::ModelProfileCache(std::string filename, uint64_t max_age_seconds) :
+	filename(filename), max_age_seconds(max_age_seconds) {
+}
+
+std::string ModelProfileCache::key(std::string &model_path, std::string &gpu, unsigned clock) {
+	std::stringstream ss;
+	ss << model_path << "\t" << gpu << "\t" << clock;
+	return ss.str();
+}
+
+uint64_t ModelProfileCache::seconds_now() {
+	return std::chrono::duration_cast<std::chrono::seconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+unsigned ModelProfileCache::load() {
+	std::ifstream in(filename);
+	if (!in.good()) return 0;
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	unsigned count = 0;
+	std::string line;
+	while (std::getline(in, line)) {
+		if (line.empty() || line[0] == '#') continue;
+
+		// model_path, gpu, clock, updated, weights_transfer_duration, exec_durations
+		std::vector<std::string> fields;
+		std::stringstream ss(line);
+		std::string field;
+		while (std::getline(ss, field, '\t')) {
+			fields.push_back(field);
+		}
+		if (fields.size() == 5) fields.push_back("");
+		if (fields.size() != 6) {
+			std::cout << "Ignoring malformed profile cache line: " << line << std::endl;
+			continue;
+		}
+
+		Entry entry;
+		try {
+			unsigned clock = std::stoul(fields[2]);
+			entry.updated = std::stoull(fields[3]);
+			entry.weights_transfer_duration = std::stoull(fields[4]);
+
+			// Exec durations are formatted batchsize:duration,batchsize:duration,...
+			std::stringstream execs(fields[5]);
+			std::string exec;
+			while (std::getline(execs, exec, ',')) {
+				size_t split = exec.find(':');
+				if (split == std::string::npos) continue;
+				unsigned batch_size = std::stoul(exec.substr(0, split));
+				entry.exec_duration[batch_size] = std::stoull(exec.substr(split + 1));
+			}
+
+			entries[key(fields[0], fields[1], clock)] = entry;
+			count++;
+		} catch (const std::exception &e) {
+			std::cout << "Ignoring malformed profile cache line: " << line << std::endl;
+		}
+	}
+
+	return count;
+}
+
+void ModelProfileCache::save() {
+	std::string tmpfilename = filename + ".tmp";
+	{
+		std::ofstream out(tmpfilename);
+		if (!out.good()) {
+			std::cout << "Unable to write profile cache " << tmpfilename << std::endl;
+			return;
+		}
+
+		out << "#model_path\tgpu\tclock\tupdated\tweights_transfer_duration\texec_duration" << std::endl;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		for (auto &p : entries) {
+			Entry &entry = p.second;
+			out << p.first << "\t" << entry.updated << "\t" << entry.weights_transfer_duration << "\t";
+			bool first = true;
+			for (auto &e : entry.exec_duration) {
+				if (!first) out << ",";
+				first = false;
+				out << e.first << ":" << e.second;
+			}
+			out << std::endl;
+		}
+	}
+
+	// Replace atomically so a crash mid-write doesn't corrupt the cache
+	CHECK(std::rename(tmpfilename.c_str(), filename.c_str()) == 0)
+		<< "Unable to replace profile cache " << filename;
+}
+
+bool ModelProfileCache::lookup(std::string model_path, std::string gpu, unsigned clock, Entry &entry) {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto it = entries.find(key(model_path, gpu, clock));
+	if (it == entries.end()) return false;
+	if (it->second.updated + max_age_seconds < seconds_now()) return false;
+
+	entry = it->second;
+	return true;
+}
+
+void ModelProfileCache::update(std::string model_path, std::string gpu, unsigned clock,
+		uint64_t weights_transfer_duration, std::map<unsigned, uint64_t> &exec_duration) {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	Entry &entry = entries[key(model_path, gpu, clock)];
+	entry.updated = seconds_now();
+	if (weights_transfer_duration > 0) {
+		entry.weights_transfer_duration = weights_transfer_duration;
+	}
+	for (auto &p : exec_duration) {
+		entry.exec_duration[p.first] = p.second;
+	}
+}
+
+bool ModelProfileCache::gpu_key(ClockworkState &state, std::string &gpu, unsigned &clock) {
+	bool found = false;
+	for (auto &worker : state.workers) {
+		for (auto &g : worker.gpus) {
+			if (!found) {
+				gpu = g.name;
+				clock = g.max_clock;
+				found = true;
+			} else if (g.name != gpu || g.max_clock != clock) {
+				std::cout << "Warning: not using profile cache, found " << gpu << " @" << clock 
+				          << "MHz and " << g.name << " @" << g.max_clock << "MHz" << std::endl;
+				return false;
+			}
+		}
+	}
+	return found;
+}
+
+unsigned ModelProfileCache::apply(ClockworkState &state) {
+	std::string gpu;
+	unsigned clock;
+	if (!gpu_key(state, gpu, clock)) return 0;
+
+	std::set<unsigned> found;
+	for (auto &worker : state.workers) {
+		for (auto &p : worker.models) {
+			BatchedModelState &model = p.second;
+
+			Entry entry;
+			if (!lookup(model.model_path, gpu, clock, entry)) continue;
+
+			if (entry.weights_transfer_duration > 0) {
+				model.weights_transfer_duration = entry.weights_transfer_duration;
+			}
+			for (auto &batch_size : model.supported_batch_sizes) {
+				auto it = entry.exec_duration.find(batch_size);
+				if (it != entry.exec_duration.end()) {
+					model.exec_duration[batch_size] = it->second;
+				}
+			}
+			found.insert(model.id);
+		}
+	}
+	return found.size();
+}
+
+}
@@ -0,0 +1,68 @@
+#ifndef _CLOCKWORK_CONTROLLER_PROFILE_CACHE_H_
+#define _CLOCKWORK_CONTROLLER_PROFILE_CACHE_H_
+
+#include <map>
+#include <mutex>
+#include <string>
+#include "clockwork/controller/scheduler.h"
+
+namespace clockwork {
+
+/*
+A persistent cache of model performance profiles, used to warm-start the controller.
+
+Entries record the weights transfer duration and per-batch-size exec durations of a model,
+keyed by (model path, GPU model, max GPU clock).  Durations have the same meaning as the
+corresponding fields of BatchedModelState.  The scheduler records what it has measured;
+on the next startup, fresh entries replace the worker-reported values in the ClockworkState
+so that the scheduler does not have to re-learn them.
+Measurements are pooled across the GPUs of a ClockworkState, so the cache is only used if all
+of them have the same GPU model and max clock.
+
+The cache is stored as a TSV file, one entry per line, and is rewritten in full on save.
+*/
+class ModelProfileCache {
+public:
+	struct Entry {
+		uint64_t updated; // Seconds since unix epoch
+		uint64_t weights_transfer_duration; // 0 if not measured
+		std::map<unsigned, uint64_t> exec_duration; // batch size to exec duration
+	};
+
+	const std::string filename;
+	const uint64_t max_age_seconds; // Entries older than this are ignored
+
+	ModelProfileCache(std::string filename, uint64_t max_age_seconds = 86400);
+
+	// Reads the cache file, if it exists.  Returns the number of entries read.
+	unsigned load();
+
+	// Writes all entries to the cache file
+	void save();
+
+	// Looks up a fresh entry
+	bool lookup(std::string model_path, std::string gpu, unsigned clock, Entry &entry);
+
+	// Merges measurements into an entry.  Batch sizes not provided are retained.
+	void update(std::string model_path, std::string gpu, unsigned clock,
+		uint64_t weights_transfer_duration, std::map<unsigned, uint64_t> &exec_duration);
+
+	// Overwrites model measurements in state with fresh cached entries.  Returns the
+	// number of models that were found in the cache.
+	unsigned apply(ClockworkState &state);
+
+	// Sets the key under which the state's measurements are cached.  Returns false, with a
+	// warning, if its GPUs differ in model or max clock.
+	static bool gpu_key(ClockworkState &state, std::string &gpu, unsigned &clock);
+
+private:
+	std::mutex mutex;
+	std::map<std::string, Entry> entries;
+
+	static std::string key(std::string &model_path, std::string &gpu, unsigned clock);
+	static uint64_t seconds_now();
+};
+
+}
+
+#endif
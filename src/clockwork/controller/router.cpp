@@ -0,0 +1,337 @@
+#include "clockwork/controller/router.h"
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <unistd.h>
+#include "clockwork/thread.h"
+#include "clockwork/util.h"
+#include "dmlc/logging.h"
+
+namespace clockwork {
+namespace controller {
+
+Router::Router(int client_port,
+		std::vector<std::pair<std::string, std::string>> controller_host_port_pairs,
+		unsigned replicas,
+		int spill_threshold) :
+			replicas(replicas),
+			spill_threshold(spill_threshold),
+			ring(controller_host_port_pairs.size()),
+			next_request_id(0),
+			routes(max_models) {
+	CHECK(controller_host_port_pairs.size() > 0) << "Router needs at least one controller";
+	CHECK(replicas > 0) << "Models must be loaded on at least one shard";
+
+	std::cout << "Router using:" << std::endl;
+	std::cout << "\t controllers=" << controller_host_port_pairs.size() << std::endl;
+	std::cout << "\t replicas=" << replicas << std::endl;
+	std::cout << "\t spill_threshold=" << spill_threshold << std::endl;
+
+	manager = new network::client::ConnectionManager();
+	for (auto &host_port : controller_host_port_pairs) {
+		add_shard(host_port.first + ":" + host_port.second, manager->connect(host_port.first, host_port.second));
+	}
+
+	server = new network::controller::Server(this, client_port);
+
+	printer = std::thread(&Router::run_printer, this);
+	threading::initLoggerThread(printer);
+}
+
+Router::Router(std::vector<clientapi::ClientAPI*> controllers,
+		unsigned replicas,
+		int spill_threshold) :
+			replicas(replicas),
+			spill_threshold(spill_threshold),
+			ring(controllers.size()),
+			next_request_id(0),
+			routes(max_models) {
+	CHECK(controllers.size() > 0) << "Router needs at least one controller";
+	CHECK(replicas > 0) << "Models must be loaded on at least one shard";
+
+	for (unsigned i = 0; i < controllers.size(); i++) {
+		add_shard("local-" + std::to_string(i), controllers[i]);
+	}
+}
+
+void Router::add_shard(std::string address, clientapi::ClientAPI* connection) {
+	Shard* shard = new Shard();
+	shard->id = shards.size();
+	shard->address = address;
+	shard->connection = connection;
+	shards.push_back(shard);
+}
+
+void Router::join() {
+	if (manager != nullptr) manager->join();
+}
+
+Router::Route* Router::lookup(int model_id) {
+	if (model_id < 0 || model_id >= (int) max_models) return nullptr;
+	return routes[model_id].load();
+}
+
+int Router::add_route(Route* route) {
+	CHECK(num_routes < max_models) << "Router supports at most " << max_models << " models";
+	int model_id = num_routes++;
+	for (auto &replica : route->replicas) {
+		global_ids[{replica.shard->id, replica.model_id}] = model_id;
+	}
+	routes[model_id].store(route);
+	return model_id;
+}
+
+void Router::uploadModel(clientapi::UploadModelRequest &request, std::function<void(clientapi::UploadModelResponse&)> callback) {
+	clientapi::UploadModelResponse response;
+	response.header.user_request_id = request.header.user_request_id;
+	response.header.status = clockworkError;
+	response.header.message = "uploadModel not supported by the router";
+	callback(response);
+}
+
+int Router::choose(Forward* forward) {
+	auto &replicas = forward->route->replicas;
+
+	// The first untried replica, normally the owner
+	int first = -1;
+	for (unsigned i = 0; i < replicas.size(); i++) {
+		if (!forward->tried[i]) {
+			first = i;
+			break;
+		}
+	}
+	if (first == -1) return -1;
+	if (replicas[first].shard->outstanding < spill_threshold) return first;
+
+	// Overloaded; spill to the least-loaded untried replica
+	int best = first;
+	for (unsigned i = first + 1; i < replicas.size(); i++) {
+		if (forward->tried[i]) continue;
+		if (replicas[i].shard->outstanding < replicas[best].shard->outstanding) best = i;
+	}
+	if (best != first) replicas[best].shard->spilled++;
+	return best;
+}
+
+void Router::send(Forward* forward) {
+	int choice = choose(forward);
+	forward->tried[choice] = true;
+
+	Replica &replica = forward->route->replicas[choice];
+	Shard* shard = replica.shard;
+	shard->outstanding++;
+	shard->forwarded++;
+
+	forward->request.model_id = replica.model_id;
+	shard->connection->infer(forward->request, [this, forward, shard] (clientapi::InferenceResponse &response) {
+		shard->outstanding--;
+
+		if (response.header.status == clockworkControllerRejected) {
+			shard->rejected++;
+			if (choose(forward) != -1) {
+				if (response.output != nullptr) free(response.output);
+				send(forward);
+				return;
+			}
+		}
+
+		response.header.user_request_id = forward->user_request_id;
+		response.model_id = forward->model_id;
+		forward->callback(response);
+
+		delete static_cast<char*>(forward->request.input);
+		delete forward;
+	});
+}
+
+void Router::infer(clientapi::InferenceRequest &request, std::function<void(clientapi::InferenceResponse&)> callback) {
+	Route* route = lookup(request.model_id);
+	if (route == nullptr) {
+		clientapi::InferenceResponse response;
+		response.header.user_request_id = request.header.user_request_id;
+		response.header.status = clockworkInvalidRequest;
+		response.header.message = "Invalid model ID";
+		response.model_id = request.model_id;
+		response.batch_size = request.batch_size;
+		response.output_size = 0;
+		response.output = nullptr;
+		callback(response);
+		delete static_cast<char*>(request.input);
+		return;
+	}
+
+	Forward* forward = new Forward();
+	forward->model_id = request.model_id;
+	forward->route = route;
+	forward->request = request;
+	forward->callback = callback;
+	forward->tried.resize(route->replicas.size(), false);
+	forward->user_request_id = request.header.user_request_id;
+	forward->request.header.user_request_id = next_request_id++;
+	send(forward);
+}
+
+void Router::evict(clientapi::EvictRequest &request, std::function<void(clientapi::EvictResponse&)> callback) {
+	Route* route = lookup(request.model_id);
+	if (route == nullptr) {
+		clientapi::EvictResponse response;
+		response.header.user_request_id = request.header.user_request_id;
+		response.header.status = clockworkInvalidRequest;
+		response.header.message = "Invalid model ID";
+		callback(response);
+		return;
+	}
+
+	// Evict every replica; respond with the first error, if any
+	struct Pending {
+		std::atomic_int remaining;
+		std::vector<clientapi::EvictResponse> responses;
+	};
+	auto pending = std::make_shared<Pending>();
+	pending->remaining = route->replicas.size();
+	pending->responses.resize(route->replicas.size());
+
+	for (unsigned i = 0; i < route->replicas.size(); i++) {
+		clientapi::EvictRequest forwarded = request;
+		forwarded.model_id = route->replicas[i].model_id;
+		route->replicas[i].shard->connection->evict(forwarded, [pending, i, callback] (clientapi::EvictResponse &response) {
+			pending->responses[i] = response;
+			if (--pending->remaining > 0) return;
+
+			for (auto &response : pending->responses) {
+				if (response.header.status != clockworkSuccess) {
+					callback(response);
+					return;
+				}
+			}
+			callback(pending->responses[0]);
+		});
+	}
+}
+
+void Router::loadRemoteModel(clientapi::LoadModelFromRemoteDiskRequest &request, std::function<void(clientapi::LoadModelFromRemoteDiskResponse&)> callback) {
+	std::vector<unsigned> owners = ring.owners(request.remote_path, replicas);
+
+	struct Pending {
+		std::atomic_int remaining;
+		std::vector<clientapi::LoadModelFromRemoteDiskResponse> responses;
+	};
+	auto pending = std::make_shared<Pending>();
+	pending->remaining = owners.size();
+	pending->responses.resize(owners.size());
+
+	std::string remote_path = request.remote_path;
+	for (unsigned i = 0; i < owners.size(); i++) {
+		auto onResponse = [this, pending, owners, remote_path, i, callback] (clientapi::LoadModelFromRemoteDiskResponse &response) {
+			pending->responses[i] = response;
+			if (--pending->remaining > 0) return;
+
+			// Copies already loaded on other shards are left in place if one shard fails
+			for (auto &response : pending->responses) {
+				if (response.header.status != clockworkSuccess) {
+					callback(response);
+					return;
+				}
+			}
+
+			clientapi::LoadModelFromRemoteDiskResponse result = pending->responses[0];
+			for (auto &response : pending->responses) {
+				result.copies_created = std::min(result.copies_created, response.copies_created);
+			}
+
+			// Global ids of a model's copies must be contiguous
+			std::lock_guard<std::mutex> lock(routes_mutex);
+			for (int copy = 0; copy < result.copies_created; copy++) {
+				Route* route = new Route();
+				route->remote_path = remote_path;
+				route->input_size = result.input_size;
+				route->output_size = result.output_size;
+				for (unsigned j = 0; j < owners.size(); j++) {
+					route->replicas.push_back({shards[owners[j]], pending->responses[j].model_id + copy});
+				}
+				int model_id = add_route(route);
+				if (copy == 0) result.model_id = model_id;
+			}
+			callback(result);
+		};
+		shards[owners[i]]->connection->loadRemoteModel(request, onResponse);
+	}
+}
+
+void Router::ls(clientapi::LSRequest &request, std::function<void(clientapi::LSResponse&)> callback) {
+	struct Pending {
+		std::atomic_int remaining;
+		std::vector<clientapi::LSResponse> responses;
+	};
+	auto pending = std::make_shared<Pending>();
+	pending->remaining = shards.size();
+	pending->responses.resize(shards.size());
+
+	for (unsigned i = 0; i < shards.size(); i++) {
+		shards[i]->connection->ls(request, [this, pending, i, callback] (clientapi::LSResponse &response) {
+			pending->responses[i] = response;
+			if (--pending->remaining > 0) return;
+
+			clientapi::LSResponse result;
+			result.header = pending->responses[0].header;
+			for (auto &response : pending->responses) {
+				if (response.header.status != clockworkSuccess) {
+					callback(response);
+					return;
+				}
+			}
+
+			// Models loaded directly on a controller get a route to that controller only
+			std::lock_guard<std::mutex> lock(routes_mutex);
+			for (unsigned shard = 0; shard < pending->responses.size(); shard++) {
+				for (auto &model : pending->responses[shard].models) {
+					if (global_ids.find({shard, model.model_id}) != global_ids.end()) continue;
+
+					Route* route = new Route();
+					route->remote_path = model.remote_path;
+					route->input_size = model.input_size;
+					route->output_size = model.output_size;
+					route->replicas.push_back({shards[shard], model.model_id});
+					add_route(route);
+				}
+			}
+
+			for (unsigned model_id = 0; model_id < num_routes; model_id++) {
+				Route* route = routes[model_id].load();
+				clientapi::ClientModelInfo info;
+				info.model_id = model_id;
+				info.remote_path = route->remote_path;
+				info.input_size = route->input_size;
+				info.output_size = route->output_size;
+				result.models.push_back(info);
+			}
+			callback(result);
+		});
+	}
+}
+
+void Router::run_printer() {
+	uint64_t last_print = util::now();
+	while (true) {
+		usleep(100000);
+		uint64_t now = util::now();
+		if (last_print + print_interval > now) continue;
+
+		float duration = (now - last_print) / 1000000000.0;
+		last_print = now;
+
+		std::stringstream s;
+		s << std::fixed << std::setprecision(1);
+		for (auto &shard : shards) {
+			s << "Shard-" << shard->id << " " << shard->address << ": "
+			  << (shard->forwarded.exchange(0) / duration) << " r/s, "
+			  << shard->outstanding << " outstanding, "
+			  << shard->spilled.exchange(0) << " spilled in, "
+			  << shard->rejected.exchange(0) << " rejected" << std::endl;
+		}
+		std::cout << s.str();
+	}
+}
+
+}
+}
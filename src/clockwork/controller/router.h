@@ -0,0 +1,131 @@
+#ifndef _CLOCKWORK_CONTROLLER_ROUTER_H_
+#define _CLOCKWORK_CONTROLLER_ROUTER_H_
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "clockwork/api/client_api.h"
+#include "clockwork/network/client.h"
+#include "clockwork/network/controller.h"
+#include "clockwork/controller/hash_ring.h"
+
+namespace clockwork {
+namespace controller {
+
+/*
+A thin front-end for several controllers, each scheduling its own disjoint set of workers.
+
+The router speaks the client API to clients and forwards each call to the controllers that
+own the model.  Models are partitioned by consistent hashing of their remote path, so all
+copies of a model live on the same shard.  Model ids are controller-local, so the router
+hands out its own global ids and rewrites them in both directions.
+
+Controllers only load models during their startup phase, so rebalancing cannot move models
+once requests are flowing.  Instead each model can be loaded on several shards (its owner,
+then its successors on the ring).  Requests go to the owner unless it has spill_threshold
+or more requests outstanding, in which case they go to the least-loaded replica.  A request
+that a controller rejects at admission is retried on a replica that hasn't seen it.
+
+Clients choose their own user_request_ids, so ids from different clients can collide at a
+controller.  The router forwards each request under a router-unique user_request_id, the
+same on every attempt, and restores the client's id on the response.
+*/
+class Router : public clientapi::ClientAPI {
+public:
+	static constexpr unsigned max_models = 65536; // global model ids are below this
+	static constexpr uint64_t print_interval = 10000000000UL;
+
+	const unsigned replicas; // number of shards each model is loaded on
+	const int spill_threshold; // outstanding requests at which a shard is overloaded
+
+private:
+	struct Shard {
+		unsigned id;
+		std::string address;
+		clientapi::ClientAPI* connection;
+		std::atomic_int outstanding;
+		std::atomic_uint64_t forwarded;
+		std::atomic_uint64_t spilled; // forwarded here because the owner was overloaded
+		std::atomic_uint64_t rejected; // rejected at admission by this shard
+
+		Shard() : outstanding(0), forwarded(0), spilled(0), rejected(0) {}
+	};
+
+	struct Replica {
+		Shard* shard;
+		int model_id; // the controller-local model id
+	};
+
+	struct Route {
+		std::string remote_path;
+		size_t input_size;
+		size_t output_size;
+		std::vector<Replica> replicas; // owner first
+	};
+
+	// An inference request in flight; retried on other replicas if rejected
+	struct Forward {
+		int model_id;
+		Route* route;
+		clientapi::InferenceRequest request;
+		std::function<void(clientapi::InferenceResponse&)> callback;
+		std::vector<bool> tried;
+		int user_request_id; // the client's, restored on the response
+	};
+
+	HashRing ring;
+	std::vector<Shard*> shards;
+	network::client::ConnectionManager* manager = nullptr;
+	network::controller::Server* server = nullptr;
+	std::atomic_int next_request_id;
+
+	// Routes are only added by loadRemoteModel and ls; infer reads them without locking
+	std::mutex routes_mutex;
+	std::vector<std::atomic<Route*>> routes;
+	unsigned num_routes = 0;
+	std::map<std::pair<unsigned, int>, int> global_ids; // (shard, local model id) -> global id
+
+	std::thread printer;
+
+public:
+	Router(int client_port,
+		std::vector<std::pair<std::string, std::string>> controller_host_port_pairs,
+		unsigned replicas = 1,
+		int spill_threshold = 256);
+
+	// Routes to already-connected controllers, without listening for clients or printing
+	Router(std::vector<clientapi::ClientAPI*> controllers,
+		unsigned replicas = 1,
+		int spill_threshold = 256);
+
+	void join();
+
+	// clientapi -- requests from clients call these functions
+	virtual void uploadModel(clientapi::UploadModelRequest &request, std::function<void(clientapi::UploadModelResponse&)> callback);
+	virtual void infer(clientapi::InferenceRequest &request, std::function<void(clientapi::InferenceResponse&)> callback);
+	virtual void evict(clientapi::EvictRequest &request, std::function<void(clientapi::EvictResponse&)> callback);
+	virtual void loadRemoteModel(clientapi::LoadModelFromRemoteDiskRequest &request, std::function<void(clientapi::LoadModelFromRemoteDiskResponse&)> callback);
+	virtual void ls(clientapi::LSRequest &request, std::function<void(clientapi::LSResponse&)> callback);
+
+private:
+	void add_shard(std::string address, clientapi::ClientAPI* connection);
+
+	Route* lookup(int model_id);
+
+	// Adds a route and returns its global id; requires routes_mutex
+	int add_route(Route* route);
+
+	// Picks the replica for the next attempt, or returns -1 if all have been tried
+	int choose(Forward* forward);
+	void send(Forward* forward);
+
+	void run_printer();
+};
+
+}
+}
+
+#endif
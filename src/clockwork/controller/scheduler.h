@@ -29,6 +29,9 @@ struct GPUState {
   size_t weights_cache_size;
   unsigned weights_cache_total_pages;   // Number of pages in GPU weights cache
   std::vector<unsigned> loaded_models;  // Models loaded into GPU memory
+  std::string name;                     // GPU model name
+  unsigned clock;                       // SM clock in MHz when the worker was queried
+  unsigned max_clock;                   // Max SM clock in MHz; 0 if unknown
 
   std::string str();
 };
@@ -42,7 +45,7 @@ struct WorkerState {
 };
 
 struct ClockworkState {
-  size_t page_size;
+  size_t page_size = 0;
   std::vector<WorkerState> workers;
 
   std::string str();
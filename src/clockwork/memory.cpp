@@ -76,6 +76,7 @@ void ModelStore::put(int model_id, unsigned gpu_id, RuntimeModel* model) {
 	while (in_use.test_and_set());
 
 	models[std::make_pair(model_id, gpu_id)] = model;
+	record(workerapi::modelAddedEvent, model_id, gpu_id);
 
 	in_use.clear();
 }
@@ -89,6 +90,7 @@ bool ModelStore::put_if_absent(int model_id, unsigned gpu_id, RuntimeModel* mode
 
 	if ( got == models.end() ){
 		models[key] = model;
+		record(workerapi::modelAddedEvent, model_id, gpu_id);
 		did_put = true;
 	}
 
@@ -97,9 +99,23 @@ bool ModelStore::put_if_absent(int model_id, unsigned gpu_id, RuntimeModel* mode
 	return did_put;
 }
 
-void ModelStore::get_model_info(workerapi::WorkerMemoryInfo &info) {
-	while (in_use.test_and_set());
+workerapi::ModelInfo make_model_info(int model_id, RuntimeModel* rm, size_t page_size) {
+	workerapi::ModelInfo modelinfo;
+	modelinfo.id = model_id;
+	modelinfo.source = rm->model->source;
+	modelinfo.input_size = rm->model->single_input_size;
+	modelinfo.output_size = rm->model->single_output_size;
+	modelinfo.supported_batch_sizes = rm->model->implemented_batch_sizes();
+	modelinfo.num_weights_pages = rm->model->num_weights_pages(page_size);
+	modelinfo.weights_size = rm->model->weights_size;
+	modelinfo.weights_load_time_nanos = rm->model->transfer_measurement;
+	for (auto &p : rm->model->models) {
+		modelinfo.batch_size_exec_times_nanos.push_back(p.second->exec_measurement);
+	}
+	return modelinfo;
+}
 
+void ModelStore::populate_model_info(workerapi::WorkerMemoryInfo &info) {
 	std::map<int, workerapi::ModelInfo> models_info;
 
 	for (auto p : models) {
@@ -109,19 +125,7 @@ void ModelStore::get_model_info(workerapi::WorkerMemoryInfo &info) {
 
 		auto it = models_info.find(model_id);
 		if (it == models_info.end()) {
-			workerapi::ModelInfo modelinfo;
-			modelinfo.id = model_id;
-			modelinfo.source = rm->model->source;
-			modelinfo.input_size = rm->model->single_input_size;
-			modelinfo.output_size = rm->model->single_output_size;
-			modelinfo.supported_batch_sizes = rm->model->implemented_batch_sizes();
-			modelinfo.num_weights_pages = rm->model->num_weights_pages(info.page_size);
-			modelinfo.weights_size = rm->model->weights_size;
-			modelinfo.weights_load_time_nanos = rm->model->transfer_measurement;
-			for (auto &p : rm->model->models) {
-				modelinfo.batch_size_exec_times_nanos.push_back(p.second->exec_measurement);
-			}
-			models_info[model_id] = modelinfo;
+			models_info[model_id] = make_model_info(model_id, rm, info.page_size);
 		}
 
 		// Also store which models are loaded
@@ -139,6 +143,74 @@ void ModelStore::get_model_info(workerapi::WorkerMemoryInfo &info) {
 	for (unsigned i = 0; i < info.gpus.size(); i++) {
 		std::sort(info.gpus[i].models.begin(), info.gpus[i].models.end());
 	}
+}
+
+void ModelStore::get_model_info(workerapi::WorkerMemoryInfo &info) {
+	while (in_use.test_and_set());
+
+	populate_model_info(info);
+
+	in_use.clear();
+}
+
+void ModelStore::record(int type, int model_id, unsigned gpu_id) {
+	events.push_back(Event{++seqno, type, model_id, gpu_id});
+	if (events.size() > max_retained_events) {
+		events.pop_front();
+	}
+}
+
+void ModelStore::weights_loaded(int model_id, unsigned gpu_id) {
+	while (in_use.test_and_set());
+
+	record(workerapi::modelLoadedEvent, model_id, gpu_id);
+
+	in_use.clear();
+}
+
+void ModelStore::weights_evicted(int model_id, unsigned gpu_id) {
+	while (in_use.test_and_set());
+
+	record(workerapi::modelEvictedEvent, model_id, gpu_id);
+
+	in_use.clear();
+}
+
+void ModelStore::invalidate_events() {
+	while (in_use.test_and_set());
+
+	// Bump the seqno so that nobody can be up to date without a snapshot
+	seqno++;
+	events.clear();
+
+	in_use.clear();
+}
+
+void ModelStore::get_state(uint64_t since_seqno, workerapi::GetWorkerStateResult &result) {
+	while (in_use.test_and_set());
+
+	result.seqno = seqno;
+
+	// Deltas are only possible if every event after since_seqno is retained
+	uint64_t oldest = events.empty() ? seqno + 1 : events.front().seqno;
+	result.is_snapshot = since_seqno == 0 || since_seqno > seqno || since_seqno + 1 < oldest;
+
+	if (result.is_snapshot) {
+		populate_model_info(result.worker);
+	} else {
+		for (auto it = events.begin() + (since_seqno + 1 - oldest); it != events.end(); it++) {
+			workerapi::WorkerStateEvent event;
+			event.seqno = it->seqno;
+			event.type = it->type;
+			event.model_id = it->model_id;
+			event.gpu_id = it->gpu_id;
+			if (it->type == workerapi::modelAddedEvent) {
+				RuntimeModel* rm = models[std::make_pair(it->model_id, it->gpu_id)];
+				event.model = make_model_info(it->model_id, rm, result.worker.page_size);
+			}
+			result.events.push_back(event);
+		}
+	}
 
 	in_use.clear();
 }
@@ -175,7 +247,7 @@ MemoryManager::~MemoryManager() {
 	}
 }
 
-void MemoryManager::get_worker_memory_info(workerapi::WorkerMemoryInfo &info) {
+void MemoryManager::get_worker_basic_info(workerapi::WorkerMemoryInfo &info) {
 	// Store basic info
 	info.page_size = page_size;
 	info.host_weights_cache_size = ULONG_MAX; // Not currently fixed
@@ -192,11 +264,22 @@ void MemoryManager::get_worker_memory_info(workerapi::WorkerMemoryInfo &info) {
 		// Add models later
 		info.gpus.push_back(gpu);
 	}
+}
+
+void MemoryManager::get_worker_memory_info(workerapi::WorkerMemoryInfo &info) {
+	get_worker_basic_info(info);
 
 	// Store model info
 	models->get_model_info(info);
 }
 
+void MemoryManager::get_worker_state(uint64_t since_seqno, workerapi::GetWorkerStateResult &result) {
+	get_worker_basic_info(result.worker);
+
+	// Store model info or events
+	models->get_state(since_seqno, result);
+}
+
 MemoryPool::MemoryPool(char* base_ptr, size_t size) : base_ptr(base_ptr), size(size) {
 }
 
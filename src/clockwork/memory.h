@@ -32,8 +32,21 @@ public:
 
 class ModelStore {
 public:
+	/* Changes to the store, in seqno order, so that the controller can sync
+	incrementally rather than fetching a full snapshot every time.  Events are
+	idempotent, so replaying an event that a snapshot already reflects is harmless. */
+	struct Event {
+		uint64_t seqno;
+		int type; // workerapi::modelAddedEvent etc.
+		int model_id;
+		unsigned gpu_id;
+	};
+	static const unsigned max_retained_events = 65536;
+
 	std::atomic_flag in_use;
 	std::unordered_map<std::pair<int, unsigned>, RuntimeModel*, util::hash_pair> models;
+	uint64_t seqno = 0;
+	std::deque<Event> events;
 
 	ModelStore();
 
@@ -46,6 +59,21 @@ public:
 	bool put_if_absent(int model_id, unsigned gpu_id, RuntimeModel* model);
 	void get_model_info(clockwork::workerapi::WorkerMemoryInfo &worker_memory_info);
 
+	// Record changes to the weights of a model.  Call after the change is visible
+	void weights_loaded(int model_id, unsigned gpu_id);
+	void weights_evicted(int model_id, unsigned gpu_id);
+
+	// Drop all retained events, e.g. after bulk changes, so that the next sync is a snapshot
+	void invalidate_events();
+
+	// Populates result with the events after since_seqno if they are all retained,
+	// otherwise with a full snapshot.  result.worker.page_size must already be set.
+	void get_state(uint64_t since_seqno, clockwork::workerapi::GetWorkerStateResult &result);
+
+private:
+	void record(int type, int model_id, unsigned gpu_id); // Caller must hold in_use
+	void populate_model_info(clockwork::workerapi::WorkerMemoryInfo &worker_memory_info); // Caller must hold in_use
+
 };
 
 
@@ -122,6 +150,10 @@ public:
 
 	void initialize(ClockworkWorkerConfig &config);
 	void get_worker_memory_info(clockwork::workerapi::WorkerMemoryInfo &worker_memory_info);
+	void get_worker_state(uint64_t since_seqno, clockwork::workerapi::GetWorkerStateResult &result);
+
+private:
+	void get_worker_basic_info(clockwork::workerapi::WorkerMemoryInfo &worker_memory_info);
 };
 
 class CUDAMemoryPool : public MemoryPool {
@@ -7,6 +7,9 @@ namespace network {
 void set_header(RequestHeader &request_header, RequestHeaderProto* proto) {
 	proto->set_user_id(request_header.user_id);
 	proto->set_user_request_id(request_header.user_request_id);
+	if (request_header.trace_id != 0) {
+		proto->set_trace_id(request_header.trace_id);
+	}
 }
 
 void set_header(ResponseHeader &response_header, ResponseHeaderProto* proto) {
@@ -18,6 +21,7 @@ void set_header(ResponseHeader &response_header, ResponseHeaderProto* proto) {
 void get_header(RequestHeader &request_header, const RequestHeaderProto &proto) {
 	request_header.user_id = proto.user_id();
 	request_header.user_request_id = proto.user_request_id();
+	request_header.trace_id = proto.trace_id();
 }
 
 void get_header(ResponseHeader &response_header, const ResponseHeaderProto &proto) {
@@ -48,6 +52,7 @@ void msg_inference_rsp_tx::set(clientapi::InferenceResponse &response) {
   	set_header(response.header, msg.mutable_header());
   	msg.set_model_id(response.model_id);
   	msg.set_batch_size(response.batch_size);
+  	msg.set_retry_after(response.retry_after);
   	body_len_ = response.output_size;
   	body_ = response.output;
 }
@@ -56,6 +61,7 @@ void msg_inference_rsp_rx::get(clientapi::InferenceResponse &response) {
     get_header(response.header, msg.header());
     response.model_id = msg.model_id();
     response.batch_size = msg.batch_size();
+    response.retry_after = msg.retry_after();
     response.output_size = body_len_;
     response.output = body_;
 }
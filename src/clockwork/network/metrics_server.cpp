@@ -0,0 +1,149 @@
+#include "clockwork/network/metrics_server.h"
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+#include <vector>
+#include <dmlc/logging.h>
+#include "clockwork/thread.h"
+#include "clockwork/telemetry/sampling.h"
+
+namespace clockwork {
+namespace network {
+
+struct MetricsServer::Session {
+	tcp::socket socket;
+	asio::streambuf request;
+	std::string response;
+
+	Session(asio::io_service &io_service) : socket(io_service) {}
+};
+
+MetricsServer::MetricsServer(int port, metrics::Registry &registry) :
+		is_started(false),
+		registry(registry),
+		io_service(),
+		network_thread(&MetricsServer::run, this, port) {
+	threading::initLoggerThread(network_thread);
+}
+
+MetricsServer::~MetricsServer() {
+	shutdown(true);
+}
+
+void MetricsServer::shutdown(bool awaitShutdown) {
+	io_service.stop();
+	if (awaitShutdown) {
+		join();
+	}
+}
+
+void MetricsServer::join() {
+	while (!is_started);
+	if (network_thread.joinable()) {
+		network_thread.join();
+	}
+}
+
+void MetricsServer::run(int port) {
+	try {
+		auto endpoint = tcp::endpoint(asio::ip::address_v4::loopback(), port);
+		tcp::acceptor acceptor(io_service, endpoint);
+		is_started.store(true);
+		start_accept(&acceptor);
+		std::cout << "Metrics server listening on " << endpoint << std::endl;
+		io_service.run();
+	} catch (std::exception& e) {
+		is_started.store(true);
+		CHECK(false) << "Exception in metrics server thread: " << e.what();
+	}
+}
+
+void MetricsServer::start_accept(tcp::acceptor* acceptor) {
+	auto session = std::make_shared<Session>(io_service);
+	acceptor->async_accept(session->socket, [this, session, acceptor] (const asio::error_code& error) {
+		if (error == asio::error::operation_aborted) return;
+		if (!error) {
+			handle_request(session);
+		}
+		start_accept(acceptor);
+	});
+}
+
+void MetricsServer::handle_request(std::shared_ptr<Session> session) {
+	asio::async_read_until(session->socket, session->request, "\r\n\r\n",
+		[this, session] (const asio::error_code& error, size_t bytes_transferred) {
+			if (error) return;
+
+			// Only the request line matters, eg. "GET /metrics HTTP/1.1"
+			std::istream in(&session->request);
+			std::string method, path;
+			in >> method >> path;
+
+			if (path == "/sampling" || path.rfind("/sampling?", 0) == 0) {
+				if (method == "GET") {
+					respond(session, "200 OK", sampling::rates_str());
+				} else if (method == "PUT") {
+					if (set_sample_rates(path)) {
+						respond(session, "200 OK", sampling::rates_str());
+					} else {
+						respond(session, "400 Bad Request", "");
+					}
+				} else {
+					respond(session, "405 Method Not Allowed", "");
+				}
+			} else if (method != "GET") {
+				respond(session, "405 Method Not Allowed", "");
+			} else if (path == "/metrics" || path.rfind("/metrics?", 0) == 0) {
+				respond(session, "200 OK", registry.scrape());
+			} else {
+				respond(session, "404 Not Found", "");
+			}
+		});
+}
+
+bool MetricsServer::set_sample_rates(std::string path) {
+	// eg. /sampling?requests=0.01&actions=0.1; every parameter is checked before any is applied
+	std::vector<std::pair<std::string, double>> rates;
+	size_t query = path.find('?');
+	if (query == std::string::npos) return false;
+
+	std::stringstream params(path.substr(query + 1));
+	for (std::string param; std::getline(params, param, '&');) {
+		size_t equals = param.find('=');
+		if (equals == std::string::npos) return false;
+
+		std::string stream = param.substr(0, equals);
+		std::string value = param.substr(equals + 1);
+		char* end;
+		double rate = std::strtod(value.c_str(), &end);
+		if (value.empty() || *end != '\0' || !(rate >= 0 && rate <= 1)) return false;
+		if (stream != sampling::requests().name && stream != sampling::actions().name) return false;
+		rates.push_back({stream, rate});
+	}
+
+	for (auto &rate : rates) {
+		sampling::set_rate(rate.first, rate.second);
+		std::cout << "Set " << rate.first << " log sample rate to " << rate.second << std::endl;
+	}
+	return !rates.empty();
+}
+
+void MetricsServer::respond(std::shared_ptr<Session> session, std::string status, std::string body) {
+	std::stringstream response;
+	response << "HTTP/1.1 " << status << "\r\n";
+	response << "Content-Type: text/plain; version=0.0.4\r\n";
+	response << "Content-Length: " << body.size() << "\r\n";
+	response << "Connection: close\r\n\r\n";
+	response << body;
+	session->response = response.str();
+
+	asio::async_write(session->socket, asio::buffer(session->response),
+		[session] (const asio::error_code& error, size_t bytes_transferred) {
+			asio::error_code ignored;
+			session->socket.shutdown(tcp::socket::shutdown_both, ignored);
+			session->socket.close(ignored);
+		});
+}
+
+}
+}
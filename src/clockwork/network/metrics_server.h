@@ -0,0 +1,53 @@
+#ifndef _CLOCKWORK_NETWORK_METRICS_SERVER_H_
+#define _CLOCKWORK_NETWORK_METRICS_SERVER_H_
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <asio.hpp>
+#include "clockwork/telemetry/metrics.h"
+
+namespace clockwork {
+namespace network {
+
+using asio::ip::tcp;
+
+/*
+Serves GET /metrics in the Prometheus text format, on localhost only.
+
+Also serves the controller's log sample rates at /sampling.  GET returns the current rates;
+PUT /sampling?requests=0.01&actions=0.1 changes them.
+
+Runs its own IO service on a low-priority thread, so scrapes never contend with
+the controller or worker network threads.
+*/
+class MetricsServer {
+private:
+	struct Session;
+
+	std::atomic_bool is_started;
+	metrics::Registry &registry;
+	asio::io_service io_service;
+	std::thread network_thread;
+
+public:
+	MetricsServer(int port, metrics::Registry &registry = metrics::registry());
+	~MetricsServer();
+
+	void shutdown(bool awaitShutdown);
+	void join();
+	void run(int port);
+
+private:
+	void start_accept(tcp::acceptor* acceptor);
+	void handle_request(std::shared_ptr<Session> session);
+	void respond(std::shared_ptr<Session> session, std::string status, std::string body);
+	bool set_sample_rates(std::string path);
+
+};
+
+}
+}
+
+#endif
@@ -7,6 +7,24 @@
 namespace clockwork {
 namespace network {
 
+connection_stats &global_stats() {
+  static connection_stats stats;
+  return stats;
+}
+
+void add_metrics(metrics::Registry &registry) {
+  registry.add([](metrics::Writer &writer) {
+    connection_stats &stats = global_stats();
+    writer.counter("clockwork_network_sent_bytes_total",
+        "Bytes sent over all connections", stats.bytes_sent);
+    writer.counter("clockwork_network_received_bytes_total",
+        "Bytes received over all connections", stats.bytes_received);
+    writer.counter("clockwork_network_sent_messages_total",
+        "Messages sent over all connections", stats.messages_sent);
+    writer.counter("clockwork_network_received_messages_total",
+        "Messages received over all connections", stats.messages_received);
+  });
+}
 
 message_sender::message_sender(message_connection *conn, message_handler &handler)
   : socket_(conn->get_socket()), conn_(conn), handler_(handler), req_(0)
@@ -47,6 +65,7 @@ void message_sender::start_send(message_tx &req)
 
   // Increment stats here, even though it hasn't sent yet. Simpler
   conn_->stats.message_sent(pre_header[1] + 48);
+  global_stats().message_sent(pre_header[1] + 48);
 
   req_ = &req;
   asio::async_write(socket_, asio::buffer(pre_header),
@@ -176,6 +195,7 @@ void message_receiver::handle_pre_read(const asio::error_code& error,
 
   // Increment stats here, even though it hasn't received yet. Simpler
   conn_->stats.message_received(pre_header[1] + 48);
+  global_stats().message_received(pre_header[1] + 48);
 
   asio::async_read(socket_, asio::buffer(header_buf, pre_header[0]),
       boost::bind(&message_receiver::handle_header_read, this,
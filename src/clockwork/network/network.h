@@ -11,6 +11,7 @@
 #include "tbb/concurrent_queue.h"
 #include "clockwork/util.h"
 #include "clockwork/sliding_window.h"
+#include "clockwork/telemetry/metrics.h"
 
 namespace clockwork {
 namespace network {
@@ -80,6 +81,12 @@ public:
   // }
 };
 
+/* totals across every connection in this process */
+connection_stats &global_stats();
+
+/* exports global_stats as counters */
+void add_metrics(metrics::Registry &registry);
+
 class message_handler {
 public:
   /* header length,  body length, message type, message id */
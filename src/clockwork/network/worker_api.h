@@ -222,6 +222,9 @@ public:
   	msg.set_batch_size(action.batch_size);
     for (auto &size : action.input_sizes) {
       msg.add_input_sizes(size);
+    }
+    for (auto &trace_id : action.trace_ids) {
+      msg.add_trace_ids(trace_id);
     }
   	body_len_ = action.input_size;
   	body_ = action.input;
@@ -242,6 +245,9 @@ public:
   	action.input_size = body_len_;
     for (unsigned i = 0; i < msg.input_sizes_size(); i++) {
       action.input_sizes.push_back(msg.input_sizes(i));
+    }
+    for (unsigned i = 0; i < msg.trace_ids_size(); i++) {
+      action.trace_ids.push_back(msg.trace_ids(i));
     }
   	action.input = static_cast<char*>(body_);
   }
@@ -265,6 +271,17 @@ public:
   	msg.mutable_copy_output_timing()->set_duration(result.copy_output.duration);
     msg.set_action_received(result.action_received);
     msg.set_result_sent(result.result_sent);
+    for (auto &e : result.executors) {
+      ExecutorTelemetryProto* executor = msg.add_executors();
+      executor->set_task_type(e.task_type);
+      executor->set_gpu_id(e.gpu_id);
+      executor->set_timestamp(e.timestamp);
+      executor->set_busy(e.busy);
+      executor->set_tasks(e.tasks);
+      executor->set_dropped(e.dropped);
+      executor->set_lateness(e.lateness);
+      executor->set_queued(e.queued);
+    }
   	body_len_ = result.output_size;
   	body_ = result.output;
   }
@@ -290,6 +307,18 @@ public:
   	result.copy_output.duration = msg.copy_output_timing().duration();
     result.action_received = msg.action_received();
     result.result_sent = msg.result_sent();
+    for (auto &executor : msg.executors()) {
+      ExecutorTelemetry e;
+      e.task_type = executor.task_type();
+      e.gpu_id = executor.gpu_id();
+      e.timestamp = executor.timestamp();
+      e.busy = executor.busy();
+      e.tasks = executor.tasks();
+      e.dropped = executor.dropped();
+      e.lateness = executor.lateness();
+      e.queued = executor.queued();
+      result.executors.push_back(e);
+    }
   	result.output_size = body_len_;
   	result.output = static_cast<char*>(body_);
   }
@@ -333,6 +362,7 @@ class get_worker_state_action_tx : public msg_protobuf_tx_with_body<ACT_GET_WORK
 public:
   virtual void set(workerapi::GetWorkerState &action) {
 	msg.set_action_id(action.id);
+	msg.set_since_seqno(action.since_seqno);
   }
 };
 
@@ -341,6 +371,7 @@ public:
   virtual void get(workerapi::GetWorkerState &action) {
 	action.id = msg.action_id();
 	action.action_type = workerapi::getWorkerStateAction;
+	action.since_seqno = msg.since_seqno();
   }
 };
 
@@ -356,6 +387,9 @@ public:
     }
     proto->set_io_pool_size(gpu.io_pool_size);
     proto->set_workspace_pool_size(gpu.workspace_pool_size);    
+    proto->set_name(gpu.name);
+    proto->set_clock(gpu.clock);
+    proto->set_max_clock(gpu.max_clock);
   }
 
   void setmodel(const workerapi::ModelInfo &model, ModelInfoProto* proto) {
@@ -392,6 +426,19 @@ public:
       ModelInfoProto* modelproto = proto->add_models();
       setmodel(model, modelproto);
     }
+
+    msg.set_seqno(result.seqno);
+    msg.set_is_snapshot(result.is_snapshot);
+    for (auto &event : result.events) {
+      WorkerStateEventProto* eventproto = msg.add_events();
+      eventproto->set_seqno(event.seqno);
+      eventproto->set_type(event.type);
+      eventproto->set_model_id(event.model_id);
+      eventproto->set_gpu_id(event.gpu_id);
+      if (event.type == workerapi::modelAddedEvent) {
+        setmodel(event.model, eventproto->mutable_model());
+      }
+    }
     msg.set_action_received(result.action_received);
     msg.set_result_sent(result.result_sent);
   }
@@ -409,6 +456,9 @@ public:
     }
     gpu.io_pool_size = proto.io_pool_size();
     gpu.workspace_pool_size = proto.workspace_pool_size();
+    gpu.name = proto.name();
+    gpu.clock = proto.clock();
+    gpu.max_clock = proto.max_clock();
   }
 
   void getmodel(workerapi::ModelInfo &model, const ModelInfoProto &proto) {
@@ -446,6 +496,21 @@ public:
       getmodel(model, proto.models(i));
       worker.models.push_back(model);
     }
+
+    result.seqno = msg.seqno();
+    result.is_snapshot = msg.is_snapshot();
+    for (unsigned i = 0; i < msg.events_size(); i++) {
+      auto &eventproto = msg.events(i);
+      workerapi::WorkerStateEvent event;
+      event.seqno = eventproto.seqno();
+      event.type = eventproto.type();
+      event.model_id = eventproto.model_id();
+      event.gpu_id = eventproto.gpu_id();
+      if (eventproto.has_model()) {
+        getmodel(event.model, eventproto.model());
+      }
+      result.events.push_back(event);
+    }
     result.action_received = msg.action_received();
     result.result_sent = msg.result_sent();
   }
@@ -5,8 +5,30 @@
 
 namespace clockwork {
 
+void ExecutorStats::dequeued(Task* task, uint64_t now) {
+	tasks++;
+	uint64_t eligible = task->eligible();
+	if (now > eligible) lateness += now - eligible;
+	if (now > task->deadline()) dropped++; // the task will fail as too late
+
+	task->executor_stats = this;
+	task->dequeued_at = now;
+}
+
+void ExecutorStats::ran(uint64_t dequeued, uint64_t now) {
+	busy += now - dequeued;
+}
+
+void ExecutorStats::async_completed(uint64_t dequeued, uint64_t now) {
+	if (now <= async_end) return;
+	busy += now - std::max(dequeued, async_end);
+	async_end = now;
+}
+
 void BaseExecutor::enqueue(Task* task) {
+	queued++;
 	if (!queue.enqueue(task, task->eligible())) {
+		queued--;
 		throw TaskError(actionErrorShuttingDown, "Cannot enqueue task to executor that is shutting down");
 	}
 }
@@ -35,10 +57,14 @@ void CPUExecutor::executorMain(unsigned executor_id) {
 		LoadModelFromDiskTask* next = dynamic_cast<LoadModelFromDiskTask*>(queue.dequeue());
 		
 		if (next != nullptr) {
-			auto telemetry = next->telemetry;
-			telemetry->dequeued = util::hrt();
+			queued--;
+			uint64_t dequeued = util::now();
+			stats.dequeued(next, dequeued);
+
+			// next may be deleted by the time run returns
+			next->telemetry.dequeued = util::hrt();
 			next->run();
-			telemetry->exec_complete = util::hrt();
+			stats.ran(dequeued, util::now());
 		}
 	}
 
@@ -71,11 +97,14 @@ void GPUExecutorExclusive::executorMain(unsigned executor_id) {
 		Task* next = queue.dequeue();
 
 		if (next != nullptr) {
-			auto telemetry = next->telemetry;
+			queued--;
+			uint64_t dequeued = util::now();
+			stats.dequeued(next, dequeued);
 
-			telemetry->dequeued = util::hrt();
+			// next may be deleted by the time run returns; CudaAsyncTask sets exec_complete
+			next->telemetry.dequeued = util::hrt();
 			next->run(stream);
-			telemetry->exec_complete = util::hrt();
+			stats.ran(dequeued, util::now());
 		}
 	}
 
@@ -114,8 +143,10 @@ void AsyncTaskChecker::executorMain(unsigned executor_id) {
 		std::vector<AsyncTask*> still_pending;
 		for (AsyncTask* task : pending_tasks) {
 			if (task->is_complete()) {
-				auto telemetry = task->telemetry;
-				telemetry->async_complete = util::hrt();
+				task->telemetry.async_complete = util::hrt();
+				if (task->executor_stats != nullptr) {
+					task->executor_stats->async_completed(task->dequeued_at, util::now());
+				}
 				task->process_completion();
 			} else {
 				still_pending.push_back(task);
@@ -174,4 +205,67 @@ void ClockworkRuntime::join() {
 	}
 }
 
+void ClockworkRuntime::add_metrics(metrics::Registry &registry) {
+	registry.add([this] (metrics::Writer &writer) {
+		std::string help = "Tasks waiting in an executor's queue";
+		writer.gauge("clockwork_executor_queued_tasks", help, load_model_executor->queued,
+			{{"type", TaskTypeName(load_model_executor->type)}});
+		for (unsigned gpu_id = 0; gpu_id < num_gpus; gpu_id++) {
+			for (BaseExecutor* executor : std::vector<BaseExecutor*>{
+					gpu_executors[gpu_id], weights_executors[gpu_id],
+					inputs_executors[gpu_id], outputs_executors[gpu_id]}) {
+				writer.gauge("clockwork_executor_queued_tasks", help, executor->queued,
+					{{"gpu", std::to_string(gpu_id)}, {"type", TaskTypeName(executor->type)}});
+			}
+		}
+
+		std::vector<ExecutorTelemetry> executors;
+		executor_telemetry(executors);
+		for (auto &e : executors) {
+			metrics::Labels labels = {{"type", TaskTypeName(static_cast<TaskType>(e.task_type))}};
+			if (e.gpu_id >= 0) labels.insert(labels.begin(), {"gpu", std::to_string(e.gpu_id)});
+			writer.counter("clockwork_executor_busy_seconds_total",
+				"Time an executor had a task in progress", e.busy / 1000000000.0, labels);
+			writer.counter("clockwork_executor_tasks_total",
+				"Tasks dequeued by an executor", e.tasks, labels);
+			writer.counter("clockwork_executor_dropped_tasks_total",
+				"Tasks dequeued after the latest time they could start", e.dropped, labels);
+			writer.counter("clockwork_executor_lateness_seconds_total",
+				"Total time from tasks becoming eligible until they were dequeued", e.lateness / 1000000000.0, labels);
+		}
+
+		for (unsigned gpu_id = 0; gpu_id < manager->weights_caches.size(); gpu_id++) {
+			PageCache* cache = manager->weights_caches[gpu_id];
+			metrics::Labels labels = {{"gpu", std::to_string(gpu_id)}};
+			writer.gauge("clockwork_weights_cache_pages_used",
+				"Weights cache pages allocated", (int) cache->n_pages - cache->freePages.size(), labels);
+			writer.gauge("clockwork_weights_cache_pages_total",
+				"Weights cache pages", cache->n_pages, labels);
+		}
+	});
+}
+
+void ClockworkRuntime::executor_telemetry(std::vector<ExecutorTelemetry> &telemetry) {
+	auto read = [&telemetry] (BaseExecutor* executor, int gpu_id) {
+		ExecutorTelemetry t;
+		t.task_type = executor->type;
+		t.gpu_id = gpu_id;
+		t.timestamp = util::now();
+		t.busy = executor->stats.busy;
+		t.tasks = executor->stats.tasks;
+		t.dropped = executor->stats.dropped;
+		t.lateness = executor->stats.lateness;
+		t.queued = executor->queued;
+		telemetry.push_back(t);
+	};
+
+	read(load_model_executor, -1);
+	for (unsigned gpu_id = 0; gpu_id < num_gpus; gpu_id++) {
+		read(gpu_executors[gpu_id], gpu_id);
+		read(weights_executors[gpu_id], gpu_id);
+		read(inputs_executors[gpu_id], gpu_id);
+		read(outputs_executors[gpu_id], gpu_id);
+	}
+}
+
 }
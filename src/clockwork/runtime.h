@@ -19,6 +19,7 @@
 #include "clockwork/task.h"
 #include "clockwork/memory.h"
 #include "clockwork/config.h"
+#include "clockwork/telemetry/metrics.h"
 
 /*
 This file contains the clockwork scheduling and thread pool logic for executing tasks, asynchronous
@@ -29,14 +30,40 @@ namespace clockwork {
 
 class ClockworkRuntime;
 
+// Running totals of an executor's work, read without locks
+class ExecutorStats {
+private:
+	uint64_t async_end = 0; // when the last asynchronous work completed
+
+public:
+	std::atomic_uint64_t busy;
+	std::atomic_uint64_t tasks;
+	std::atomic_uint64_t dropped;
+	std::atomic_uint64_t lateness;
+
+	ExecutorStats() : busy(0), tasks(0), dropped(0), lateness(0) {}
+
+	// Called by the executor thread as it dequeues a task, and when the task's run returns
+	void dequeued(Task* task, uint64_t now);
+	void ran(uint64_t dequeued, uint64_t now);
+
+	// Called by the async task checker when a task's asynchronous work completes.  Asynchronous
+	// work runs in order on the executor's stream, so only time not already covered by the
+	// previous task's work is counted.  Launches are counted both here and by ran, but take
+	// microseconds.
+	void async_completed(uint64_t dequeued, uint64_t now);
+};
+
 class BaseExecutor {
 public:
 	const TaskType type;
 	std::atomic_bool alive;
 	std::vector<std::thread> threads;
 	single_reader_priority_queue<Task> queue;
+	std::atomic_int64_t queued; // tasks enqueued but not yet dequeued
+	ExecutorStats stats;
 
-	BaseExecutor(TaskType type) : type(type), alive(true) {}
+	BaseExecutor(TaskType type) : type(type), alive(true), queued(0) {}
 
 	void enqueue(Task* task);
 	void shutdown();
@@ -138,6 +165,12 @@ public:
 
 	void join();
 
+	// Exports executor queue depths and utilization, and weights cache occupancy
+	void add_metrics(metrics::Registry &registry);
+
+	// Reads the running totals of every executor
+	void executor_telemetry(std::vector<ExecutorTelemetry> &telemetry);
+
 protected:
 
 
@@ -1,76 +1,74 @@
 #ifndef _CLOCKWORK_SLIDING_WINDOW_H_
 #define _CLOCKWORK_SLIDING_WINDOW_H_
 
-/* These two files are included for the Order Statistics Tree. */
-#include <ext/pb_ds/assoc_container.hpp>
-#include <ext/pb_ds/tree_policy.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
 
+/* Sliding window over the most recent window_size measurements, supporting
+   order-statistic queries.  Measurements are kept twice: in a ring buffer in
+   arrival order, so the oldest can be found in O(1), and in a sorted array, so
+   that get_value and get_percentile are O(1).  An insert into a full window
+   replaces the oldest measurement in the sorted array with a single shift of
+   the elements between the two positions.  Windows in clockwork are small
+   (10 to 1024 entries), so this is a short memmove with no allocation. */
 template <typename T> 
 class SlidingWindowT {
 private:
 	unsigned window_size;
 
-	/* An order statistics tree is used to implement a wrapper around a C++
-	   set with the ability to know the ordinal number of an item in the set
-	   and also to get an item by its ordinal number from the set.
-	   The data structure I use is implemented in STL but only for GNU C++.
-	   Some sources are documented below:
-	     -- https://gcc.gnu.org/onlinedocs/libstdc++/ext/pb_ds/
-	     -- https://codeforces.com/blog/entry/11080
-	     -- https://gcc.gnu.org/onlinedocs/libstdc++/ext/pb_ds/tree_based_containers.html
-	     -- https://opensource.apple.com/source/llvmgcc42/llvmgcc42-2336.9/libstdc++-v3/testsuite/ext/pb_ds/example/tree_order_statistics.cc.auto.html
-		 -- https://stackoverflow.com/questions/44238144/order-statistics-tree-using-gnu-pbds-for-multiset
-	     -- https://www.geeksforgeeks.org/order-statistic-tree-using-fenwick-tree-bit/ */
-
-	typedef __gnu_pbds::tree<
-		T,
-		__gnu_pbds::null_type,
-		std::less_equal<T>,
-		__gnu_pbds::rb_tree_tag,
-		__gnu_pbds::tree_order_statistics_node_update> OrderedMultiset;
-
-	/* We maintain a list of data items (FIFO ordered) so that the latest
-	   and the oldest items can be easily tracked for insertion and removal.
-	   And we also maintain a parallel OrderedMultiset data structure where the
-	   items are stored in an order statistics tree so that querying, say, the
-	   99th percentile value is easy. We also maintain an upper bound on sliding
-	   window size. After the first few iterations, the number of data items
-	   is always equal to the upper bound. Thus, we have:
-			-- Invariant 1: q.size() == oms.size()
-			-- Invariant 2: q.size() <= window_size */
-	std::list<T> q;
-	OrderedMultiset oms;
+	/* Invariants:
+			-- ring.size() == sorted.size() <= window_size
+			-- once the window is full, ring[head] is the oldest item */
+	std::vector<T> ring;
+	std::vector<T> sorted;
+	unsigned head = 0;
 
 public:
-	SlidingWindowT() : window_size(100) {}
-	SlidingWindowT(unsigned window_size) : window_size(window_size) {}
+	SlidingWindowT() : SlidingWindowT(100) {}
+	SlidingWindowT(unsigned window_size) : window_size(window_size) {
+		ring.reserve(window_size);
+		sorted.reserve(window_size);
+	}
 
-	/* Assumption: q.size() == oms.size() */
-	unsigned get_size() { return q.size(); }
+	unsigned get_size() { return sorted.size(); }
 
-	/* Requirement: rank < oms.size() */
-	T get_value(unsigned rank) { return (*(oms.find_by_order(rank))); }
+	/* Requirement: rank < get_size() */
+	T get_value(unsigned rank) { return sorted[rank]; }
 	T get_percentile(float percentile) {
-		float position = percentile * (q.size() - 1);
+		float position = percentile * (sorted.size() - 1);
 		unsigned up = ceil(position);
 		unsigned down = floor(position);
 		if (up == down) return get_value(up);
 		return get_value(up) * (position - down) + get_value(down) * (up - position);
 	}
 	T get_min() { return get_value(0); }
-	T get_max() { return get_value(q.size()-1); }
+	T get_max() { return get_value(sorted.size()-1); }
 	void insert(T latest) {
-		q.push_back(latest);
-		oms.insert(latest);
-		if (q.size() > window_size) {
-			uint64_t oldest = q.front();
-			q.pop_front();
-			auto it=oms.upper_bound (oldest);
-			oms.erase(it); // Assumption: *it == oldest
+		if (ring.size() < window_size) {
+			ring.push_back(latest);
+			sorted.insert(std::upper_bound(sorted.begin(), sorted.end(), latest), latest);
+			return;
+		}
+
+		T oldest = ring[head];
+		ring[head] = latest;
+		head = (head + 1) % window_size;
+
+		auto remove = std::lower_bound(sorted.begin(), sorted.end(), oldest); // Assumption: *remove == oldest
+		auto position = std::upper_bound(sorted.begin(), sorted.end(), latest);
+		if (position > remove) {
+			/* Shift (remove, position) left by one */
+			std::move(remove + 1, position, remove);
+			*(position - 1) = latest;
+		} else {
+			/* Shift [position, remove) right by one */
+			std::move_backward(position, remove, remove + 1);
+			*position = latest;
 		}
 	}
 	
-	SlidingWindowT(unsigned window_size, T initial_value) : window_size(window_size) {
+	SlidingWindowT(unsigned window_size, T initial_value) : SlidingWindowT(window_size) {
 		insert(initial_value);
 	}
 };
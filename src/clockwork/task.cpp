@@ -32,6 +32,7 @@ void CudaAsyncTask::record_async_begin(cudaStream_t stream) {
 void CudaAsyncTask::record_async_end(cudaStream_t stream) {
 	CUDA_CALL(cudaSetDevice(gpu_id));
 	CUDA_CALL(cudaEventRecord(async_end_event, stream));
+	telemetry.exec_complete = util::hrt();
 	async_end_submitted.store(true);
 }
 
@@ -86,6 +87,10 @@ uint64_t LoadModelFromDiskTask::eligible() {
 	return earliest;
 }
 
+uint64_t LoadModelFromDiskTask::deadline() {
+	return latest;
+}
+
 void LoadModelFromDiskTask::run(cudaStream_t stream) {
 	uint64_t now = util::now(); // TODO: use chrono
 	if (now < earliest) {
@@ -156,6 +161,10 @@ uint64_t LoadWeightsTask::eligible() {
 	return earliest;
 }
 
+uint64_t LoadWeightsTask::deadline() {
+	return latest;
+}
+
 void LoadWeightsTask::run(cudaStream_t stream) {
 	uint64_t now = util::now(); // TODO: use chrono
 	if (now < earliest) {
@@ -193,6 +202,7 @@ void LoadWeightsTask::run(cudaStream_t stream) {
 	if (previous_weights != nullptr && !previous_weights->evicted) {
 		manager->weights_caches[gpu_id]->unlock(previous_weights);
 		manager->weights_caches[gpu_id]->free(previous_weights);
+		manager->models->weights_evicted(model_id, gpu_id);
 	}
 
 	unsigned num_pages = rm->model->num_weights_pages(manager->weights_caches[gpu_id]->page_size);
@@ -208,7 +218,7 @@ void LoadWeightsTask::run(cudaStream_t stream) {
 }
 
 void LoadWeightsTask::process_completion() {
-	telemetry->async_duration = this->async_duration();
+	telemetry.async_duration = this->async_duration();
 
 	bool version_unchanged = false;
 
@@ -223,6 +233,7 @@ void LoadWeightsTask::process_completion() {
 	rm->unlock();
 
 	if (version_unchanged) {
+		manager->models->weights_loaded(model_id, gpu_id);
 		success(rm);
 	} else {
 		throw TaskError(loadWeightsConcurrentModification, "Model weights were modified while being copied");
@@ -242,6 +253,10 @@ uint64_t EvictWeightsTask::eligible() {
 	return earliest;
 }
 
+uint64_t EvictWeightsTask::deadline() {
+	return latest;
+}
+
 void EvictWeightsTask::run(cudaStream_t stream) {
 	uint64_t now = util::now(); // TODO: use chrono, possibly use the task telemetry
 	if (now < earliest) {
@@ -271,6 +286,7 @@ void EvictWeightsTask::run(cudaStream_t stream) {
 
 	manager->weights_caches[gpu_id]->unlock(previous_weights);
 	manager->weights_caches[gpu_id]->free(previous_weights);
+	manager->models->weights_evicted(model_id, gpu_id);
 
 	success(rm);
 }
@@ -302,6 +318,10 @@ uint64_t CopyInputTask::eligible() {
 	return earliest;
 }
 
+uint64_t CopyInputTask::deadline() {
+	return latest;
+}
+
 void CopyInputTask::run(cudaStream_t stream) {
 	uint64_t now = util::now(); // TODO: use chrono
 	if (now < earliest) {
@@ -407,7 +427,7 @@ void CopyInputTask::run(cudaStream_t stream) {
 }
 
 void CopyInputTask::process_completion() {
-	telemetry->async_duration = this->async_duration();
+	telemetry.async_duration = this->async_duration();
 	this->success(rm, io_memory);
 }
 
@@ -434,6 +454,10 @@ uint64_t ExecTask::eligible() {
 	return earliest;
 }
 
+uint64_t ExecTask::deadline() {
+	return latest;
+}
+
 void ExecTask::run(cudaStream_t stream) {
 	uint64_t now = util::now(); // TODO: use chrono
 	if (now < earliest) {
@@ -491,7 +515,7 @@ void ExecTask::run(cudaStream_t stream) {
 }
 
 void ExecTask::process_completion() {
-	telemetry->async_duration = this->async_duration();
+	telemetry.async_duration = this->async_duration();
 
 	rm->lock();
 
@@ -523,6 +547,10 @@ uint64_t CopyOutputTask::eligible() {
 	return earliest;
 }
 
+uint64_t CopyOutputTask::deadline() {
+	return latest;
+}
+
 void CopyOutputTask::run(cudaStream_t stream) {
 	uint64_t now = util::now(); // TODO: use chrono
 	if (now < earliest) {
@@ -546,7 +574,7 @@ void CopyOutputTask::run(cudaStream_t stream) {
 }
 
 void CopyOutputTask::process_completion() {
-	telemetry->async_duration = this->async_duration();
+	telemetry.async_duration = this->async_duration();
 	this->success(output);
 }
 
@@ -39,16 +39,23 @@ public:
 
 };
 
+class ExecutorStats;
+
 class Task {
 public:
-	std::shared_ptr<TaskTelemetry> telemetry;
+	TaskTelemetry telemetry;
 	unsigned gpu_id = -1;
 
-	Task() : telemetry(std::make_shared<TaskTelemetry>()){}
+	// Set by the executor that dequeues the task, so asynchronous completion can be accounted to it
+	ExecutorStats* executor_stats = nullptr;
+	uint64_t dequeued_at = 0;
+
+	Task() {}
 
-	Task(unsigned gpu_id): gpu_id(gpu_id), telemetry(std::make_shared<TaskTelemetry>()) {}
+	Task(unsigned gpu_id): gpu_id(gpu_id) {}
 
 	virtual uint64_t eligible() = 0;
+	virtual uint64_t deadline() = 0; // the latest time the task can start
 	virtual void run(cudaStream_t stream) = 0;
 	virtual void cancel() = 0;
 };
@@ -108,6 +115,7 @@ public:
 
 	// Task
 	uint64_t eligible();
+	uint64_t deadline();
 	void run(cudaStream_t stream = 0);
 	virtual void cancel() = 0;
 
@@ -134,6 +142,7 @@ public:
 
 	// Task
 	uint64_t eligible();
+	uint64_t deadline();
 	void run(cudaStream_t stream);
 	virtual void cancel() = 0;
 
@@ -159,6 +168,7 @@ public:
 
 	// Task
 	uint64_t eligible();
+	uint64_t deadline();
 	void run(cudaStream_t stream);
 	virtual void cancel() = 0;
 
@@ -193,6 +203,7 @@ public:
 
 	// Task
 	uint64_t eligible();
+	uint64_t deadline();
 	void run(cudaStream_t stream);
 	virtual void cancel() = 0;
 
@@ -224,6 +235,7 @@ public:
 
 	// Task
 	uint64_t eligible();
+	uint64_t deadline();
 	void run(cudaStream_t stream);
 	virtual void cancel() = 0;
 
@@ -253,6 +265,7 @@ public:
 
 	// Task
 	uint64_t eligible();
+	uint64_t deadline();
 	void run(cudaStream_t stream);
 	virtual void cancel() = 0;
 
@@ -16,29 +16,33 @@
 #include <pods/buffers.h>
 #include <pods/streams.h>
 #include "clockwork/thread.h"
+#include "clockwork/telemetry/columnar.h"
+#include "clockwork/telemetry/telemetry_ring.h"
 
 
 namespace clockwork {
 
 class ActionTelemetryLogger {
 public:
-	virtual void log(std::shared_ptr<ActionTelemetry> telemetry) = 0;
+	virtual void log(ActionTelemetry &telemetry) = 0;
 	virtual void shutdown(bool awaitCompletion) = 0;
 };
 
 class ActionTelemetryDummyLogger : public ActionTelemetryLogger {
 
-	void log(std::shared_ptr<ActionTelemetry> telemetry) {}
+	void log(ActionTelemetry &telemetry) {}
 	void shutdown(bool awaitCompletion) {}
 
 };
 
 class ActionTelemetryFileLogger : public ActionTelemetryLogger {
 private:
+	static const uint64_t flush_interval = 5000000000UL; // how often a partial columnar chunk is written out
 	const std::string output_filename;
 	std::atomic_bool alive;
 	std::thread thread;
-	tbb::concurrent_queue<std::shared_ptr<ActionTelemetry>> action_queue;
+	TelemetryRings<ActionTelemetry> action_rings; // one per worker thread
+	uint64_t dropped_reported = 0;
 
 public:	
 	ActionTelemetryFileLogger(std::string output_filename) : output_filename(output_filename), alive(true) {
@@ -53,53 +57,98 @@ public:
 		}
 	}
 	
-	void log(std::shared_ptr<ActionTelemetry> telemetry) {
-		action_queue.push(telemetry);
+	void log(ActionTelemetry &telemetry) {
+		action_rings.log(telemetry);
 	}
 
-	void convert(std::shared_ptr<ActionTelemetry> telemetry, SerializedActionTelemetry *converted) {
-		converted->telemetry_type = telemetry->telemetry_type;
-		converted->action_id = telemetry->action_id;
-		converted->action_type = telemetry->action_type;
-		converted->status = telemetry->status;
-		converted->timestamp = util::nanos(telemetry->timestamp);
+	uint64_t dropped() {
+		return action_rings.dropped();
+	}
+
+	// Prints records dropped since the last call; only called from the logger thread
+	void report_dropped() {
+		uint64_t total = dropped();
+		if (total > dropped_reported) {
+			std::cout << "Dropped " << (total - dropped_reported) << " action telemetry records" << std::endl;
+			dropped_reported = total;
+		}
+	}
+
+	void convert(const ActionTelemetry &telemetry, SerializedActionTelemetry *converted) {
+		converted->telemetry_type = telemetry.telemetry_type;
+		converted->action_id = telemetry.action_id;
+		converted->action_type = telemetry.action_type;
+		converted->status = telemetry.status;
+		converted->timestamp = util::nanos(telemetry.timestamp);
 	}
 
 	void main() {
+		if (columnar::has_extension(output_filename)) {
+			main_columnar();
+			return;
+		}
+
 		std::ofstream outfile;
 		outfile.open(output_filename);
 	    pods::OutputStream out(outfile);
 	    pods::BinarySerializer<decltype(out)> serializer(out);
 
-		while (alive) {
-			std::shared_ptr<ActionTelemetry> srcActionTelemetry;
-			if (!action_queue.try_pop(srcActionTelemetry)) {
-				usleep(10000);
-				continue;
-			}
-
+		auto save = [this, &serializer] (ActionTelemetry &srcActionTelemetry) {
 			SerializedActionTelemetry actionTelemetry;
 			convert(srcActionTelemetry, &actionTelemetry);
-		   	CHECK(serializer.save(actionTelemetry) == pods::Error::NoError) << "Unable to serialize action telemetry";
-
-			// std::stringstream msg;
-			// msg << "Logging request " << telemetry.request_id 
-			//     << " model=" << telemetry.model_id
-			//     << " latency=" << (telemetry.complete - telemetry.submitted)
-			//     << " totallatency=" << (telemetry.complete - telemetry.arrived)
-			//     << std::endl;
-			// for (int i = 0; i < telemetry.tasks.size(); i++) {
-			// 	msg << "   Task " << i << std::endl
-			// 	    << "     queue=" << (telemetry.tasks[i].dequeued - telemetry.tasks[i].enqueued) << std::endl
-			// 	    << "     exec="  << (telemetry.tasks[i].exec_complete - telemetry.tasks[i].dequeued) << std::endl
-			// 	    << "     async_wait=" << telemetry.tasks[i].async_wait << std::endl
-			// 	    << "     async_duration=" << telemetry.tasks[i].async_duration << std::endl;
-			// }
-			// std::cout << msg.str();
+			CHECK(serializer.save(actionTelemetry) == pods::Error::NoError) << "Unable to serialize action telemetry";
+		};
+
+		while (alive) {
+			action_rings.drain(save);
+			report_dropped();
+			usleep(10000);
 		}
+		action_rings.drain(save);
+		report_dropped();
 		outfile.close();
 	}
 
+	// Writes the columns `./inflate action` would
+	void main_columnar() {
+		columnar::Writer writer(output_filename, {
+			{"telemetry_type", columnar::i32},
+			{"action_id", columnar::i32},
+			{"action_type", columnar::i32},
+			{"status", columnar::i32},
+			{"timestamp", columnar::timestamp}
+		});
+
+		auto save = [this, &writer] (ActionTelemetry &srcActionTelemetry) {
+			SerializedActionTelemetry t;
+			convert(srcActionTelemetry, &t);
+
+			writer.set_int(0, t.telemetry_type);
+			writer.set_int(1, t.action_id);
+			writer.set_int(2, t.action_type);
+			writer.set_int(3, t.status);
+			writer.set_int(4, t.timestamp);
+			writer.end_row();
+		};
+
+		uint64_t next_flush = util::now() + flush_interval;
+		while (alive) {
+			action_rings.drain(save);
+			report_dropped();
+
+			// Write out a partial chunk so the file keeps up with a slow trickle of rows
+			uint64_t now = util::now();
+			if (now >= next_flush) {
+				writer.flush();
+				next_flush = now + flush_interval;
+			}
+			usleep(10000);
+		}
+		action_rings.drain(save);
+		report_dropped();
+		writer.close();
+	}
+
 };
 
 }
@@ -21,6 +21,7 @@
 #include <tbb/concurrent_queue.h>
 #include <iomanip>
 #include "clockwork/thread.h"
+#include "clockwork/telemetry/histogram.h"
 
 
 namespace clockwork {
@@ -32,7 +33,7 @@ public:
 	std::atomic_uint64_t completed = 0;
 	virtual void log(int user_id, int model_id, int batch_size, 
 		size_t input_size, size_t output_size,
-		uint64_t request_sent, uint64_t response_received,
+		uint64_t request_intended, uint64_t request_sent, uint64_t response_received,
 		bool success) = 0;
 	void incrOutstanding() { outstanding++; submitted++; }
 	void decrOutstanding() { outstanding--; completed++; }
@@ -43,59 +44,31 @@ class NoOpClientTelemetryLogger : public ClientTelemetryLogger {
 public:
 	virtual void log(int user_id, int model_id, int batch_size, 
 		size_t input_size, size_t output_size,
-		uint64_t request_sent, uint64_t response_received,
+		uint64_t request_intended, uint64_t request_sent, uint64_t response_received,
 		bool success) {};
 	virtual void shutdown(bool awaitCompletion) {};
 };
 
-struct Sample {
-	int user_id;
-	int model_id;
-	int batch_size;
-	size_t input_size;
-	size_t output_size;
-	uint64_t request_sent;
-	uint64_t response_received;
-	bool success;
-};
-
 struct Summary {
-	int count;
-	double sum;
+	uint64_t count;
 	uint64_t min;
 	uint64_t max;
+	double mean;
 	double throughput;
-	uint64_t duration;
-
-	Summary(uint64_t duration, std::vector<Sample> samples): duration(duration) {
-		if (samples.size() == 0) {
-			count = 0;
-			sum = 0;
-			min = 0;
-			max = 0;
-			throughput = 0;
-			duration = duration;
-		} else {
-			count = samples.size();
-			sum = 0;
-			min = UINT64_MAX;
-			max = 0;
-			duration = duration;
-			for (auto &sample : samples) {
-				uint64_t latency = sample.response_received - sample.request_sent;
-				sum += latency;
-				min = std::min(min, latency);
-				max = std::max(max, latency);
-			}
-			throughput = count * 1000000000.0 / static_cast<double>(duration);
-		}
+	std::string percentiles;
+
+	Summary(uint64_t duration, const Histogram &latency) :
+		count(latency.count()), min(latency.min()), max(latency.max()), mean(latency.mean()),
+		throughput(count * 1000000000.0 / static_cast<double>(duration)),
+		percentiles(latency.percentiles_str()) {
 	}
 
 	std::string str() {
 		std::stringstream s;
 		s << std::fixed << std::setprecision(2);
 		s << "throughput=" << throughput;
-		s << " min=" << (min/1000000.0) << " max=" << (max/1000000.0) << " mean=" << (sum/(1000000.0*count));
+		s << " min=" << (min/1000000.0) << " max=" << (max/1000000.0) << " mean=" << (mean/1000000.0);
+		s << " " << percentiles;
 		return s.str();
 	}
 };
@@ -104,7 +77,9 @@ class ClientTelemetrySummarizer : public ClientTelemetryLogger {
 public:
 	uint64_t print_interval;
 	std::atomic_bool alive = true;
-	tbb::concurrent_queue<Sample> samples;
+	Histogram latency; // of successful requests since the last print
+	Histogram intended_latency; // as latency, but from when requests were meant to be sent
+	Histogram lag; // of all requests, from when they were meant to be sent until they were sent
 	std::thread thread;
 	std::atomic_int errors = 0;
 
@@ -118,64 +93,50 @@ public:
 		uint64_t last_print = util::now();
 		bool begun = false;
 
-		std::queue<Sample> newSamples;
+		Histogram interval;
+		Histogram interval_intended;
+		Histogram interval_lag;
 		while (alive) {
-			Sample sample;
-			while (samples.try_pop(sample)) {
-				newSamples.push(sample);
-				begun = true;
-			}
-
 			uint64_t now = util::now();
 			if (last_print + print_interval > now) {
 				usleep(10000);
 				continue;
 			}
 
-			std::vector<Sample> all_samples;
-			// std::map<unsigned, std::vector<Sample>> samples_by_user;
-			while (!newSamples.empty()) {
-				sample = newSamples.front();
-				// samples_by_user[sample.user_id].push_back(sample);
-				all_samples.push_back(sample);
-				newSamples.pop();
-			}
+			interval.reset();
+			interval_intended.reset();
+			interval_lag.reset();
+			latency.drain_into(interval);
+			intended_latency.drain_into(interval_intended);
+			lag.drain_into(interval_lag);
+			begun |= interval.count() > 0;
 
 			std::stringstream report;
 			report << "total=" << submitted.exchange(0) << " ";
-			if (begun && all_samples.size() == 0) {
+			if (begun && interval.count() == 0) {
 				report << "throughput=0" << std::endl;
 			} else if (begun) {
-				report << Summary(now - last_print,all_samples).str() 
+				report << Summary(now - last_print, interval).str() 
+				       << " intended " << interval_intended.percentiles_str()
+				       << " lag_max=" << std::fixed << std::setprecision(2) << (interval_lag.max() / 1000000.0)
+				       << " lag " << interval_lag.percentiles_str()
 				       << std::endl;
 			}
 			std::cout << report.str();
 
-			// std::stringstream report;
-			// if (begun && samples_by_user.size() == 0) {
-			// 	report << "throughput=0" << std::endl;
-			// } else {
-			// 	for (auto &p : samples_by_user) {
-			// 		report << "User " << p.first << " " 
-			// 		       << Summary(now - last_print, p.second).str() 
-			// 		       << std::endl;
-			// 	}
-			// }
-			// std::cout << report.str();
-
 			last_print = now;
 		}
 	}
 
 	virtual void log(int user_id, int model_id, int batch_size, 
 		size_t input_size, size_t output_size,
-		uint64_t request_sent, uint64_t response_received,
+		uint64_t request_intended, uint64_t request_sent, uint64_t response_received,
 		bool success)
 	{
+		lag.record(request_sent - request_intended);
 		if (success) {
-			samples.push(Sample{user_id, model_id, batch_size, 
-				input_size, output_size, request_sent, 
-				response_received, success});
+			latency.record(response_received - request_sent);
+			intended_latency.record(response_received - request_intended);
 		} else {
 			errors++;
 		}
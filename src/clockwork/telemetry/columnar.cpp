@@ -0,0 +1,298 @@
+#include "clockwork/telemetry/columnar.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <lz4.h>
+#include <dmlc/logging.h>
+
+namespace clockwork {
+namespace columnar {
+
+unsigned width(Type type) {
+	switch (type) {
+		case i32: return 4;
+		case i64: return 8;
+		case f32: return 4;
+		case f64: return 8;
+		case timestamp: return 8;
+	}
+	CHECK(false) << "Unknown column type " << (int) type;
+	return 0;
+}
+
+Writer::Writer(std::string filename, std::vector<Column> columns, bool compress, unsigned chunk_rows) :
+		columns(columns), compress(compress), chunk_rows(chunk_rows),
+		buffers(columns.size()), previous(columns.size(), 0), assigned(columns.size(), false) {
+	CHECK(chunk_rows > 0) << "Chunks must have at least one row";
+	f = fopen(filename.c_str(), "wb");
+	CHECK(f != nullptr) << "Unable to open " << filename << " for writing";
+
+	uint32_t num_columns = columns.size();
+	fwrite(magic, sizeof(magic), 1, f);
+	fwrite(&num_columns, sizeof(num_columns), 1, f);
+	for (auto &column : columns) {
+		CHECK(column.name.size() < 256) << "Column name too long: " << column.name;
+		uint8_t type = column.type;
+		uint8_t length = column.name.size();
+		fwrite(&type, 1, 1, f);
+		fwrite(&length, 1, 1, f);
+		fwrite(column.name.data(), 1, length, f);
+	}
+	fflush(f);
+
+	for (unsigned i = 0; i < columns.size(); i++) {
+		widths.push_back(width(columns[i].type));
+		buffers[i].resize(widths[i] * chunk_rows, 0);
+	}
+}
+
+Writer::~Writer() {
+	close();
+}
+
+void Writer::set_int(unsigned column, int64_t value) {
+	char* dst = buffers[column].data() + rows * widths[column];
+	switch (columns[column].type) {
+		case i32: { int32_t v = value; memcpy(dst, &v, 4); return; }
+		case i64: { memcpy(dst, &value, 8); return; }
+		case f32: { float v = value; memcpy(dst, &v, 4); return; }
+		case f64: { double v = value; memcpy(dst, &v, 8); return; }
+		case timestamp: {
+			uint64_t v = value;
+			uint64_t delta = v - previous[column];
+			memcpy(dst, &delta, 8);
+			previous[column] = v;
+			assigned[column] = true;
+			return;
+		}
+	}
+}
+
+void Writer::set_float(unsigned column, double value) {
+	char* dst = buffers[column].data() + rows * widths[column];
+	switch (columns[column].type) {
+		case f32: { float v = value; memcpy(dst, &v, 4); return; }
+		case f64: { memcpy(dst, &value, 8); return; }
+		default: set_int(column, (int64_t) value); return;
+	}
+}
+
+void Writer::end_row() {
+	// Like other values, a timestamp not set in this row is 0
+	for (unsigned i = 0; i < columns.size(); i++) {
+		if (columns[i].type != timestamp) continue;
+		if (!assigned[i]) {
+			uint64_t delta = 0 - previous[i];
+			memcpy(buffers[i].data() + rows * 8, &delta, 8);
+			previous[i] = 0;
+		}
+		assigned[i] = false;
+	}
+
+	rows++;
+	if (rows < chunk_rows) {
+		for (unsigned i = 0; i < columns.size(); i++) {
+			memset(buffers[i].data() + rows * widths[i], 0, widths[i]);
+		}
+	} else {
+		flush();
+	}
+}
+
+void Writer::flush() {
+	if (f == nullptr || rows == 0) return;
+
+	raw.clear();
+	for (unsigned i = 0; i < columns.size(); i++) {
+		raw.insert(raw.end(), buffers[i].data(), buffers[i].data() + rows * widths[i]);
+	}
+
+	ChunkHeader header;
+	header.magic = chunk_magic;
+	header.rows = rows;
+	header.flags = 0;
+	header.raw_size = raw.size();
+	header.stored_size = raw.size();
+	const char* data = raw.data();
+
+	if (compress) {
+		compressed.resize(LZ4_compressBound(raw.size()));
+		int size = LZ4_compress_default(raw.data(), compressed.data(), raw.size(), compressed.size());
+		if (size > 0 && (size_t) size < raw.size()) {
+			header.flags |= chunk_compressed;
+			header.stored_size = size;
+			data = compressed.data();
+		}
+	}
+
+	fwrite(&header, sizeof(header), 1, f);
+	fwrite(data, 1, header.stored_size, f);
+	fflush(f);
+
+	// Each chunk's first timestamps are stored in full
+	rows = 0;
+	for (unsigned i = 0; i < columns.size(); i++) {
+		memset(buffers[i].data(), 0, widths[i]);
+		previous[i] = 0;
+	}
+}
+
+void Writer::close() {
+	if (f == nullptr) return;
+	flush();
+	fclose(f);
+	f = nullptr;
+}
+
+int64_t Reader::Chunk::get_int(unsigned column, unsigned row) const {
+	const char* src = columns[column] + row * width((*schema)[column].type);
+	switch ((*schema)[column].type) {
+		case i32: { int32_t v; memcpy(&v, src, 4); return v; }
+		case f32: { float v; memcpy(&v, src, 4); return v; }
+		case f64: { double v; memcpy(&v, src, 8); return v; }
+		default: { int64_t v; memcpy(&v, src, 8); return v; }
+	}
+}
+
+double Reader::Chunk::get_float(unsigned column, unsigned row) const {
+	const char* src = columns[column] + row * width((*schema)[column].type);
+	switch ((*schema)[column].type) {
+		case f32: { float v; memcpy(&v, src, 4); return v; }
+		case f64: { double v; memcpy(&v, src, 8); return v; }
+		default: return get_int(column, row);
+	}
+}
+
+Reader::Reader(std::string filename) {
+	fd = open(filename.c_str(), O_RDONLY);
+	CHECK(fd >= 0) << "Unable to open " << filename;
+
+	struct stat st;
+	CHECK(fstat(fd, &st) == 0) << "Unable to stat " << filename;
+	size = st.st_size;
+	CHECK(size >= sizeof(magic) + sizeof(uint32_t)) << filename << " is not a columnar telemetry file";
+
+	void* m = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	CHECK(m != MAP_FAILED) << "Unable to mmap " << filename;
+	mapped = static_cast<const char*>(m);
+	madvise(m, size, MADV_SEQUENTIAL);
+
+	CHECK(memcmp(mapped, magic, sizeof(magic)) == 0) << filename << " is not a columnar telemetry file";
+	size_t offset = sizeof(magic);
+
+	uint32_t num_columns;
+	memcpy(&num_columns, mapped + offset, sizeof(num_columns));
+	offset += sizeof(num_columns);
+	for (unsigned i = 0; i < num_columns; i++) {
+		CHECK(offset + 2 <= size) << filename << " has a truncated header";
+		Column column;
+		column.type = static_cast<Type>(mapped[offset]);
+		uint8_t length = mapped[offset + 1];
+		offset += 2;
+		CHECK(offset + length <= size) << filename << " has a truncated header";
+		column.name = std::string(mapped + offset, length);
+		offset += length;
+		width(column.type);
+		columns_.push_back(column);
+	}
+
+	// Index the chunks; a truncated chunk at the end is still being written
+	while (offset + sizeof(ChunkHeader) <= size) {
+		ChunkHeader header;
+		memcpy(&header, mapped + offset, sizeof(header));
+		CHECK(header.magic == chunk_magic) << filename << " has a corrupt chunk at offset " << offset;
+		if (offset + sizeof(header) + header.stored_size > size) break;
+
+		chunk_offsets.push_back(offset);
+		rows_ += header.rows;
+		offset += sizeof(header) + header.stored_size;
+	}
+}
+
+Reader::~Reader() {
+	if (mapped != nullptr) munmap(const_cast<char*>(mapped), size);
+	if (fd >= 0) ::close(fd);
+}
+
+int Reader::column(std::string name) const {
+	for (unsigned i = 0; i < columns_.size(); i++) {
+		if (columns_[i].name == name) return i;
+	}
+	return -1;
+}
+
+void Reader::read(unsigned index, Chunk &chunk) const {
+	ChunkHeader header;
+	memcpy(&header, mapped + chunk_offsets[index], sizeof(header));
+	const char* data = mapped + chunk_offsets[index] + sizeof(header);
+
+	if (header.flags & chunk_compressed) {
+		chunk.decompressed.resize(header.raw_size);
+		int size = LZ4_decompress_safe(data, chunk.decompressed.data(), header.stored_size, header.raw_size);
+		CHECK(size == (int) header.raw_size) << "Unable to decompress chunk " << index;
+		data = chunk.decompressed.data();
+	}
+
+	chunk.schema = &columns_;
+	chunk.rows = header.rows;
+	chunk.columns.resize(columns_.size());
+	chunk.timestamps.resize(columns_.size());
+	for (unsigned i = 0; i < columns_.size(); i++) {
+		if (columns_[i].type == timestamp) {
+			// Undo the delta encoding
+			auto &values = chunk.timestamps[i];
+			values.resize(header.rows);
+			memcpy(values.data(), data, header.rows * sizeof(int64_t));
+			for (unsigned row = 1; row < header.rows; row++) {
+				values[row] += values[row - 1];
+			}
+			chunk.columns[i] = reinterpret_cast<const char*>(values.data());
+		} else {
+			chunk.columns[i] = data;
+		}
+		data += header.rows * width(columns_[i].type);
+	}
+}
+
+void Reader::to_tsv(std::ostream &out) const {
+	for (unsigned i = 0; i < columns_.size(); i++) {
+		out << (i == 0 ? "" : "\t") << columns_[i].name;
+	}
+	out << "\n";
+
+	Chunk chunk;
+	for (unsigned index = 0; index < chunk_offsets.size(); index++) {
+		read(index, chunk);
+		for (unsigned row = 0; row < chunk.rows; row++) {
+			for (unsigned i = 0; i < columns_.size(); i++) {
+				if (i > 0) out << "\t";
+				switch (columns_[i].type) {
+					case f32: case f64: out << chunk.get_float(i, row); break;
+					case timestamp: out << (uint64_t) chunk.get_int(i, row); break;
+					default: out << chunk.get_int(i, row); break;
+				}
+			}
+			out << "\n";
+		}
+	}
+}
+
+bool is_columnar(std::string filename) {
+	FILE* f = fopen(filename.c_str(), "rb");
+	if (f == nullptr) return false;
+	char header[sizeof(magic)];
+	bool result = fread(header, sizeof(header), 1, f) == 1 && memcmp(header, magic, sizeof(magic)) == 0;
+	fclose(f);
+	return result;
+}
+
+bool has_extension(std::string filename) {
+	static const std::string extension = ".cwcol";
+	return filename.size() >= extension.size() &&
+		filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+}
+}
@@ -0,0 +1,131 @@
+#ifndef _CLOCKWORK_TELEMETRY_COLUMNAR_H_
+#define _CLOCKWORK_TELEMETRY_COLUMNAR_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace clockwork {
+
+/*
+A chunked, columnar binary format for telemetry logs, written in place of TSV files.
+
+A file is a header naming each column and its type, followed by chunks of up to chunk_rows
+rows.  Within a chunk, each column's values are stored contiguously at a fixed width.
+Timestamp columns store the chunk's first value, then each value's difference from the
+previous one, which compress well.  Each chunk is LZ4-compressed if that makes it smaller.
+
+Files can be read while they are still being written; a partially written chunk at the end
+is ignored.
+*/
+namespace columnar {
+
+enum Type : uint8_t { i32 = 0, i64 = 1, f32 = 2, f64 = 3, timestamp = 4 };
+
+struct Column {
+	std::string name;
+	Type type;
+};
+
+unsigned width(Type type);
+
+static const char magic[8] = {'C', 'W', 'C', 'O', 'L', 'v', '1', '\n'};
+static const uint32_t chunk_magic = 0x4b4e4843; // "CHNK"
+static const uint32_t chunk_compressed = 1;
+
+struct ChunkHeader {
+	uint32_t magic;
+	uint32_t rows;
+	uint32_t flags;
+	uint32_t stored_size; // size of the chunk's data in the file
+	uint32_t raw_size; // size of the chunk's data once decompressed
+};
+
+class Writer {
+public:
+	const std::vector<Column> columns;
+	const bool compress;
+	const unsigned chunk_rows;
+
+private:
+	FILE* f;
+	std::vector<unsigned> widths;
+	std::vector<std::vector<char>> buffers; // one per column, chunk_rows values each
+	std::vector<uint64_t> previous; // last timestamp written, per column
+	std::vector<bool> assigned; // whether each timestamp has been set in the current row
+	std::vector<char> raw;
+	std::vector<char> compressed;
+	unsigned rows = 0;
+
+public:
+	Writer(std::string filename, std::vector<Column> columns,
+		   bool compress = true, unsigned chunk_rows = 4096);
+	~Writer();
+
+	// Set values of the current row, each at most once.  Values not set in a row are 0.
+	void set_int(unsigned column, int64_t value);
+	void set_float(unsigned column, double value);
+	void end_row();
+
+	// Writes out the rows ended so far as a partial chunk
+	void flush();
+	void close();
+};
+
+class Reader {
+public:
+
+	// A decoded chunk; values are only valid until the chunk is next read into
+	class Chunk {
+	public:
+		unsigned rows = 0;
+
+		// Fixed-width values of a column; timestamps are decoded
+		const char* data(unsigned column) const { return columns[column]; }
+		int64_t get_int(unsigned column, unsigned row) const;
+		double get_float(unsigned column, unsigned row) const;
+
+	private:
+		friend class Reader;
+		const std::vector<Column>* schema = nullptr;
+		std::vector<const char*> columns;
+		std::vector<char> decompressed;
+		std::vector<std::vector<int64_t>> timestamps;
+	};
+
+private:
+	int fd = -1;
+	const char* mapped = nullptr;
+	size_t size = 0;
+	std::vector<Column> columns_;
+	std::vector<size_t> chunk_offsets; // offset of each chunk's header
+	uint64_t rows_ = 0;
+
+public:
+	// Maps the file and indexes its chunks
+	Reader(std::string filename);
+	~Reader();
+
+	const std::vector<Column> &columns() const { return columns_; }
+	int column(std::string name) const; // -1 if no such column
+	unsigned num_chunks() const { return chunk_offsets.size(); }
+	uint64_t num_rows() const { return rows_; }
+
+	void read(unsigned index, Chunk &chunk) const;
+
+	// Writes a header row, then every row, tab-separated
+	void to_tsv(std::ostream &out) const;
+};
+
+// Whether the file starts with the columnar magic
+bool is_columnar(std::string filename);
+
+// Whether telemetry written to filename should be columnar, ie. it ends with .cwcol
+bool has_extension(std::string filename);
+
+}
+}
+
+#endif
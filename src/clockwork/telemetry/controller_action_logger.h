@@ -9,6 +9,8 @@
 #include <sstream>
 #include <iostream>
 #include <numeric>
+#include <climits>
+#include <map>
 #include <fstream>
 #include "clockwork/util.h"
 #include "clockwork/telemetry.h"
@@ -23,6 +25,10 @@
 #include <tuple>
 #include "clockwork/api/worker_api.h"
 #include "clockwork/thread.h"
+#include "clockwork/telemetry/columnar.h"
+#include "clockwork/telemetry/telemetry_ring.h"
+#include "clockwork/telemetry/histogram.h"
+#include "clockwork/telemetry/sampling.h"
 #include <fstream>
 
 
@@ -62,6 +68,7 @@ struct ControllerActionTelemetry {
 	// Set manually
 	unsigned requests_queued = 0;
 	unsigned copies_loaded = 0;
+	uint64_t sample_hash = 0; // smallest sampling hash of the action's requests; 0 if unknown
 
 	void set(std::shared_ptr<workerapi::Infer> &infer);
 	void set(std::shared_ptr<workerapi::LoadWeights> &load);
@@ -100,12 +107,41 @@ public:
 	void shutdown(bool awaitCompletion);
 };
 
+// Writes the same columns as the TSV logger, in the columnar format
+class ControllerActionTelemetryColumnarLogger : public ControllerActionTelemetryLogger {
+private:
+	columnar::Writer f;
+
+public:
+	ControllerActionTelemetryColumnarLogger(std::string filename);
+
+	void log(ControllerActionTelemetry &t);
+	void shutdown(bool awaitCompletion);
+};
+
+// Passes actions of sampled requests on to another logger, along with every error, load,
+// eviction, and action whose requests missed their SLOs
+class SampledControllerActionTelemetryLogger : public ControllerActionTelemetryLogger {
+private:
+	ControllerActionTelemetryLogger* logger;
+	sampling::Sampler &sampler;
+
+public:
+	SampledControllerActionTelemetryLogger(ControllerActionTelemetryLogger* logger, sampling::Sampler &sampler = sampling::actions());
+
+	static bool always_log(ControllerActionTelemetry &t);
+
+	void log(ControllerActionTelemetry &t);
+	void shutdown(bool awaitCompletion);
+};
+
 class AsyncControllerActionTelemetryLogger : public ControllerActionTelemetryLogger {
 private:
 	std::atomic_bool alive = true;
 	std::thread thread;
-	tbb::concurrent_queue<ControllerActionTelemetry> queue;
+	TelemetryRings<ControllerActionTelemetry> rings; // one per scheduler thread
 	std::vector<ControllerActionTelemetryLogger*> loggers;
+	uint64_t dropped_reported = 0;
 
 public:
 	AsyncControllerActionTelemetryLogger();
@@ -124,7 +160,6 @@ class ActionPrinter : public ControllerActionTelemetryLogger {
 private:
 	uint64_t last_print;
 	const uint64_t print_interval;
-	std::queue<ControllerActionTelemetry> buffered;
 
 public:
 	ActionPrinter(uint64_t print_interval);
@@ -132,20 +167,40 @@ public:
 	void log(ControllerActionTelemetry &telemetry);
 	void shutdown(bool awaitCompletion);
 
-	virtual void print(uint64_t interval, std::queue<ControllerActionTelemetry> &buffered) = 0;
+	// Summarizes telemetry in constant memory until the next print
+	virtual void record(ControllerActionTelemetry &telemetry) = 0;
+	virtual void print(uint64_t interval) = 0;
 };
 
 class SimpleActionPrinter : public ActionPrinter {
 public:
+	typedef std::tuple<int,int,int> Group; // worker, GPU and action type
+
+	// Successful actions of a group in the current interval
+	struct Summary {
+		Histogram duration; // worker exec duration
+		Histogram e2e; // from action sent to result received
+		uint64_t normalized_sum = 0; // worker exec duration scaled to the base GPU clock
+		uint64_t normalized_max = 0;
+		unsigned clock_min = UINT_MAX;
+		unsigned clock_max = 0;
+		double useful_duration = 0; // worker exec duration weighted by goodput
+
+		void record(ControllerActionTelemetry &t);
+		void reset();
+	};
 
-	SimpleActionPrinter(uint64_t print_interval);
+private:
+	std::map<Group, Summary> groups;
 
-	typedef std::tuple<int,int,int> Group;
+public:
 
-	void print(uint64_t interval, const Group &group, std::queue<ControllerActionTelemetry> &buffered);
-	void print(uint64_t interval, std::queue<ControllerActionTelemetry> &buffered);
-};
+	SimpleActionPrinter(uint64_t print_interval);
 
+	void record(ControllerActionTelemetry &telemetry);
+	void print(uint64_t interval, const Group &group, Summary &summary);
+	void print(uint64_t interval);
+};
 
 }
 
@@ -22,6 +22,11 @@
 #include "clockwork/api/client_api.h"
 #include <iostream>
 #include "clockwork/thread.h"
+#include "clockwork/telemetry/columnar.h"
+#include "clockwork/telemetry/telemetry_ring.h"
+#include "clockwork/telemetry/histogram.h"
+#include "clockwork/telemetry/metrics.h"
+#include "clockwork/telemetry/sampling.h"
 
 
 namespace clockwork {
@@ -38,6 +43,13 @@ struct ControllerRequestTelemetry {
 	int arrival_count;
 	int departure_count;
 	int result;
+	int cache_status; // 0 if executed; 1 if a result cache hit; 2 if it joined an identical request
+	size_t input_size;
+	size_t output_size;
+	uint64_t trace_id; // not logged
+
+	// Bytes not sent to or received from a worker because of the result cache
+	size_t bytes_saved() { return cache_status == 0 ? 0 : input_size + output_size; }
 
 	void set(clientapi::InferenceRequest &request);
 	void set(clientapi::InferenceResponse &response);
@@ -72,12 +84,40 @@ public:
 	void shutdown(bool awaitCompletion);
 };
 
+// Writes the same columns as the TSV logger, in the columnar format
+class RequestTelemetryColumnarLogger : public RequestTelemetryLogger {
+private:
+	columnar::Writer f;
+
+public:
+	RequestTelemetryColumnarLogger(std::string filename);
+
+	void log(ControllerRequestTelemetry &t);
+	void shutdown(bool awaitCompletion);
+};
+
+// Passes a sample of requests on to another logger, along with every error, SLO miss and cold start
+class SampledRequestTelemetryLogger : public RequestTelemetryLogger {
+private:
+	RequestTelemetryLogger* logger;
+	sampling::Sampler &sampler;
+
+public:
+	SampledRequestTelemetryLogger(RequestTelemetryLogger* logger, sampling::Sampler &sampler = sampling::requests());
+
+	static bool always_log(ControllerRequestTelemetry &t);
+
+	void log(ControllerRequestTelemetry &t);
+	void shutdown(bool awaitCompletion);
+};
+
 class AsyncRequestTelemetryLogger : public RequestTelemetryLogger {
 private:
 	std::atomic_bool alive = true;
 	std::thread thread;
-	tbb::concurrent_queue<ControllerRequestTelemetry> queue;
+	TelemetryRings<ControllerRequestTelemetry> rings; // one per thread completing requests
 	std::vector<RequestTelemetryLogger*> loggers;
+	uint64_t dropped_reported = 0;
 
 public:	
 
@@ -92,14 +132,31 @@ public:
 };
 
 class RequestTelemetryPrinter : public RequestTelemetryLogger {
+public:
+	// Requests completed in the current interval
+	struct Summary {
+		Histogram latency; // of successful requests
+		unsigned violations = 0;
+		unsigned deadlines_met = 0;
+		unsigned cached = 0;
+		uint64_t bytes_saved = 0;
+
+		void record(ControllerRequestTelemetry &t);
+		void merge(const Summary &other);
+		void reset();
+	};
+
+	const bool print_models; // also print a line per model
+
 private:
 	uint64_t last_print;
 	const uint64_t print_interval;
-	std::queue<ControllerRequestTelemetry> buffered;
+	std::map<int, Summary> models;
+	Summary total;
 
 public:
 
-	RequestTelemetryPrinter(uint64_t print_interval);
+	RequestTelemetryPrinter(uint64_t print_interval, bool print_models = false);
 
 	void print(uint64_t interval);
 	void log(ControllerRequestTelemetry &telemetry);
@@ -107,6 +164,30 @@ public:
 
 };
 
+// Running totals of completed requests, exported as live metrics
+class RequestMetrics : public RequestTelemetryLogger {
+private:
+	metrics::Registry &registry;
+	unsigned collector_id;
+
+	std::atomic_uint64_t requests;
+	std::atomic_uint64_t errors;
+	std::atomic_uint64_t deadlines_met;
+	std::atomic_uint64_t cached;
+	std::atomic_uint64_t bytes_saved;
+	Histogram latency; // of successful requests
+
+public:
+
+	RequestMetrics(metrics::Registry &registry = metrics::registry());
+	~RequestMetrics();
+
+	void log(ControllerRequestTelemetry &telemetry);
+	void shutdown(bool awaitCompletion);
+	void collect(metrics::Writer &writer);
+
+};
+
 }
 
 #endif
@@ -0,0 +1,147 @@
+#include "clockwork/telemetry/histogram.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+namespace clockwork {
+
+Histogram::Histogram() : count_(0), sum_(0), min_(UINT64_MAX), max_(0) {
+	for (auto &bucket : buckets) {
+		bucket.store(0, std::memory_order_relaxed);
+	}
+}
+
+unsigned Histogram::bucket_index(uint64_t value) {
+	if (value < (1UL << precision)) return value;
+
+	unsigned exponent = 63 - __builtin_clzl(value);
+	if (exponent >= max_exponent) return num_buckets - 1;
+
+	// The top precision+1 bits of value, ie. in [2^precision, 2^(precision+1))
+	uint64_t mantissa = value >> (exponent - precision);
+	return ((exponent - precision + 1) << precision) + (mantissa - (1UL << precision));
+}
+
+uint64_t Histogram::bucket_lowest(unsigned index) {
+	if (index < (1U << precision)) return index;
+
+	unsigned exponent = (index >> precision) + precision - 1;
+	uint64_t mantissa = (index & ((1U << precision) - 1)) + (1UL << precision);
+	return mantissa << (exponent - precision);
+}
+
+uint64_t Histogram::bucket_highest(unsigned index) {
+	if (index < (1U << precision)) return index;
+
+	unsigned exponent = (index >> precision) + precision - 1;
+	return bucket_lowest(index) + (1UL << (exponent - precision)) - 1;
+}
+
+void Histogram::record(uint64_t value, uint64_t count) {
+	if (count == 0) return;
+
+	buckets[bucket_index(value)].fetch_add(count, std::memory_order_relaxed);
+	count_.fetch_add(count, std::memory_order_relaxed);
+	sum_.fetch_add(value * count, std::memory_order_relaxed);
+
+	uint64_t current = min_.load(std::memory_order_relaxed);
+	while (value < current && !min_.compare_exchange_weak(current, value, std::memory_order_relaxed));
+
+	current = max_.load(std::memory_order_relaxed);
+	while (value > current && !max_.compare_exchange_weak(current, value, std::memory_order_relaxed));
+}
+
+void Histogram::merge(const Histogram &other) {
+	for (unsigned i = 0; i < num_buckets; i++) {
+		uint64_t count = other.buckets[i].load(std::memory_order_relaxed);
+		if (count > 0) buckets[i].fetch_add(count, std::memory_order_relaxed);
+	}
+	count_.fetch_add(other.count(), std::memory_order_relaxed);
+	sum_.fetch_add(other.sum(), std::memory_order_relaxed);
+
+	uint64_t value = other.min_.load(std::memory_order_relaxed);
+	uint64_t current = min_.load(std::memory_order_relaxed);
+	while (value < current && !min_.compare_exchange_weak(current, value, std::memory_order_relaxed));
+
+	value = other.max();
+	current = max_.load(std::memory_order_relaxed);
+	while (value > current && !max_.compare_exchange_weak(current, value, std::memory_order_relaxed));
+}
+
+void Histogram::drain_into(Histogram &other) {
+	uint64_t total = 0;
+	for (unsigned i = 0; i < num_buckets; i++) {
+		if (buckets[i].load(std::memory_order_relaxed) == 0) continue;
+		uint64_t count = buckets[i].exchange(0, std::memory_order_relaxed);
+		other.buckets[i].fetch_add(count, std::memory_order_relaxed);
+		total += count;
+	}
+	other.count_.fetch_add(total, std::memory_order_relaxed);
+	count_.fetch_sub(total, std::memory_order_relaxed);
+
+	uint64_t sum = sum_.exchange(0, std::memory_order_relaxed);
+	other.sum_.fetch_add(sum, std::memory_order_relaxed);
+
+	uint64_t value = min_.exchange(UINT64_MAX, std::memory_order_relaxed);
+	uint64_t current = other.min_.load(std::memory_order_relaxed);
+	while (value < current && !other.min_.compare_exchange_weak(current, value, std::memory_order_relaxed));
+
+	value = max_.exchange(0, std::memory_order_relaxed);
+	current = other.max_.load(std::memory_order_relaxed);
+	while (value > current && !other.max_.compare_exchange_weak(current, value, std::memory_order_relaxed));
+}
+
+void Histogram::reset() {
+	for (auto &bucket : buckets) {
+		bucket.store(0, std::memory_order_relaxed);
+	}
+	count_.store(0, std::memory_order_relaxed);
+	sum_.store(0, std::memory_order_relaxed);
+	min_.store(UINT64_MAX, std::memory_order_relaxed);
+	max_.store(0, std::memory_order_relaxed);
+}
+
+uint64_t Histogram::min() const {
+	return count() == 0 ? 0 : min_.load(std::memory_order_relaxed);
+}
+
+double Histogram::mean() const {
+	uint64_t count = this->count();
+	return count == 0 ? 0 : sum() / static_cast<double>(count);
+}
+
+uint64_t Histogram::percentile(double p) const {
+	uint64_t count = this->count();
+	if (count == 0) return 0;
+
+	uint64_t rank = std::max<uint64_t>(1, std::ceil(count * std::min(p, 100.0) / 100.0));
+	uint64_t seen = 0;
+	for (unsigned i = 0; i < num_buckets; i++) {
+		seen += buckets[i].load(std::memory_order_relaxed);
+		if (seen >= rank) {
+			return std::max(min(), std::min(max(), bucket_highest(i)));
+		}
+	}
+	return max();
+}
+
+uint64_t Histogram::count_at_or_below(uint64_t value) const {
+	unsigned last = bucket_index(value);
+	uint64_t count = 0;
+	for (unsigned i = 0; i <= last; i++) {
+		count += buckets[i].load(std::memory_order_relaxed);
+	}
+	return count;
+}
+
+std::string Histogram::percentiles_str() const {
+	std::stringstream s;
+	s << std::fixed << std::setprecision(1);
+	s << "p50=" << (percentile(50) / 1000000.0)
+	  << " p99=" << (percentile(99) / 1000000.0)
+	  << " p99.9=" << (percentile(99.9) / 1000000.0);
+	return s.str();
+}
+
+}
@@ -0,0 +1,68 @@
+#ifndef _CLOCKWORK_TELEMETRY_HISTOGRAM_H_
+#define _CLOCKWORK_TELEMETRY_HISTOGRAM_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace clockwork {
+
+/*
+A log-bucketed (HDR) histogram of non-negative integer values, typically latencies in
+nanoseconds.  Values below 2^precision are counted exactly; larger values fall into one of
+2^precision buckets per power of two, so a reported percentile is within 1/2^precision of
+the true value.  Values of 2^max_exponent or more are counted as the largest value.
+
+Memory use is fixed.  record may be called concurrently from any thread; the remaining
+methods are approximate while recording is in progress.
+*/
+class Histogram {
+public:
+	static const unsigned precision = 6;
+	static const unsigned max_exponent = 41; // ~36 minutes in nanoseconds
+	static const unsigned num_buckets = (max_exponent - precision + 1) << precision;
+
+private:
+	std::array<std::atomic_uint64_t, num_buckets> buckets;
+	std::atomic_uint64_t count_;
+	std::atomic_uint64_t sum_;
+	std::atomic_uint64_t min_;
+	std::atomic_uint64_t max_;
+
+public:
+	Histogram();
+
+	void record(uint64_t value, uint64_t count = 1);
+
+	// Adds other's values to this histogram
+	void merge(const Histogram &other);
+
+	// Moves this histogram's values into other, leaving this histogram empty
+	void drain_into(Histogram &other);
+
+	void reset();
+
+	uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+	uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+	uint64_t min() const;
+	uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+	double mean() const;
+
+	// The value at percentile p, where 0 <= p <= 100; 0 if empty
+	uint64_t percentile(double p) const;
+
+	// The number of values at most value, to within the bucket containing value
+	uint64_t count_at_or_below(uint64_t value) const;
+
+	// eg. "p50=1.2 p99=3.4 p99.9=5.6", in milliseconds
+	std::string percentiles_str() const;
+
+	static unsigned bucket_index(uint64_t value);
+	static uint64_t bucket_lowest(unsigned index);
+	static uint64_t bucket_highest(unsigned index);
+};
+
+}
+
+#endif
@@ -0,0 +1,69 @@
+#include "clockwork/telemetry/inflater.h"
+#include <charconv>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <dmlc/logging.h>
+
+namespace clockwork {
+namespace inflater {
+
+void RowFormatter::add(uint64_t value) {
+	separate();
+	char buf[24];
+	auto result = std::to_chars(buf, buf + sizeof(buf), value);
+	out.append(buf, result.ptr);
+}
+
+void RowFormatter::add(int64_t value) {
+	separate();
+	char buf[24];
+	auto result = std::to_chars(buf, buf + sizeof(buf), value);
+	out.append(buf, result.ptr);
+}
+
+void RowFormatter::add(double value) {
+	// Matches std::ostream's default formatting
+	separate();
+	char buf[32];
+	int length = snprintf(buf, sizeof(buf), "%g", value);
+	out.append(buf, length);
+}
+
+void RowFormatter::add(const std::string &value) {
+	separate();
+	out.append(value);
+}
+
+void RowFormatter::skip() {
+	separate();
+}
+
+void RowFormatter::end_row() {
+	out.push_back('\n');
+	first = true;
+}
+
+MappedFile::MappedFile(std::string filename) {
+	fd = open(filename.c_str(), O_RDONLY);
+	CHECK(fd >= 0) << "Unable to open " << filename;
+
+	struct stat st;
+	CHECK(fstat(fd, &st) == 0) << "Unable to stat " << filename;
+	size = st.st_size;
+	if (size == 0) return;
+
+	void* m = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	CHECK(m != MAP_FAILED) << "Unable to mmap " << filename;
+	data = static_cast<const char*>(m);
+	madvise(m, size, MADV_SEQUENTIAL);
+}
+
+MappedFile::~MappedFile() {
+	if (data != nullptr) munmap(const_cast<char*>(data), size);
+	if (fd >= 0) close(fd);
+}
+
+}
+}
@@ -0,0 +1,119 @@
+#ifndef _CLOCKWORK_TELEMETRY_INFLATER_H_
+#define _CLOCKWORK_TELEMETRY_INFLATER_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <future>
+#include <string>
+
+namespace clockwork {
+
+/*
+Building blocks for converting telemetry logs to TSV in bounded memory.
+
+Logs are read a chunk at a time, chunks are formatted in parallel, and the formatted chunks
+are written in order.  Only a few chunks are held in memory at once, regardless of the size
+of the log.
+*/
+namespace inflater {
+
+// Appends tab-separated fields to a string, without intermediate strings
+class RowFormatter {
+private:
+	std::string &out;
+	bool first = true;
+
+public:
+	RowFormatter(std::string &out) : out(out) {}
+
+	void add(uint64_t value);
+	void add(int64_t value);
+	void add(int value) { add(static_cast<int64_t>(value)); }
+	void add(unsigned value) { add(static_cast<uint64_t>(value)); }
+	void add(double value);
+	void add(const std::string &value);
+	void skip(); // an empty field
+	void end_row();
+
+private:
+	void separate() {
+		if (!first) out.push_back('\t');
+		first = false;
+	}
+};
+
+// Rows to keep; a row is kept if it matches every criterion that is set
+struct Filter {
+	uint64_t from = 0; // nanoseconds, inclusive
+	uint64_t to = UINT64_MAX; // nanoseconds, exclusive
+	int model_id = -1; // -1 for any model
+	int action_type = -1; // -1 for any action type
+
+	bool by_time() const { return from != 0 || to != UINT64_MAX; }
+	bool by_model() const { return model_id != -1; }
+	bool by_action_type() const { return action_type != -1; }
+
+	bool time_matches(uint64_t t) const { return t >= from && t < to; }
+	bool model_matches(int model_id) const { return this->model_id == -1 || this->model_id == model_id; }
+	bool action_type_matches(int action_type) const { return this->action_type == -1 || this->action_type == action_type; }
+};
+
+// A read-only mapping of a whole file
+class MappedFile {
+public:
+	const char* data = nullptr;
+	size_t size = 0;
+
+private:
+	int fd = -1;
+
+public:
+	MappedFile(std::string filename);
+	~MappedFile();
+};
+
+/*
+Formats chunks on up to num_threads threads and writes them to out in order.  next fills in
+the next chunk, returning false when there are no more; format appends a chunk's rows.
+Returns the number of chunks.
+*/
+template <typename Chunk>
+uint64_t format_parallel(std::function<bool(Chunk&)> next,
+		std::function<void(Chunk&, std::string&)> format,
+		FILE* out, unsigned num_threads) {
+	std::deque<std::future<std::string>> pending;
+	auto write_oldest = [&pending, out] {
+		std::string formatted = pending.front().get();
+		fwrite(formatted.data(), 1, formatted.size(), out);
+		pending.pop_front();
+	};
+
+	uint64_t chunks = 0;
+	while (true) {
+		Chunk chunk;
+		if (!next(chunk)) break;
+		chunks++;
+
+		pending.push_back(std::async(std::launch::async, [&format] (Chunk chunk) {
+			std::string formatted;
+			format(chunk, formatted);
+			return formatted;
+		}, std::move(chunk)));
+
+		if (pending.size() >= num_threads) {
+			write_oldest();
+		}
+	}
+
+	while (!pending.empty()) {
+		write_oldest();
+	}
+	return chunks;
+}
+
+}
+}
+
+#endif
@@ -0,0 +1,113 @@
+#include "clockwork/telemetry/metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace clockwork {
+namespace metrics {
+
+// Upper bounds of exported histogram buckets, in seconds
+static const std::vector<double> histogram_bounds = {
+	0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10
+};
+
+static std::string escape(const std::string &value) {
+	std::string escaped;
+	for (char c : value) {
+		switch (c) {
+			case '\\': escaped += "\\\\"; break;
+			case '"': escaped += "\\\""; break;
+			case '\n': escaped += "\\n"; break;
+			default: escaped += c;
+		}
+	}
+	return escaped;
+}
+
+Writer::Writer(std::ostream &out) : out(out) {}
+
+void Writer::describe(const std::string &name, const std::string &help, const char* type) {
+	if (!described.insert(name).second) return;
+	out << "# HELP " << name << " " << help << "\n";
+	out << "# TYPE " << name << " " << type << "\n";
+}
+
+void Writer::sample(const std::string &name, double value, const Labels &labels, const std::string &le) {
+	out << name;
+	if (!labels.empty() || !le.empty()) {
+		out << "{";
+		bool first = true;
+		for (auto &label : labels) {
+			out << (first ? "" : ",") << label.first << "=\"" << escape(label.second) << "\"";
+			first = false;
+		}
+		if (!le.empty()) {
+			out << (first ? "" : ",") << "le=\"" << le << "\"";
+		}
+		out << "}";
+	}
+	out << " ";
+	if (std::isinf(value)) {
+		out << (value > 0 ? "+Inf" : "-Inf");
+	} else {
+		out << value;
+	}
+	out << "\n";
+}
+
+void Writer::counter(std::string name, std::string help, double value, const Labels &labels) {
+	describe(name, help, "counter");
+	sample(name, value, labels);
+}
+
+void Writer::gauge(std::string name, std::string help, double value, const Labels &labels) {
+	describe(name, help, "gauge");
+	sample(name, value, labels);
+}
+
+void Writer::histogram(std::string name, std::string help, const Histogram &histogram, const Labels &labels) {
+	describe(name, help, "histogram");
+
+	// Read the count first, so that buckets are never more than the total
+	uint64_t count = histogram.count();
+	for (double bound : histogram_bounds) {
+		uint64_t below = histogram.count_at_or_below(std::llround(bound * 1000000000.0));
+		std::stringstream le;
+		le << bound;
+		sample(name + "_bucket", std::min(below, count), labels, le.str());
+	}
+	sample(name + "_bucket", count, labels, "+Inf");
+	sample(name + "_sum", histogram.sum() / 1000000000.0, labels);
+	sample(name + "_count", count, labels);
+}
+
+unsigned Registry::add(Collector collector) {
+	std::lock_guard<std::mutex> lock(mutex);
+	unsigned id = next_id++;
+	collectors[id] = collector;
+	return id;
+}
+
+void Registry::remove(unsigned id) {
+	std::lock_guard<std::mutex> lock(mutex);
+	collectors.erase(id);
+}
+
+std::string Registry::scrape() {
+	std::stringstream out;
+	Writer writer(out);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	for (auto &p : collectors) {
+		p.second(writer);
+	}
+	return out.str();
+}
+
+Registry &registry() {
+	static Registry registry;
+	return registry;
+}
+
+}
+}
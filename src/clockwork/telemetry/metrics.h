@@ -0,0 +1,70 @@
+#ifndef _CLOCKWORK_TELEMETRY_METRICS_H_
+#define _CLOCKWORK_TELEMETRY_METRICS_H_
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+#include "clockwork/telemetry/histogram.h"
+
+namespace clockwork {
+
+/*
+Live metrics, scraped in the Prometheus text exposition format.
+
+Components register a Collector that writes their current values when scraped.  Collectors
+run on the scraping thread, so they must only read values that are safe to read
+concurrently (eg. atomics), and must never take locks on the scheduling or execution path.
+*/
+namespace metrics {
+
+typedef std::vector<std::pair<std::string, std::string>> Labels;
+
+class Writer {
+private:
+	std::ostream &out;
+	std::set<std::string> described;
+
+public:
+	Writer(std::ostream &out);
+
+	void counter(std::string name, std::string help, double value, const Labels &labels = {});
+	void gauge(std::string name, std::string help, double value, const Labels &labels = {});
+
+	// Exports a histogram of nanosecond values as seconds, with fixed bucket boundaries
+	void histogram(std::string name, std::string help, const Histogram &histogram, const Labels &labels = {});
+
+private:
+	void describe(const std::string &name, const std::string &help, const char* type);
+	void sample(const std::string &name, double value, const Labels &labels,
+		const std::string &le = "");
+};
+
+typedef std::function<void(Writer&)> Collector;
+
+class Registry {
+private:
+	std::mutex mutex;
+	unsigned next_id = 0;
+	std::map<unsigned, Collector> collectors;
+
+public:
+	// Returns an id that can be passed to remove
+	unsigned add(Collector collector);
+	void remove(unsigned id);
+
+	std::string scrape();
+};
+
+// The process-wide registry
+Registry &registry();
+
+}
+}
+
+#endif
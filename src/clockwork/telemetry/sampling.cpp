@@ -0,0 +1,59 @@
+#include "clockwork/telemetry/sampling.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include "clockwork/util.h"
+
+namespace clockwork {
+namespace sampling {
+
+Sampler::Sampler(std::string name, double rate) : name(name), threshold(UINT64_MAX) {
+	set_rate(rate);
+}
+
+void Sampler::set_rate(double rate) {
+	// NaN is treated as 0
+	rate = std::isnan(rate) ? 0 : std::min(1.0, std::max(0.0, rate));
+	if (rate >= 1.0) {
+		threshold = UINT64_MAX;
+	} else {
+		threshold = static_cast<uint64_t>(std::ldexp(rate, 64));
+	}
+}
+
+double Sampler::rate() const {
+	uint64_t t = threshold.load();
+	if (t == UINT64_MAX) return 1.0;
+	return std::ldexp(static_cast<double>(t), -64);
+}
+
+Sampler &requests() {
+	static Sampler sampler("requests", util::get_request_log_sample_rate());
+	return sampler;
+}
+
+Sampler &actions() {
+	static Sampler sampler("actions", util::get_action_log_sample_rate());
+	return sampler;
+}
+
+bool set_rate(std::string stream, double rate) {
+	for (Sampler* sampler : {&requests(), &actions()}) {
+		if (sampler->name == stream) {
+			sampler->set_rate(rate);
+			return true;
+		}
+	}
+	return false;
+}
+
+std::string rates_str() {
+	std::stringstream ss;
+	for (Sampler* sampler : {&requests(), &actions()}) {
+		ss << sampler->name << " " << sampler->rate() << "\n";
+	}
+	return ss.str();
+}
+
+}
+}
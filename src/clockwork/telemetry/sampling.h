@@ -0,0 +1,71 @@
+#ifndef _CLOCKWORK_TELEMETRY_SAMPLING_H_
+#define _CLOCKWORK_TELEMETRY_SAMPLING_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace clockwork {
+
+/*
+Deterministic sampling of the controller's request and action logs.
+
+A request is sampled if the hash of its user id and request id falls below the stream's
+sample rate.  An action is sampled if any of its requests would be, ie. if the smallest hash
+of its requests falls below the rate.  So long as the action log's rate is at least the
+request log's, every logged request's actions are logged too, and the logs can be joined.
+
+Sampling only applies to the log files; printed summaries and live metrics see every event.
+Rates can be changed at any time.
+*/
+namespace sampling {
+
+// A well-mixed 64-bit hash (the splitmix64 finalizer)
+inline uint64_t hash(uint64_t key) {
+	key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9UL;
+	key = (key ^ (key >> 27)) * 0x94d049bb133111ebUL;
+	return key ^ (key >> 31);
+}
+
+// The sampling key of a request, the same at every component that sees it
+inline uint64_t request_key(int user_id, int user_request_id) {
+	return (static_cast<uint64_t>(static_cast<uint32_t>(user_id)) << 32) |
+		static_cast<uint32_t>(user_request_id);
+}
+
+class Sampler {
+public:
+	const std::string name;
+
+private:
+	std::atomic_uint64_t threshold; // hashes below the threshold are sampled; UINT64_MAX for all
+
+public:
+	Sampler(std::string name, double rate = 1.0);
+
+	// rate is clamped to [0, 1]
+	void set_rate(double rate);
+	double rate() const;
+
+	bool sampled_hash(uint64_t hash) const {
+		uint64_t t = threshold.load(std::memory_order_relaxed);
+		return t == UINT64_MAX || hash < t;
+	}
+	bool sampled(uint64_t key) const { return sampled_hash(sampling::hash(key)); }
+};
+
+// Sample rates of the controller's request and action logs; initially 1, unless
+// CLOCKWORK_REQUEST_LOG_SAMPLE_RATE or CLOCKWORK_ACTION_LOG_SAMPLE_RATE is set
+Sampler &requests();
+Sampler &actions();
+
+// Sets the rate of the named stream ("requests" or "actions"); returns false if there's no such stream
+bool set_rate(std::string stream, double rate);
+
+// One "name rate" line per stream
+std::string rates_str();
+
+}
+}
+
+#endif
@@ -16,30 +16,34 @@
 #include <pods/buffers.h>
 #include <pods/streams.h>
 #include "clockwork/thread.h"
+#include "clockwork/telemetry/columnar.h"
+#include "clockwork/telemetry/telemetry_ring.h"
 
 
 namespace clockwork {
 
 class TaskTelemetryLogger {
 public:
-	virtual void log(std::shared_ptr<TaskTelemetry> telemetry) = 0;
+	virtual void log(TaskTelemetry &telemetry) = 0;
 	virtual void log(RequestTelemetry* telemetry) = 0;
 	virtual void shutdown(bool awaitCompletion) = 0;
 };
 
 class TaskTelemetryDummyLogger : public TaskTelemetryLogger {
-	void log(std::shared_ptr<TaskTelemetry> telemetry){}
+	void log(TaskTelemetry &telemetry){}
  	void log(RequestTelemetry* telemetry) {}
 	void shutdown(bool awaitCompletion) {}
 };
 
 class TaskTelemetryFileLogger : public TaskTelemetryLogger {
 private:
+	static const uint64_t flush_interval = 5000000000UL; // how often a partial columnar chunk is written out
 	const std::string output_filename;
 	std::atomic_bool alive;
 	std::thread thread;
-	tbb::concurrent_queue<std::shared_ptr<TaskTelemetry>> task_queue;
+	TelemetryRings<TaskTelemetry> task_rings; // one per executor thread
 	tbb::concurrent_queue<RequestTelemetry*> request_queue;
+	uint64_t dropped_reported = 0;
 
 public:	
 	TaskTelemetryFileLogger(std::string output_filename) : output_filename(output_filename), alive(true) {
@@ -54,31 +58,44 @@ public:
 		}
 	}
 
-	void log(std::shared_ptr<TaskTelemetry> telemetry) {
-		task_queue.push(telemetry);
+	void log(TaskTelemetry &telemetry) {
+		task_rings.log(telemetry);
 	}
 
 	void log(RequestTelemetry* telemetry) {
 		request_queue.push(telemetry);
 	}
 
+	uint64_t dropped() {
+		return task_rings.dropped();
+	}
 
-	void convert(std::shared_ptr<TaskTelemetry> telemetry, SerializedTaskTelemetry *converted) {
-		converted->action_type = telemetry->action_type;
-		converted->task_type = telemetry->task_type;
-		converted->executor_id = telemetry->executor_id;
-		converted->gpu_id = telemetry->gpu_id;
-		converted->model_id = telemetry->model_id;
-		converted->batch_size = telemetry->batch_size;
-		converted->status = telemetry->status;
-		converted->action_id = telemetry->action_id;
-		converted->enqueued = util::nanos(telemetry->enqueued);
-		converted->eligible_for_dequeue = telemetry->eligible_for_dequeue;
-		converted->dequeued = util::nanos(telemetry->dequeued);
-		converted->exec_complete = util::nanos(telemetry->exec_complete);
-		converted->async_complete = util::nanos(telemetry->async_complete);
-		converted->async_wait = telemetry->async_wait * 1000000;
-		converted->async_duration = telemetry->async_duration * 1000000;
+	// Prints records dropped since the last call; only called from the logger thread
+	void report_dropped() {
+		uint64_t total = dropped();
+		if (total > dropped_reported) {
+			std::cout << "Dropped " << (total - dropped_reported) << " task telemetry records" << std::endl;
+			dropped_reported = total;
+		}
+	}
+
+
+	void convert(const TaskTelemetry &telemetry, SerializedTaskTelemetry *converted) {
+		converted->action_type = telemetry.action_type;
+		converted->task_type = telemetry.task_type;
+		converted->executor_id = telemetry.executor_id;
+		converted->gpu_id = telemetry.gpu_id;
+		converted->model_id = telemetry.model_id;
+		converted->batch_size = telemetry.batch_size;
+		converted->status = telemetry.status;
+		converted->action_id = telemetry.action_id;
+		converted->enqueued = util::nanos(telemetry.enqueued);
+		converted->eligible_for_dequeue = telemetry.eligible_for_dequeue;
+		converted->dequeued = util::nanos(telemetry.dequeued);
+		converted->exec_complete = util::nanos(telemetry.exec_complete);
+		converted->async_complete = util::nanos(telemetry.async_complete);
+		converted->async_wait = telemetry.async_wait * 1000000;
+		converted->async_duration = telemetry.async_duration * 1000000;
 	}
 
 	void convert(TaskTelemetry* telemetry, SerializedTaskTelemetry *converted) {
@@ -111,47 +128,97 @@ public:
 
 
 	void main() {
+		if (columnar::has_extension(output_filename)) {
+			main_columnar();
+			return;
+		}
+
 		std::ofstream outfile;
 		outfile.open(output_filename);
 	    pods::OutputStream out(outfile);
 	    pods::BinarySerializer<decltype(out)> serializer(out);
 
-		while (alive) {
-			std::shared_ptr<TaskTelemetry> srcTelemetry;
-			if (!task_queue.try_pop(srcTelemetry)) {
-				usleep(10000);
-				continue;
-			}
-
+		auto save = [this, &serializer] (TaskTelemetry &srcTelemetry) {
 			SerializedTaskTelemetry telemetry;
 			convert(srcTelemetry, &telemetry);
-			
-			//TODO: delete srcTelemetry;
 			CHECK(serializer.save(telemetry) == pods::Error::NoError) << "Unable to serialize task telemetry";
-		
-			// std::stringstream msg;
-			// msg << "Logging request " << telemetry.request_id 
-			//     << " model=" << telemetry.model_id
-			//     << " latency=" << (telemetry.complete - telemetry.submitted)
-			//     << " totallatency=" << (telemetry.complete - telemetry.arrived)
-			//     << std::endl;
-			// for (int i = 0; i < telemetry.tasks.size(); i++) {
-			// 	msg << "   Task " << i << std::endl
-			// 	    << "     queue=" << (telemetry.tasks[i].dequeued - telemetry.tasks[i].enqueued) << std::endl
-			// 	    << "     exec="  << (telemetry.tasks[i].exec_complete - telemetry.tasks[i].dequeued) << std::endl
-			// 	    << "     async_wait=" << telemetry.tasks[i].async_wait << std::endl
-			// 	    << "     async_duration=" << telemetry.tasks[i].async_duration << std::endl;
-			// }
-			// std::cout << msg.str();
+		};
+
+		while (alive) {
+			task_rings.drain(save);
+			report_dropped();
+			usleep(10000);
 		}
+		task_rings.drain(save);
+		report_dropped();
 		outfile.close();
 	}
 
+	// Writes the columns `./inflate task` would, less the derived latencies
+	void main_columnar() {
+		columnar::Writer writer(output_filename, {
+			{"action_id", columnar::i32},
+			{"action_type", columnar::i32},
+			{"task_type", columnar::i32},
+			{"executor_id", columnar::i32},
+			{"gpu_id", columnar::i32},
+			{"status", columnar::i32},
+			{"model_id", columnar::i32},
+			{"batch_size", columnar::i32},
+			{"enqueued", columnar::timestamp},
+			{"eligible_for_dequeue", columnar::timestamp},
+			{"dequeued", columnar::timestamp},
+			{"exec_complete", columnar::timestamp},
+			{"async_complete", columnar::timestamp},
+			{"async_wait", columnar::i64},
+			{"async_duration", columnar::i64}
+		});
+
+		auto save = [this, &writer] (TaskTelemetry &srcTelemetry) {
+			SerializedTaskTelemetry t;
+			convert(srcTelemetry, &t);
+
+			writer.set_int(0, t.action_id);
+			writer.set_int(1, t.action_type);
+			writer.set_int(2, t.task_type);
+			writer.set_int(3, t.executor_id);
+			writer.set_int(4, t.gpu_id);
+			writer.set_int(5, t.status);
+			writer.set_int(6, t.model_id);
+			writer.set_int(7, t.batch_size);
+			writer.set_int(8, t.enqueued);
+			writer.set_int(9, t.eligible_for_dequeue);
+			writer.set_int(10, t.dequeued);
+			writer.set_int(11, t.exec_complete);
+			writer.set_int(12, t.async_complete);
+			writer.set_int(13, t.async_wait);
+			writer.set_int(14, t.async_duration);
+			writer.end_row();
+		};
+
+		uint64_t next_flush = util::now() + flush_interval;
+		while (alive) {
+			task_rings.drain(save);
+			report_dropped();
+
+			// Write out a partial chunk so the file keeps up with a slow trickle of rows
+			uint64_t now = util::now();
+			if (now >= next_flush) {
+				writer.flush();
+				next_flush = now + flush_interval;
+			}
+			usleep(10000);
+		}
+		task_rings.drain(save);
+		report_dropped();
+		writer.close();
+	}
+
 };
 
 class InMemoryTelemetryBuffer : public TaskTelemetryLogger {
 public:
-	tbb::concurrent_queue<std::shared_ptr<TaskTelemetry>> task_queue;
+	tbb::concurrent_queue<TaskTelemetry> task_queue;
 	tbb::concurrent_queue<RequestTelemetry*> request_queue;
 
 public:	
@@ -159,7 +226,7 @@ public:
 
 	void shutdown(bool awaitCompletion) {}
 
-	void log(std::shared_ptr<TaskTelemetry> telemetry) {
+	void log(TaskTelemetry &telemetry) {
 		task_queue.push(telemetry);
 	}
 
@@ -167,9 +234,9 @@ public:
 		request_queue.push(telemetry);
 	}
 
-	std::vector<std::shared_ptr<TaskTelemetry>> take_task() {
-		std::vector<std::shared_ptr<TaskTelemetry>> telemetry;
-		std::shared_ptr<TaskTelemetry> next;
+	std::vector<TaskTelemetry> take_task() {
+		std::vector<TaskTelemetry> telemetry;
+		TaskTelemetry next;
 		while (task_queue.try_pop(next)) {
 			telemetry.push_back(next);
 		}
@@ -3,6 +3,20 @@
 
 namespace clockwork {
 
+// The deadline relative to arrival time, -1 if there was none
+void relative_deadline(ControllerRequestTelemetry &t, int64_t &deadline, bool &deadline_met) {
+	if (t.deadline == 0) {
+		deadline = -1;
+		deadline_met = t.result == clockworkSuccess;
+	} else if (t.deadline < t.arrival) {
+		deadline = 0;
+		deadline_met = false;
+	} else {
+		deadline = t.deadline - t.arrival;
+		deadline_met = t.result == clockworkSuccess && t.departure <= t.deadline;
+	}
+}
+
 RequestTelemetryFileLogger::RequestTelemetryFileLogger(std::string filename) : f(filename) {
 	write_headers();
 }
@@ -19,7 +33,9 @@ void RequestTelemetryFileLogger::write_headers() {
 	f << "deadline_met" <<"\t";
 	f << "arrival_count" <<"\t";
 	f << "departure_count" << "\t";
-	f << "is_coldstart" << "\n";
+	f << "is_coldstart" << "\t";
+	f << "cache_status" << "\t";
+	f << "bytes_saved" << "\n";
 }
 
 void RequestTelemetryFileLogger::log(ControllerRequestTelemetry &t) {
@@ -33,27 +49,85 @@ void RequestTelemetryFileLogger::log(ControllerRequestTelemetry &t) {
 
 	int64_t deadline;
 	bool deadline_met;
-	if (t.deadline == 0) {
-		deadline = -1;
-		deadline_met = t.result == clockworkSuccess;
-	} else if (t.deadline < t.arrival) {
-		deadline = 0;
-		deadline_met = false;
-	} else {
-		deadline = t.deadline - t.arrival; // Print the deadline relative to arrival time
-		deadline_met = t.result == clockworkSuccess && t.departure <= t.deadline;
-	}
+	relative_deadline(t, deadline, deadline_met);
 	f << deadline << "\t";
 	f << deadline_met << "\t";
 	f << t.arrival_count << "\t";
 	f << t.departure_count << "\t";
-	f << (t.departure_count > t.arrival_count && t.arrival_count == 0) << "\n";
+	f << (t.departure_count > t.arrival_count && t.arrival_count == 0) << "\t";
+	f << t.cache_status << "\t";
+	f << t.bytes_saved() << "\n";
 }
 
 void RequestTelemetryFileLogger::shutdown(bool awaitCompletion) {
 	f.close();
 }
 
+RequestTelemetryColumnarLogger::RequestTelemetryColumnarLogger(std::string filename) : f(filename, {
+		{"t", columnar::timestamp},
+		{"request_id", columnar::i32},
+		{"result", columnar::i32},
+		{"user_id", columnar::i32},
+		{"model_id", columnar::i32},
+		{"slo_factor", columnar::f32},
+		{"latency", columnar::i64},
+		{"deadline", columnar::i64},
+		{"deadline_met", columnar::i32},
+		{"arrival_count", columnar::i32},
+		{"departure_count", columnar::i32},
+		{"is_coldstart", columnar::i32},
+		{"cache_status", columnar::i32},
+		{"bytes_saved", columnar::i64}
+	}) {
+}
+
+void RequestTelemetryColumnarLogger::log(ControllerRequestTelemetry &t) {
+	int64_t deadline;
+	bool deadline_met;
+	relative_deadline(t, deadline, deadline_met);
+
+	f.set_int(0, t.departure);
+	f.set_int(1, t.request_id);
+	f.set_int(2, t.result);
+	f.set_int(3, t.user_id);
+	f.set_int(4, t.model_id);
+	f.set_float(5, t.slo_factor);
+	f.set_int(6, t.departure - t.arrival);
+	f.set_int(7, deadline);
+	f.set_int(8, deadline_met);
+	f.set_int(9, t.arrival_count);
+	f.set_int(10, t.departure_count);
+	f.set_int(11, t.departure_count > t.arrival_count && t.arrival_count == 0);
+	f.set_int(12, t.cache_status);
+	f.set_int(13, t.bytes_saved());
+	f.end_row();
+}
+
+void RequestTelemetryColumnarLogger::shutdown(bool awaitCompletion) {
+	f.close();
+}
+
+SampledRequestTelemetryLogger::SampledRequestTelemetryLogger(RequestTelemetryLogger* logger, sampling::Sampler &sampler) :
+	logger(logger), sampler(sampler) {}
+
+bool SampledRequestTelemetryLogger::always_log(ControllerRequestTelemetry &t) {
+	int64_t deadline;
+	bool deadline_met;
+	relative_deadline(t, deadline, deadline_met);
+	bool is_coldstart = t.departure_count > t.arrival_count && t.arrival_count == 0;
+	return t.result != clockworkSuccess || !deadline_met || is_coldstart;
+}
+
+void SampledRequestTelemetryLogger::log(ControllerRequestTelemetry &t) {
+	if (always_log(t) || sampler.sampled(sampling::request_key(t.user_id, t.request_id))) {
+		logger->log(t);
+	}
+}
+
+void SampledRequestTelemetryLogger::shutdown(bool awaitCompletion) {
+	logger->shutdown(awaitCompletion);
+}
+
 AsyncRequestTelemetryLogger::AsyncRequestTelemetryLogger() {}
 
 void AsyncRequestTelemetryLogger::addLogger(RequestTelemetryLogger* logger) {
@@ -66,12 +140,19 @@ void AsyncRequestTelemetryLogger::start() {
 }
 
 void AsyncRequestTelemetryLogger::run() {
+	auto log = [this] (ControllerRequestTelemetry &next) {
+		for (auto &logger : loggers) {
+			logger->log(next);
+		}
+	};
+
 	while (alive) {
-		ControllerRequestTelemetry next;
-		while (queue.try_pop(next)) {
-			for (auto &logger : loggers) {
-				logger->log(next);
-			}
+		rings.drain(log);
+
+		uint64_t dropped = rings.dropped();
+		if (dropped > dropped_reported) {
+			std::cout << "Dropped " << (dropped - dropped_reported) << " request telemetry records" << std::endl;
+			dropped_reported = dropped;
 		}
 
 		usleep(1000);
@@ -79,7 +160,7 @@ void AsyncRequestTelemetryLogger::run() {
 }
 
 void AsyncRequestTelemetryLogger::log(ControllerRequestTelemetry &telemetry) {
-	queue.push(telemetry);
+	rings.log(telemetry);
 }
 
 void AsyncRequestTelemetryLogger::shutdown(bool awaitCompletion) {
@@ -89,39 +170,48 @@ void AsyncRequestTelemetryLogger::shutdown(bool awaitCompletion) {
 	}
 }
 
-RequestTelemetryPrinter::RequestTelemetryPrinter(uint64_t print_interval) :
-	print_interval(print_interval) {}
+RequestTelemetryPrinter::RequestTelemetryPrinter(uint64_t print_interval, bool print_models) :
+	print_models(print_models), print_interval(print_interval) {}
 
-void RequestTelemetryPrinter::print(uint64_t interval) {
-	if (buffered.size() == 0) {
-		std::stringstream ss;
-		ss << "Client throughput=0" << std::endl;
-		std::cout << ss.str();
-		return;
+void RequestTelemetryPrinter::Summary::record(ControllerRequestTelemetry &t) {
+	if (t.cache_status != 0) {
+		cached++;
+		bytes_saved += t.bytes_saved();
 	}
 
-	uint64_t duration_sum = 0;
-	unsigned count = 0;
-	unsigned violations = 0;
-	uint64_t min_latency = UINT64_MAX;
-	uint64_t max_latency = 0;
-	while (buffered.size() > 0) {
-		ControllerRequestTelemetry &next = buffered.front();
-
-		if (next.result == clockworkSuccess) {
-			uint64_t latency = (next.departure - next.arrival);
-			duration_sum += latency;
-			count++;
-			min_latency = std::min(min_latency, latency);
-			max_latency = std::max(max_latency, latency);
-		} else {
-			violations++;
-		}
+	if (t.result == clockworkSuccess) {
+		latency.record(t.departure - t.arrival);
 
-		buffered.pop();
+		int64_t deadline;
+		bool deadline_met;
+		relative_deadline(t, deadline, deadline_met);
+		if (deadline_met) deadlines_met++;
+	} else {
+		violations++;
 	}
+}
+
+void RequestTelemetryPrinter::Summary::merge(const Summary &other) {
+	latency.merge(other.latency);
+	violations += other.violations;
+	deadlines_met += other.deadlines_met;
+	cached += other.cached;
+	bytes_saved += other.bytes_saved;
+}
 
+void RequestTelemetryPrinter::Summary::reset() {
+	latency.reset();
+	violations = 0;
+	deadlines_met = 0;
+	cached = 0;
+	bytes_saved = 0;
+}
+
+std::string summary_str(RequestTelemetryPrinter::Summary &summary, uint64_t interval) {
+	unsigned count = summary.latency.count();
+	unsigned violations = summary.violations;
 	double throughput = (1000000000.0 * count) / ((double) interval);
+	double goodput = (1000000000.0 * summary.deadlines_met) / ((double) interval);
 	double success_rate = 100;
 	if (count > 0 || violations > 0) {
 		success_rate = count / ((double) (count + violations));
@@ -130,23 +220,52 @@ void RequestTelemetryPrinter::print(uint64_t interval) {
 	std::stringstream ss;
 	ss << std::fixed;
 	if (count == 0) {
-		ss << "Client throughput=0 success=0% (" << violations << "/" << violations << " violations)";
+		ss << "throughput=0 success=0% (" << violations << "/" << violations << " violations)";
 	} else {
-		ss << "Client throughput=" << std::setprecision(1) << throughput;
+		ss << "throughput=" << std::setprecision(1) << throughput;
+		ss << " goodput=" << std::setprecision(1) << goodput;
 		ss << " success=" << std::setprecision(2) << (100*success_rate) << "%";
 		if (violations > 0) {
 			ss << " (" << violations << "/" << (count+violations) << " violations)";
 		}
-		ss << " min=" << std::setprecision(1) << (min_latency / 1000000.0);
-		ss << " max=" << std::setprecision(1) << (max_latency / 1000000.0);
-		ss << " mean=" << std::setprecision(1) << ((duration_sum/count) / 1000000.0);
+		ss << " min=" << std::setprecision(1) << (summary.latency.min() / 1000000.0);
+		ss << " max=" << std::setprecision(1) << (summary.latency.max() / 1000000.0);
+		ss << " mean=" << std::setprecision(1) << (summary.latency.mean() / 1000000.0);
+		ss << " " << summary.latency.percentiles_str();
+	}
+	if (summary.cached > 0) {
+		ss << " cache_hits=" << std::setprecision(2) << (100.0 * summary.cached / (count + violations)) << "%";
+		ss << " saved=" << std::setprecision(1) << (summary.bytes_saved / 1048576.0) << "MB";
+	}
+	return ss.str();
+}
+
+void RequestTelemetryPrinter::print(uint64_t interval) {
+	total.reset();
+	for (auto &p : models) {
+		total.merge(p.second);
+	}
+
+	if (total.latency.count() == 0 && total.violations == 0) {
+		std::stringstream ss;
+		ss << "Client throughput=0" << std::endl;
+		std::cout << ss.str();
+		return;
+	}
+
+	std::stringstream ss;
+	ss << "Client " << summary_str(total, interval) << std::endl;
+	for (auto &p : models) {
+		if (print_models && (p.second.latency.count() > 0 || p.second.violations > 0)) {
+			ss << "  Model " << p.first << " " << summary_str(p.second, interval) << std::endl;
+		}
+		p.second.reset();
 	}
-	ss << std::endl;
 	std::cout << ss.str();
 }
 
 void RequestTelemetryPrinter::log(ControllerRequestTelemetry &telemetry) {
-	buffered.push(telemetry);
+	models[telemetry.model_id].record(telemetry);
 
 	uint64_t now = util::now();
 	if (last_print + print_interval <= now) {
@@ -160,17 +279,68 @@ void RequestTelemetryPrinter::shutdown(bool awaitCompletion) {
 	std::cout << std::flush;
 }
 
+RequestMetrics::RequestMetrics(metrics::Registry &registry) :
+		registry(registry), requests(0), errors(0), deadlines_met(0), cached(0), bytes_saved(0) {
+	collector_id = registry.add([this] (metrics::Writer &writer) { collect(writer); });
+}
+
+RequestMetrics::~RequestMetrics() {
+	registry.remove(collector_id);
+}
+
+void RequestMetrics::log(ControllerRequestTelemetry &t) {
+	requests++;
+	if (t.cache_status != 0) {
+		cached++;
+		bytes_saved += t.bytes_saved();
+	}
+
+	if (t.result == clockworkSuccess) {
+		latency.record(t.departure - t.arrival);
+	} else {
+		errors++;
+	}
+
+	int64_t deadline;
+	bool deadline_met;
+	relative_deadline(t, deadline, deadline_met);
+	if (deadline_met) deadlines_met++;
+}
+
+void RequestMetrics::shutdown(bool awaitCompletion) {}
+
+void RequestMetrics::collect(metrics::Writer &writer) {
+	writer.counter("clockwork_requests_total",
+		"Inference requests completed", requests);
+	writer.counter("clockwork_request_errors_total",
+		"Inference requests that completed unsuccessfully", errors);
+	writer.counter("clockwork_request_deadlines_met_total",
+		"Inference requests that succeeded within their SLO", deadlines_met);
+	writer.counter("clockwork_request_cache_hits_total",
+		"Inference requests answered from the result cache", cached);
+	writer.counter("clockwork_request_cache_saved_bytes_total",
+		"Bytes not sent to workers because of the result cache", bytes_saved);
+	writer.histogram("clockwork_request_latency_seconds",
+		"Latency of successful inference requests", latency);
+}
+
 RequestTelemetryLogger* ControllerRequestTelemetry::summarize(uint64_t print_interval) {
 	auto result = new AsyncRequestTelemetryLogger();
 	result->addLogger(new RequestTelemetryPrinter(print_interval));
+	result->addLogger(new RequestMetrics());
 	result->start();
 	return result;
 }
 
 RequestTelemetryLogger* ControllerRequestTelemetry::log_and_summarize(std::string filename, uint64_t print_interval) {
 	auto result = new AsyncRequestTelemetryLogger();
-	result->addLogger(new RequestTelemetryFileLogger(filename));
+	if (columnar::has_extension(filename)) {
+		result->addLogger(new SampledRequestTelemetryLogger(new RequestTelemetryColumnarLogger(filename)));
+	} else {
+		result->addLogger(new SampledRequestTelemetryLogger(new RequestTelemetryFileLogger(filename)));
+	}
 	result->addLogger(new RequestTelemetryPrinter(print_interval));
+	result->addLogger(new RequestMetrics());
 	result->start();
 	return result;
 }
@@ -184,6 +354,8 @@ void ControllerRequestTelemetry::set(clientapi::InferenceRequest &request) {
 	user_id = request.header.user_id;
 	model_id = request.model_id;
 	slo_factor = request.slo_factor;
+	input_size = request.input_size;
+	trace_id = request.header.trace_id;
 }
 
 void ControllerRequestTelemetry::set(clientapi::InferenceResponse &response) {
@@ -195,6 +367,8 @@ void ControllerRequestTelemetry::set(clientapi::InferenceResponse &response) {
 	deadline = response.deadline;
 	arrival_count = response.arrival_count;
 	departure_count = response.departure_count;
+	cache_status = response.cache_status;
+	output_size = response.output_size;
 }
 
 void ControllerActionTelemetry::set(std::shared_ptr<workerapi::Infer> &infer) {
@@ -303,7 +477,11 @@ AsyncControllerActionTelemetryLogger* ControllerActionTelemetry::summarize(uint6
 AsyncControllerActionTelemetryLogger* ControllerActionTelemetry::log_and_summarize(std::string filename, uint64_t print_interval) {
 	auto result = new AsyncControllerActionTelemetryLogger();
 	result->addLogger(new SimpleActionPrinter(print_interval));
-	result->addLogger(new ControllerActionTelemetryFileLogger(filename));
+	if (columnar::has_extension(filename)) {
+		result->addLogger(new SampledControllerActionTelemetryLogger(new ControllerActionTelemetryColumnarLogger(filename)));
+	} else {
+		result->addLogger(new SampledControllerActionTelemetryLogger(new ControllerActionTelemetryFileLogger(filename)));
+	}
 	result->start();
 	return result;
 }
@@ -348,6 +526,18 @@ uint64_t delta_from(uint64_t value, uint64_t start) {
 	return value < start ? 0 : value - start;
 }
 
+// Make sure the worker received the action at least after the controller sent it
+// This shouldn't ever happen, but just in case
+void align_worker_clock(ControllerActionTelemetry &t) {
+	if (t.worker_action_received != 0 && t.worker_action_received < t.action_sent) {
+		uint64_t delta = t.action_sent - t.worker_action_received;
+		t.worker_action_received += delta;
+		t.worker_exec_complete += delta;
+		t.worker_copy_output_complete += delta;
+		t.worker_result_sent += delta;
+	}
+}
+
 void ControllerActionTelemetryFileLogger::log(ControllerActionTelemetry &t) {
 	f << t.result_received << "\t";
 	f << t.action_id << "\t";
@@ -362,15 +552,7 @@ void ControllerActionTelemetryFileLogger::log(ControllerActionTelemetry &t) {
 	f << t.expected_duration << "\t";
 	f << t.worker_duration << "\t";
 
-	// Make sure the worker received the action at least after the controller sent it
-	// This shouldn't ever happen, but just in case
-	if (t.worker_action_received != 0 && t.worker_action_received < t.action_sent) {
-		uint64_t delta = t.action_sent - t.worker_action_received;
-		t.worker_action_received += delta;
-		t.worker_exec_complete += delta;
-		t.worker_copy_output_complete += delta;
-		t.worker_result_sent += delta;
-	}
+	align_worker_clock(t);
 
 	f << delta_from(t.expected_exec_complete, t.action_sent) << "\t";
 	f << delta_from(t.worker_exec_complete, t.action_sent) << "\t";
@@ -394,6 +576,83 @@ void ControllerActionTelemetryFileLogger::shutdown(bool awaitCompletion) {
 	f.close();
 }
 
+ControllerActionTelemetryColumnarLogger::ControllerActionTelemetryColumnarLogger(std::string filename) : f(filename, {
+		{"t", columnar::timestamp},
+		{"action_id", columnar::i32},
+		{"action_type", columnar::i32},
+		{"status", columnar::i32},
+		{"worker_id", columnar::i32},
+		{"gpu_id", columnar::i32},
+		{"model_id", columnar::i32},
+		{"batch_size", columnar::i32},
+		{"expected_exec_duration", columnar::i64},
+		{"worker_exec_duration", columnar::i64},
+		{"expected_exec_complete", columnar::i64},
+		{"worker_exec_complete", columnar::i64},
+		{"expected_gpu_clock", columnar::i32},
+		{"worker_gpu_clock_before", columnar::i32},
+		{"worker_gpu_clock", columnar::i32},
+		{"worker_copy_output_complete", columnar::i64},
+		{"worker_action_received", columnar::i64},
+		{"worker_result_sent", columnar::i64},
+		{"controller_result_enqueue", columnar::i64},
+		{"controller_action_duration", columnar::i64},
+		{"goodput", columnar::i64},
+		{"requests_queued", columnar::i32},
+		{"copies_loaded", columnar::i32}
+	}) {
+}
+
+void ControllerActionTelemetryColumnarLogger::log(ControllerActionTelemetry &t) {
+	align_worker_clock(t);
+
+	f.set_int(0, t.result_received);
+	f.set_int(1, t.action_id);
+	f.set_int(2, t.action_type);
+	f.set_int(3, t.status);
+	f.set_int(4, t.worker_id);
+	f.set_int(5, t.gpu_id);
+	f.set_int(6, t.model_id);
+	f.set_int(7, t.batch_size);
+	f.set_int(8, t.expected_duration);
+	f.set_int(9, t.worker_duration);
+	f.set_int(10, delta_from(t.expected_exec_complete, t.action_sent));
+	f.set_int(11, delta_from(t.worker_exec_complete, t.action_sent));
+	f.set_int(12, t.expected_gpu_clock);
+	f.set_int(13, t.gpu_clock_before);
+	f.set_int(14, t.gpu_clock);
+	f.set_int(15, delta_from(t.worker_copy_output_complete, t.action_sent));
+	f.set_int(16, delta_from(t.worker_action_received, t.action_sent));
+	f.set_int(17, delta_from(t.worker_result_sent, t.action_sent));
+	f.set_int(18, t.result_received - t.action_sent);
+	f.set_int(19, t.result_processing - t.action_sent);
+	f.set_int(20, static_cast<uint64_t>(t.worker_duration * t.goodput));
+	f.set_int(21, t.requests_queued);
+	f.set_int(22, t.copies_loaded);
+	f.end_row();
+}
+
+void ControllerActionTelemetryColumnarLogger::shutdown(bool awaitCompletion) {
+	f.close();
+}
+
+SampledControllerActionTelemetryLogger::SampledControllerActionTelemetryLogger(ControllerActionTelemetryLogger* logger, sampling::Sampler &sampler) :
+	logger(logger), sampler(sampler) {}
+
+bool SampledControllerActionTelemetryLogger::always_log(ControllerActionTelemetry &t) {
+	return t.status != actionSuccess || t.action_type != workerapi::inferAction || t.goodput < 1.0;
+}
+
+void SampledControllerActionTelemetryLogger::log(ControllerActionTelemetry &t) {
+	if (always_log(t) || sampler.sampled_hash(t.sample_hash)) {
+		logger->log(t);
+	}
+}
+
+void SampledControllerActionTelemetryLogger::shutdown(bool awaitCompletion) {
+	logger->shutdown(awaitCompletion);
+}
+
 AsyncControllerActionTelemetryLogger::AsyncControllerActionTelemetryLogger() {}
 
 
@@ -407,12 +666,19 @@ void AsyncControllerActionTelemetryLogger::start() {
 }
 
 void AsyncControllerActionTelemetryLogger::run() {
+	auto log = [this] (ControllerActionTelemetry &next) {
+		for (auto &logger : loggers) {
+			logger->log(next);
+		}
+	};
+
 	while (alive) {
-		ControllerActionTelemetry next;
-		while (queue.try_pop(next)) {
-			for (auto &logger : loggers) {
-				logger->log(next);
-			}
+		rings.drain(log);
+
+		uint64_t dropped = rings.dropped();
+		if (dropped > dropped_reported) {
+			std::cout << "Dropped " << (dropped - dropped_reported) << " action telemetry records" << std::endl;
+			dropped_reported = dropped;
 		}
 
 		usleep(1000);
@@ -420,7 +686,7 @@ void AsyncControllerActionTelemetryLogger::run() {
 }
 
 void AsyncControllerActionTelemetryLogger::log(ControllerActionTelemetry &telemetry) {
-	queue.push(telemetry);
+	rings.log(telemetry);
 }
 
 void AsyncControllerActionTelemetryLogger::shutdown(bool awaitCompletion) {
@@ -433,11 +699,11 @@ void AsyncControllerActionTelemetryLogger::shutdown(bool awaitCompletion) {
 ActionPrinter::ActionPrinter(uint64_t print_interval) : print_interval(print_interval) {}
 
 void ActionPrinter::log(ControllerActionTelemetry &telemetry) {
-	buffered.push(telemetry);
+	record(telemetry);
 
 	uint64_t now = util::now();
 	if (last_print + print_interval <= now) {
-		print(now - last_print, buffered);
+		print(now - last_print);
 		last_print = now;
 	}
 }
@@ -447,76 +713,50 @@ void ActionPrinter::shutdown(bool awaitCompletion) {}
 
 SimpleActionPrinter::SimpleActionPrinter(uint64_t print_interval) : ActionPrinter(print_interval) {}
 
-std::map<SimpleActionPrinter::Group, std::queue<ControllerActionTelemetry>> make_groups(
-		std::queue<ControllerActionTelemetry> &buffered) {
-	std::map<SimpleActionPrinter::Group, std::queue<ControllerActionTelemetry>> result;
-	while (!buffered.empty()) {
-		auto &t = buffered.front();
-		if ((t.action_type == workerapi::loadWeightsAction || 
-			t.action_type == workerapi::inferAction) &&
-			t.status == clockworkSuccess) {
-			SimpleActionPrinter::Group key = std::make_tuple(t.worker_id, t.gpu_id, t.action_type);
-			result[key].push(t);
-		}
-		buffered.pop();
+void SimpleActionPrinter::Summary::record(ControllerActionTelemetry &t) {
+	duration.record(t.worker_duration);
+	e2e.record(t.result_received - t.action_sent);
+
+	uint64_t normalized = t.worker_duration * t.gpu_clock / 1380;
+	normalized_sum += normalized;
+	normalized_max = std::max(normalized_max, normalized);
+	clock_min = std::min(clock_min, t.gpu_clock);
+	clock_max = std::max(clock_max, t.gpu_clock);
+	useful_duration += t.worker_duration * t.goodput;
+}
+
+void SimpleActionPrinter::Summary::reset() {
+	duration.reset();
+	e2e.reset();
+	normalized_sum = 0;
+	normalized_max = 0;
+	clock_min = UINT_MAX;
+	clock_max = 0;
+	useful_duration = 0;
+}
+
+void SimpleActionPrinter::record(ControllerActionTelemetry &t) {
+	if ((t.action_type == workerapi::loadWeightsAction || 
+		t.action_type == workerapi::inferAction) &&
+		t.status == clockworkSuccess) {
+		groups[std::make_tuple(t.worker_id, t.gpu_id, t.action_type)].record(t);
 	}
-	return result;
 }
 
-void SimpleActionPrinter::print(uint64_t interval, std::queue<ControllerActionTelemetry> &buffered) {
-	auto groups = make_groups(buffered);
-
+void SimpleActionPrinter::print(uint64_t interval) {
 	for (auto &p : groups) {
 		print(interval, p.first, p.second);
+		p.second.reset();
 	}
 }
 
-struct Stat {
-	std::vector<uint64_t> v;
-
-	unsigned size() { return v.size(); }
-	uint64_t min() { return *std::min_element(v.begin(), v.end()); }
-	uint64_t max() { return *std::max_element(v.begin(), v.end()); }
-	uint64_t mean() { return std::accumulate(v.begin(), v.end(), 0.0) / v.size(); }
-	double throughput(uint64_t interval) {
-		return (size() * 1000000000.0) / static_cast<double>(interval);
-	}
-	double utilization(uint64_t interval) { 
-		return std::accumulate(v.begin(), v.end(), 0.0) / static_cast<double>(interval);
-	}
-};
-
-void SimpleActionPrinter::print(uint64_t interval, const Group &group, std::queue<ControllerActionTelemetry> &buffered) {
-	if (buffered.empty()) return;
+void SimpleActionPrinter::print(uint64_t interval, const Group &group, Summary &summary) {
+	if (summary.duration.count() == 0) return;
 
 	int worker_id = std::get<0>(group);
 	int gpu_id = std::get<1>(group);
 	int action_type = std::get<2>(group);
 
-	Stat e2e;
-	Stat w;
-	Stat w_norm;
-	Stat gpu_clock;
-
-	if (buffered.empty()) {
-		std::stringstream s;
-		s << std::fixed << std::setprecision(2);
-		s << "W" << worker_id
-		  << "-GPU" << gpu_id
-		  << " throughput=0" << std::endl;
-		std::cout << s.str();
-		return;
-	}
-
-	while (!buffered.empty()) {
-		auto &t = buffered.front();
-		e2e.v.push_back(t.result_received - t.action_sent);
-		w.v.push_back(t.worker_duration);
-		w_norm.v.push_back(t.worker_duration * t.gpu_clock / 1380);
-		gpu_clock.v.push_back(t.gpu_clock);
-		buffered.pop();
-	}
-
 	std::stringstream s;
 	s << std::fixed << std::setprecision(2);
 	s << "W" << worker_id
@@ -528,18 +768,21 @@ void SimpleActionPrinter::print(uint64_t interval, const Group &group, std::queu
 		default: return;
 	}
 
-	s << " min=" << (w.min() / 1000000.0)
-	  << " max=" << (w.max() / 1000000.0)
-	  << " mean=" << (w.mean() / 1000000.0) 
-	  << " e2emean=" << (e2e.mean() / 1000000.0)
-	  << " e2emax=" << (e2e.max() / 1000000.0)
+	uint64_t count = summary.duration.count();
+	s << " min=" << (summary.duration.min() / 1000000.0)
+	  << " max=" << (summary.duration.max() / 1000000.0)
+	  << " mean=" << (summary.duration.mean() / 1000000.0) 
+	  << " " << summary.duration.percentiles_str()
+	  << " e2emean=" << (summary.e2e.mean() / 1000000.0)
+	  << " e2emax=" << (summary.e2e.max() / 1000000.0)
 	  << std::setprecision(1)
-	  << " throughput=" << w.throughput(interval) 
+	  << " throughput=" << (count * 1000000000.0) / static_cast<double>(interval)
 	  << std::setprecision(2)
-	  << " utilization=" << w.utilization(interval)
-	  << " clock=[" << gpu_clock.min() << "-" << gpu_clock.max() << "]"
-	  << " norm_max=" << (w_norm.max() / 1000000.0)
-	  << " norm_mean=" << (w_norm.mean() / 1000000.0)
+	  << " utilization=" << summary.duration.sum() / static_cast<double>(interval)
+	  << " goodput=" << summary.useful_duration / static_cast<double>(interval)
+	  << " clock=[" << summary.clock_min << "-" << summary.clock_max << "]"
+	  << " norm_max=" << (summary.normalized_max / 1000000.0)
+	  << " norm_mean=" << (summary.normalized_sum / (1000000.0 * count))
 	  << std::endl;
 	std::cout << s.str();
 }
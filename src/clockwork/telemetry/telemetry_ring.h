@@ -0,0 +1,152 @@
+#ifndef _CLOCKWORK_TELEMETRY_TELEMETRY_RING_H_
+#define _CLOCKWORK_TELEMETRY_TELEMETRY_RING_H_
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace clockwork {
+
+/*
+A fixed-capacity ring of telemetry records with a single producer and a single consumer.
+Records are copied in place; when the ring is full, records are dropped and counted rather
+than blocking the producer.
+*/
+template <typename T> class TelemetryRing {
+public:
+	const uint64_t capacity; // a power of two
+
+private:
+	const uint64_t mask;
+	std::vector<T> records;
+
+	alignas(64) std::atomic_uint64_t head; // next record to drain; written by the consumer
+	alignas(64) std::atomic_uint64_t tail; // next record to write; written by the producer
+	uint64_t cached_head = 0; // the producer's last view of head
+
+public:
+	std::atomic_uint64_t dropped;
+
+	TelemetryRing(uint64_t min_capacity) :
+			capacity(round_up(min_capacity)), mask(capacity - 1), records(capacity),
+			head(0), tail(0), dropped(0) {
+	}
+
+	// Called only by the producer
+	bool push(const T &record) {
+		uint64_t t = tail.load(std::memory_order_relaxed);
+		if (t - cached_head >= capacity) {
+			cached_head = head.load(std::memory_order_acquire);
+			if (t - cached_head >= capacity) {
+				dropped.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+		}
+		records[t & mask] = record;
+		tail.store(t + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Called only by the consumer; passes each pending record to f, in order
+	template <typename F> uint64_t drain(F &&f) {
+		uint64_t h = head.load(std::memory_order_relaxed);
+		uint64_t t = tail.load(std::memory_order_acquire);
+		for (uint64_t i = h; i < t; i++) {
+			f(records[i & mask]);
+		}
+		head.store(t, std::memory_order_release);
+		return t - h;
+	}
+
+private:
+	static uint64_t round_up(uint64_t n) {
+		uint64_t capacity = 1;
+		while (capacity < n) capacity <<= 1;
+		return capacity;
+	}
+};
+
+/*
+One TelemetryRing per producing thread, drained by a single collector thread.
+
+A thread's ring is created the first time it logs, and lives as long as the TelemetryRings;
+after that, logging takes no locks and makes no allocations.
+*/
+template <typename T> class TelemetryRings {
+public:
+	const uint64_t ring_capacity;
+
+private:
+	const unsigned id;
+	std::mutex mutex;
+	std::vector<TelemetryRing<T>*> rings;
+
+public:
+	TelemetryRings(uint64_t ring_capacity = 4096) :
+			ring_capacity(ring_capacity), id(next_id()++) {
+	}
+
+	~TelemetryRings() {
+		for (auto ring : rings) {
+			delete ring;
+		}
+	}
+
+	// Returns false if the calling thread's ring was full and the record was dropped
+	bool log(const T &record) {
+		return local()->push(record);
+	}
+
+	// Called by the collector thread
+	template <typename F> uint64_t drain(F &&f) {
+		uint64_t drained = 0;
+		for (auto ring : snapshot()) {
+			drained += ring->drain(f);
+		}
+		return drained;
+	}
+
+	// Total records dropped so far because a ring was full
+	uint64_t dropped() {
+		uint64_t dropped = 0;
+		for (auto ring : snapshot()) {
+			dropped += ring->dropped.load(std::memory_order_relaxed);
+		}
+		return dropped;
+	}
+
+private:
+	static std::atomic_uint &next_id() {
+		static std::atomic_uint id(0);
+		return id;
+	}
+
+	std::vector<TelemetryRing<T>*> snapshot() {
+		std::lock_guard<std::mutex> lock(mutex);
+		return rings;
+	}
+
+	TelemetryRing<T>* local() {
+		// Indexed by TelemetryRings id; ids are never reused, so stale entries are never read
+		thread_local std::vector<TelemetryRing<T>*> local_rings;
+		if (id < local_rings.size() && local_rings[id] != nullptr) {
+			return local_rings[id];
+		}
+
+		auto ring = new TelemetryRing<T>(ring_capacity);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			rings.push_back(ring);
+		}
+		if (local_rings.size() <= id) {
+			local_rings.resize(id + 1, nullptr);
+		}
+		local_rings[id] = ring;
+		return ring;
+	}
+};
+
+}
+
+#endif
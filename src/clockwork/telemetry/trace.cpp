@@ -0,0 +1,133 @@
+#include "clockwork/telemetry/trace.h"
+#include <iostream>
+#include <random>
+#include <unistd.h>
+#include <inttypes.h>
+#include <dmlc/logging.h>
+#include "clockwork/thread.h"
+
+namespace clockwork {
+namespace trace {
+
+Writer::Writer(std::string filename, std::string process_name) :
+		filename(filename), process_name(process_name), pid(getpid()) {
+	f = fopen(filename.c_str(), "w");
+	CHECK(f != nullptr) << "Unable to open " << filename << " for writing";
+
+	// The JSON array format; the closing bracket is optional, and omitting it means files
+	// can be concatenated by dropping the first line of each but the first
+	fprintf(f, "[\n");
+	fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"%s\"}},\n",
+		pid, process_name.c_str());
+	fflush(f);
+}
+
+Writer::~Writer() {
+	close();
+}
+
+void Writer::write(const Span &span) {
+	if (f == nullptr) return;
+
+	// Microseconds, printed from integers; nanoseconds since the epoch exceed a double's precision
+	uint64_t duration = span.end > span.begin ? span.end - span.begin : 0;
+	fprintf(f, "{\"name\":\"%s\",\"cat\":\"clockwork\",\"ph\":\"X\",\"pid\":%d,\"tid\":%" PRIu64 ","
+		"\"ts\":%" PRIu64 ".%03" PRIu64 ",\"dur\":%" PRIu64 ".%03" PRIu64 ","
+		"\"args\":{\"trace_id\":\"%016" PRIx64 "\"",
+		span.name, pid, (span.trace_id ^ (span.trace_id >> 32)) & 0x7fffffff,
+		span.begin / 1000, span.begin % 1000, duration / 1000, duration % 1000,
+		span.trace_id);
+	if (span.action_id >= 0) {
+		fprintf(f, ",\"action_id\":%" PRId64, span.action_id);
+	}
+	fprintf(f, "}},\n");
+}
+
+void Writer::flush() {
+	if (f != nullptr) fflush(f);
+}
+
+void Writer::close() {
+	if (f == nullptr) return;
+	fclose(f);
+	f = nullptr;
+}
+
+Tracer::Tracer(std::string filename, std::string process_name) :
+		alive(true), writer(filename, process_name), rings(16384) {
+	thread = std::thread(&Tracer::run, this);
+	threading::initLoggerThread(thread);
+}
+
+void Tracer::log(const Span &span) {
+	rings.log(span);
+}
+
+void Tracer::run() {
+	auto write = [this] (Span &span) { writer.write(span); };
+
+	while (alive) {
+		if (rings.drain(write) > 0) {
+			writer.flush();
+		}
+
+		uint64_t dropped = rings.dropped();
+		if (dropped > dropped_reported) {
+			std::cout << "Dropped " << (dropped - dropped_reported) << " trace spans" << std::endl;
+			dropped_reported = dropped;
+		}
+
+		usleep(1000);
+	}
+
+	rings.drain(write);
+	writer.close();
+}
+
+void Tracer::shutdown(bool awaitCompletion) {
+	alive = false;
+	if (awaitCompletion && thread.joinable()) {
+		thread.join();
+	}
+}
+
+static std::atomic<Tracer*> &current() {
+	static std::atomic<Tracer*> tracer(nullptr);
+	return tracer;
+}
+
+void start(std::string filename, std::string process_name) {
+	Tracer* previous = current().exchange(new Tracer(filename, process_name));
+	if (previous != nullptr) {
+		previous->shutdown(true);
+	}
+	std::cout << "Writing trace to " << filename << std::endl;
+}
+
+void shutdown() {
+	// The tracer isn't deleted, in case another thread is still logging to it
+	Tracer* tracer = current().exchange(nullptr);
+	if (tracer != nullptr) {
+		tracer->shutdown(true);
+	}
+}
+
+bool enabled() {
+	return current().load(std::memory_order_relaxed) != nullptr;
+}
+
+void span(uint64_t trace_id, const char* name, uint64_t begin, uint64_t end, int64_t action_id) {
+	Tracer* tracer = current().load(std::memory_order_relaxed);
+	if (tracer == nullptr || trace_id == 0) return;
+	tracer->log(Span{trace_id, name, begin, end, action_id});
+}
+
+uint64_t new_id() {
+	// A random per-process prefix, followed by a sequence number
+	static const uint64_t prefix = (std::random_device()() & 0x7fffffffUL) | 0x1;
+	static std::atomic_uint64_t seqno(0);
+	return (prefix << 32) | (seqno++ & 0xffffffffUL);
+}
+
+}
+}
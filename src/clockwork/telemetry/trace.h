@@ -0,0 +1,85 @@
+#ifndef _CLOCKWORK_TELEMETRY_TRACE_H_
+#define _CLOCKWORK_TELEMETRY_TRACE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include "clockwork/telemetry/telemetry_ring.h"
+
+namespace clockwork {
+
+/*
+End-to-end request tracing.
+
+A trace id is chosen by the client (or by the controller, for requests without one) and
+carried in the request header, then in each InferAction sent to a worker.  The client,
+controller and workers each write the spans they observe to their own trace file.  Span
+times are converted to the controller's clock using the clock delta measured by each
+network connection, so the files can be concatenated and viewed together.
+
+Trace files are in the Chrome trace event format, viewable in chrome://tracing or
+Perfetto.  Each process is named, and each trace is a separate thread within it.
+*/
+namespace trace {
+
+struct Span {
+	uint64_t trace_id;
+	const char* name; // a string literal
+	uint64_t begin; // nanoseconds, controller clock
+	uint64_t end;
+	int64_t action_id; // -1 if the span isn't part of an action
+};
+
+class Writer {
+public:
+	const std::string filename;
+	const std::string process_name;
+
+private:
+	FILE* f;
+	const int pid;
+
+public:
+	Writer(std::string filename, std::string process_name);
+	~Writer();
+
+	void write(const Span &span);
+	void flush();
+	void close();
+};
+
+// Writes spans on a background thread; logging never blocks
+class Tracer {
+private:
+	std::atomic_bool alive;
+	Writer writer;
+	TelemetryRings<Span> rings; // one per thread logging spans
+	std::thread thread;
+	uint64_t dropped_reported = 0;
+
+public:
+	Tracer(std::string filename, std::string process_name);
+
+	void log(const Span &span);
+	void shutdown(bool awaitCompletion);
+
+private:
+	void run();
+};
+
+// Starts tracing in this process; until then, span does nothing
+void start(std::string filename, std::string process_name);
+void shutdown();
+bool enabled();
+
+void span(uint64_t trace_id, const char* name, uint64_t begin, uint64_t end, int64_t action_id = -1);
+
+// A new trace id, unique with high probability across processes; never 0
+uint64_t new_id();
+
+}
+}
+
+#endif
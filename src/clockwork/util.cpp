@@ -124,6 +124,21 @@ std::string getGPUmodel(int deviceNumber) {
 }
 
 
+unsigned getGPUMaxClock(int deviceNumber) {
+  nvmlReturn_t status = nvmlInit();
+  if (status != NVML_SUCCESS && status != NVML_ERROR_ALREADY_INITIALIZED) return 0;
+
+  nvmlDevice_t device;
+  unsigned clock = 0;
+  if (nvmlDeviceGetHandleByIndex(deviceNumber, &device) != NVML_SUCCESS ||
+      nvmlDeviceGetMaxClockInfo(device, NVML_CLOCK_SM, &clock) != NVML_SUCCESS) {
+    clock = 0;
+  }
+  nvmlShutdown();
+  return clock;
+}
+
+
 char* getGPUModelToBuffer(int deviceNumber, char* buf) {
   strcpy(buf, getGPUmodel(deviceNumber).c_str());
   return buf;
@@ -213,6 +228,54 @@ std::string get_controller_log_dir() {
   return logdirs;
 }
 
+std::string get_controller_log_extension() {
+  auto format = std::getenv("CLOCKWORK_TELEMETRY_FORMAT");
+  if (format != nullptr && std::string(format) == "columnar") return ".cwcol";
+  return ".tsv";
+}
+
+std::string get_trace_file(std::string name) {
+  auto tracedir = std::getenv("CLOCKWORK_TRACE_DIR");
+  if (tracedir == nullptr || std::string(tracedir) == "") return "";
+  return std::string(tracedir) + "/" + name + ".trace.json";
+}
+
+double get_request_log_sample_rate() {
+  auto rate = std::getenv("CLOCKWORK_REQUEST_LOG_SAMPLE_RATE");
+  if (rate == nullptr || std::string(rate) == "") return 1.0;
+  return std::atof(rate);
+}
+
+double get_action_log_sample_rate() {
+  auto rate = std::getenv("CLOCKWORK_ACTION_LOG_SAMPLE_RATE");
+  if (rate == nullptr || std::string(rate) == "") return 1.0;
+  return std::atof(rate);
+}
+
+int get_controller_port() {
+  auto port = std::getenv("CLOCKWORK_CONTROLLER_PORT");
+  if (port == nullptr || std::string(port) == "") return 12346;
+  return std::atoi(port);
+}
+
+int get_controller_metrics_port() {
+  auto port = std::getenv("CLOCKWORK_CONTROLLER_METRICS_PORT");
+  if (port == nullptr || std::string(port) == "") return 0;
+  return std::atoi(port);
+}
+
+int get_worker_metrics_port() {
+  auto port = std::getenv("CLOCKWORK_WORKER_METRICS_PORT");
+  if (port == nullptr || std::string(port) == "") return 0;
+  return std::atoi(port);
+}
+
+unsigned get_client_generator_threads() {
+  auto threads = std::getenv("CLOCKWORK_CLIENT_THREADS");
+  if (threads == nullptr || std::string(threads) == "") return 1;
+  return std::max(1, std::atoi(threads));
+}
+
 std::string get_modelzoo_dir() {
   auto modelzoo = std::getenv("CLOCKWORK_MODEL_DIR");
   if (modelzoo == nullptr) { return ""; }
@@ -316,6 +379,10 @@ void InputGenerator::generateCompressedInput(size_t size, char** bufPtr, size_t*
 }
 
 std::string& InputGenerator::getPrecompressedInput(size_t size) {
+  return getPrecompressedInput(size, rng);
+}
+
+std::string& InputGenerator::getPrecompressedInput(size_t size, std::minstd_rand &rng) {
   auto it = compressed_inputs.find(size);
   CHECK(it != compressed_inputs.end()) << "Generated inputs not available for input size " << size;
   
@@ -37,6 +37,7 @@ unsigned get_num_gpus();
 void setCudaFlags();
 
 std::string getGPUmodel(int deviceNumber);
+unsigned getGPUMaxClock(int deviceNumber); // Max SM clock in MHz; 0 if unknown
 
 extern "C" char* getGPUModelToBuffer(int deviceNumber, char* buf);
 
@@ -81,6 +82,14 @@ std::string get_example_model_path(std::string model_name = "resnet18_tesla-m40"
 std::string get_example_model_path(std::string clockwork_directory, std::string model_name);
 
 std::string get_controller_log_dir();
+std::string get_controller_log_extension(); // ".tsv", or ".cwcol" if CLOCKWORK_TELEMETRY_FORMAT=columnar
+std::string get_trace_file(std::string name); // "", ie. no tracing, unless CLOCKWORK_TRACE_DIR is set
+double get_request_log_sample_rate(); // 1, ie. log every request, unless CLOCKWORK_REQUEST_LOG_SAMPLE_RATE is set
+double get_action_log_sample_rate(); // 1, ie. log every action, unless CLOCKWORK_ACTION_LOG_SAMPLE_RATE is set
+int get_controller_port();
+int get_controller_metrics_port(); // 0, ie. disabled, unless CLOCKWORK_CONTROLLER_METRICS_PORT is set
+int get_worker_metrics_port(); // 0, ie. disabled, unless CLOCKWORK_WORKER_METRICS_PORT is set
+unsigned get_client_generator_threads(); // 1 unless CLOCKWORK_CLIENT_THREADS is set
 std::string get_modelzoo_dir();
 std::string get_clockwork_model(std::string shortname);
 
@@ -106,6 +115,7 @@ class InputGenerator {
  	void generateCompressedInput(size_t size, char** bufPtr, size_t* compressed_size);
  	void generatePrecompressedInput(size_t size, char** bufPtr, size_t* compressed_size);
  	std::string& getPrecompressedInput(size_t size);
+ 	std::string& getPrecompressedInput(size_t size, std::minstd_rand &rng); // can be called concurrently with distinct rngs
 };
 
 /* A simple utility class that runs a background thread checking the GPU clock state */
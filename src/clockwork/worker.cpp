@@ -1,4 +1,5 @@
 #include "clockwork/worker.h"
+#include "clockwork/telemetry/trace.h"
 #include <algorithm>
 #include <sstream>
 #include <iostream>
@@ -6,25 +7,25 @@
 namespace clockwork {
 
 void set_and_log_actionTelemetry(
-		std::shared_ptr<ActionTelemetry> telemetry, ClockworkRuntime* runtime,
+		ActionTelemetry &telemetry, ClockworkRuntime* runtime,
 		int telemetry_type, int action_id, int action_type, int status,
 		clockwork::time_point timestamp){
-	telemetry->telemetry_type = telemetry_type;
-	telemetry->action_id = action_id;
-	telemetry->action_type = action_type;
-	telemetry->status = status;
-	telemetry->timestamp = timestamp;
+	telemetry.telemetry_type = telemetry_type;
+	telemetry.action_id = action_id;
+	telemetry.action_type = action_type;
+	telemetry.status = status;
+	telemetry.timestamp = timestamp;
 
 	runtime->action_telemetry_logger->log(telemetry);
 }
 
 // TODO: actually instantiate the clockwork runtime properly and set the controller
 ClockworkWorker::ClockworkWorker() : 
-		runtime(new ClockworkRuntime()), has_logged_inputs_status(ATOMIC_FLAG_INIT) {
+		runtime(new ClockworkRuntime()), next_executor_report(0), has_logged_inputs_status(ATOMIC_FLAG_INIT) {
 }
 
 ClockworkWorker::ClockworkWorker(ClockworkWorkerConfig &config) :
-		runtime(new ClockworkRuntime(config)), has_logged_inputs_status(ATOMIC_FLAG_INIT) {
+		runtime(new ClockworkRuntime(config)), next_executor_report(0), has_logged_inputs_status(ATOMIC_FLAG_INIT) {
 }
 ClockworkWorker::~ClockworkWorker() {
 	this->shutdown(false);
@@ -56,6 +57,19 @@ void ClockworkWorker::sendActions(std::vector<std::shared_ptr<workerapi::Action>
 	}
 }
 
+void ClockworkWorker::report_executors(workerapi::InferResult &result, int64_t clock_delta) {
+	uint64_t now = util::now();
+	uint64_t next = next_executor_report.load();
+	if (now < next || !next_executor_report.compare_exchange_strong(next, now + executor_report_interval)) {
+		return;
+	}
+
+	runtime->executor_telemetry(result.executors);
+	for (auto &executor : result.executors) {
+		executor.timestamp = adjust_timestamp(executor.timestamp, -clock_delta);
+	}
+}
+
 void ClockworkWorker::invalidAction(std::shared_ptr<workerapi::Action> action) {
 	auto result = std::make_shared<workerapi::ErrorResult>();
 
@@ -147,6 +161,7 @@ void ClockworkWorker::clearCache(std::shared_ptr<workerapi::Action> action) {
 		for (unsigned i = 0; i < runtime->num_gpus; i++) {
 			runtime->manager->weights_caches[i]->clear();
 		}
+		runtime->manager->models->invalidate_events(); // Everything was evicted
 		auto result = std::make_shared<workerapi::ClearCacheResult>();
 		result->id = action->id;
 		result->action_type = workerapi::clearCacheAction;
@@ -163,7 +178,12 @@ void ClockworkWorker::getWorkerState(std::shared_ptr<workerapi::Action> action)
 		auto result = std::make_shared<workerapi::GetWorkerStateResult>();
 		result->id = action->id;
 		result->action_type = workerapi::getWorkerStateAction;
-		runtime->manager->get_worker_memory_info(result->worker);
+		runtime->manager->get_worker_state(get_worker_state->since_seqno, *result);
+		for (auto &gpu : result->worker.gpus) {
+			gpu.name = util::getGPUmodel(gpu.id);
+			gpu.clock = runtime->gpu_clock->get(gpu.id);
+			gpu.max_clock = util::getGPUMaxClock(gpu.id);
+		}
 		result->status = actionSuccess; // TODO What about error handling?
 		controller->sendResult(result);
 	} else {
@@ -172,9 +192,7 @@ void ClockworkWorker::getWorkerState(std::shared_ptr<workerapi::Action> action)
 }
 
 LoadModelFromDisk::LoadModelFromDisk(ClockworkWorker* worker, std::shared_ptr<workerapi::LoadModelFromDisk> action) : 
-		LoadModelFromDiskAction(worker->runtime, action), worker(worker),
-		action_telemetry(std::make_shared<ActionTelemetry>()),
-		response_telemetry(std::make_shared<ActionTelemetry>()) {
+		LoadModelFromDiskAction(worker->runtime, action), worker(worker) {
 	// set_and_log_actionTelemetry(action_telemetry, runtime, 0, action->id, workerapi::loadModelFromDiskAction, 0, util::hrt());
 }
 
@@ -201,9 +219,7 @@ void LoadModelFromDisk::error(std::shared_ptr<workerapi::ErrorResult> result) {
 
 
 LoadWeights::LoadWeights(ClockworkWorker* worker, std::shared_ptr<workerapi::LoadWeights> action) :
-		LoadWeightsAction(worker->runtime, action), worker(worker),
-		action_telemetry(std::make_shared<ActionTelemetry>()),
-		response_telemetry(std::make_shared<ActionTelemetry>()) {
+		LoadWeightsAction(worker->runtime, action), worker(worker) {
 	// set_and_log_actionTelemetry(action_telemetry, runtime, 0, action->id, workerapi::loadWeightsAction, 0, util::hrt());
 }
 
@@ -229,9 +245,7 @@ void LoadWeights::error(std::shared_ptr<workerapi::ErrorResult> result) {
 }
 
 EvictWeights::EvictWeights(ClockworkWorker* worker, std::shared_ptr<workerapi::EvictWeights> action) :
-		EvictWeightsAction(worker->runtime, action), worker(worker),
-		action_telemetry(std::make_shared<ActionTelemetry>()),
-		response_telemetry(std::make_shared<ActionTelemetry>()) {
+		EvictWeightsAction(worker->runtime, action), worker(worker) {
 	// set_and_log_actionTelemetry(action_telemetry, runtime, 0, action->id, workerapi::evictWeightsAction, 0, util::hrt());
 }
 
@@ -257,9 +271,7 @@ void EvictWeights::error(std::shared_ptr<workerapi::ErrorResult> result) {
 }
 
 Infer::Infer(ClockworkWorker* worker, std::shared_ptr<workerapi::Infer> action) :
-		InferAction(worker->runtime, action), worker(worker),
-		action_telemetry(std::make_shared<ActionTelemetry>()),
-		response_telemetry(std::make_shared<ActionTelemetry>())   {
+		InferAction(worker->runtime, action), worker(worker) {
 	// set_and_log_actionTelemetry(action_telemetry, runtime, 0, action->id, workerapi::inferAction, 0, util::hrt());
 }
 
@@ -275,6 +287,16 @@ void Infer::success(std::shared_ptr<workerapi::InferResult> result) {
 	result->copy_output.end = adjust_timestamp(result->copy_output.end, -action->clock_delta);
 	result->action_received = adjust_timestamp(action->received, -action->clock_delta);
 	result->clock_delta = action->clock_delta;
+
+	// Timestamps are now in controller time
+	for (uint64_t trace_id : action->trace_ids) {
+		trace::span(trace_id, "worker queued", result->action_received, result->copy_input.begin, action->id);
+		trace::span(trace_id, "copy_input", result->copy_input.begin, result->copy_input.end, action->id);
+		trace::span(trace_id, "exec", result->exec.begin, result->exec.end, action->id);
+		trace::span(trace_id, "copy_output", result->copy_output.begin, result->copy_output.end, action->id);
+	}
+
+	worker->report_executors(*result, action->clock_delta);
 	
 	worker->controller->sendResult(result);
 	delete this;
@@ -284,6 +306,12 @@ void Infer::error(std::shared_ptr<workerapi::ErrorResult> result) {
 	// set_and_log_actionTelemetry(response_telemetry, runtime, 1, result->id, workerapi::inferAction, result->status, util::hrt());
 	result->action_received = adjust_timestamp(action->received, -action->clock_delta);
 	result->clock_delta = action->clock_delta;
+
+	uint64_t now = adjust_timestamp(util::now(), -action->clock_delta);
+	for (uint64_t trace_id : action->trace_ids) {
+		trace::span(trace_id, "worker error", result->action_received, now, action->id);
+	}
+
 	worker->controller->sendResult(result);
 	delete this;
 }
@@ -28,7 +28,13 @@ public:
 
 	void sendActions(std::vector<std::shared_ptr<workerapi::Action>> &actions);
 
+	// Attaches executor telemetry to the result if none has been sent for executor_report_interval
+	void report_executors(workerapi::InferResult &result, int64_t clock_delta);
+
 private:
+	static const uint64_t executor_report_interval = 100000000UL; // 100ms
+	std::atomic_uint64_t next_executor_report;
+
 	void invalidAction(std::shared_ptr<workerapi::Action> action);
 	void loadModel(std::shared_ptr<workerapi::Action> action);
 	void loadWeights(std::shared_ptr<workerapi::Action> action);
@@ -45,8 +51,8 @@ class LoadModelFromDisk : public LoadModelFromDiskAction {
 public:
 	ClockworkWorker* worker;
 
-	std::shared_ptr<ActionTelemetry> action_telemetry;
-	std::shared_ptr<ActionTelemetry> response_telemetry;
+	ActionTelemetry action_telemetry;
+	ActionTelemetry response_telemetry;
 
 	LoadModelFromDisk(ClockworkWorker* worker, std::shared_ptr<workerapi::LoadModelFromDisk> action);
 
@@ -58,8 +64,8 @@ class LoadWeights : public LoadWeightsAction {
 public:
 	ClockworkWorker* worker;
 
-	std::shared_ptr<ActionTelemetry> action_telemetry;
-	std::shared_ptr<ActionTelemetry> response_telemetry;
+	ActionTelemetry action_telemetry;
+	ActionTelemetry response_telemetry;
 
 	LoadWeights(ClockworkWorker* worker, std::shared_ptr<workerapi::LoadWeights> action);
 
@@ -71,8 +77,8 @@ class EvictWeights : public EvictWeightsAction {
 public:
 	ClockworkWorker* worker;
 
-	std::shared_ptr<ActionTelemetry> action_telemetry;
-	std::shared_ptr<ActionTelemetry> response_telemetry;
+	ActionTelemetry action_telemetry;
+	ActionTelemetry response_telemetry;
 
 	EvictWeights(ClockworkWorker* worker, std::shared_ptr<workerapi::EvictWeights> action);
 
@@ -84,8 +90,8 @@ class Infer : public InferAction {
 public:
 	ClockworkWorker* worker;
 
-	std::shared_ptr<ActionTelemetry> action_telemetry;
-	std::shared_ptr<ActionTelemetry> response_telemetry;
+	ActionTelemetry action_telemetry;
+	ActionTelemetry response_telemetry;
 
 	Infer(ClockworkWorker* worker, std::shared_ptr<workerapi::Infer> action);
 
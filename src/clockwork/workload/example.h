@@ -221,6 +221,42 @@ Engine* poisson_open_loop(clockwork::Client* client, unsigned num_models,
 	return engine;
 }
 
+// Well-behaved open-loop tenants sharing the GPUs with one tenant that floods its own models.
+// Tenants are distinguished by client id, which is the user_id the controller sees.
+Engine* noisy_neighbour(clockwork::Client* client, unsigned num_tenants,
+	unsigned models_per_tenant, double rate, unsigned noisy_concurrency) {
+	Engine* engine = new Engine();
+
+	std::string modelpath = util::get_clockwork_modelzoo()["resnet50_v2"];
+
+	std::cout << "Adding " << num_tenants << " PoissonOpenLoop tenants with "
+			  << models_per_tenant << " models each, at " << rate
+			  << " requests/second per tenant" << std::endl;
+	for (unsigned i = 0; i < num_tenants; i++) {
+		auto models = client->load_remote_models(modelpath, models_per_tenant);
+		for (unsigned j = 0; j < models.size(); j++) {
+			engine->AddWorkload(new PoissonOpenLoop(
+				i,							// client id
+				models[j],					// model
+				i * models_per_tenant + j,	// rng seed
+				rate / models_per_tenant	// requests/second
+			));
+		}
+	}
+
+	std::cout << "Adding noisy ClosedLoop tenant " << num_tenants << " with "
+			  << models_per_tenant << " models and concurrency "
+			  << noisy_concurrency << std::endl;
+	auto models = client->load_remote_models(modelpath, models_per_tenant);
+	engine->AddWorkload(new ClosedLoop(
+		num_tenants,		// client id
+		models,				// models
+		noisy_concurrency	// concurrency
+	));
+
+	return engine;
+}
+
 Engine* example(clockwork::Client* client) {
 	Engine* engine = new Engine();
 
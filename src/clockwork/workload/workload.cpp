@@ -2,39 +2,100 @@
 #include "clockwork/api/api_common.h"
 #include <dmlc/logging.h>
 #include "clockwork/util.h"
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
 
 using namespace clockwork::workload;
 
-void Engine::AddWorkload(Workload* workload, uint64_t start_after) {
-	workloads.push_back(workload);
-	workload->SetEngine(this);
-	workload->start_after = start_after;
+Shard::Shard(unsigned id, Engine* engine) : id(id), engine(engine), rng(id) {
 }
 
-void Engine::SetTimeout(uint64_t timeout, std::function<void(void)> callback) {
+void Shard::SetTimeout(uint64_t timeout, std::function<void(void)> callback) {
 	if (timeout == 0) callback();
 	else queue.push(element{now + timeout, callback});
 }
 
-void Engine::InferComplete(Workload* workload, unsigned model_index) {
-	auto callback = [this, workload, model_index]() {
-		workload->InferComplete(now, model_index);
-	};
+void Shard::Post(std::function<void(void)> callback) {
 	runqueue.push(callback);
 }
 
-void Engine::InferError(Workload* workload, unsigned model_index, int status) {
-	std::function<void(void)> callback;
-	if (status == clockworkInitializing) {
-		callback = [this, workload, model_index]() {
-			workload->InferErrorInitializing(now, model_index);
-		};
-	} else {
-		callback = [this, workload, model_index, status]() {
-			workload->InferError(now, model_index, status);
-		};
+void Shard::Complete(Workload* workload, unsigned model_index, int status) {
+	results.push(result{workload, model_index, status});
+}
+
+void Shard::Run() {
+	while (engine->running > 0) {
+		// Process all pending results
+		now = util::now();
+		result r;
+		for (unsigned i = 0; i < max_results_per_poll && results.try_pop(r); i++) {
+			if (r.status == clockworkSuccess) {
+				r.workload->InferComplete(now, r.model_index);
+			} else if (r.status == clockworkInitializing) {
+				r.workload->InferErrorInitializing(now, r.model_index);
+			} else {
+				r.workload->InferError(now, r.model_index, r.status);
+			}
+		}
+
+		// Then any callbacks posted from other threads
+		std::function<void(void)> callback;
+		while (runqueue.try_pop(callback)) {
+			callback();
+		}
+
+		// Run the timeouts that are due.  Each runs at its intended time, so
+		// falling behind shows up as lag rather than as a lower request rate
+		uint64_t actual = util::now();
+		unsigned count = 0;
+		for (; count < max_timeouts_per_poll; count++) {
+			if (queue.empty() || queue.top().ready > actual) break;
+			auto next = queue.top();
+			queue.pop();
+			lag.record(actual - next.ready);
+			now = next.ready;
+			next.callback();
+			actual = util::now();
+		}
+
+		if (count == 0 && (queue.empty() || queue.top().ready > actual + spin_threshold)) {
+			usleep(1);
+		}
 	}
-	runqueue.push(callback);
+}
+
+Engine::Engine() : Engine(util::get_client_generator_threads()) {
+}
+
+Engine::Engine(unsigned num_shards) {
+	CHECK(num_shards > 0) << "Engine requires at least one shard";
+	for (unsigned i = 0; i < num_shards; i++) {
+		shards.push_back(new Shard(i, this));
+	}
+}
+
+Engine::~Engine() {
+	for (auto &shard : shards) {
+		delete shard;
+	}
+	delete input_generator;
+}
+
+void Engine::AddWorkload(Workload* workload, uint64_t start_after) {
+	workload->shard = shards[workloads.size() % shards.size()];
+	workloads.push_back(workload);
+	workload->SetEngine(this);
+	workload->start_after = start_after;
+}
+
+void Engine::InferComplete(Workload* workload, unsigned model_index) {
+	workload->shard->Complete(workload, model_index, clockworkSuccess);
+}
+
+void Engine::InferError(Workload* workload, unsigned model_index, int status) {
+	workload->shard->Complete(workload, model_index, status);
 }
 
 void Engine::Run(clockwork::Client* client) {
@@ -51,30 +112,54 @@ void Engine::Run(clockwork::Client* client) {
 		}
 	}
 
-	now = util::now();
+	// Loading inputs is slow, and timers don't need them
+	for (auto &workload : workloads) {
+		if (input_generator == nullptr && workload->models.size() > 0) {
+			input_generator = new util::InputGenerator();
+		}
+	}
+
 	for (auto &workload : workloads) {
 		running++;
-		SetTimeout(workload->start_after, [this, workload]() { workload->Start(now); });
+		workload->Post([workload]() {
+			Shard* shard = workload->shard;
+			shard->SetTimeout(workload->start_after, [shard, workload]() { workload->Start(shard->now); });
+		});
 	}
+
+	std::vector<std::thread> threads;
+	for (auto &shard : shards) {
+		threads.emplace_back(&Shard::Run, shard);
+	}
+
+	// Periodically report how far behind schedule the shards are running
+	uint64_t last_print = util::now();
+	Histogram interval;
 	while (running > 0) {
-		// Process all pending results
-		now = util::now();
-		std::function<void(void)> callback;
-		while (runqueue.try_pop(callback)) {
-			callback();
+		usleep(10000);
+		uint64_t now = util::now();
+		if (last_print + print_interval > now) continue;
+
+		interval.reset();
+		for (auto &shard : shards) {
+			shard->lag.drain_into(interval);
 		}
 
-		// Run one next request if available
-		now = util::now();
-		if (!queue.empty() && queue.top().ready <= now) {
-			auto next = queue.top();
-			queue.pop();
-			now = next.ready;
-			next.callback();
-		} else {
-			usleep(1);
-			now = util::now();
+		std::stringstream report;
+		report << std::fixed << std::setprecision(2);
+		report << "engine shards=" << shards.size() << " timeouts=" << interval.count();
+		if (interval.count() > 0) {
+			report << " lag mean=" << (interval.mean() / 1000000.0)
+			       << " max=" << (interval.max() / 1000000.0)
+			       << " " << interval.percentiles_str();
 		}
+		std::cout << report.str() << std::endl;
+
+		last_print = now;
+	}
+
+	for (auto &thread : threads) {
+		thread.join();
 	}
 }
 
@@ -91,6 +176,7 @@ Workload::Workload(int id, std::vector<clockwork::Model*> &models) : user_id(id)
 
 void Workload::AddModel(clockwork::Model* model) {
 	model->set_user_id(user_id);
+	completions.emplace_back(this, models.size());
 	models.push_back(model);
 }
 
@@ -109,26 +195,29 @@ void Workload::Infer(unsigned model_index) {
 		<< " inferring on non-existent model ";
 	auto &model = models[model_index];
 
-	std::string& generated = engine->input_generator.getPrecompressedInput(model->input_size());
-	uint8_t* ptr = static_cast<uint8_t*>(static_cast<void*>(generated.data()));
-	std::vector<uint8_t> input(ptr, ptr+generated.size());
-
+	std::string& generated = engine->input_generator->getPrecompressedInput(model->input_size(), shard->rng);
 
-	auto onSuccess = [this, model_index](std::vector<uint8_t> &output) {
-		engine->InferComplete(this, model_index);
-	};
+	// Inputs live as long as the input generator, so are sent without copying.
+	// Timeouts run at their intended time, so a shard that falls behind is charged for it
+	model->infer(generated.data(), generated.size(), &completions[model_index], shard->now);
+}
 
-	auto onError = [this, model_index](int status, std::string message) {
-		engine->InferError(this, model_index, status);
-	};
+void Workload::SetTimeout(uint64_t timeout, std::function<void(void)> callback) {
+	shard->SetTimeout(timeout, callback);
+}
 
-	model->infer(input, onSuccess, onError, true);
+void Workload::Post(std::function<void(void)> callback) {
+	shard->Post(callback);
 }
 
-void Workload::SetTimeout(uint64_t timeout, std::function<void(void)> callback) {
-	engine->SetTimeout(timeout, callback);
+
+void Completion::success(uint8_t* output, size_t output_size) {
+	workload->engine->InferComplete(workload, model_index);
 }
 
+void Completion::error(int status, std::string &message) {
+	workload->engine->InferError(workload, model_index, status);
+}
 
 void Workload::InferErrorInitializing(uint64_t now, unsigned model_index) {
 	InferError(now, model_index, clockworkInitializing);
@@ -1,6 +1,7 @@
 #ifndef _CLOCKWORK_WORKLOAD_WORKLOAD_H_
 #define _CLOCKWORK_WORKLOAD_WORKLOAD_H_
 
+#include <deque>
 #include <queue>
 #include <cstdint>
 #include <functional>
@@ -10,15 +11,22 @@
 #include "tbb/concurrent_queue.h"
 #include <random>
 #include "dmlc/logging.h"
+#include "clockwork/telemetry/histogram.h"
 
 namespace clockwork {
 namespace workload {
 
+class Engine;
 class Workload;
 
 typedef std::exponential_distribution<double> Exponential;
 
-class Engine {
+/*
+Runs a partition of an Engine's workloads on its own thread, with its own timers.
+All of a workload's timeouts and infer results are processed by its shard's thread,
+so workloads don't need to synchronize.
+*/
+class Shard {
 private:
 	struct element {
 		uint64_t ready;
@@ -32,17 +40,67 @@ private:
 		}
 	};
 
-	uint64_t now = util::now();
+	// Sleeps overshoot by tens of microseconds, so spin if the next timeout is sooner
+	static const uint64_t spin_threshold = 100000UL;
+
+	// Results are processed between batches of timeouts, even when behind
+	static const unsigned max_timeouts_per_poll = 64;
+
+	// Handling a result can submit a request, whose result can arrive before the queue is
+	// drained; bounded so that timeouts aren't starved
+	static const unsigned max_results_per_poll = 1024;
+
+	struct result {
+		Workload* workload;
+		unsigned model_index;
+		int status;
+	};
+
+	tbb::concurrent_queue<result> results;
 	tbb::concurrent_queue<std::function<void(void)>> runqueue;
 	std::priority_queue<element, std::vector<element>, std::greater<element>> queue;
+
+public:
+	const unsigned id;
+	Engine* engine;
+
+	// While a timeout runs, the time it was intended to run; otherwise the current time
+	uint64_t now = util::now();
+	std::minstd_rand rng;
+
+	// From when each timeout was intended to run until it ran
+	Histogram lag;
+
+	Shard(unsigned id, Engine* engine);
+
+	void SetTimeout(uint64_t timeout, std::function<void(void)> callback);
+
+	// Runs callback on this shard's thread; can be called from any thread
+	void Post(std::function<void(void)> callback);
+
+	// Passes an infer result to workload on this shard's thread; can be called from any thread
+	void Complete(Workload* workload, unsigned model_index, int status);
+
+	void Run();
+
+};
+
+class Engine {
+private:
+	std::vector<Shard*> shards;
 	std::vector<Workload*> workloads;
+	uint64_t print_interval = 10000000000UL;
 
 public:
 	std::atomic_int running = 0;
-	util::InputGenerator input_generator;
+	util::InputGenerator* input_generator = nullptr;
+
+	// Workloads are partitioned across num_shards threads; by default, get_client_generator_threads()
+	Engine();
+	Engine(unsigned num_shards);
+	~Engine();
 
 	void AddWorkload(Workload* workload, uint64_t start_after = 0);
-	void SetTimeout(uint64_t timeout, std::function<void(void)> callback);
 	void InferComplete(Workload* workload, unsigned model_index);
 	void InferError(Workload* workload, unsigned model_index, int status);
 
@@ -50,12 +108,26 @@ public:
 
 };
 
+// Passes a model's infer results to its workload.  Each model has one, used by all its requests
+class Completion : public clockwork::InferCallback {
+public:
+	Workload* workload;
+	unsigned model_index;
+
+	Completion(Workload* workload, unsigned model_index) : workload(workload), model_index(model_index) {}
+
+	void success(uint8_t* output, size_t output_size);
+	void error(int status, std::string &message);
+};
+
 class Workload {
 public:
 	std::vector<clockwork::Model*> models;
+	std::deque<Completion> completions; // a deque, so that models can be added while requests are outstanding
 
 	int user_id;
 	Engine* engine;
+	Shard* shard = nullptr;
 	uint64_t start_after = 0;
 	uint64_t stop_after = UINT64_MAX;
 
@@ -72,6 +144,9 @@ public:
 	void Infer(unsigned model_index = 0);
 	void SetTimeout(uint64_t timeout, std::function<void(void)> callback);
 
+	// Runs callback on this workload's shard; for timers that adjust other workloads
+	void Post(std::function<void(void)> callback);
+
 	// Methods to be implemented by subclasses
 	virtual void Start(uint64_t now) = 0;
 	virtual void InferComplete(uint64_t now, unsigned model_index) = 0;
@@ -516,8 +591,9 @@ public:
 		try_termination();
 
 		std::cout << ">>>> Updating scale_factor to " << current << std::endl;
+		Exponential distribution(current / 60000000000.0);
 		for (auto workload : workloads) {
-			workload->set_distribution(Exponential(current / 60000000000.0));
+			workload->Post([workload, distribution]() { workload->set_distribution(distribution); });
 		}
 
 		SetTimeout(period, [this]() { update_scale_factor(); });
@@ -585,8 +661,9 @@ public:
 		try_termination();
 
 		std::cout << "Updating rate to " << current << std::endl;
+		Exponential distribution(current / 1000000000.0);
 		for (auto workload : workloads) {
-			workload->set_distribution(Exponential(current / 1000000000.0));
+			workload->Post([workload, distribution]() { workload->set_distribution(distribution); });
 		}
 
 		SetTimeout(period, [this]() { UpdateRate(); });
@@ -615,8 +692,9 @@ public:
 		try_termination();
 
 		std::cout << "Updating rate to " << current << std::endl;
+		Static distribution(1000000000.0 / current);
 		for (auto workload : workloads) {
-			workload->set_distribution(Static(1000000000.0 / current));
+			workload->Post([workload, distribution]() { workload->set_distribution(distribution); });
 		}
 
 		if (previous == 0) { Start(util::now()); }
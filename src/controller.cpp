@@ -5,6 +5,8 @@
 #include "clockwork/controller/concurrent_infer_and_load_scheduler.h"
 #include "clockwork/controller/infer5/infer5_scheduler.h"
 #include "clockwork/telemetry/controller_request_logger.h"
+#include "clockwork/network/metrics_server.h"
+#include "clockwork/telemetry/trace.h"
 #include <csignal>
 #include <sstream>
 #include <string>
@@ -57,6 +59,14 @@ void show_usage() {
     s << "       default_slo        (int, default 100000000)  The default SLO to use if client's don't specify slo_factor.  Default 100ms\n";
     s << "       max_exec        (int, default 25000000)  Don't use batch sizes >1, whose exec time exceeds this number.  Default 25ms \n";
     s << "       max_batch        (int, default 16)  Don't use batch sizes that exceed this number.  Default 16. \n";
+    s << "       admission_threads        (int, default 4)  Number of threads admitting requests, sharded by model id.  Default 4. \n";
+    s << "       tenants        (string, default \"\")  Fair-share weights and reserved GPU shares per client user_id, as user_id:weight[:reserved],...  Unlisted tenants have weight 1.  e.g. 0:2:0.25,1:1 \n";
+    s << "       forecast_interval        (int, default 0)  Bucket size for per-model arrival forecasts used to prefetch weights into spare GPU pages, e.g. 60000000000 for 1 minute.  Default 0 disables prefetching. \n";
+    s << "       hedge_budget        (float, default 0)  Fraction of exec time that may be spent duplicating late batches on another GPU with the model loaded; the first result wins.  0 disables hedging. \n";
+    s << "       early_rejection        (bool, default false)  Reject requests at admission, with a retry-after hint, if they are predicted to miss their deadline.  Prediction precision and recall are reported either way. \n";
+    s << "       autotune        (bool, default false)  Tune schedule_ahead, latest_delta, max_exec and max_batch at runtime from observed load, worker lag and SLO attainment.  max_exec and max_batch are only lowered below their configured values.  Adjustments are logged to clockwork_tuning_log.tsv. \n";
+    s << "       result_cache_mb        (int, default 0)  Memory bound, in MB, for caching the results of requests with identical inputs.  Identical requests that arrive while one is executing share its result.  0 disables the cache. \n";
+    s << "       result_cache_ttl        (int, default 10000000000)  How long, in nanoseconds, a cached result may be reused.  Default 10s. \n";
     s << "WORKERS\n";
     s << "  Comma-separated list of worker host:port pairs.  e.g.:                        \n";
     s << "    volta03:12345,volta04:12345,volta05:12345                                   \n";
@@ -103,10 +113,24 @@ int main(int argc, char *argv[]) {
         worker_host_port_pairs.push_back({p[0], p[1]});
     }
 
-    int client_requests_listen_port = 12346;
+    int client_requests_listen_port = util::get_controller_port();
 
-    std::string actions_filename = util::get_controller_log_dir() + "/clockwork_action_log.tsv";
-    std::string requests_filename = util::get_controller_log_dir() + "/clockwork_request_log.tsv";
+    // Live metrics, if CLOCKWORK_CONTROLLER_METRICS_PORT is set
+    int metrics_port = util::get_controller_metrics_port();
+    if (metrics_port != 0) {
+        network::add_metrics(metrics::registry());
+        new network::MetricsServer(metrics_port);
+    }
+
+    // Trace spans, if CLOCKWORK_TRACE_DIR is set
+    std::string trace_file = util::get_trace_file("clockwork_controller");
+    if (trace_file != "") {
+        trace::start(trace_file, "controller");
+    }
+
+    std::string actions_filename = util::get_controller_log_dir() + "/clockwork_action_log" + util::get_controller_log_extension();
+    std::string requests_filename = util::get_controller_log_dir() + "/clockwork_request_log" + util::get_controller_log_extension();
+    std::string profile_cache_filename = util::get_controller_log_dir() + "/clockwork_profile_cache.tsv";
 
     if (controller_type == "DIRECT") {
         DirectControllerImpl* controller = new DirectControllerImpl(client_requests_listen_port, worker_host_port_pairs);
@@ -153,8 +177,19 @@ int main(int argc, char *argv[]) {
         uint64_t default_slo = argc > ++i ? std::stoull(argv[i]) : 100000000UL;
         uint64_t max_exec_time = argc > ++i ? std::stoull(argv[i]) : 250000000UL;
         int max_batch_size = argc > ++i ? atoi(argv[i]) : 8;
+        unsigned admission_threads = argc > ++i ? atoi(argv[i]) : 4;
+        std::string tenants = argc > ++i ? argv[i] : "";
+        uint64_t forecast_interval = argc > ++i ? std::stoull(argv[i]) : 0;
+        double hedge_budget = argc > ++i ? std::stod(argv[i]) : 0;
+        bool early_rejection = argc > ++i ? atoi(argv[i]) != 0 : false;
+        bool autotune = argc > ++i ? atoi(argv[i]) != 0 : false;
+        std::string tuning_filename = autotune ? util::get_controller_log_dir() + "/clockwork_tuning_log.tsv" : "";
+        size_t result_cache_mb = argc > ++i ? std::stoull(argv[i]) : 0;
+        uint64_t result_cache_ttl = argc > ++i ? std::stoull(argv[i]) : 10000000000UL;
         std::cout << "Logging requests to " << requests_filename << std::endl;
         std::cout << "Logging actions to " << actions_filename << std::endl;
+        ModelProfileCache* profile_cache = new ModelProfileCache(profile_cache_filename);
+        std::cout << "Loaded " << profile_cache->load() << " model profiles from " << profile_cache_filename << std::endl;
         Scheduler* scheduler = new scheduler::infer5::Scheduler(
             default_slo,
             schedule_ahead, schedule_ahead,
@@ -162,13 +197,22 @@ int main(int argc, char *argv[]) {
             max_gpus,
             max_exec_time,
             max_batch_size,
-            actions_filename
+            actions_filename,
+            admission_threads,
+            profile_cache,
+            tenants,
+            forecast_interval,
+            hedge_budget,
+            early_rejection,
+            tuning_filename,
+            result_cache_mb * 1024 * 1024,
+            result_cache_ttl
         );
         controller::ControllerWithStartupPhase* controller = new controller::ControllerWithStartupPhase(
             client_requests_listen_port,
             worker_host_port_pairs,
             1000000000UL, // 10s load stage timeout
-            new controller::ControllerStartup(max_batch_size, max_exec_time), // in future the startup type might be customizable
+            new controller::ControllerStartup(max_batch_size, max_exec_time, profile_cache), // in future the startup type might be customizable
             scheduler,
             ControllerRequestTelemetry::log_and_summarize(
                 requests_filename,     // 
@@ -1,38 +1,58 @@
 #include <string>
 #include <vector>
-#include <unordered_map>
+#include <atomic>
 #include <iostream>
+#include <thread>
 #include "clockwork/telemetry.h"
 #include "clockwork/common.h"
-#include <fstream>
-#include <sstream>
+#include "clockwork/telemetry/columnar.h"
+#include "clockwork/telemetry/inflater.h"
+#include <dmlc/logging.h>
 #include <pods/pods.h>
 #include <pods/binary.h>
 #include <pods/buffers.h>
-#include <pods/streams.h>
 
-/** Inflates output clockwork telemetry to TSV file */
-void inflate_task(std::string input_filename, std::string output_filename)
-{
-    std::ifstream infile;
-    infile.open(input_filename);
+using namespace clockwork::inflater;
 
-    pods::InputStream in(infile);
-    pods::BinaryDeserializer<decltype(in)> deserializer(in);
+/* Records deserialized per chunk; chunks are formatted in parallel */
+const unsigned records_per_chunk = 65536;
 
-    uint64_t start_time = 0;
+/** Calls next until it has read records_per_chunk records or reaches the end of the file */
+template <typename T, typename Deserializer>
+bool next_records(Deserializer &deserializer, std::vector<T> &chunk)
+{
+    chunk.reserve(records_per_chunk);
+    T t;
+    while (chunk.size() < records_per_chunk && deserializer.load(t) == pods::Error::NoError)
+    {
+        chunk.push_back(t);
+    }
+    return !chunk.empty();
+}
 
-    clockwork::SerializedTaskTelemetry t;
-    int count = 0;
+void write_headers(FILE* out, std::vector<std::string> &headers)
+{
+    std::string line;
+    RowFormatter row(line);
+    for (auto &header : headers)
+    {
+        row.add(header);
+    }
+    row.end_row();
+    fwrite(line.data(), 1, line.size(), out);
+}
 
+/** Inflates output clockwork telemetry to TSV file */
+uint64_t inflate_task(const MappedFile &in, FILE* out, Filter &filter, unsigned threads)
+{
     std::vector<std::string> headers = {{"action_id",
                                          "action_type",
-										 "task_type",
-										 "executor_id",
-										 "gpu_id",
-										 "status",
+                                         "task_type",
+                                         "executor_id",
+                                         "gpu_id",
+                                         "status",
                                          "model_id",
-										 "batch_size",
+                                         "batch_size",
                                          "enqueued",
                                          "eligible_for_dequeue",
                                          "dequeued",
@@ -42,142 +62,89 @@ void inflate_task(std::string input_filename, std::string output_filename)
                                          "async_duration",
                                          "queue_latency",
                                          "total_latency"}};
-
-    std::vector<std::unordered_map<std::string, std::string>> rows;
-    while (deserializer.load(t) == pods::Error::NoError)
-    {
-        std::unordered_map<std::string, std::string> row;
-
-		row["action_type"] = std::to_string(t.action_type);
-		row["task_type"] = std::to_string(t.task_type);
-        row["action_id"] = std::to_string(t.action_id);
-        row["status"] = std::to_string(t.status);
-        row["executor_id"] = std::to_string(t.executor_id);
-        row["gpu_id"] = std::to_string(t.gpu_id);
-        row["model_id"] = std::to_string(t.model_id);
-        row["batch_size"] = std::to_string(t.batch_size);
-        row["enqueued"] = std::to_string(t.enqueued);
-        row["eligible_for_dequeue"] = std::to_string(t.eligible_for_dequeue);
-        row["dequeued"] = std::to_string(t.dequeued);
-        row["exec_complete"] = std::to_string(t.exec_complete);
-        row["async_complete"] = std::to_string(t.async_complete);
-        row["async_wait"] = std::to_string(t.async_wait);
-        row["async_duration"] = std::to_string(t.async_duration);
-        row["queue_latency"] = std::to_string(t.dequeued - t.enqueued);
-        row["total_latency"] = std::to_string(t.async_complete - t.enqueued);
-
-        rows.push_back(row);
-    }
-    std::cout << "Processed " << rows.size() << " records" << std::endl;
-
-    std::ofstream outfile;
-    outfile.open(output_filename);
-
-    int i = 0;
-    for (auto header : headers)
-    {
-        if (i++ > 0)
-        {
-            outfile << "\t";
-        }
-        outfile << header;
-    }
-    outfile << "\n";
-
-    for (auto row : rows)
-    {
-        i = 0;
-        for (auto header : headers)
-        {
-            if (i++ > 0)
-                outfile << "\t";
-            if (row.find(header) != row.end())
-                outfile << row[header];
-        }
-        outfile << "\n";
-    }
-
-    outfile.close();
+    write_headers(out, headers);
+
+    pods::InputBuffer buffer(in.data, in.size);
+    pods::BinaryDeserializer<pods::InputBuffer> deserializer(buffer);
+
+    std::atomic_uint64_t count(0);
+    typedef std::vector<clockwork::SerializedTaskTelemetry> Chunk;
+    format_parallel<Chunk>(
+        [&deserializer] (Chunk &chunk) { return next_records(deserializer, chunk); },
+        [&filter, &count] (Chunk &chunk, std::string &formatted) {
+            RowFormatter row(formatted);
+            for (auto &t : chunk)
+            {
+                if (!filter.time_matches(t.enqueued) ||
+                    !filter.model_matches(t.model_id) ||
+                    !filter.action_type_matches(t.action_type)) continue;
+
+                row.add(t.action_id);
+                row.add(t.action_type);
+                row.add(t.task_type);
+                row.add(t.executor_id);
+                row.add(t.gpu_id);
+                row.add(t.status);
+                row.add(t.model_id);
+                row.add(t.batch_size);
+                row.add(t.enqueued);
+                row.add(t.eligible_for_dequeue);
+                row.add(t.dequeued);
+                row.add(t.exec_complete);
+                row.add(t.async_complete);
+                row.add(t.async_wait);
+                row.add(t.async_duration);
+                row.add(t.dequeued - t.enqueued);
+                row.add(t.async_complete - t.enqueued);
+                row.end_row();
+                count++;
+            }
+        },
+        out, threads);
+    return count;
 }
 
-void inflate_action(std::string input_filename, std::string output_filename)
+uint64_t inflate_action(const MappedFile &in, FILE* out, Filter &filter, unsigned threads)
 {
-    std::ifstream infile;
-    infile.open(input_filename);
-
-    pods::InputStream in(infile);
-    pods::BinaryDeserializer<decltype(in)> deserializer(in);
-
-    uint64_t start_time = 0;
-
-    clockwork::SerializedActionTelemetry t;
-    int count = 0;
+    CHECK(!filter.by_model()) << "Action telemetry has no model_id to filter by";
 
     std::vector<std::string> headers = {{"telemetry_type",
-										"action_id",
-										 "action_type",
-										 "status",
-										 "timestamp"}};
-
-
-    std::vector<std::unordered_map<std::string, std::string>> rows;
-    while (deserializer.load(t) == pods::Error::NoError)
-    {
-        std::unordered_map<std::string, std::string> row;
-
-		row["telemetry_type"] = std::to_string(t.telemetry_type);
-		row["action_id"] = std::to_string(t.action_id);
-		row["action_type"] = std::to_string(t.action_type);
-		row["status"] = std::to_string(t.status);
-		row["timestamp"] = std::to_string(t.timestamp);
-
-		rows.push_back(row);
-    }
-
-    std::cout << "Processed " << rows.size() << " records" << std::endl;
-
-    std::ofstream outfile;
-    outfile.open(output_filename);
-
-    int i = 0;
-    for (auto header : headers)
-    {
-        if (i++ > 0)
-        {
-            outfile << "\t";
-        }
-        outfile << header;
-    }
-    outfile << "\n";
-
-    for (auto row : rows)
-    {
-        i = 0;
-        for (auto header : headers)
-        {
-            if (i++ > 0)
-                outfile << "\t";
-            if (row.find(header) != row.end())
-                outfile << row[header];
-        }
-        outfile << "\n";
-    }
-
-    outfile.close();
+                                         "action_id",
+                                         "action_type",
+                                         "status",
+                                         "timestamp"}};
+    write_headers(out, headers);
+
+    pods::InputBuffer buffer(in.data, in.size);
+    pods::BinaryDeserializer<pods::InputBuffer> deserializer(buffer);
+
+    std::atomic_uint64_t count(0);
+    typedef std::vector<clockwork::SerializedActionTelemetry> Chunk;
+    format_parallel<Chunk>(
+        [&deserializer] (Chunk &chunk) { return next_records(deserializer, chunk); },
+        [&filter, &count] (Chunk &chunk, std::string &formatted) {
+            RowFormatter row(formatted);
+            for (auto &t : chunk)
+            {
+                if (!filter.time_matches(t.timestamp) ||
+                    !filter.action_type_matches(t.action_type)) continue;
+
+                row.add(t.telemetry_type);
+                row.add(t.action_id);
+                row.add(t.action_type);
+                row.add(t.status);
+                row.add(t.timestamp);
+                row.end_row();
+                count++;
+            }
+        },
+        out, threads);
+    return count;
 }
 
-void inflate_request(std::string input_filename, std::string output_filename)
+uint64_t inflate_request(const MappedFile &in, FILE* out, Filter &filter, unsigned threads)
 {
-    std::ifstream infile;
-    infile.open(input_filename);
-
-    pods::InputStream in(infile);
-    pods::BinaryDeserializer<decltype(in)> deserializer(in);
-
-    uint64_t start_time = 0;
-
-    clockwork::SerializedRequestTelemetry t;
-    int count = 0;
+    CHECK(!filter.by_action_type()) << "Request telemetry has no action_type to filter by";
 
     std::vector<std::string> headers = {{
         "request_id",
@@ -197,83 +164,152 @@ void inflate_request(std::string input_filename, std::string output_filename)
         headers.push_back(task_type + "_sync");
         headers.push_back(task_type + "_async");
     }
-
-    std::vector<std::unordered_map<std::string, std::string>> rows;
-    while (deserializer.load(t) == pods::Error::NoError)
-    {
-        std::unordered_map<std::string, std::string> row;
-
-        row["request_id"] = std::to_string(t.request_id);
-        row["model_id"] = std::to_string(t.model_id);
-        row["arrived"] = std::to_string(t.arrived);
-        row["submitted"] = std::to_string(t.submitted);
-        row["complete"] = std::to_string(t.complete);
-        row["execution_latency"] = std::to_string(t.complete - t.submitted);
-        row["total_latency"] = std::to_string(t.complete - t.arrived);
-
-        for (unsigned i = 0; i < t.tasks.size(); i++)
-        {
-            clockwork::SerializedTaskTelemetry task = t.tasks[i];
-            std::string task_type = clockwork::TaskTypeName(clockwork::TaskTypes[task.task_type]);
-
-            if (i < t.tasks.size() - 1)
-            {
-                row[task_type] = std::to_string(t.tasks[i + 1].enqueued - task.dequeued);
-            }
-            else
+    write_headers(out, headers);
+
+    pods::InputBuffer buffer(in.data, in.size);
+    pods::BinaryDeserializer<pods::InputBuffer> deserializer(buffer);
+
+    std::atomic_uint64_t count(0);
+    typedef std::vector<clockwork::SerializedRequestTelemetry> Chunk;
+    format_parallel<Chunk>(
+        [&deserializer] (Chunk &chunk) { return next_records(deserializer, chunk); },
+        [&filter, &count] (Chunk &chunk, std::string &formatted) {
+            // Four columns per task type; a task type may not appear in a request
+            unsigned num_task_columns = 4 * clockwork::TaskTypes.size();
+            std::vector<uint64_t> values(num_task_columns);
+            std::vector<bool> present(num_task_columns);
+
+            RowFormatter row(formatted);
+            for (auto &t : chunk)
             {
-                row[task_type] = std::to_string(t.complete - task.dequeued);
+                if (!filter.time_matches(t.arrived) || !filter.model_matches(t.model_id)) continue;
+
+                row.add(t.request_id);
+                row.add(t.model_id);
+                row.add(t.arrived);
+                row.add(t.submitted);
+                row.add(t.complete);
+                row.add(t.complete - t.submitted);
+                row.add(t.complete - t.arrived);
+
+                std::fill(present.begin(), present.end(), false);
+                for (unsigned i = 0; i < t.tasks.size(); i++)
+                {
+                    clockwork::SerializedTaskTelemetry &task = t.tasks[i];
+                    unsigned column = 4 * task.task_type;
+                    CHECK(column < num_task_columns) << "Unknown task type " << task.task_type;
+
+                    if (i < t.tasks.size() - 1)
+                    {
+                        values[column] = t.tasks[i + 1].enqueued - task.dequeued;
+                    }
+                    else
+                    {
+                        values[column] = t.complete - task.dequeued;
+                    }
+                    values[column + 1] = task.dequeued - task.eligible_for_dequeue;
+                    values[column + 2] = task.exec_complete - task.dequeued;
+                    values[column + 3] = task.async_duration;
+                    for (unsigned j = 0; j < 4; j++)
+                    {
+                        present[column + j] = true;
+                    }
+                }
+
+                for (unsigned i = 0; i < num_task_columns; i++)
+                {
+                    if (present[i]) row.add(values[i]);
+                    else row.skip();
+                }
+                row.end_row();
+                count++;
             }
-            row[task_type + "_queue"] = std::to_string(task.dequeued - task.eligible_for_dequeue);
-            row[task_type + "_sync"] = std::to_string(task.exec_complete - task.dequeued);
-            row[task_type + "_async"] = std::to_string(task.async_duration);
-        }
-
-        rows.push_back(row);
-    }
-    std::cout << "Processed " << rows.size() << " records" << std::endl;
+        },
+        out, threads);
+    return count;
+}
 
-    std::ofstream outfile;
-    outfile.open(output_filename);
+uint64_t inflate_columnar(std::string input_filename, FILE* out, Filter &filter, unsigned threads)
+{
+    using namespace clockwork::columnar;
+    Reader reader(input_filename);
+    auto &columns = reader.columns();
 
-    int i = 0;
-    for (auto header : headers)
+    // Filter by time on the t column, or failing that, the first timestamp
+    int time_column = reader.column("t");
+    for (unsigned i = 0; time_column < 0 && i < columns.size(); i++)
     {
-        if (i++ > 0)
-        {
-            outfile << "\t";
-        }
-        outfile << header;
+        if (columns[i].type == timestamp) time_column = i;
     }
-    outfile << "\n";
-
-    for (auto row : rows)
+    int model_column = reader.column("model_id");
+    int action_type_column = reader.column("action_type");
+    CHECK(!filter.by_time() || time_column >= 0) << input_filename << " has no timestamps to filter by";
+    CHECK(!filter.by_model() || model_column >= 0) << input_filename << " has no model_id to filter by";
+    CHECK(!filter.by_action_type() || action_type_column >= 0) << input_filename << " has no action_type to filter by";
+
+    std::vector<std::string> headers;
+    for (auto &column : columns)
     {
-        i = 0;
-        for (auto header : headers)
-        {
-            if (i++ > 0)
-                outfile << "\t";
-            if (row.find(header) != row.end())
-                outfile << row[header];
-        }
-        outfile << "\n";
+        headers.push_back(column.name);
     }
-
-    outfile.close();
+    write_headers(out, headers);
+
+    // Chunks of the file are decoded in parallel
+    unsigned next_chunk = 0;
+    std::atomic_uint64_t count(0);
+    format_parallel<unsigned>(
+        [&reader, &next_chunk] (unsigned &index) {
+            index = next_chunk++;
+            return index < reader.num_chunks();
+        },
+        [&] (unsigned &index, std::string &formatted) {
+            Reader::Chunk chunk;
+            reader.read(index, chunk);
+
+            RowFormatter row(formatted);
+            for (unsigned r = 0; r < chunk.rows; r++)
+            {
+                if (time_column >= 0 && !filter.time_matches(chunk.get_int(time_column, r))) continue;
+                if (model_column >= 0 && !filter.model_matches(chunk.get_int(model_column, r))) continue;
+                if (action_type_column >= 0 && !filter.action_type_matches(chunk.get_int(action_type_column, r))) continue;
+
+                for (unsigned i = 0; i < columns.size(); i++)
+                {
+                    switch (columns[i].type)
+                    {
+                        case f32: case f64: row.add(chunk.get_float(i, r)); break;
+                        case timestamp: row.add((uint64_t) chunk.get_int(i, r)); break;
+                        default: row.add(chunk.get_int(i, r)); break;
+                    }
+                }
+                row.end_row();
+                count++;
+            }
+        },
+        out, threads);
+    return count;
 }
 
 void show_usage()
 {
     std::cout << "Inflates a binary format telemetry file into a TSV" << std::endl;
-    std::cout << "./inflate [input_file] [outputfile] [request/task/action]" << std::endl;
+    std::cout << "./inflate [options] [input_file] [outputfile] [request/task/action]" << std::endl;
+    std::cout << "Columnar (.cwcol) files are detected automatically and need no type" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --from T          Only rows at or after time T, in nanoseconds" << std::endl;
+    std::cout << "  --to T            Only rows before time T, in nanoseconds" << std::endl;
+    std::cout << "  --model ID        Only rows for model ID" << std::endl;
+    std::cout << "  --action-type N   Only rows for action type N" << std::endl;
+    std::cout << "  --threads N       Format with N threads; default: one per core" << std::endl;
 }
 
 int main(int argc, char *argv[])
 {
     std::vector<std::string> non_argument_strings;
+    Filter filter;
+    unsigned threads = std::max(1U, std::thread::hardware_concurrency());
 
-    if (argc < 4)
+    if (argc < 2)
     {
         show_usage();
         return 0;
@@ -282,11 +318,32 @@ int main(int argc, char *argv[])
     for (int i = 1; i < argc; ++i)
     {
         std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
         if ((arg == "-h") || (arg == "--help"))
         {
             show_usage();
             return 0;
         }
+        else if (arg == "--from" && has_value)
+        {
+            filter.from = std::stoull(argv[++i]);
+        }
+        else if (arg == "--to" && has_value)
+        {
+            filter.to = std::stoull(argv[++i]);
+        }
+        else if (arg == "--model" && has_value)
+        {
+            filter.model_id = std::stoi(argv[++i]);
+        }
+        else if (arg == "--action-type" && has_value)
+        {
+            filter.action_type = std::stoi(argv[++i]);
+        }
+        else if (arg == "--threads" && has_value)
+        {
+            threads = std::max(1, std::stoi(argv[++i]));
+        }
         else
         {
             non_argument_strings.push_back(arg);
@@ -307,21 +364,47 @@ int main(int argc, char *argv[])
         output_filename = non_argument_strings[1];
     }
 
+    bool columnar = clockwork::columnar::is_columnar(input_filename);
+    std::string type = non_argument_strings.size() >= 3 ? non_argument_strings[2] : "";
+    if (!columnar && type != "request" && type != "task" && type != "action")
+    {
+        std::cerr << "Expected telemetry type, none given." << std::endl
+                  << "Execute with --help for usage information." << std::endl;
+        return 1;
+    }
+
     std::cout << "Inflating " << input_filename << std::endl
               << "       to " << output_filename << std::endl;
 
-    if (non_argument_strings[2] == std::string("request"))
+    FILE* out = fopen(output_filename.c_str(), "w");
+    CHECK(out != nullptr) << "Unable to open " << output_filename << " for writing";
+    std::vector<char> out_buffer(4 * 1024 * 1024);
+    setvbuf(out, out_buffer.data(), _IOFBF, out_buffer.size());
+
+    uint64_t count;
+    if (columnar)
     {
-        inflate_request(input_filename, output_filename);
+        count = inflate_columnar(input_filename, out, filter, threads);
     }
-    else if (non_argument_strings[2] == std::string("task"))
+    else
     {
-        inflate_task(input_filename, output_filename);
+        MappedFile in(input_filename);
+        if (type == "request")
+        {
+            count = inflate_request(in, out, filter, threads);
+        }
+        else if (type == "task")
+        {
+            count = inflate_task(in, out, filter, threads);
+        }
+        else
+        {
+            count = inflate_action(in, out, filter, threads);
+        }
     }
-	else if (non_argument_strings[2] == std::string("action"))
-	{
-		inflate_action(input_filename, output_filename);
-	}
+
+    fclose(out);
+    std::cout << "Processed " << count << " records" << std::endl;
 
     return 0;
 }
@@ -0,0 +1,84 @@
+#include "clockwork/controller/router.h"
+#include <csignal>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "clockwork/thread.h"
+#include "clockwork/util.h"
+
+using namespace clockwork;
+
+void signalHandler(int signum) {
+    std::cout << "Interrupt signal (" << signum << ") received." << std::endl;
+    std::cout << "Clockwork Router Exiting" << std::endl;
+    exit(signum);
+}
+
+void show_usage() {
+    std::stringstream s;
+    s << "USAGE:\n";
+    s << "  router [CONTROLLERS] [OPTIONS]\n";
+    s << "DESCRIPTION\n";
+    s << "  Run a front-end that shards models across several controllers.  Clients      \n";
+    s << "  connect to the router exactly as they would to a controller.  Each controller \n";
+    s << "  should be started with its own disjoint set of workers.  The router listens on\n";
+    s << "  CLOCKWORK_CONTROLLER_PORT (default 12346); controllers sharing a machine need  \n";
+    s << "  their own CLOCKWORK_CONTROLLER_PORT and CLOCKWORK_LOG_DIR.                     \n";
+    s << "CONTROLLERS\n";
+    s << "  Comma-separated list of controller host:port pairs.  e.g.:                    \n";
+    s << "    localhost:12347,localhost:12348                                             \n";
+    s << "OPTIONS\n";
+    s << "       replicas        (int, default 1)  Number of controllers each model is loaded on: its owner on the hash ring, then its successors.\n";
+    s << "       spill_threshold        (int, default 256)  Outstanding requests at which a controller is overloaded and requests spill to another replica.\n";
+    s << "  -h,  --help\n";
+    s << "        Print this message\n";
+    std::cout << s.str();
+}
+
+std::vector<std::string> split(std::string string, char delimiter = ',') {
+    std::stringstream ss(string);
+    std::vector<std::string> result;
+
+    while( ss.good() )
+    {
+        std::string substr;
+        getline( ss, substr, delimiter);
+        result.push_back( substr );
+    }
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2 || std::string(argv[1]) == "-h" || std::string(argv[1]) == "--help") {
+        show_usage();
+        return 1;
+    }
+
+    signal(SIGTERM, signalHandler);
+    signal(SIGINT, signalHandler);
+
+    threading::initProcess();
+
+    std::cout << "Starting Clockwork Router" << std::endl;
+
+    std::vector<std::pair<std::string, std::string>> controller_host_port_pairs;
+    for (std::string controller : split(argv[1])) {
+        std::vector<std::string> p = split(controller, ':');
+        controller_host_port_pairs.push_back({p[0], p[1]});
+    }
+
+    int i = 1;
+    unsigned replicas = argc > ++i ? atoi(argv[i]) : 1;
+    int spill_threshold = argc > ++i ? atoi(argv[i]) : 256;
+
+    controller::Router* router = new controller::Router(
+        util::get_controller_port(),
+        controller_host_port_pairs,
+        replicas,
+        spill_threshold
+    );
+    router->join();
+
+    std::cout << "Clockwork Router Exiting" << std::endl;
+}
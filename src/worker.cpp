@@ -1,5 +1,8 @@
 #include "clockwork/worker.h"
 #include "clockwork/network/worker.h"
+#include "clockwork/network/metrics_server.h"
+#include "clockwork/telemetry/trace.h"
+#include <unistd.h>
 #include "clockwork/runtime.h"
 #include "clockwork/config.h"
 #include "clockwork/worker.h"
@@ -49,10 +52,24 @@ int main(int argc, char *argv[]) {
 
 	ClockworkWorkerConfig config(config_file_path);
 
+	// Trace spans, if CLOCKWORK_TRACE_DIR is set
+	std::string trace_file = util::get_trace_file("clockwork_worker_" + std::to_string(getpid()));
+	if (trace_file != "") {
+		clockwork::trace::start(trace_file, "worker");
+	}
+
 	clockwork::ClockworkWorker* clockwork = new clockwork::ClockworkWorker(config);
 	clockwork::network::worker::Server* server = new clockwork::network::worker::Server(clockwork, port);
 	clockwork->controller = server;
 
+	// Live metrics, if CLOCKWORK_WORKER_METRICS_PORT is set
+	int metrics_port = util::get_worker_metrics_port();
+	if (metrics_port != 0) {
+		clockwork::network::add_metrics(clockwork::metrics::registry());
+		clockwork->runtime->add_metrics(clockwork::metrics::registry());
+		new clockwork::network::MetricsServer(metrics_port);
+	}
+
 	threading::setDefaultPriority(); // Revert thread priority
 	clockwork->join();
 
@@ -25,14 +25,14 @@ int action_id = -1;
 int model_id = -1;
 int batch_size = -1;
 uint64_t action_timestamp;
-tbb::concurrent_queue<std::shared_ptr<TaskTelemetry>> task_queue;
+tbb::concurrent_queue<TaskTelemetry> task_queue;
 
 class TestActionTelemetryLogger : public ActionTelemetryLogger {
 public:
-	void log(std::shared_ptr<ActionTelemetry> telemetry) {
+	void log(ActionTelemetry &telemetry) {
 		actions_logged ++;
-		action_id = telemetry->action_id;
-		action_timestamp = util::nanos(telemetry->timestamp);
+		action_id = telemetry.action_id;
+		action_timestamp = util::nanos(telemetry.timestamp);
 	}
 
 	void shutdown(bool awaitCompletion){}
@@ -41,11 +41,11 @@ public:
 
 class TestTaskTelemetryLogger : public TaskTelemetryLogger {
 public:
-	void log(std::shared_ptr<TaskTelemetry> telemetry) {
+	void log(TaskTelemetry &telemetry) {
 		tasks_logged ++;
-		action_id = telemetry->action_id;
-		model_id = telemetry->model_id;
-		batch_size = telemetry->batch_size;
+		action_id = telemetry.action_id;
+		model_id = telemetry.model_id;
+		batch_size = telemetry.batch_size;
 		task_queue.push(telemetry);
 	}
 
@@ -1,10 +1,155 @@
 #include <catch2/catch.hpp>
 
 #include <cstdlib>
+#include <mutex>
+#include <set>
+#include <thread>
 
 #include "clockwork/client.h"
 #include "clockwork/api/client_api.h"
 #include "clockwork/api/worker_api.h"
+#include "clockwork/workload/workload.h"
 
 TEST_CASE("Placeholder testclient.cpp", "[client]") {
-}
\ No newline at end of file
+}
+
+using namespace clockwork;
+
+// Only supports ls, which the engine calls before starting
+class LSClient : public Client {
+public:
+	Model* get_model(int model_id) { return nullptr; }
+	std::future<Model*> get_model_async(int model_id) { return {}; }
+	Model* upload_model(std::vector<uint8_t> &serialized_model) { return nullptr; }
+	std::future<Model*> upload_model_async(std::vector<uint8_t> &serialized_model) { return {}; }
+	Model* load_remote_model(std::string model_path) { return nullptr; }
+	std::future<Model*> load_remote_model_async(std::string model_path) { return {}; }
+	std::vector<Model*> load_remote_models(std::string model_path, int no_of_copies) { return {}; }
+	std::future<std::vector<Model*>> load_remote_models_async(std::string model_path, int no_of_copies) { return {}; }
+	ModelSet ls() { return {}; }
+	std::future<ModelSet> ls_async() { return {}; }
+};
+
+// Fires a fixed number of timeouts, recording the threads and intended times they ran at
+class CountingTimer : public workload::Timer {
+public:
+	uint64_t period;
+	unsigned remaining;
+	std::set<std::thread::id> threads;
+	std::vector<uint64_t> times;
+
+	CountingTimer(uint64_t period, unsigned count) : period(period), remaining(count) {}
+
+	void Tick() {
+		threads.insert(std::this_thread::get_id());
+		times.push_back(shard->now);
+		if (--remaining == 0) {
+			engine->running--;
+		} else {
+			SetTimeout(period, [this]() { Tick(); });
+		}
+	}
+
+	void Start(uint64_t now) {
+		SetTimeout(period, [this]() { Tick(); });
+	}
+};
+
+TEST_CASE("Sharded engine pins each workload to one generator thread", "[client] [workload]") {
+	unsigned num_shards = 4;
+	workload::Engine engine(num_shards);
+
+	std::vector<CountingTimer*> timers;
+	for (unsigned i = 0; i < 8; i++) {
+		timers.push_back(new CountingTimer(100000UL, 100));
+		engine.AddWorkload(timers.back());
+	}
+
+	LSClient client;
+	engine.Run(&client);
+
+	REQUIRE(engine.running == 0);
+
+	std::set<std::thread::id> all_threads;
+	for (unsigned i = 0; i < timers.size(); i++) {
+		CountingTimer* timer = timers[i];
+		REQUIRE(timer->remaining == 0);
+		REQUIRE(timer->times.size() == 100);
+
+		// Workloads are partitioned round-robin, and never move between threads
+		REQUIRE(timer->threads.size() == 1);
+		REQUIRE(timer->shard == timers[i % num_shards]->shard);
+		all_threads.insert(*timer->threads.begin());
+
+		// Timeouts run at their intended times, regardless of lag
+		for (unsigned j = 1; j < timer->times.size(); j++) {
+			REQUIRE(timer->times[j] - timer->times[j-1] == 100000UL);
+		}
+	}
+	REQUIRE(all_threads.size() == num_shards);
+
+	for (auto timer : timers) {
+		delete timer;
+	}
+}
+
+// Completes every request immediately, recording the buffers and callbacks it was given
+class ImmediateModel : public Model {
+public:
+	int user_id_ = 0;
+	std::set<const void*> inputs;
+	std::set<InferCallback*> callbacks;
+	unsigned count = 0;
+
+	int id() { return 0; }
+	std::string source() { return ""; }
+	size_t input_size() { return 12288; }
+	size_t output_size() { return 0; }
+	int user_id() { return user_id_; }
+	void set_user_id(int user_id) { user_id_ = user_id; }
+	void set_slo_factor(float slo_factor) {}
+	void disable_inputs() {}
+	std::vector<uint8_t> infer(std::vector<uint8_t> &input, bool compressed) { return {}; }
+	std::future<std::vector<uint8_t>> infer_async(std::vector<uint8_t> &input, bool compressed) { return {}; }
+	void infer(std::vector<uint8_t> &input,
+		std::function<void(std::vector<uint8_t>&)> onSuccess,
+		std::function<void(int, std::string&)> onError,
+		bool compressed, uint64_t intended_send) {
+		FAIL("Workloads should not copy their inputs");
+	}
+	void infer(const void* input, size_t input_size, InferCallback* callback, uint64_t intended_send) {
+		inputs.insert(input);
+		callbacks.insert(callback);
+		count++;
+		callback->success(nullptr, 0);
+	}
+	void evict() {}
+	std::future<void> evict_async() { return {}; }
+};
+
+TEST_CASE("Workloads submit borrowed inputs with reused callbacks", "[client] [workload]") {
+	workload::Engine engine(2);
+
+	std::vector<ImmediateModel*> models;
+	std::vector<workload::ClosedLoop*> workloads;
+	for (unsigned i = 0; i < 4; i++) {
+		models.push_back(new ImmediateModel());
+		workloads.push_back(new workload::ClosedLoop(i, models.back(), 1, 1000, 0));
+		engine.AddWorkload(workloads.back());
+	}
+
+	LSClient client;
+	engine.Run(&client);
+
+	for (unsigned i = 0; i < models.size(); i++) {
+		REQUIRE(models[i]->count == 1001);
+
+		// One callback per model, and inputs sent from the generator's own buffers
+		REQUIRE(models[i]->callbacks.size() == 1);
+		REQUIRE(*models[i]->callbacks.begin() == &workloads[i]->completions[0]);
+		REQUIRE(models[i]->inputs.size() <= 20);
+
+		delete workloads[i];
+		delete models[i];
+	}
+}
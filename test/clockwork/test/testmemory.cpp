@@ -292,4 +292,67 @@ TEST_CASE("CUDAHostMemoryPool", "[mempool]") {
 
     CUDAHostMemoryPool* pool = CUDAHostMemoryPool::create(1000);
     delete pool;
-}
\ No newline at end of file
+}
+TEST_CASE("ModelStore events since seqno", "[modelstore]") {
+    using namespace clockwork;
+
+    ModelStore store;
+
+    store.weights_loaded(1, 0);
+    store.weights_loaded(2, 0);
+    store.weights_evicted(1, 0);
+    REQUIRE(store.seqno == 3);
+
+    // seqno 0 always gets a snapshot
+    workerapi::GetWorkerStateResult snapshot;
+    snapshot.worker.page_size = 16;
+    store.get_state(0, snapshot);
+    REQUIRE(snapshot.is_snapshot);
+    REQUIRE(snapshot.seqno == 3);
+    REQUIRE(snapshot.events.size() == 0);
+
+    workerapi::GetWorkerStateResult delta;
+    delta.worker.page_size = 16;
+    store.get_state(1, delta);
+    REQUIRE(!delta.is_snapshot);
+    REQUIRE(delta.seqno == 3);
+    REQUIRE(delta.events.size() == 2);
+    REQUIRE(delta.events[0].seqno == 2);
+    REQUIRE(delta.events[0].type == workerapi::modelLoadedEvent);
+    REQUIRE(delta.events[0].model_id == 2);
+    REQUIRE(delta.events[1].seqno == 3);
+    REQUIRE(delta.events[1].type == workerapi::modelEvictedEvent);
+    REQUIRE(delta.events[1].model_id == 1);
+
+    workerapi::GetWorkerStateResult uptodate;
+    store.get_state(3, uptodate);
+    REQUIRE(!uptodate.is_snapshot);
+    REQUIRE(uptodate.events.size() == 0);
+
+    // After invalidating, old seqnos can only get a snapshot
+    store.invalidate_events();
+    workerapi::GetWorkerStateResult invalidated;
+    store.get_state(3, invalidated);
+    REQUIRE(invalidated.is_snapshot);
+    REQUIRE(invalidated.seqno == 4);
+}
+
+TEST_CASE("ModelStore retains bounded events", "[modelstore]") {
+    using namespace clockwork;
+
+    ModelStore store;
+    for (unsigned i = 0; i < ModelStore::max_retained_events + 10; i++) {
+        store.weights_loaded(i, 0);
+    }
+    REQUIRE(store.events.size() == ModelStore::max_retained_events);
+
+    workerapi::GetWorkerStateResult gap;
+    store.get_state(5, gap);
+    REQUIRE(gap.is_snapshot);
+
+    workerapi::GetWorkerStateResult delta;
+    store.get_state(10, delta);
+    REQUIRE(!delta.is_snapshot);
+    REQUIRE(delta.events.size() == ModelStore::max_retained_events);
+    REQUIRE(delta.events[0].seqno == 11);
+}
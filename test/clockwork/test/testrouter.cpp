@@ -0,0 +1,259 @@
+#include <catch2/catch.hpp>
+#include <deque>
+#include <map>
+#include <set>
+#include "clockwork/controller/hash_ring.h"
+#include "clockwork/controller/router.h"
+
+using namespace clockwork::controller;
+
+TEST_CASE("Hash ring owners are distinct and start with the owner", "[router]") {
+    HashRing ring(4);
+
+    for (unsigned i = 0; i < 100; i++) {
+        std::string key = "/models/model-" + std::to_string(i);
+        std::vector<unsigned> owners = ring.owners(key, 3);
+
+        REQUIRE(owners.size() == 3);
+        REQUIRE(owners[0] == ring.owner(key));
+        REQUIRE(std::set<unsigned>(owners.begin(), owners.end()).size() == 3);
+        for (unsigned owner : owners) {
+            REQUIRE(owner < 4);
+        }
+    }
+
+    // Can't have more replicas than shards
+    REQUIRE(ring.owners("/models/model-0", 10).size() == 4);
+}
+
+TEST_CASE("Hash ring spreads keys evenly", "[router]") {
+    HashRing ring(4);
+
+    std::map<unsigned, unsigned> counts;
+    for (unsigned i = 0; i < 4000; i++) {
+        counts[ring.owner("/models/model-" + std::to_string(i))]++;
+    }
+
+    REQUIRE(counts.size() == 4);
+    for (auto &p : counts) {
+        REQUIRE(p.second > 700);
+        REQUIRE(p.second < 1300);
+    }
+}
+
+TEST_CASE("Hash ring only moves keys of an added shard", "[router]") {
+    HashRing before(4);
+    HashRing after(5);
+
+    unsigned moved = 0;
+    for (unsigned i = 0; i < 4000; i++) {
+        std::string key = "/models/model-" + std::to_string(i);
+        unsigned owner = after.owner(key);
+        if (owner != before.owner(key)) {
+            // Keys only move to the new shard
+            REQUIRE(owner == 4);
+            moved++;
+        }
+    }
+
+    // Roughly a fifth of the keys move
+    REQUIRE(moved > 500);
+    REQUIRE(moved < 1100);
+}
+
+/* Stands in for a controller connection.  Loads succeed immediately; inference requests
+are held until the test responds to them. */
+class StubController : public clockwork::clientapi::ClientAPI {
+public:
+    struct Pending {
+        clockwork::clientapi::InferenceRequest request;
+        std::function<void(clockwork::clientapi::InferenceResponse&)> callback;
+    };
+
+    int local_model_id; // returned by loadRemoteModel
+    std::deque<Pending> pending;
+
+    StubController(int local_model_id) : local_model_id(local_model_id) {}
+
+    void uploadModel(clockwork::clientapi::UploadModelRequest &request, std::function<void(clockwork::clientapi::UploadModelResponse&)> callback) {}
+
+    void infer(clockwork::clientapi::InferenceRequest &request, std::function<void(clockwork::clientapi::InferenceResponse&)> callback) {
+        pending.push_back({request, callback});
+    }
+
+    void evict(clockwork::clientapi::EvictRequest &request, std::function<void(clockwork::clientapi::EvictResponse&)> callback) {}
+
+    void loadRemoteModel(clockwork::clientapi::LoadModelFromRemoteDiskRequest &request, std::function<void(clockwork::clientapi::LoadModelFromRemoteDiskResponse&)> callback) {
+        clockwork::clientapi::LoadModelFromRemoteDiskResponse response;
+        response.header.user_request_id = request.header.user_request_id;
+        response.header.status = clockworkSuccess;
+        response.model_id = local_model_id;
+        response.copies_created = 1;
+        response.input_size = 10;
+        response.output_size = 20;
+        callback(response);
+    }
+
+    void ls(clockwork::clientapi::LSRequest &request, std::function<void(clockwork::clientapi::LSResponse&)> callback) {}
+
+    // Responds to the oldest held request as a controller would, echoing its header
+    void respond(int status) {
+        REQUIRE(!pending.empty());
+        Pending p = pending.front();
+        pending.pop_front();
+
+        clockwork::clientapi::InferenceResponse response;
+        response.header.user_request_id = p.request.header.user_request_id;
+        response.header.status = status;
+        response.model_id = p.request.model_id;
+        response.batch_size = p.request.batch_size;
+        response.output_size = 0;
+        response.output = nullptr;
+        p.callback(response);
+    }
+};
+
+// Loads a model through the router and returns its global id
+int load(Router &router, std::string remote_path) {
+    clockwork::clientapi::LoadModelFromRemoteDiskRequest request;
+    request.header.user_id = 0;
+    request.header.user_request_id = 0;
+    request.remote_path = remote_path;
+
+    int model_id = -1;
+    router.loadRemoteModel(request, [&model_id] (clockwork::clientapi::LoadModelFromRemoteDiskResponse &response) {
+        REQUIRE(response.header.status == clockworkSuccess);
+        model_id = response.model_id;
+    });
+    return model_id;
+}
+
+// Sends a request through the router; responses are appended to responses
+void infer(Router &router, int model_id, int user_request_id, std::vector<clockwork::clientapi::InferenceResponse> &responses) {
+    clockwork::clientapi::InferenceRequest request;
+    request.header.user_id = 0;
+    request.header.user_request_id = user_request_id;
+    request.model_id = model_id;
+    request.batch_size = 1;
+    request.input_size = 0;
+    request.input = nullptr;
+    request.slo_factor = 0;
+    router.infer(request, [&responses] (clockwork::clientapi::InferenceResponse &response) {
+        responses.push_back(response);
+    });
+}
+
+TEST_CASE("Router forwards requests to the owner and rewrites ids", "[router]") {
+    StubController a(7), b(7);
+    Router router({&a, &b});
+
+    std::string path = "/models/model-0";
+    StubController &owner = HashRing(2).owner(path) == 0 ? a : b;
+    StubController &other = &owner == &a ? b : a;
+
+    int model_id = load(router, path);
+    REQUIRE(model_id == 0);
+
+    // Two clients that happen to use the same user_request_id
+    std::vector<clockwork::clientapi::InferenceResponse> responses;
+    infer(router, model_id, 42, responses);
+    infer(router, model_id, 42, responses);
+    REQUIRE(other.pending.empty());
+    REQUIRE(owner.pending.size() == 2);
+    REQUIRE(owner.pending[0].request.model_id == 7);
+    REQUIRE(owner.pending[0].request.header.user_request_id != owner.pending[1].request.header.user_request_id);
+
+    owner.respond(clockworkSuccess);
+    owner.respond(clockworkSuccess);
+    REQUIRE(responses.size() == 2);
+    for (auto &response : responses) {
+        REQUIRE(response.header.status == clockworkSuccess);
+        REQUIRE(response.header.user_request_id == 42);
+        REQUIRE(response.model_id == model_id);
+    }
+
+    // Models the router doesn't know about are rejected without forwarding
+    infer(router, model_id + 1, 43, responses);
+    REQUIRE(responses.size() == 3);
+    REQUIRE(responses[2].header.status == clockworkInvalidRequest);
+    REQUIRE(responses[2].header.user_request_id == 43);
+    REQUIRE(owner.pending.empty());
+    REQUIRE(other.pending.empty());
+}
+
+TEST_CASE("Router spills to a replica once the owner is over spill_threshold", "[router]") {
+    StubController a(3), b(5);
+    Router router({&a, &b}, 2, 2);
+
+    std::string path = "/models/model-0";
+    StubController &owner = HashRing(2).owner(path) == 0 ? a : b;
+    StubController &replica = &owner == &a ? b : a;
+
+    int model_id = load(router, path);
+
+    std::vector<clockwork::clientapi::InferenceResponse> responses;
+    infer(router, model_id, 1, responses);
+    infer(router, model_id, 2, responses);
+    REQUIRE(owner.pending.size() == 2);
+    REQUIRE(replica.pending.empty());
+
+    // The owner has spill_threshold outstanding
+    infer(router, model_id, 3, responses);
+    REQUIRE(owner.pending.size() == 2);
+    REQUIRE(replica.pending.size() == 1);
+    REQUIRE(replica.pending[0].request.model_id == replica.local_model_id);
+
+    // Once the owner catches up, requests go back to it
+    owner.respond(clockworkSuccess);
+    infer(router, model_id, 4, responses);
+    REQUIRE(owner.pending.size() == 2);
+    REQUIRE(replica.pending.size() == 1);
+
+    replica.respond(clockworkSuccess);
+    owner.respond(clockworkSuccess);
+    owner.respond(clockworkSuccess);
+    REQUIRE(responses.size() == 4);
+    std::set<int> ids;
+    for (auto &response : responses) {
+        REQUIRE(response.model_id == model_id);
+        ids.insert(response.header.user_request_id);
+    }
+    REQUIRE(ids == std::set<int>({1, 2, 3, 4}));
+}
+
+TEST_CASE("Router retries rejected requests on an untried replica", "[router]") {
+    StubController a(3), b(5);
+    Router router({&a, &b}, 2);
+
+    std::string path = "/models/model-0";
+    StubController &owner = HashRing(2).owner(path) == 0 ? a : b;
+    StubController &replica = &owner == &a ? b : a;
+
+    int model_id = load(router, path);
+
+    // Rejected by the owner, then served by the replica under the same forwarded id
+    std::vector<clockwork::clientapi::InferenceResponse> responses;
+    infer(router, model_id, 10, responses);
+    int forwarded_id = owner.pending[0].request.header.user_request_id;
+    owner.respond(clockworkControllerRejected);
+    REQUIRE(responses.empty());
+    REQUIRE(replica.pending.size() == 1);
+    REQUIRE(replica.pending[0].request.model_id == replica.local_model_id);
+    REQUIRE(replica.pending[0].request.header.user_request_id == forwarded_id);
+
+    replica.respond(clockworkSuccess);
+    REQUIRE(responses.size() == 1);
+    REQUIRE(responses[0].header.status == clockworkSuccess);
+    REQUIRE(responses[0].header.user_request_id == 10);
+    REQUIRE(responses[0].model_id == model_id);
+
+    // Once every replica has rejected it, the rejection goes back to the client
+    infer(router, model_id, 11, responses);
+    owner.respond(clockworkControllerRejected);
+    replica.respond(clockworkControllerRejected);
+    REQUIRE(owner.pending.empty());
+    REQUIRE(replica.pending.empty());
+    REQUIRE(responses.size() == 2);
+    REQUIRE(responses[1].header.status == clockworkControllerRejected);
+    REQUIRE(responses[1].header.user_request_id == 11);
+}
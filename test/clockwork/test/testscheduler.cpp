@@ -0,0 +1,864 @@
+#include <catch2/catch.hpp>
+
+#include <unistd.h>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <random>
+#include <sstream>
+
+#include "clockwork/controller/infer5/action_registry.h"
+#include "clockwork/controller/infer5/request_log.h"
+#include "clockwork/controller/infer5/tenant_tracker.h"
+#include "clockwork/controller/infer5/arrival_forecaster.h"
+#include "clockwork/controller/infer5/load_tracker.h"
+#include "clockwork/controller/infer5/batch_planner.h"
+#include "clockwork/controller/infer5/parameter_tuner.h"
+#include "clockwork/controller/infer5/result_cache.h"
+#include "clockwork/controller/infer5/scheduling_policy.h"
+#include "clockwork/controller/infer5/infer5_scheduler.h"
+#include "clockwork/controller/profile_cache.h"
+#include "clockwork/controller/controller.h"
+
+TEST_CASE("Action registry insert and take", "[scheduler]") {
+    using namespace clockwork::scheduler::infer5;
+
+    ActionRegistry<int> registry(16);
+    REQUIRE(registry.capacity() == 16);
+
+    for (unsigned i = 0; i < 10; i++) {
+        registry.insert(i, i % 3, 100 + i);
+    }
+
+    for (unsigned i = 0; i < 10; i++) {
+        unsigned owner;
+        REQUIRE(registry.owner(i, owner));
+        REQUIRE(owner == i % 3);
+    }
+
+    for (unsigned i = 0; i < 10; i++) {
+        int value;
+        REQUIRE(registry.take(i, value));
+        REQUIRE(value == 100 + i);
+
+        // Can only be taken once
+        REQUIRE(!registry.take(i, value));
+
+        unsigned owner;
+        REQUIRE(!registry.owner(i, owner));
+    }
+}
+
+TEST_CASE("Action registry rejects stale generations", "[scheduler]") {
+    using namespace clockwork::scheduler::infer5;
+
+    ActionRegistry<int> registry(4);
+
+    // Action 1 and action 5 share a slot
+    registry.insert(1, 0, 1);
+
+    int value;
+    unsigned owner;
+    REQUIRE(!registry.take(5, value));
+    REQUIRE(!registry.owner(5, owner));
+
+    REQUIRE(registry.take(1, value));
+    REQUIRE(value == 1);
+
+    registry.insert(5, 0, 5);
+    REQUIRE(!registry.take(1, value));
+    REQUIRE(registry.take(5, value));
+    REQUIRE(value == 5);
+}
+
+TEST_CASE("Action registry overflows when a slot is still occupied", "[scheduler]") {
+    using namespace clockwork::scheduler::infer5;
+
+    ActionRegistry<int> registry(4);
+
+    // Action 1's result never arrives; actions 5 and 9 share its slot
+    registry.insert(1, 0, 1);
+    registry.insert(5, 1, 5);
+    registry.insert(9, 2, 9);
+    REQUIRE(registry.overflow_count() == 2);
+
+    int value;
+    unsigned owner;
+    REQUIRE(registry.owner(9, owner));
+    REQUIRE(owner == 2);
+    REQUIRE(registry.take(5, value));
+    REQUIRE(value == 5);
+    REQUIRE(!registry.take(5, value));
+    REQUIRE(registry.take(9, value));
+    REQUIRE(value == 9);
+    REQUIRE(registry.overflow_count() == 0);
+
+    // Action 1 is still in its slot
+    REQUIRE(registry.take(1, value));
+    REQUIRE(value == 1);
+    registry.insert(13, 0, 13);
+    REQUIRE(registry.overflow_count() == 0);
+}
+
+TEST_CASE("Action registry concurrent insert and take", "[scheduler]") {
+    using namespace clockwork::scheduler::infer5;
+
+    unsigned num_threads = 4;
+    unsigned per_thread = 100000;
+    ActionRegistry<std::shared_ptr<unsigned>> registry(1 << 20);
+    std::atomic_uint64_t seed(0);
+    std::atomic_uint64_t taken(0);
+
+    // Each thread registers and then removes its own actions, interleaved with other threads
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < num_threads; t++) {
+        threads.push_back(std::thread([&, t]() {
+            for (unsigned i = 0; i < per_thread; i++) {
+                uint64_t id = seed++;
+                registry.insert(id, t, std::make_shared<unsigned>(t));
+
+                unsigned owner;
+                if (!registry.owner(id, owner) || owner != t) continue;
+
+                std::shared_ptr<unsigned> value;
+                if (registry.take(id, value) && *value == t) taken++;
+            }
+        }));
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    REQUIRE(taken == num_threads * per_thread);
+}
+
+TEST_CASE("Request log matches replicated queues", "[scheduler] [requestlog]") {
+    using namespace clockwork::scheduler::infer5;
+
+    std::vector<unsigned> batch_sizes = {1, 2, 4, 8, 16};
+    RequestLog<uint64_t> log(batch_sizes.size());
+    ReplicatedRequestQueues<uint64_t> reference(batch_sizes.size());
+
+    std::mt19937_64 rng(0);
+    uint64_t now = 0;
+    uint64_t next_id = 0;
+    unsigned dequeued = 0;
+
+    for (unsigned round = 0; round < 20000; round++) {
+        // Arrivals; most requests share an SLO but some have a much looser one
+        unsigned arrivals = rng() % 6;
+        for (unsigned i = 0; i < arrivals; i++) {
+            uint64_t slo = (rng() % 10 == 0) ? 50000 : 10000;
+            uint64_t deadline = now + slo + (rng() % 1000);
+            uint64_t id = next_id++;
+            REQUIRE(log.push(id, deadline) == reference.push(id, deadline));
+        }
+        now += rng() % 2000;
+
+        // Same steps as Model::try_dequeue
+        for (unsigned i = 0; i < batch_sizes.size(); i++) {
+            uint64_t completion = now + 1000 * batch_sizes[i];
+            log.drop_expired(i, completion);
+            reference.drop_expired(i, completion);
+            REQUIRE(log.size(i) == reference.size(i));
+            if (log.size(i) > 0) {
+                REQUIRE(log.front(i) == reference.front(i));
+                REQUIRE(log.front_deadline(i) == reference.front_deadline(i));
+            }
+        }
+
+        unsigned i = 0;
+        while (i < batch_sizes.size() - 1 && log.size(i+1) >= batch_sizes[i+1]) i++;
+        if (log.size(i) < batch_sizes[i] || rng() % 3 == 0) {
+            log.trim();
+            continue;
+        }
+
+        std::vector<uint64_t> taken, expected;
+        uint64_t seqno = log.take(i, batch_sizes[i], taken);
+        REQUIRE(seqno == reference.take(i, batch_sizes[i], expected));
+        REQUIRE(taken == expected);
+        dequeued += taken.size();
+
+        log.catch_up(seqno);
+        reference.catch_up(seqno);
+        log.trim();
+
+        for (unsigned i = 0; i < batch_sizes.size(); i++) {
+            REQUIRE(log.size(i) == reference.size(i));
+        }
+    }
+
+    // Make sure the trace actually exercised batching and expiry
+    REQUIRE(dequeued > 0);
+    REQUIRE(dequeued < next_id);
+}
+
+TEST_CASE("Tenant tracker penalizes tenants over their share", "[scheduler] [tenants]") {
+    using namespace clockwork::scheduler::infer5;
+
+    uint64_t ms = 1000000UL;
+    TenantTracker tenants(10 * ms);
+    uint64_t now = 1000 * ms;
+
+    // A single active tenant is never penalized
+    tenants.arrived(0, now);
+    tenants.charge(0, 50 * ms);
+    tenants.refresh(now);
+    REQUIRE(tenants.penalty(0) == 0);
+    REQUIRE(tenants.demand_scale(0) == 1.0);
+
+    // Tenant 1 uses 4ms of GPU for every 1ms used by tenant 0
+    tenants.arrived(1, now);
+    now += 100 * ms;
+    tenants.arrived(0, now);
+    tenants.arrived(1, now);
+    tenants.charge(0, 1 * ms);
+    tenants.charge(1, 4 * ms);
+    tenants.refresh(now);
+    REQUIRE(tenants.penalty(0) == 0);
+    REQUIRE(tenants.penalty(1) > 0);
+    REQUIRE(tenants.demand_scale(1) < 1.0);
+
+    // The penalty is capped
+    tenants.charge(1, 1000 * ms);
+    tenants.refresh(now);
+    REQUIRE(tenants.penalty(1) == 10 * ms);
+    REQUIRE(tenants.demand_scale(1) == 0.5);
+
+    // Tenant 0 goes idle and comes back without credit for the time away
+    now += 2000 * ms;
+    tenants.arrived(1, now);
+    tenants.charge(1, 5000 * ms);
+    tenants.refresh(now);
+    tenants.arrived(0, now);
+    tenants.charge(0, 2 * ms);
+    tenants.charge(1, 1 * ms);
+    tenants.refresh(now);
+    REQUIRE(tenants.penalty(0) == 1 * ms);
+    REQUIRE(tenants.penalty(1) == 0);
+}
+
+TEST_CASE("Tenant tracker weights and reservations", "[scheduler] [tenants]") {
+    using namespace clockwork::scheduler::infer5;
+
+    uint64_t ms = 1000000UL;
+    uint64_t now = 1000 * ms;
+
+    // Tenant 0 is entitled to twice as much as tenant 1
+    TenantTracker weighted(100 * ms);
+    weighted.configure("0:2,1:1");
+    weighted.arrived(0, now);
+    weighted.arrived(1, now);
+    weighted.charge(0, 20 * ms);
+    weighted.charge(1, 10 * ms);
+    weighted.refresh(now);
+    REQUIRE(weighted.penalty(0) == 0);
+    REQUIRE(weighted.penalty(1) == 0);
+
+    weighted.charge(0, 20 * ms);
+    weighted.refresh(now);
+    REQUIRE(weighted.penalty(0) == 10 * ms);
+    REQUIRE(weighted.penalty(1) == 0);
+
+    // Tenant 0 is ahead, but hasn't yet received its reserved 75%
+    TenantTracker reserved(100 * ms);
+    reserved.configure("0:1:0.75");
+    reserved.arrived(0, now);
+    reserved.arrived(1, now);
+    reserved.charge(0, 20 * ms);
+    reserved.charge(1, 10 * ms);
+    reserved.refresh(now);
+    REQUIRE(reserved.penalty(0) == 0);
+
+    reserved.charge(0, 90 * ms);
+    reserved.refresh(now);
+    REQUIRE(reserved.penalty(0) == 100 * ms);
+}
+
+TEST_CASE("Tenant tracker exports per-tenant metrics", "[scheduler] [tenants]") {
+    using namespace clockwork::scheduler::infer5;
+
+    uint64_t ms = 1000000UL;
+    uint64_t now = 1000 * ms;
+
+    TenantTracker tenants(10 * ms);
+    tenants.arrived(0, now);
+    tenants.arrived(1, now);
+    tenants.charge(0, 250 * ms);
+    tenants.charge(1, 750 * ms);
+    tenants.refresh(now);
+
+    std::stringstream out;
+    clockwork::metrics::Writer writer(out);
+    tenants.collect_metrics(writer);
+    std::string scraped = out.str();
+
+    REQUIRE(scraped.find("clockwork_tenant_charged_seconds_total{tenant=\"0\"} 0.25\n") != std::string::npos);
+    REQUIRE(scraped.find("clockwork_tenant_share{tenant=\"1\"} 0.75\n") != std::string::npos);
+    REQUIRE(scraped.find("clockwork_tenant_penalty_seconds{tenant=\"1\"} 0.01\n") != std::string::npos);
+
+    // Tenants that never made a request aren't exported
+    REQUIRE(scraped.find("tenant=\"2\"") == std::string::npos);
+}
+
+TEST_CASE("Arrival forecaster detects periodic demand", "[scheduler] [forecast]") {
+    using namespace clockwork::scheduler::infer5;
+
+    uint64_t bucket = 1000;
+    ArrivalForecaster forecaster(2, bucket, 0);
+
+    // Model 0 has a burst of 100 requests every 12 buckets; model 1 has a steady 5
+    uint64_t now = 0;
+    for (unsigned i = 0; i < 190; i++) {
+        unsigned burst = (i % 12 == 11) ? 100 : 0;
+        for (unsigned j = 0; j < burst; j++) forecaster.arrived(0);
+        for (unsigned j = 0; j < 5; j++) forecaster.arrived(1);
+
+        now += bucket;
+        REQUIRE(forecaster.refresh(now));
+        REQUIRE(!forecaster.refresh(now));
+    }
+
+    REQUIRE(forecaster.period(0) == 12);
+    REQUIRE(forecaster.period(1) == 0);
+
+    // 190 buckets closed; bucket 190 is not a burst, bucket 191 is
+    REQUIRE(forecaster.forecast(0) < 25);
+    REQUIRE(forecaster.forecast(1) == Approx(5));
+
+    std::vector<int64_t> forecasts = forecaster.forecasts();
+    REQUIRE(forecasts.size() == 2);
+    REQUIRE(forecasts[1] == 5);
+
+    now += bucket;
+    forecaster.refresh(now);
+    REQUIRE(forecaster.forecast(0) >= 75);
+
+    // Elapsed buckets with no refresh had no arrivals
+    now += 100 * bucket;
+    forecaster.refresh(now);
+    REQUIRE(forecaster.forecast(1) < 1);
+}
+
+TEST_CASE("Arrival forecaster only considers periods up to max_period", "[scheduler] [forecast]") {
+    using namespace clockwork::scheduler::infer5;
+
+    // A burst every 12 buckets is detected; a burst every 200 buckets is beyond max_period
+    std::vector<double> short_period(ArrivalForecaster::max_history, 0);
+    std::vector<double> long_period(ArrivalForecaster::max_history, 0);
+    for (unsigned i = 0; i < ArrivalForecaster::max_history; i++) {
+        if (i % 12 == 11) short_period[i] = 100;
+        if (i % 200 == 199) long_period[i] = 100;
+    }
+
+    REQUIRE(ArrivalForecaster::detect_period(short_period) == 12);
+    REQUIRE(ArrivalForecaster::detect_period(long_period) == 0);
+}
+
+TEST_CASE("Load tracker prefetches and evicts by forecast", "[scheduler] [forecast]") {
+    using namespace clockwork::scheduler::infer5;
+
+    LoadTracker tracker(1, 3, 100000000UL);
+    std::vector<ModelLoadTracker*> models = {
+        tracker.newModelTracker(0, 1),
+        tracker.newModelTracker(1, 1),
+        tracker.newModelTracker(2, 10)
+    };
+
+    // No forecasts, nothing to prefetch
+    REQUIRE(tracker.prefetchModel(0, 2) == -1);
+
+    // Model 2 has the most forecast demand but doesn't fit
+    tracker.updateForecasts({5, 0, 20});
+    REQUIRE(tracker.prefetchModel(0, 2) == 0);
+    REQUIRE(tracker.prefetchModel(0, 1) == -1);
+
+    tracker.updateForecasts({5, 1, 20});
+    REQUIRE(tracker.prefetchModel(0, 1) == 1);
+
+    for (auto &model : models) {
+        model->loadComplete(0, true);
+    }
+    tracker.process(models[0]);
+    tracker.process(models[1]);
+
+    // Model 1 was loaded more recently but has less forecast demand
+    REQUIRE(tracker.evictModel(0) == 1);
+    REQUIRE(tracker.evictModel(0) == 0);
+    REQUIRE(tracker.evictModel(0) == -1);
+}
+
+TEST_CASE("Batch planner chooses between split, pad and wait", "[scheduler] [batching]") {
+    using namespace clockwork::scheduler::infer5;
+
+    uint64_t ms = 1000000UL;
+    std::vector<unsigned> batch_sizes = {1, 2, 4, 8, 16};
+    std::vector<uint64_t> estimates = {3 * ms, 4 * ms, 6 * ms, 10 * ms, 18 * ms};
+    std::vector<uint64_t> slack(5, 0);
+
+    // Nothing queued
+    BatchPlan plan = plan_batch(batch_sizes, estimates, {0, 0, 0, 0, 0}, slack, 0, 2 * ms);
+    REQUIRE(plan.choice == BatchPlan::none);
+
+    plan = plan_batch(batch_sizes, estimates, {1, 1, 0, 0, 0}, slack, 0, 2 * ms);
+    REQUIRE(plan.choice == BatchPlan::split);
+    REQUIRE(plan.index == 0);
+    REQUIRE(plan.count == 1);
+
+    // 9 requests: 8+1 is cheaper than a padded 16
+    plan = plan_batch(batch_sizes, estimates, {9, 9, 9, 9, 9}, slack, 0, 2 * ms);
+    REQUIRE(plan.choice == BatchPlan::split);
+    REQUIRE(plan.index == 3);
+    REQUIRE(plan.count == 8);
+
+    // 12 requests on a model where b16 is cheap: pad
+    std::vector<uint64_t> cheap = {3 * ms, 4 * ms, 6 * ms, 10 * ms, 12 * ms};
+    plan = plan_batch(batch_sizes, cheap, {12, 12, 12, 12, 12}, slack, 0, 2 * ms);
+    REQUIRE(plan.choice == BatchPlan::pad);
+    REQUIRE(plan.index == 4);
+    REQUIRE(plan.count == 12);
+
+    // ... unless a request would miss its deadline in the padded batch
+    plan = plan_batch(batch_sizes, cheap, {12, 12, 12, 12, 11}, slack, 0, 2 * ms);
+    REQUIRE(plan.choice == BatchPlan::split);
+    REQUIRE(plan.index == 3);
+
+    // Requests arriving every 0.1ms will fill b16 in 0.7ms
+    slack[4] = 1 * ms;
+    plan = plan_batch(batch_sizes, estimates, {9, 9, 9, 9, 9}, slack, 100000UL, 2 * ms);
+    REQUIRE(plan.choice == BatchPlan::wait);
+    REQUIRE(plan.index == 4);
+    REQUIRE(plan.count == 16);
+
+    // Not enough slack, or too long a wait
+    slack[4] = 500000UL;
+    plan = plan_batch(batch_sizes, estimates, {9, 9, 9, 9, 9}, slack, 100000UL, 2 * ms);
+    REQUIRE(plan.choice == BatchPlan::split);
+    slack[4] = 10 * ms;
+    plan = plan_batch(batch_sizes, estimates, {9, 9, 9, 9, 9}, slack, 100000UL, 500000UL);
+    REQUIRE(plan.choice == BatchPlan::split);
+}
+
+TEST_CASE("Hedged requests respond once", "[scheduler] [hedging]") {
+    using namespace clockwork;
+    using Request = scheduler::infer5::Scheduler::RequestImpl;
+
+    clientapi::InferenceRequest request;
+    request.header.user_request_id = 0;
+    request.input = nullptr;
+    auto callback = [](clientapi::InferenceResponse &response) {};
+
+    // Primary fails while the hedge is outstanding; the hedge responds
+    Request failed(nullptr, request, callback);
+    failed.attempt();
+    failed.attempt();
+    REQUIRE(!failed.claim(false));
+    REQUIRE(!failed.is_claimed());
+    REQUIRE(failed.claim(true));
+
+    // First success wins
+    Request raced(nullptr, request, callback);
+    raced.attempt();
+    raced.attempt();
+    REQUIRE(raced.claim(true));
+    REQUIRE(raced.is_claimed());
+    REQUIRE(!raced.claim(true));
+
+    // Both fail; the last error responds
+    Request both(nullptr, request, callback);
+    both.attempt();
+    both.attempt();
+    REQUIRE(!both.claim(false));
+    REQUIRE(both.claim(false));
+
+    // Unhedged requests respond with whatever comes back
+    Request single(nullptr, request, callback);
+    single.attempt();
+    REQUIRE(single.claim(false));
+}
+
+TEST_CASE("Parameter tuner adjusts with hysteresis and bounds", "[scheduler] [tuning]") {
+    using namespace clockwork::scheduler::infer5;
+
+    ParameterTuner tuner(10000000UL, 10000000UL, 25000000UL, 16);
+
+    ParameterTuner::Observation busy;
+    busy.met = 1000;
+    busy.infer_actions = 100;
+    busy.utilization = 0.9;
+    busy.mean_lag = 5000000UL;
+
+    // Busy and keeping up: schedule further ahead, but only once the signal persists
+    REQUIRE(tuner.update(busy).empty());
+    REQUIRE(tuner.update(busy).empty());
+    auto adjustments = tuner.update(busy);
+    REQUIRE(adjustments.size() == 1);
+    REQUIRE(adjustments[0].parameter == "schedule_ahead");
+    REQUIRE(adjustments[0].before == 10000000UL);
+    REQUIRE(adjustments[0].after == 12500000UL);
+
+    // Then hold for the cooldown
+    for (unsigned i = 0; i < ParameterTuner::cooldown + ParameterTuner::patience - 1; i++) {
+        REQUIRE(tuner.update(busy).empty());
+    }
+    REQUIRE(tuner.update(busy).size() == 1);
+    REQUIRE(tuner.schedule_ahead.value == 15625000UL);
+
+    // Too few requests to act on
+    ParameterTuner::Observation quiet = busy;
+    quiet.met = 10;
+    for (unsigned i = 0; i < 20; i++) {
+        REQUIRE(tuner.update(quiet).empty());
+    }
+
+    // Missing SLOs while idle: smaller batches, down to the bounds
+    ParameterTuner::Observation idle;
+    idle.met = 500;
+    idle.missed = 500;
+    idle.infer_actions = 100;
+    idle.utilization = 0.1;
+    idle.mean_lag = 5000000UL;
+    for (unsigned i = 0; i < 200; i++) {
+        tuner.update(idle);
+    }
+    REQUIRE(tuner.max_batch.value == 1);
+    REQUIRE(tuner.max_exec.value == 25000000UL / 8);
+    REQUIRE(tuner.schedule_ahead.value == 2000000UL);
+
+    // Workers dropping actions: more slack for late actions, up to the bound
+    ParameterTuner::Observation dropping = busy;
+    dropping.infer_errors = 10;
+    for (unsigned i = 0; i < 200; i++) {
+        tuner.update(dropping);
+    }
+    REQUIRE(tuner.latest_delta.value == 40000000UL);
+    REQUIRE(tuner.max_batch.value == 1);
+}
+
+TEST_CASE("Result cache hits, joins in-flight requests and evicts", "[scheduler] [resultcache]") {
+    using namespace clockwork;
+    using namespace clockwork::scheduler::infer5;
+
+    ResultCache cache(ResultCache::num_shards * 100, 1000);
+
+    char input[64];
+    for (unsigned i = 0; i < sizeof(input); i++) input[i] = i;
+    auto key = ResultCache::key(3, input, sizeof(input));
+
+    // Same input, different model or different input: different keys
+    REQUIRE(key == ResultCache::key(3, input, sizeof(input)));
+    REQUIRE_FALSE(key == ResultCache::key(4, input, sizeof(input)));
+    input[63]++;
+    REQUIRE_FALSE(key == ResultCache::key(3, input, sizeof(input)));
+    input[63]--;
+
+    clientapi::InferenceRequest request;
+    request.header.user_request_id = 7;
+    request.model_id = 3;
+    request.batch_size = 1;
+
+    std::vector<clientapi::InferenceResponse> joined;
+    auto callback = [&joined] (clientapi::InferenceResponse &response) { joined.push_back(response); };
+
+    clientapi::InferenceResponse response;
+    REQUIRE(cache.lookup(key, 0, request, 100, callback, response) == ResultCache::miss);
+    request.header.user_request_id = 8;
+    REQUIRE(cache.lookup(key, 1, request, 101, callback, response) == ResultCache::joined);
+    REQUIRE(joined.size() == 0);
+
+    char output[50] = "result";
+    clientapi::InferenceResponse executed;
+    executed.header.user_request_id = 7;
+    executed.header.status = clockworkSuccess;
+    executed.model_id = 3;
+    executed.batch_size = 1;
+    executed.output_size = sizeof(output);
+    executed.output = output;
+    cache.complete(key, 10, executed);
+
+    REQUIRE(joined.size() == 1);
+    REQUIRE(joined[0].header.user_request_id == 8);
+    REQUIRE(joined[0].cache_status == ResultCache::joined);
+    REQUIRE(joined[0].deadline == 101);
+    REQUIRE(joined[0].output != output);
+    REQUIRE(std::string(static_cast<char*>(joined[0].output)) == "result");
+    free(joined[0].output);
+
+    request.header.user_request_id = 9;
+    REQUIRE(cache.lookup(key, 20, request, 120, callback, response) == ResultCache::hit);
+    REQUIRE(response.header.user_request_id == 9);
+    REQUIRE(response.header.status == clockworkSuccess);
+    REQUIRE(response.cache_status == ResultCache::hit);
+    REQUIRE(response.output_size == sizeof(output));
+    REQUIRE(std::string(static_cast<char*>(response.output)) == "result");
+    free(response.output);
+    REQUIRE(cache.size_bytes() == sizeof(output));
+
+    // Expired after the TTL; the next request executes again
+    REQUIRE(cache.lookup(key, 10 + 1000, request, 2000, callback, response) == ResultCache::miss);
+    REQUIRE(cache.size_bytes() == 0);
+
+    // Errors are shared with joined requests but not cached
+    REQUIRE(cache.lookup(key, 1100, request, 2100, callback, response) == ResultCache::joined);
+    executed.header.status = clockworkTimeout;
+    executed.output_size = 0;
+    executed.output = nullptr;
+    cache.complete(key, 1200, executed);
+    REQUIRE(joined.size() == 2);
+    REQUIRE(joined[1].header.status == clockworkTimeout);
+    REQUIRE(cache.size_bytes() == 0);
+    REQUIRE(cache.lookup(key, 1300, request, 2300, callback, response) == ResultCache::miss);
+    executed.header.status = clockworkSuccess;
+    executed.output_size = sizeof(output);
+    executed.output = output;
+    cache.complete(key, 1300, executed);
+
+    // Each shard holds at most 100 bytes; older entries are evicted to make room
+    std::vector<ResultCache::Key> keys = {key};
+    while (keys.size() < 4) {
+        input[0]++;
+        auto next = ResultCache::key(3, input, sizeof(input));
+        if (next.hi % ResultCache::num_shards != key.hi % ResultCache::num_shards) continue;
+        REQUIRE(cache.lookup(next, 1400, request, 2400, callback, response) == ResultCache::miss);
+        cache.complete(next, 1400, executed);
+        keys.push_back(next);
+    }
+    REQUIRE(cache.size_bytes() == 2 * sizeof(output));
+    REQUIRE(cache.evictions == 2);
+    REQUIRE(cache.lookup(keys[3], 1500, request, 2500, callback, response) == ResultCache::hit);
+    free(response.output);
+    REQUIRE(cache.lookup(keys[0], 1500, request, 2500, callback, response) == ResultCache::miss);
+}
+
+TEST_CASE("Deadline policy priorities, batching and prefetching", "[scheduler] [policy]") {
+    using namespace clockwork::scheduler::infer5;
+
+    DeadlinePolicy policy(true, 2000000UL);
+
+    // Earlier deadlines and longer batches first; tenants over their share go later
+    SchedulingPolicy::InferOption a = {0, 1, 100000000UL, 5000000UL, 0, 0};
+    SchedulingPolicy::InferOption b = {1, 4, 100000000UL, 20000000UL, 0, 0};
+    SchedulingPolicy::InferOption c = {2, 4, 100000000UL, 20000000UL, 1, 50000000UL};
+    REQUIRE(policy.infer_priority(b) < policy.infer_priority(a));
+    REQUIRE(policy.infer_priority(a) < policy.infer_priority(c));
+
+    SchedulingPolicy::BatchOptions options;
+    options.batch_sizes = {1, 2, 4};
+    options.exec_times = {4000000UL, 5000000UL, 6000000UL};
+    options.available = {3, 3, 3};
+    options.slack = {50000000UL, 50000000UL, 50000000UL};
+    options.interarrival = 0;
+    BatchPlan expected = plan_batch(options.batch_sizes, options.exec_times, options.available,
+                                    options.slack, 0, 2000000UL);
+    BatchPlan plan = policy.plan(options);
+    REQUIRE(plan.choice == expected.choice);
+    REQUIRE(plan.index == expected.index);
+    REQUIRE(plan.count == expected.count);
+
+    LoadTracker tracker(1, 2, 100000000UL);
+    tracker.newModelTracker(0, 1);
+    tracker.newModelTracker(1, 1);
+    tracker.updateForecasts({0, 5});
+
+    // With no outstanding demand, only prefetch while PCIe is idle
+    bool prefetch = true;
+    SchedulingPolicy::LoadOption option = {0, false, false, 4};
+    REQUIRE(policy.choose_load(&tracker, option, prefetch) == -1);
+    REQUIRE_FALSE(prefetch);
+    option.pcie_idle = true;
+    REQUIRE(policy.choose_load(&tracker, option, prefetch) == 1);
+    REQUIRE(prefetch);
+
+    DeadlinePolicy no_forecasts(false, 2000000UL);
+    REQUIRE(no_forecasts.choose_load(&tracker, option, prefetch) == -1);
+    REQUIRE_FALSE(prefetch);
+}
+
+TEST_CASE("Model profile cache round trip", "[scheduler] [profilecache]") {
+    using namespace clockwork;
+
+    std::string filename = "/tmp/clockwork_test_profile_cache.tsv";
+    std::remove(filename.c_str());
+
+    ModelProfileCache cache(filename);
+    REQUIRE(cache.load() == 0);
+
+    std::map<unsigned, uint64_t> exec_duration = {{1, 1000}, {2, 1800}};
+    cache.update("/models/resnet50", "Tesla V100", 1380, 5000, exec_duration);
+
+    // Later updates merge with earlier ones
+    std::map<unsigned, uint64_t> more = {{4, 3000}};
+    cache.update("/models/resnet50", "Tesla V100", 1380, 0, more);
+    cache.save();
+
+    ModelProfileCache reloaded(filename);
+    REQUIRE(reloaded.load() == 1);
+
+    ModelProfileCache::Entry entry;
+    REQUIRE(reloaded.lookup("/models/resnet50", "Tesla V100", 1380, entry));
+    REQUIRE(entry.weights_transfer_duration == 5000);
+    REQUIRE(entry.exec_duration.size() == 3);
+    REQUIRE(entry.exec_duration[1] == 1000);
+    REQUIRE(entry.exec_duration[2] == 1800);
+    REQUIRE(entry.exec_duration[4] == 3000);
+
+    // Different GPU model or clock is a miss
+    REQUIRE(!reloaded.lookup("/models/resnet50", "Tesla T4", 1380, entry));
+    REQUIRE(!reloaded.lookup("/models/resnet50", "Tesla V100", 1530, entry));
+
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("Model profile cache warm starts state", "[scheduler] [profilecache]") {
+    using namespace clockwork;
+
+    ModelProfileCache cache("/tmp/clockwork_test_profile_cache_unused.tsv");
+    std::map<unsigned, uint64_t> exec_duration = {{1, 1000}, {8, 4000}};
+    cache.update("/models/resnet50", "Tesla V100", 1380, 5000, exec_duration);
+
+    ClockworkState state;
+    WorkerState worker;
+    GPUState gpu;
+    gpu.name = "Tesla V100";
+    gpu.clock = 1200; // throttled; entries are keyed by the max clock
+    gpu.max_clock = 1380;
+    worker.gpus.push_back(gpu);
+    gpu.clock = 1380;
+    worker.gpus.push_back(gpu);
+
+    BatchedModelState model;
+    model.id = 0;
+    model.model_path = "/models/resnet50";
+    model.weights_transfer_duration = 0;
+    model.supported_batch_sizes = {1, 2};
+    model.exec_duration[1] = 0;
+    model.exec_duration[2] = 0;
+    worker.models[0] = model;
+
+    model.id = 1;
+    model.model_path = "/models/other";
+    worker.models[1] = model;
+
+    state.workers.push_back(worker);
+
+    REQUIRE(cache.apply(state) == 1);
+
+    auto &warm = state.workers[0].models[0];
+    REQUIRE(warm.weights_transfer_duration == 5000);
+    REQUIRE(warm.exec_duration[1] == 1000);
+    REQUIRE(warm.exec_duration[2] == 0); // not in cache
+    REQUIRE(warm.exec_duration.find(8) == warm.exec_duration.end()); // not supported
+
+    auto &cold = state.workers[0].models[1];
+    REQUIRE(cold.weights_transfer_duration == 0);
+    REQUIRE(cold.exec_duration[1] == 0);
+
+    // The cache isn't used if GPUs differ
+    ClockworkState mixed = state;
+    mixed.workers[0].models[0].weights_transfer_duration = 0;
+    mixed.workers[0].gpus[1].name = "Tesla T4";
+    std::string key_gpu;
+    unsigned key_clock;
+    REQUIRE(!ModelProfileCache::gpu_key(mixed, key_gpu, key_clock));
+    REQUIRE(cache.apply(mixed) == 0);
+    REQUIRE(mixed.workers[0].models[0].weights_transfer_duration == 0);
+
+    // Stale entries are ignored
+    ModelProfileCache stale("/tmp/clockwork_test_profile_cache_unused.tsv", 0);
+    stale.update("/models/resnet50", "Tesla V100", 1380, 5000, exec_duration);
+    usleep(1100000);
+    ModelProfileCache::Entry entry;
+    REQUIRE(!stale.lookup("/models/resnet50", "Tesla V100", 1380, entry));
+}
+
+TEST_CASE("Worker state deltas apply in order", "[scheduler] [workerstate]") {
+    using namespace clockwork;
+    using namespace clockwork::controller::startup;
+
+    QueryWorkerStage stage;
+    WorkerState worker;
+    uint64_t seqno = 0;
+
+    workerapi::GPUInfo gpuinfo;
+    gpuinfo.id = 0;
+    gpuinfo.weights_cache_size = 1024;
+    gpuinfo.weights_cache_total_pages = 64;
+    gpuinfo.models = {3};
+    gpuinfo.clock = 1380;
+
+    workerapi::ModelInfo modelinfo;
+    modelinfo.id = 3;
+    modelinfo.source = "/models/resnet50";
+    modelinfo.input_size = 10;
+    modelinfo.output_size = 10;
+    modelinfo.supported_batch_sizes = {1};
+    modelinfo.weights_size = 100;
+    modelinfo.num_weights_pages = 1;
+    modelinfo.weights_load_time_nanos = 1000;
+    modelinfo.batch_size_exec_times_nanos = {2000};
+
+    workerapi::GetWorkerStateResult snapshot;
+    snapshot.seqno = 5;
+    snapshot.is_snapshot = true;
+    snapshot.worker.gpus.push_back(gpuinfo);
+    snapshot.worker.models.push_back(modelinfo);
+
+    REQUIRE(stage.apply(worker, seqno, snapshot));
+    REQUIRE(seqno == 5);
+    REQUIRE(worker.models.size() == 1);
+    REQUIRE(worker.gpus[0].loaded_models == std::vector<unsigned>{3});
+
+    // A delta adds model 4, loads it, and evicts model 3
+    workerapi::GetWorkerStateResult delta;
+    delta.seqno = 8;
+    delta.is_snapshot = false;
+    gpuinfo.models.clear();
+    gpuinfo.clock = 1530;
+    delta.worker.gpus.push_back(gpuinfo);
+
+    workerapi::WorkerStateEvent added;
+    added.seqno = 6;
+    added.type = workerapi::modelAddedEvent;
+    added.model_id = 4;
+    added.gpu_id = 0;
+    added.model = modelinfo;
+    added.model.id = 4;
+    delta.events.push_back(added);
+
+    workerapi::WorkerStateEvent loaded;
+    loaded.seqno = 7;
+    loaded.type = workerapi::modelLoadedEvent;
+    loaded.model_id = 4;
+    loaded.gpu_id = 0;
+    delta.events.push_back(loaded);
+
+    workerapi::WorkerStateEvent evicted;
+    evicted.seqno = 8;
+    evicted.type = workerapi::modelEvictedEvent;
+    evicted.model_id = 3;
+    evicted.gpu_id = 0;
+    delta.events.push_back(evicted);
+
+    REQUIRE(stage.apply(worker, seqno, delta));
+    REQUIRE(seqno == 8);
+    REQUIRE(worker.models.size() == 2);
+    REQUIRE(worker.models[4].model_path == "/models/resnet50");
+    REQUIRE(worker.gpus[0].loaded_models == std::vector<unsigned>{4});
+    REQUIRE(worker.gpus[0].clock == 1530);
+
+    // Replaying the same delta is a gap, and leaves the state untouched
+    REQUIRE(!stage.apply(worker, seqno, delta));
+    REQUIRE(seqno == 8);
+    REQUIRE(worker.gpus[0].loaded_models == std::vector<unsigned>{4});
+
+    // Deltas without a prior snapshot cannot be applied
+    WorkerState fresh;
+    uint64_t fresh_seqno = 0;
+    delta.events.erase(delta.events.begin(), delta.events.end());
+    delta.seqno = 0;
+    REQUIRE(!stage.apply(fresh, fresh_seqno, delta));
+}
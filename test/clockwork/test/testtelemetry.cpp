@@ -1,4 +1,17 @@
 #include "telemetry.h"
+#include <sstream>
+#include <cstdio>
+#include <thread>
+#include "clockwork/telemetry/columnar.h"
+#include "clockwork/telemetry/telemetry_ring.h"
+#include "clockwork/telemetry/histogram.h"
+#include "clockwork/telemetry/metrics.h"
+#include "clockwork/telemetry/trace.h"
+#include "clockwork/telemetry/inflater.h"
+#include "clockwork/telemetry/sampling.h"
+#include "clockwork/telemetry/controller_request_logger.h"
+#include "clockwork/telemetry/controller_action_logger.h"
+#include "clockwork/controller/executor_tracker.h"
 
 using namespace clockwork;
 using namespace clockwork::model;
@@ -20,17 +33,17 @@ bool telemetry_in_range(
 				clockwork::time_point start,
 				clockwork::time_point end, bool evict) {
 	bool in_range = true;
-	std::shared_ptr<TaskTelemetry> srcTelemetry;
+	TaskTelemetry srcTelemetry;
 
 	if (!task_queue.try_pop(srcTelemetry))
 		usleep(10000);
 
-	in_range &= srcTelemetry->enqueued > start && srcTelemetry->enqueued < end;
-	in_range &= srcTelemetry->dequeued > start && srcTelemetry->dequeued < end;
-	in_range &= srcTelemetry->exec_complete > start && srcTelemetry->exec_complete < end;
+	in_range &= srcTelemetry.enqueued > start && srcTelemetry.enqueued < end;
+	in_range &= srcTelemetry.dequeued > start && srcTelemetry.dequeued < end;
+	in_range &= srcTelemetry.exec_complete > start && srcTelemetry.exec_complete < end;
 
 	if (!evict) {
-		in_range &= srcTelemetry->async_complete > start && srcTelemetry->async_complete < end;
+		in_range &= srcTelemetry.async_complete > start && srcTelemetry.async_complete < end;
 	}
 	return in_range;
 }
@@ -136,3 +149,455 @@ TEST_CASE("Action Telemetry", "[action_telemetry]"){
 	worker->shutdown(true);
 	delete worker;
 }
+
+TEST_CASE("Columnar telemetry round trip", "[telemetry] [columnar]") {
+	using namespace clockwork::columnar;
+
+	std::string filename = "/tmp/clockwork_test_columnar.cwcol";
+	for (bool compress : {true, false}) {
+		{
+			Writer writer(filename, {{"t", timestamp}, {"id", i32}, {"size", i64}, {"factor", f32}}, compress, 100);
+			for (unsigned i = 0; i < 250; i++) {
+				writer.set_int(0, 1600000000000000000UL + i * 1000);
+				writer.set_int(1, -(int) i);
+				writer.set_int(2, i * 1000000000UL);
+				if (i % 2 == 0) writer.set_float(3, i / 4.0);
+				writer.end_row();
+			}
+			writer.set_int(1, 7);
+			writer.end_row();
+		}
+		REQUIRE(is_columnar(filename));
+
+		Reader reader(filename);
+		REQUIRE(reader.columns().size() == 4);
+		REQUIRE(reader.column("factor") == 3);
+		REQUIRE(reader.column("missing") == -1);
+		REQUIRE(reader.num_chunks() == 3);
+		REQUIRE(reader.num_rows() == 251);
+
+		Reader::Chunk chunk;
+		unsigned i = 0;
+		for (unsigned index = 0; index < reader.num_chunks(); index++) {
+			reader.read(index, chunk);
+			for (unsigned row = 0; row < chunk.rows; row++, i++) {
+				if (i == 250) {
+					REQUIRE(chunk.get_int(0, row) == 0);
+					REQUIRE(chunk.get_int(1, row) == 7);
+					continue;
+				}
+				REQUIRE(chunk.get_int(0, row) == (int64_t) (1600000000000000000UL + i * 1000));
+				REQUIRE(chunk.get_int(1, row) == -(int) i);
+				REQUIRE(chunk.get_int(2, row) == (int64_t) (i * 1000000000UL));
+				REQUIRE(chunk.get_float(3, row) == (i % 2 == 0 ? i / 4.0 : 0));
+			}
+		}
+		REQUIRE(i == 251);
+
+		std::stringstream tsv;
+		reader.to_tsv(tsv);
+		std::string header, first;
+		std::getline(tsv, header);
+		std::getline(tsv, first);
+		REQUIRE(header == "t\tid\tsize\tfactor");
+		REQUIRE(first == "1600000000000000000\t0\t0\t0");
+	}
+	remove(filename.c_str());
+}
+
+TEST_CASE("Telemetry rings drain in order and count drops", "[telemetry] [ring]") {
+	TelemetryRings<int> rings(4);
+
+	for (int i = 0; i < 6; i++) {
+		REQUIRE(rings.log(i) == (i < 4));
+	}
+	REQUIRE(rings.dropped() == 2);
+
+	std::vector<int> drained;
+	REQUIRE(rings.drain([&drained] (int &i) { drained.push_back(i); }) == 4);
+	REQUIRE(drained == std::vector<int>({0, 1, 2, 3}));
+	REQUIRE(rings.drain([&drained] (int &i) { drained.push_back(i); }) == 0);
+
+	// Each producing thread gets its own ring
+	std::vector<std::thread> producers;
+	for (int t = 0; t < 4; t++) {
+		producers.emplace_back([&rings, t] {
+			for (int i = 0; i < 3; i++) {
+				rings.log(100 * (t + 1) + i);
+			}
+		});
+	}
+	for (auto &producer : producers) {
+		producer.join();
+	}
+
+	drained.clear();
+	REQUIRE(rings.drain([&drained] (int &i) { drained.push_back(i); }) == 12);
+	REQUIRE(rings.dropped() == 2);
+	for (unsigned i = 0; i < drained.size(); i++) {
+		if (drained[i] % 100 > 0) {
+			REQUIRE(drained[i - 1] == drained[i] - 1);
+		}
+	}
+}
+
+TEST_CASE("Histogram percentiles are within its precision", "[telemetry] [histogram]") {
+	for (uint64_t value : {0UL, 1UL, 63UL, 64UL, 65UL, 1000UL, 123456789UL, (1UL << 40) + 12345}) {
+		unsigned index = Histogram::bucket_index(value);
+		REQUIRE(Histogram::bucket_lowest(index) <= value);
+		REQUIRE(Histogram::bucket_highest(index) >= value);
+		REQUIRE(Histogram::bucket_highest(index) - Histogram::bucket_lowest(index) <= value >> Histogram::precision);
+	}
+
+	Histogram h;
+	REQUIRE(h.percentile(50) == 0);
+
+	// 1ms to 10ms, recorded concurrently
+	std::vector<std::thread> threads;
+	for (unsigned t = 0; t < 4; t++) {
+		threads.emplace_back([&h, t] {
+			for (uint64_t i = t; i < 10000; i += 4) {
+				h.record(1000000 + i * 900);
+			}
+		});
+	}
+	for (auto &thread : threads) {
+		thread.join();
+	}
+
+	REQUIRE(h.count() == 10000);
+	REQUIRE(h.min() == 1000000);
+	REQUIRE(h.max() == 1000000 + 9999 * 900);
+	REQUIRE(h.mean() == Approx(1000000 + 4999.5 * 900));
+	for (double p : {50.0, 99.0, 99.9}) {
+		double expected = 1000000 + (p / 100 * 10000 - 1) * 900;
+		REQUIRE(h.percentile(p) == Approx(expected).epsilon(1.0 / (1 << Histogram::precision)));
+	}
+	REQUIRE(h.percentile(100) == h.max());
+
+	Histogram merged;
+	merged.record(1);
+	merged.merge(h);
+	REQUIRE(merged.count() == 10001);
+	REQUIRE(merged.min() == 1);
+	REQUIRE(merged.max() == h.max());
+
+	Histogram drained;
+	h.drain_into(drained);
+	REQUIRE(h.count() == 0);
+	REQUIRE(h.percentile(99) == 0);
+	REQUIRE(drained.count() == 10000);
+	REQUIRE(drained.percentile(99) == merged.percentile(99));
+}
+
+TEST_CASE("Metrics are scraped in the Prometheus text format", "[telemetry] [metrics]") {
+	metrics::Registry registry;
+
+	Histogram latency;
+	latency.record(3000000); // 3ms
+	latency.record(20000000); // 20ms
+
+	unsigned id = registry.add([&latency] (metrics::Writer &writer) {
+		writer.counter("requests_total", "Requests", 7);
+		writer.gauge("queued", "Queued tasks", 2, {{"gpu", "0"}, {"type", "GPU"}});
+		writer.gauge("queued", "Queued tasks", 3, {{"gpu", "1"}, {"type", "GPU"}});
+		writer.histogram("latency_seconds", "Latency", latency);
+	});
+
+	std::string scraped = registry.scrape();
+	REQUIRE(scraped.find("# TYPE requests_total counter\nrequests_total 7\n") != std::string::npos);
+
+	// HELP and TYPE appear once per metric, however many label sets it has
+	REQUIRE(scraped.find("# TYPE queued gauge\n"
+		"queued{gpu=\"0\",type=\"GPU\"} 2\n"
+		"queued{gpu=\"1\",type=\"GPU\"} 3\n") != std::string::npos);
+
+	REQUIRE(scraped.find("# TYPE latency_seconds histogram\n") != std::string::npos);
+	REQUIRE(scraped.find("latency_seconds_bucket{le=\"0.001\"} 0\n") != std::string::npos);
+	REQUIRE(scraped.find("latency_seconds_bucket{le=\"0.005\"} 1\n") != std::string::npos);
+	REQUIRE(scraped.find("latency_seconds_bucket{le=\"0.025\"} 2\n") != std::string::npos);
+	REQUIRE(scraped.find("latency_seconds_bucket{le=\"+Inf\"} 2\n") != std::string::npos);
+	REQUIRE(scraped.find("latency_seconds_sum 0.023\n") != std::string::npos);
+	REQUIRE(scraped.find("latency_seconds_count 2\n") != std::string::npos);
+
+	registry.remove(id);
+	REQUIRE(registry.scrape() == "");
+}
+
+TEST_CASE("Trace spans are written in the Chrome trace format", "[telemetry] [trace]") {
+	std::string filename = "/tmp/clockwork_test_trace.json";
+	uint64_t trace_id = trace::new_id();
+	REQUIRE(trace_id != 0);
+	REQUIRE(trace::new_id() != trace_id);
+
+	{
+		trace::Writer writer(filename, "test");
+		writer.write(trace::Span{trace_id, "exec", 1600000000123456789UL, 1600000000125456790UL, 7});
+		writer.write(trace::Span{trace_id, "client", 1600000000000000000UL, 1600000000200000000UL, -1});
+	}
+
+	std::ifstream f(filename);
+	std::vector<std::string> lines;
+	for (std::string line; std::getline(f, line);) {
+		lines.push_back(line);
+	}
+	std::remove(filename.c_str());
+
+	REQUIRE(lines.size() == 4);
+	REQUIRE(lines[0] == "[");
+	REQUIRE(lines[1].find("\"ph\":\"M\"") != std::string::npos);
+	REQUIRE(lines[1].find("\"name\":\"test\"") != std::string::npos);
+
+	// Timestamps are exact microseconds since the epoch
+	REQUIRE(lines[2].find("\"name\":\"exec\"") != std::string::npos);
+	REQUIRE(lines[2].find("\"ts\":1600000000123456.789,") != std::string::npos);
+	REQUIRE(lines[2].find("\"dur\":2000.001,") != std::string::npos);
+	REQUIRE(lines[2].find("\"action_id\":7") != std::string::npos);
+	REQUIRE(lines[3].find("\"action_id\"") == std::string::npos);
+
+	// Every event ends with a comma, so files can be concatenated
+	for (unsigned i = 1; i < lines.size(); i++) {
+		REQUIRE(lines[i].back() == ',');
+	}
+}
+
+TEST_CASE("Inflater formats and filters rows in order", "[telemetry] [inflate]") {
+	std::string formatted;
+	inflater::RowFormatter row(formatted);
+	row.add(18446744073709551615UL);
+	row.add(-3);
+	row.skip();
+	row.add(0.5);
+	row.add(std::string("GPU"));
+	row.end_row();
+	row.add(7U);
+	row.end_row();
+	REQUIRE(formatted == "18446744073709551615\t-3\t\t0.5\tGPU\n7\n");
+
+	inflater::Filter filter;
+	REQUIRE(!filter.by_time());
+	REQUIRE(filter.time_matches(0));
+	REQUIRE(filter.model_matches(3));
+	filter.from = 100;
+	filter.to = 200;
+	filter.model_id = 3;
+	REQUIRE(filter.by_time());
+	REQUIRE(filter.by_model());
+	REQUIRE(!filter.by_action_type());
+	REQUIRE(filter.time_matches(100));
+	REQUIRE(!filter.time_matches(200));
+	REQUIRE(!filter.model_matches(4));
+	REQUIRE(filter.action_type_matches(1));
+
+	// Chunks are formatted concurrently but written in order
+	std::string filename = "/tmp/clockwork_test_inflate.tsv";
+	FILE* out = fopen(filename.c_str(), "w");
+	int next = 0;
+	uint64_t chunks = inflater::format_parallel<int>(
+		[&next] (int &chunk) { chunk = next++; return chunk < 100; },
+		[] (int &chunk, std::string &formatted) {
+			inflater::RowFormatter row(formatted);
+			row.add(chunk);
+			row.end_row();
+		},
+		out, 4);
+	fclose(out);
+	REQUIRE(chunks == 100);
+
+	std::ifstream f(filename);
+	int expected = 0;
+	for (std::string line; std::getline(f, line); expected++) {
+		REQUIRE(line == std::to_string(expected));
+	}
+	std::remove(filename.c_str());
+	REQUIRE(expected == 100);
+}
+
+class CountingRequestLogger : public RequestTelemetryLogger {
+public:
+	std::vector<int> logged;
+	void log(ControllerRequestTelemetry &t) { logged.push_back(t.request_id); }
+	void shutdown(bool awaitCompletion) {}
+};
+
+class CountingActionLogger : public ControllerActionTelemetryLogger {
+public:
+	unsigned logged = 0;
+	void log(ControllerActionTelemetry &t) { logged++; }
+	void shutdown(bool awaitCompletion) {}
+};
+
+TEST_CASE("Log sampling is deterministic and keeps requests and actions joinable", "[telemetry] [sampling]") {
+	sampling::Sampler requests("requests", 0.1);
+	sampling::Sampler actions("actions", 0.1);
+	REQUIRE(requests.rate() == Approx(0.1));
+
+	// The same requests are sampled by every sampler with the same rate
+	sampling::Sampler again("requests", 0.1);
+	unsigned sampled = 0, mismatched = 0;
+	for (int i = 0; i < 100000; i++) {
+		uint64_t key = sampling::request_key(1, i);
+		if (requests.sampled(key)) sampled++;
+		if (requests.sampled(key) != again.sampled(key)) mismatched++;
+	}
+	REQUIRE(mismatched == 0);
+	REQUIRE(sampled > 9000);
+	REQUIRE(sampled < 11000);
+
+	// Successful requests that met their deadlines are sampled
+	CountingRequestLogger* request_log = new CountingRequestLogger();
+	SampledRequestTelemetryLogger sampled_requests(request_log, requests);
+	for (int i = 0; i < 1000; i++) {
+		ControllerRequestTelemetry t = {};
+		t.request_id = i;
+		t.user_id = 1;
+		t.arrival = 1000;
+		t.departure = 2000;
+		t.deadline = 3000;
+		t.arrival_count = 1;
+		t.departure_count = 1;
+		t.result = clockworkSuccess;
+		sampled_requests.log(t);
+	}
+	REQUIRE(request_log->logged.size() > 50);
+	REQUIRE(request_log->logged.size() < 150);
+
+	// An action batching a logged request is logged too
+	CountingActionLogger* action_log = new CountingActionLogger();
+	SampledControllerActionTelemetryLogger sampled_actions(action_log, actions);
+	for (int request_id : request_log->logged) {
+		ControllerActionTelemetry t;
+		t.action_type = workerapi::inferAction;
+		t.status = actionSuccess;
+		t.sample_hash = std::min(sampling::hash(sampling::request_key(1, request_id)),
+			sampling::hash(sampling::request_key(2, request_id)));
+		sampled_actions.log(t);
+	}
+	REQUIRE(action_log->logged == request_log->logged.size());
+
+	// Errors, SLO misses and cold starts are always logged
+	requests.set_rate(0);
+	REQUIRE(requests.rate() == 0);
+	request_log->logged.clear();
+	ControllerRequestTelemetry error = {};
+	error.result = clockworkError;
+	sampled_requests.log(error);
+	ControllerRequestTelemetry late = {};
+	late.result = clockworkSuccess;
+	late.arrival = 1000;
+	late.deadline = 2000;
+	late.departure = 3000;
+	sampled_requests.log(late);
+	ControllerRequestTelemetry coldstart = {};
+	coldstart.result = clockworkSuccess;
+	coldstart.departure_count = 1;
+	sampled_requests.log(coldstart);
+	REQUIRE(request_log->logged.size() == 3);
+
+	actions.set_rate(0);
+	action_log->logged = 0;
+	ControllerActionTelemetry load;
+	load.action_type = workerapi::loadWeightsAction;
+	load.status = actionSuccess;
+	sampled_actions.log(load);
+	REQUIRE(action_log->logged == 1);
+
+	// Rates can be set by name
+	REQUIRE(sampling::set_rate("requests", 0.5));
+	REQUIRE(sampling::requests().rate() == Approx(0.5));
+	REQUIRE(!sampling::set_rate("tasks", 0.5));
+	sampling::set_rate("requests", 1);
+}
+
+class DeadlineTask : public Task {
+public:
+	uint64_t earliest, latest;
+	DeadlineTask(uint64_t earliest, uint64_t latest) : earliest(earliest), latest(latest) {}
+
+	uint64_t eligible() { return earliest; }
+	uint64_t deadline() { return latest; }
+	void run(cudaStream_t stream) {}
+	void cancel() {}
+};
+
+TEST_CASE("Executor utilization is accounted on the worker and tracked by the controller", "[telemetry] [executor]") {
+	ExecutorStats stats;
+
+	// Dequeued 200ns after becoming eligible, and in time
+	DeadlineTask on_time(1000, 5000);
+	stats.dequeued(&on_time, 1200);
+	REQUIRE(on_time.executor_stats == &stats);
+	REQUIRE(on_time.dequeued_at == 1200);
+	stats.ran(1200, 1300);
+
+	// Dequeued after its deadline; it will fail
+	DeadlineTask late(1000, 1500);
+	stats.dequeued(&late, 2000);
+	stats.ran(2000, 2050);
+
+	REQUIRE(stats.tasks == 2);
+	REQUIRE(stats.dropped == 1);
+	REQUIRE(stats.lateness == 200 + 1000);
+	REQUIRE(stats.busy == 150);
+
+	// Asynchronous work on the stream, the second overlapping the first
+	stats.async_completed(3000, 4000);
+	stats.async_completed(3500, 4500);
+	REQUIRE(stats.busy == 150 + 1000 + 500);
+	stats.async_completed(3600, 4200); // already covered
+	REQUIRE(stats.busy == 1650);
+
+	// The controller computes utilization between the worker's reports
+	ExecutorTracker tracker(0);
+	ExecutorTracker::Interval interval;
+	REQUIRE(!tracker.interval(TaskType::GPU, interval));
+
+	ExecutorTelemetry first = {TaskType::GPU, 0, 1000000, 0, 0, 0, 0, 0};
+	ExecutorTelemetry other_gpu = {TaskType::GPU, 1, 1000000, 900000, 10, 0, 0, 0};
+	tracker.update({first, other_gpu});
+	REQUIRE(!tracker.interval(TaskType::GPU, interval));
+
+	ExecutorTelemetry second = {TaskType::GPU, 0, 2000000, 250000, 10, 2, 50000, 3};
+	tracker.update({second});
+	REQUIRE(tracker.interval(TaskType::GPU, interval));
+	REQUIRE(interval.utilization == Approx(0.25));
+	REQUIRE(interval.idle == 750000);
+	REQUIRE(interval.tasks == 10);
+	REQUIRE(interval.dropped == 2);
+	REQUIRE(interval.mean_lateness == 5000);
+	REQUIRE(interval.queued == 3);
+
+	// Stale reports are ignored
+	tracker.update({first});
+	ExecutorTelemetry latest;
+	REQUIRE(tracker.latest(TaskType::GPU, latest));
+	REQUIRE(latest.timestamp == 2000000);
+	REQUIRE(!tracker.latest(PCIe_H2D_Weights, latest));
+}
+
+TEST_CASE("Executor tracker readers see consistent reports during updates", "[telemetry] [executor]") {
+	ExecutorTracker tracker(0);
+
+	// Every report is half busy, so any torn read shows up as a different utilization
+	std::atomic_bool done(false);
+	std::thread writer([&] {
+		for (uint64_t i = 1; i <= 200000; i++) {
+			ExecutorTelemetry t = {TaskType::GPU, 0, 1000 * i, 500 * i, i, 0, 0, (int64_t) i};
+			tracker.update({t});
+		}
+		done = true;
+	});
+
+	uint64_t reads = 0, inconsistent = 0;
+	ExecutorTracker::Interval interval;
+	while (!done) {
+		if (!tracker.interval(TaskType::GPU, interval)) continue;
+		reads++;
+		if (interval.utilization != 0.5 || interval.tasks != 1 || interval.idle != 500) inconsistent++;
+	}
+	writer.join();
+
+	REQUIRE(inconsistent == 0);
+	REQUIRE(tracker.interval(TaskType::GPU, interval));
+	REQUIRE(interval.queued == 200000);
+}
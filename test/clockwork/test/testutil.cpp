@@ -2,7 +2,11 @@
 #include <libgen.h>
 #include <fstream>
 #include <algorithm>
+#include <cmath>
+#include <deque>
 #include <memory>
+#include <vector>
+#include <cstdlib>
 
 #include <cuda_runtime.h>
 #include "clockwork/api/worker_api.h"
@@ -87,6 +91,98 @@ TEST_CASE("Test estimator", "[estimator] [util]") {
 }
 
 
+// Re-sorts the window on every query; the reference for SlidingWindowT
+template <typename T>
+class NaiveSlidingWindow {
+public:
+    unsigned window_size;
+    std::deque<T> values;
+
+    NaiveSlidingWindow(unsigned window_size) : window_size(window_size) {}
+
+    void insert(T value) {
+        values.push_back(value);
+        if (values.size() > window_size) values.pop_front();
+    }
+    unsigned get_size() { return values.size(); }
+    T get_value(unsigned rank) {
+        std::vector<T> sorted(values.begin(), values.end());
+        std::sort(sorted.begin(), sorted.end());
+        return sorted[rank];
+    }
+    T get_percentile(float percentile) {
+        float position = percentile * (values.size() - 1);
+        unsigned up = ceil(position);
+        unsigned down = floor(position);
+        if (up == down) return get_value(up);
+        return get_value(up) * (position - down) + get_value(down) * (up - position);
+    }
+    T get_min() { return get_value(0); }
+    T get_max() { return get_value(values.size()-1); }
+};
+
+template <typename T>
+void compare_sliding_windows(unsigned window_size, std::vector<T> &values) {
+    SlidingWindowT<T> window(window_size);
+    NaiveSlidingWindow<T> reference(window_size);
+
+    std::vector<float> percentiles = {0, 0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99, 0.999, 1};
+    for (T &value : values) {
+        window.insert(value);
+        reference.insert(value);
+
+        REQUIRE(window.get_size() == reference.get_size());
+        REQUIRE(window.get_min() == reference.get_min());
+        REQUIRE(window.get_max() == reference.get_max());
+        for (float &p : percentiles) {
+            REQUIRE(window.get_percentile(p) == reference.get_percentile(p));
+        }
+    }
+
+    for (unsigned rank = 0; rank < window.get_size(); rank++) {
+        REQUIRE(window.get_value(rank) == reference.get_value(rank));
+    }
+}
+
+TEST_CASE("Test estimator matches a naive sliding window", "[estimator] [util]") {
+    std::srand(0);
+
+    for (unsigned window_size : {1, 2, 3, 10, 100, 1024}) {
+        unsigned count = 3 * window_size + 100;
+
+        // Distinct-ish values
+        std::vector<uint64_t> values;
+        for (unsigned i = 0; i < count; i++) {
+            values.push_back(std::rand());
+        }
+        compare_sliding_windows(window_size, values);
+
+        // Many duplicates
+        std::vector<uint64_t> duplicates;
+        for (unsigned i = 0; i < count; i++) {
+            duplicates.push_back(std::rand() % 5);
+        }
+        compare_sliding_windows(window_size, duplicates);
+
+        // Monotonically increasing and decreasing
+        std::vector<uint64_t> increasing, decreasing;
+        for (unsigned i = 0; i < count; i++) {
+            increasing.push_back(i);
+            decreasing.push_back(count - i);
+        }
+        compare_sliding_windows(window_size, increasing);
+        compare_sliding_windows(window_size, decreasing);
+
+        // Signed values, as used for clock deltas
+        std::vector<int64_t> deltas;
+        for (unsigned i = 0; i < count; i++) {
+            deltas.push_back(((int64_t) std::rand()) - (RAND_MAX / 2));
+        }
+        compare_sliding_windows(window_size, deltas);
+    }
+}
+
+
 TEST_CASE("Test batch lookup", "[batchlookup] [util]") {
     {
         auto lookup = util::make_batch_lookup({0});